@@ -0,0 +1,108 @@
+#include "QmlPacketModel.h"
+
+QmlPacketModel::QmlPacketModel(QObject* parent /*= Q_NULLPTR*/)
+    : QAbstractListModel(parent) {
+  QObject::connect(&_flushTimer, &QTimer::timeout, this, &QmlPacketModel::flush);
+  _flushTimer.start(kFlushIntervalMs);
+}
+
+void QmlPacketModel::append(const chai::RtpRecord& record) {
+  Row row;
+  row.header = record.header;
+  row.color1 = record.color1;
+  row.color2 = record.color2;
+
+  std::lock_guard<std::mutex> lock(_pendingMutex);
+  _pendingRows.push_back(row);
+  _pendingDetails.push_back(record);
+  if (_pendingDetails.size() > kMaxDetails) {
+    _pendingDetails.pop_front();
+  }
+}
+
+void QmlPacketModel::flush() {
+  std::vector<Row> rows;
+  std::deque<chai::RtpRecord> details;
+  {
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    rows.swap(_pendingRows);
+    details.swap(_pendingDetails);
+  }
+  if (rows.empty()) {
+    return;
+  }
+
+  // Only the newest kMaxRows of a burst would survive the trim below.
+  size_t skip = rows.size() > size_t(kMaxRows) ? rows.size() - kMaxRows : 0;
+  int overflow = int(_rows.size() + rows.size() - skip) - kMaxRows;
+  if (overflow > 0) {
+    beginRemoveRows(QModelIndex(), 0, overflow - 1);
+    _rows.erase(_rows.begin(), _rows.begin() + overflow);
+    endRemoveRows();
+  }
+
+  int first = int(_rows.size());
+  beginInsertRows(QModelIndex(), first, first + int(rows.size() - skip) - 1);
+  _rows.insert(_rows.end(), rows.begin() + skip, rows.end());
+  endInsertRows();
+
+  for (auto& record : details) {
+    _details.push_back(std::move(record));
+  }
+  while (_details.size() > kMaxDetails) {
+    _details.pop_front();
+  }
+}
+
+int QmlPacketModel::rowCount(const QModelIndex& parent) const {
+  return parent.isValid() ? 0 : int(_rows.size());
+}
+
+QVariant QmlPacketModel::data(const QModelIndex& index, int role) const {
+  if (!index.isValid() || index.row() >= int(_rows.size())) {
+    return QVariant();
+  }
+  const Row& row = _rows[index.row()];
+  switch (role) {
+    case InfoRole:
+      return QString::fromStdString(row.header.toJson().dump());
+    case Color1Role:
+      return QString(row.color1);
+    case Color2Role:
+      return QString(row.color2);
+  }
+  return QVariant();
+}
+
+QHash<int, QByteArray> QmlPacketModel::roleNames() const {
+  return {
+      {InfoRole, "info"},
+      {Color1Role, "color1"},
+      {Color2Role, "color2"},
+  };
+}
+
+QString QmlPacketModel::details(int row) const {
+  if (row < 0 || row >= int(_rows.size())) {
+    return QString();
+  }
+  size_t fromEnd = _rows.size() - row;
+  if (fromEnd <= _details.size()) {
+    const chai::RtpRecord& record = _details[_details.size() - fromEnd];
+    return QString::fromStdString(record.toJson().dump());
+  }
+  nlohmann::json json = {{"header", _rows[row].header.toJson()}};
+  return QString::fromStdString(json.dump());
+}
+
+void QmlPacketModel::clear() {
+  {
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    _pendingRows.clear();
+    _pendingDetails.clear();
+  }
+  beginResetModel();
+  _rows.clear();
+  _details.clear();
+  endResetModel();
+}
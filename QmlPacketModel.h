@@ -0,0 +1,60 @@
+#pragma once
+
+#include "chai/RtpRecord.h"
+
+#include <QAbstractListModel>
+#include <QTimer>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Packet list of the UI. append() is called from the parse threads and only
+// queues a compact row; the rows reach the view in batches on the GUI
+// thread, and a row's text is rendered when the view asks for it.
+class QmlPacketModel : public QAbstractListModel {
+  Q_OBJECT
+
+ public:
+  enum Roles {
+    InfoRole = Qt::UserRole + 1,
+    Color1Role,
+    Color2Role,
+  };
+
+  explicit QmlPacketModel(QObject* parent = Q_NULLPTR);
+
+  void append(const chai::RtpRecord& record);
+
+  int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex& index, int role) const override;
+  QHash<int, QByteArray> roleNames() const override;
+
+  // Full JSON of |row|; only the header once the packet is older than the
+  // last kMaxDetails.
+  Q_INVOKABLE QString details(int row) const;
+  Q_INVOKABLE void clear();
+
+ private:
+  struct Row {
+    chai::RtpHeaderView header;
+    const char* color1{nullptr};
+    const char* color2{nullptr};
+  };
+
+  void flush();
+
+  static const int kMaxRows{20000};
+  static const size_t kMaxDetails{1000};
+  static const int kFlushIntervalMs{50};
+
+  // GUI thread.
+  std::deque<Row> _rows;
+  // Records of the last kMaxDetails rows, _details.back() is _rows.back().
+  std::deque<chai::RtpRecord> _details;
+  QTimer _flushTimer;
+
+  // Filled by append(), moved into the model by flush().
+  std::mutex _pendingMutex;
+  std::vector<Row> _pendingRows;
+  std::deque<chai::RtpRecord> _pendingDetails;
+};
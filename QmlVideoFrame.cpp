@@ -100,6 +100,27 @@ QString QmlVideoFrame::getLocalDescription() {
   return QString::fromStdString(this->_pc->GetLocalDescription());
 }
 
+bool QmlVideoFrame::startRtpDump(const QString& path) {
+  return this->_pc->StartRtpDump(path.toLocal8Bit().toStdString());
+}
+
+void QmlVideoFrame::stopRtpDump() {
+  this->_pc->StopRtpDump();
+}
+
+bool QmlVideoFrame::startFlightRecorder(const QString& path, int sizeMb) {
+  return this->_pc->StartFlightRecorder(path.toLocal8Bit().toStdString(),
+                                        uint64_t(sizeMb) << 20);
+}
+
+void QmlVideoFrame::stopFlightRecorder() {
+  this->_pc->StopFlightRecorder();
+}
+
+qint64 QmlVideoFrame::tapDrops() {
+  return qint64(this->_pc->GetTapDrops());
+}
+
 void QmlVideoFrame::OnFrame(const webrtc::VideoFrame& video_frame) {
   rtc::scoped_refptr<webrtc::I420BufferInterface> buffer(
       video_frame.video_frame_buffer()->ToI420());
@@ -121,14 +142,13 @@ void QmlVideoFrame::OnFrame(const webrtc::VideoFrame& video_frame) {
   }
 }
 
-void QmlVideoFrame::onRtpPakcet(nlohmann::json& json) {
-  //auto j = json.dump();
-
-  if (json["payload"].is_null()) {
+void QmlVideoFrame::onRtpRecord(const chai::RtpRecord& record) {
+  if (!record.payload) {
     //RTC_LOG(LS_VERBOSE) << "payload is null";
     return;
   }
-  Q_EMIT this->message("rtp", QString::fromStdString(json.dump()));
+
+  this->_packets.append(record);
 }
 
 void QmlVideoFrame::onRtcpPakcet(nlohmann::json& json) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "chai/PeerConnection.h"
+#include "QmlPacketModel.h"
 
 #include <QObject>
 #include <QtMultimedia/QAbstractVideoSurface>
@@ -15,6 +16,7 @@ class QmlVideoFrame : public QObject,
   Q_PROPERTY(QString direction READ direction WRITE setDirection)
   Q_PROPERTY(int width READ width WRITE setWidth)
   Q_PROPERTY(int height READ height WRITE setHeight)
+  Q_PROPERTY(QAbstractItemModel* packets READ packets CONSTANT)
 
  public:
   explicit QmlVideoFrame(QObject* parent = Q_NULLPTR);
@@ -28,6 +30,7 @@ class QmlVideoFrame : public QObject,
   void setWidth(int w) { _width = w; }
   int height() const { return _height; }
   void setHeight(int h) { _height = h; }
+  QAbstractItemModel* packets() { return &_packets; }
 
  public Q_SLOTS:
   void newVideoContent(const QVideoFrame& frame);
@@ -35,6 +38,14 @@ class QmlVideoFrame : public QObject,
   QString createAnswer();
   void setRemoteDescription(const QString& sdp);
   QString getLocalDescription();
+  // Record what the taps see to |path|, see chai::PeerConnection. Both may
+  // be started before the first description is applied.
+  bool startRtpDump(const QString& path);
+  void stopRtpDump();
+  bool startFlightRecorder(const QString& path, int sizeMb);
+  void stopFlightRecorder();
+  // See chai::PeerConnection::GetTapDrops().
+  qint64 tapDrops();
  Q_SIGNALS:
   void newFrameAvailable(const QVideoFrame& frame);
   void message(const QString& type, const QString& msg);
@@ -44,7 +55,7 @@ class QmlVideoFrame : public QObject,
   void OnFrame(const webrtc::VideoFrame& frame) override;
 
   // PeerConnectionObserver
-  void onRtpPakcet(nlohmann::json& json) override;
+  void onRtpRecord(const chai::RtpRecord& record) override;
   void onRtcpPakcet(nlohmann::json& json) override;
 
   void setFormat(QVideoFrame::PixelFormat pixelFormat);
@@ -60,6 +71,9 @@ class QmlVideoFrame : public QObject,
   int _rtxPayload{0};
   int _fecPayload{0};
 
+  // Filled from the parse threads.
+  QmlPacketModel _packets;
+
   std::unique_ptr<chai::PeerConnection> _pc{nullptr};
   rtc::scoped_refptr<webrtc::VideoTrackInterface> rendered_track_{nullptr};
 };
@@ -0,0 +1,1553 @@
+#include "Av1HeaderParser.h"
+
+#include <algorithm>
+
+namespace {
+using chai::Av1FrameHeader;
+
+const int kPrimaryRefNone{7};
+const uint8_t kAllFrames{0xff};
+const int kSelectScreenContentTools{2};
+const int kSelectIntegerMv{2};
+const int kSwitchable{4};
+
+// Reference frame names of 6.10.24.
+const int kLastFrame{1};
+const int kLast2Frame{2};
+const int kLast3Frame{3};
+const int kGoldenFrame{4};
+const int kBwdrefFrame{5};
+const int kAltref2Frame{6};
+const int kAltrefFrame{7};
+
+const int kMaxTileWidth{4096};
+const int kMaxTileArea{4096 * 2304};
+const int kMaxTileRows{64};
+const int kMaxTileCols{64};
+
+// 5.9.14
+const int kSegmentationFeatureBits[Av1FrameHeader::kSegLvlMax] = {
+    8, 6, 6, 6, 6, 3, 0, 0};
+const int kSegmentationFeatureSigned[Av1FrameHeader::kSegLvlMax] = {
+    1, 1, 1, 1, 1, 0, 0, 0};
+const int kSegmentationFeatureMax[Av1FrameHeader::kSegLvlMax] = {
+    255, 63, 63, 63, 63, 7, 0, 0};
+
+// 5.9.20: RESTORE_NONE, RESTORE_SWITCHABLE, RESTORE_WIENER, RESTORE_SGRPROJ.
+const uint8_t kRemapLrType[4] = {0, 3, 1, 2};
+
+// 5.9.24 global motion.
+const int kIdentity{0};
+const int kTranslation{1};
+const int kRotzoom{2};
+const int kAffine{3};
+const int kWarpedModelPrecBits{16};
+const int kGmAbsTransBits{12};
+const int kGmAbsTransOnlyBits{9};
+const int kGmAbsAlphaBits{12};
+const int kGmAlphaPrecBits{15};
+const int kGmTransPrecBits{6};
+const int kGmTransOnlyPrecBits{3};
+
+const int8_t kDefaultLoopFilterRefDeltas[Av1FrameHeader::kTotalRefsPerFrame] =
+    {1, 0, 0, 0, -1, 0, -1, -1};
+
+int tileLog2(int blkSize, int target) {
+  int k = 0;
+  for (; (blkSize << k) < target; ++k) {
+  }
+  return k;
+}
+
+// 5.9.12 read_delta_q().
+int8_t readDeltaQ(chai::BitReader& reader) {
+  return reader.readFlag() ? int8_t(reader.readSu(7)) : 0;
+}
+
+void setDefaultGmParams(int32_t params[Av1FrameHeader::kTotalRefsPerFrame][6]) {
+  for (int ref = kLastFrame; ref <= kAltrefFrame; ++ref) {
+    for (int i = 0; i < 6; ++i) {
+      params[ref][i] = (i % 3 == 2) ? 1 << kWarpedModelPrecBits : 0;
+    }
+  }
+}
+
+// 5.9.27, 5.9.28
+int inverseRecenter(int r, int v) {
+  if (v > 2 * r) {
+    return v;
+  } else if (v & 1) {
+    return r - ((v + 1) >> 1);
+  }
+  return r + (v >> 1);
+}
+
+int decodeSubexp(chai::BitReader& reader, int numSyms) {
+  int i = 0;
+  int mk = 0;
+  const int k = 3;
+  while (reader.ok()) {
+    int b2 = i ? k + i - 1 : k;
+    int a = 1 << b2;
+    if (numSyms <= mk + 3 * a) {
+      return int(reader.readNs(numSyms - mk)) + mk;
+    }
+    if (!reader.readFlag()) {
+      return int(reader.readBits(b2)) + mk;
+    }
+    ++i;
+    mk += a;
+  }
+  return 0;
+}
+
+int decodeUnsignedSubexpWithRef(chai::BitReader& reader, int mx, int r) {
+  int v = decodeSubexp(reader, mx);
+  if ((r << 1) <= mx) {
+    return inverseRecenter(r, v);
+  }
+  return mx - 1 - inverseRecenter(mx - 1 - r, v);
+}
+
+int decodeSignedSubexpWithRef(chai::BitReader& reader,
+                              int low,
+                              int high,
+                              int r) {
+  return decodeUnsignedSubexpWithRef(reader, high - low, r - low) + low;
+}
+}  // namespace
+
+namespace chai {
+const int Av1SequenceHeader::kMaxOperatingPoints;
+const int Av1TileInfo::kMaxTiles;
+const int Av1FrameHeader::kRefsPerFrame;
+const int Av1FrameHeader::kTotalRefsPerFrame;
+const int Av1FrameHeader::kMaxSegments;
+const int Av1FrameHeader::kSegLvlMax;
+const int Av1TileGroup::kMaxTileSizes;
+const int Av1Metadata::kMaxSpatialLayers;
+const int Av1Metadata::kMaxTemporalGroupSize;
+const int Av1Metadata::kMaxRefPicDiffs;
+
+const char* av1ObuTypeName(uint8_t type) {
+  switch (type) {
+    case kAv1ObuSequenceHeader:
+      return "OBU_SEQUENCE_HEADER";
+    case kAv1ObuTemporalDelimiter:
+      return "OBU_TEMPORAL_DELIMITER";
+    case kAv1ObuFrameHeader:
+      return "OBU_FRAME_HEADER";
+    case kAv1ObuTileGroup:
+      return "OBU_TILE_GROUP";
+    case kAv1ObuMetadata:
+      return "OBU_METADATA";
+    case kAv1ObuFrame:
+      return "OBU_FRAME";
+    case kAv1ObuRedundantFrameHeader:
+      return "OBU_REDUNDANT_FRAME_HEADER";
+    case kAv1ObuTileList:
+      return "OBU_TILE_LIST";
+    case kAv1ObuPadding:
+      return "OBU_PADDING";
+  }
+  return "Reserved";
+}
+
+const char* av1FrameTypeName(uint8_t type) {
+  switch (type) {
+    case kAv1KeyFrame:
+      return "KEY_FRAME";
+    case kAv1InterFrame:
+      return "INTER_FRAME";
+    case kAv1IntraOnlyFrame:
+      return "INTRA_ONLY_FRAME";
+    case kAv1SwitchFrame:
+      return "SWITCH_FRAME";
+  }
+  return "";
+}
+
+const char* av1MetadataTypeName(uint64_t type) {
+  switch (type) {
+    case kAv1MetadataHdrCll:
+      return "METADATA_TYPE_HDR_CLL";
+    case kAv1MetadataHdrMdcv:
+      return "METADATA_TYPE_HDR_MDCV";
+    case kAv1MetadataScalability:
+      return "METADATA_TYPE_SCALABILITY";
+    case kAv1MetadataItutT35:
+      return "METADATA_TYPE_ITUT_T35";
+    case kAv1MetadataTimecode:
+      return "METADATA_TYPE_TIMECODE";
+  }
+  return type >= 6 && type <= 31 ? "Unregistered user private" : "Reserved";
+}
+
+bool Av1HeaderParser::parseObuHeader(const uint8_t* data,
+                                     size_t size,
+                                     Av1ObuHeader* header) {
+  BitReader reader(data, size);
+  if (reader.readFlag()) {
+    // obu_forbidden_bit
+    return false;
+  }
+  header->obu_type = uint8_t(reader.readBits(4));
+  header->obu_extension_flag = reader.readFlag();
+  header->obu_has_size_field = reader.readFlag();
+  reader.skipBits(1);
+  header->temporal_id = 0;
+  header->spatial_id = 0;
+  if (header->obu_extension_flag) {
+    header->temporal_id = uint8_t(reader.readBits(3));
+    header->spatial_id = uint8_t(reader.readBits(2));
+    reader.skipBits(3);
+  }
+  size_t headerBytes = reader.bitOffset() / 8;
+  if (header->obu_has_size_field) {
+    header->obu_size = reader.readLeb128();
+  } else if (size >= headerBytes) {
+    header->obu_size = size - headerBytes;
+  }
+  header->size = uint8_t(reader.bitOffset() / 8);
+  return reader.ok() && header->obu_size <= size - header->size;
+}
+
+// 5.5.1
+bool Av1HeaderParser::parseSequenceHeader(const uint8_t* data, size_t size) {
+  BitReader reader(data, size);
+  Av1SequenceHeader seq;
+  seq.seq_profile = uint8_t(reader.readBits(3));
+  seq.still_picture = reader.readFlag();
+  seq.reduced_still_picture_header = reader.readFlag();
+  if (seq.reduced_still_picture_header) {
+    seq.operating_points[0].seq_level_idx = uint8_t(reader.readBits(5));
+  } else {
+    seq.timing_info_present_flag = reader.readFlag();
+    if (seq.timing_info_present_flag) {
+      // 5.5.3 timing_info()
+      seq.num_units_in_display_tick = reader.readBits(32);
+      seq.time_scale = reader.readBits(32);
+      seq.equal_picture_interval = reader.readFlag();
+      if (seq.equal_picture_interval) {
+        seq.num_ticks_per_picture_minus_1 = reader.readUvlc();
+      }
+      seq.decoder_model_info_present_flag = reader.readFlag();
+      if (seq.decoder_model_info_present_flag) {
+        // 5.5.4 decoder_model_info()
+        seq.buffer_delay_length_minus_1 = uint8_t(reader.readBits(5));
+        seq.num_units_in_decoding_tick = reader.readBits(32);
+        seq.buffer_removal_time_length_minus_1 = uint8_t(reader.readBits(5));
+        seq.frame_presentation_time_length_minus_1 =
+            uint8_t(reader.readBits(5));
+      }
+    }
+    seq.initial_display_delay_present_flag = reader.readFlag();
+    seq.operating_points_cnt_minus_1 = uint8_t(reader.readBits(5));
+    for (int i = 0; i <= seq.operating_points_cnt_minus_1; ++i) {
+      auto& op = seq.operating_points[i];
+      op.operating_point_idc = uint16_t(reader.readBits(12));
+      op.seq_level_idx = uint8_t(reader.readBits(5));
+      if (op.seq_level_idx > 7) {
+        op.seq_tier = uint8_t(reader.readBits(1));
+      }
+      if (seq.decoder_model_info_present_flag) {
+        op.decoder_model_present_for_this_op = reader.readFlag();
+        if (op.decoder_model_present_for_this_op) {
+          // 5.5.5 operating_parameters_info()
+          int n = seq.buffer_delay_length_minus_1 + 1;
+          op.decoder_buffer_delay = reader.readBits(n);
+          op.encoder_buffer_delay = reader.readBits(n);
+          op.low_delay_mode_flag = reader.readFlag();
+        }
+      }
+      if (seq.initial_display_delay_present_flag) {
+        op.initial_display_delay_present_for_this_op = reader.readFlag();
+        if (op.initial_display_delay_present_for_this_op) {
+          op.initial_display_delay_minus_1 = uint8_t(reader.readBits(4));
+        }
+      }
+    }
+  }
+  seq.frame_width_bits_minus_1 = uint8_t(reader.readBits(4));
+  seq.frame_height_bits_minus_1 = uint8_t(reader.readBits(4));
+  seq.max_frame_width_minus_1 =
+      uint16_t(reader.readBits(seq.frame_width_bits_minus_1 + 1));
+  seq.max_frame_height_minus_1 =
+      uint16_t(reader.readBits(seq.frame_height_bits_minus_1 + 1));
+  if (!seq.reduced_still_picture_header) {
+    seq.frame_id_numbers_present_flag = reader.readFlag();
+  }
+  if (seq.frame_id_numbers_present_flag) {
+    seq.delta_frame_id_length_minus_2 = uint8_t(reader.readBits(4));
+    seq.additional_frame_id_length_minus_1 = uint8_t(reader.readBits(3));
+  }
+  seq.use_128x128_superblock = reader.readFlag();
+  seq.enable_filter_intra = reader.readFlag();
+  seq.enable_intra_edge_filter = reader.readFlag();
+  if (seq.reduced_still_picture_header) {
+    seq.seq_force_screen_content_tools = kSelectScreenContentTools;
+    seq.seq_force_integer_mv = kSelectIntegerMv;
+  } else {
+    seq.enable_interintra_compound = reader.readFlag();
+    seq.enable_masked_compound = reader.readFlag();
+    seq.enable_warped_motion = reader.readFlag();
+    seq.enable_dual_filter = reader.readFlag();
+    seq.enable_order_hint = reader.readFlag();
+    if (seq.enable_order_hint) {
+      seq.enable_jnt_comp = reader.readFlag();
+      seq.enable_ref_frame_mvs = reader.readFlag();
+    }
+    // seq_choose_screen_content_tools
+    if (reader.readFlag()) {
+      seq.seq_force_screen_content_tools = kSelectScreenContentTools;
+    } else {
+      seq.seq_force_screen_content_tools = uint8_t(reader.readBits(1));
+    }
+    seq.seq_force_integer_mv = kSelectIntegerMv;
+    // seq_choose_integer_mv
+    if (seq.seq_force_screen_content_tools > 0 && !reader.readFlag()) {
+      seq.seq_force_integer_mv = uint8_t(reader.readBits(1));
+    }
+    if (seq.enable_order_hint) {
+      seq.OrderHintBits = uint8_t(reader.readBits(3) + 1);
+    }
+  }
+  seq.enable_superres = reader.readFlag();
+  seq.enable_cdef = reader.readFlag();
+  seq.enable_restoration = reader.readFlag();
+  colorConfig(reader, seq);
+  seq.film_grain_params_present = reader.readFlag();
+  if (!reader.ok()) {
+    return false;
+  }
+  this->sequenceHeader_ = seq;
+  this->hasSequenceHeader_ = true;
+  return true;
+}
+
+// 5.5.2
+void Av1HeaderParser::colorConfig(BitReader& reader, Av1SequenceHeader& seq) {
+  bool high_bitdepth = reader.readFlag();
+  if (seq.seq_profile == 2 && high_bitdepth) {
+    seq.BitDepth = reader.readFlag() ? 12 : 10;
+  } else {
+    seq.BitDepth = high_bitdepth ? 10 : 8;
+  }
+  seq.mono_chrome = seq.seq_profile == 1 ? false : reader.readFlag();
+  seq.color_description_present_flag = reader.readFlag();
+  if (seq.color_description_present_flag) {
+    seq.color_primaries = uint8_t(reader.readBits(8));
+    seq.transfer_characteristics = uint8_t(reader.readBits(8));
+    seq.matrix_coefficients = uint8_t(reader.readBits(8));
+  }
+  if (seq.mono_chrome) {
+    seq.color_range = reader.readFlag();
+    seq.subsampling_x = seq.subsampling_y = 1;
+    seq.chroma_sample_position = 0;
+    seq.separate_uv_delta_q = false;
+    return;
+  }
+  // CP_BT_709, TC_SRGB, MC_IDENTITY
+  if (seq.color_primaries == 1 && seq.transfer_characteristics == 13 &&
+      seq.matrix_coefficients == 0) {
+    seq.color_range = true;
+    seq.subsampling_x = seq.subsampling_y = 0;
+  } else {
+    seq.color_range = reader.readFlag();
+    if (seq.seq_profile == 0) {
+      seq.subsampling_x = seq.subsampling_y = 1;
+    } else if (seq.seq_profile == 1) {
+      seq.subsampling_x = seq.subsampling_y = 0;
+    } else if (seq.BitDepth == 12) {
+      seq.subsampling_x = uint8_t(reader.readBits(1));
+      seq.subsampling_y =
+          seq.subsampling_x ? uint8_t(reader.readBits(1)) : 0;
+    } else {
+      seq.subsampling_x = 1;
+      seq.subsampling_y = 0;
+    }
+    if (seq.subsampling_x && seq.subsampling_y) {
+      seq.chroma_sample_position = uint8_t(reader.readBits(2));
+    }
+  }
+  seq.separate_uv_delta_q = reader.readFlag();
+}
+
+// 5.9.1
+bool Av1HeaderParser::parseFrameHeader(const uint8_t* data,
+                                       size_t size,
+                                       const Av1ObuHeader& obu,
+                                       bool* copy) {
+  *copy = this->seenFrameHeader_;
+  if (this->seenFrameHeader_) {
+    // frame_header_copy()
+    return true;
+  }
+  if (!this->hasSequenceHeader_) {
+    return false;
+  }
+  BitReader reader(data, size);
+  this->frameHeader_ = Av1FrameHeader();
+  if (!this->uncompressedHeader(reader, obu) || !reader.ok()) {
+    return false;
+  }
+  this->frameHeader_.headerBits = uint32_t(reader.bitOffset());
+  if (this->frameHeader_.show_existing_frame) {
+    // decode_frame_wrapup(): only a shown key frame refreshes the slots.
+    if (this->frameHeader_.frame_type == kAv1KeyFrame) {
+      this->referenceFrameUpdate();
+    }
+  } else {
+    this->seenFrameHeader_ = true;
+    this->referenceFrameUpdate();
+  }
+  return true;
+}
+
+// 5.9.2
+bool Av1HeaderParser::uncompressedHeader(BitReader& reader,
+                                         const Av1ObuHeader& obu) {
+  const Av1SequenceHeader& seq = this->sequenceHeader_;
+  Av1FrameHeader& fh = this->frameHeader_;
+  int idLen = 0;
+  if (seq.frame_id_numbers_present_flag) {
+    idLen = seq.additional_frame_id_length_minus_1 +
+            seq.delta_frame_id_length_minus_2 + 3;
+  }
+  if (seq.reduced_still_picture_header) {
+    fh.error_resilient_mode = true;
+  } else {
+    fh.show_existing_frame = reader.readFlag();
+    if (fh.show_existing_frame) {
+      fh.frame_to_show_map_idx = uint8_t(reader.readBits(3));
+      if (seq.decoder_model_info_present_flag &&
+          !seq.equal_picture_interval) {
+        fh.frame_presentation_time =
+            reader.readBits(seq.frame_presentation_time_length_minus_1 + 1);
+      }
+      fh.refresh_frame_flags = 0;
+      if (seq.frame_id_numbers_present_flag) {
+        fh.display_frame_id = reader.readBits(idLen);
+      }
+      // 7.21 reference frame loading process.
+      const RefSlot& slot = this->refs_[fh.frame_to_show_map_idx];
+      if (!slot.valid) {
+        return false;
+      }
+      fh.frame_type = slot.frame_type;
+      fh.FrameIsIntra = fh.frame_type == kAv1IntraOnlyFrame ||
+                        fh.frame_type == kAv1KeyFrame;
+      fh.current_frame_id = slot.frame_id;
+      fh.order_hint = slot.order_hint;
+      fh.UpscaledWidth = slot.UpscaledWidth;
+      fh.FrameWidth = slot.FrameWidth;
+      fh.FrameHeight = slot.FrameHeight;
+      fh.RenderWidth = slot.RenderWidth;
+      fh.RenderHeight = slot.RenderHeight;
+      std::copy(&slot.gm_params[0][0], &slot.gm_params[0][0] + 8 * 6,
+                &fh.gm_params[0][0]);
+      std::copy(slot.loop_filter_ref_deltas, slot.loop_filter_ref_deltas + 8,
+                fh.loop_filter_ref_deltas);
+      std::copy(slot.loop_filter_mode_deltas,
+                slot.loop_filter_mode_deltas + 2, fh.loop_filter_mode_deltas);
+      std::copy(slot.FeatureEnabled, slot.FeatureEnabled + 8,
+                fh.FeatureEnabled);
+      std::copy(&slot.FeatureData[0][0], &slot.FeatureData[0][0] + 8 * 8,
+                &fh.FeatureData[0][0]);
+      if (seq.film_grain_params_present) {
+        fh.film_grain_params = slot.film_grain_params;
+      }
+      if (fh.frame_type == kAv1KeyFrame) {
+        fh.refresh_frame_flags = kAllFrames;
+      }
+      return true;
+    }
+    fh.frame_type = uint8_t(reader.readBits(2));
+    fh.FrameIsIntra = fh.frame_type == kAv1IntraOnlyFrame ||
+                      fh.frame_type == kAv1KeyFrame;
+    fh.show_frame = reader.readFlag();
+    if (fh.show_frame && seq.decoder_model_info_present_flag &&
+        !seq.equal_picture_interval) {
+      fh.frame_presentation_time =
+          reader.readBits(seq.frame_presentation_time_length_minus_1 + 1);
+    }
+    if (fh.show_frame) {
+      fh.showable_frame = fh.frame_type != kAv1KeyFrame;
+    } else {
+      fh.showable_frame = reader.readFlag();
+    }
+    if (fh.frame_type == kAv1SwitchFrame ||
+        (fh.frame_type == kAv1KeyFrame && fh.show_frame)) {
+      fh.error_resilient_mode = true;
+    } else {
+      fh.error_resilient_mode = reader.readFlag();
+    }
+  }
+  if (fh.frame_type == kAv1KeyFrame && fh.show_frame) {
+    for (RefSlot& slot : this->refs_) {
+      slot.valid = false;
+      slot.order_hint = 0;
+    }
+  }
+  fh.disable_cdf_update = reader.readFlag();
+  if (seq.seq_force_screen_content_tools == kSelectScreenContentTools) {
+    fh.allow_screen_content_tools = reader.readFlag();
+  } else {
+    fh.allow_screen_content_tools = seq.seq_force_screen_content_tools != 0;
+  }
+  if (fh.allow_screen_content_tools) {
+    if (seq.seq_force_integer_mv == kSelectIntegerMv) {
+      fh.force_integer_mv = reader.readFlag();
+    } else {
+      fh.force_integer_mv = seq.seq_force_integer_mv != 0;
+    }
+  }
+  if (fh.FrameIsIntra) {
+    fh.force_integer_mv = true;
+  }
+  if (seq.frame_id_numbers_present_flag) {
+    fh.current_frame_id = reader.readBits(idLen);
+  }
+  if (fh.frame_type == kAv1SwitchFrame) {
+    fh.frame_size_override_flag = true;
+  } else if (!seq.reduced_still_picture_header) {
+    fh.frame_size_override_flag = reader.readFlag();
+  }
+  fh.order_hint = reader.readBits(seq.OrderHintBits);
+  if (fh.FrameIsIntra || fh.error_resilient_mode) {
+    fh.primary_ref_frame = kPrimaryRefNone;
+  } else {
+    fh.primary_ref_frame = uint8_t(reader.readBits(3));
+  }
+  if (seq.decoder_model_info_present_flag) {
+    fh.buffer_removal_time_present_flag = reader.readFlag();
+    if (fh.buffer_removal_time_present_flag) {
+      for (int opNum = 0; opNum <= seq.operating_points_cnt_minus_1;
+           ++opNum) {
+        const auto& op = seq.operating_points[opNum];
+        if (!op.decoder_model_present_for_this_op) {
+          continue;
+        }
+        bool inTemporalLayer = (op.operating_point_idc >> obu.temporal_id) & 1;
+        bool inSpatialLayer =
+            (op.operating_point_idc >> (obu.spatial_id + 8)) & 1;
+        if (op.operating_point_idc == 0 ||
+            (inTemporalLayer && inSpatialLayer)) {
+          fh.buffer_removal_time[opNum] =
+              reader.readBits(seq.buffer_removal_time_length_minus_1 + 1);
+        }
+      }
+    }
+  }
+  if (fh.frame_type == kAv1SwitchFrame ||
+      (fh.frame_type == kAv1KeyFrame && fh.show_frame)) {
+    fh.refresh_frame_flags = kAllFrames;
+  } else {
+    fh.refresh_frame_flags = uint8_t(reader.readBits(8));
+  }
+  if ((!fh.FrameIsIntra || fh.refresh_frame_flags != kAllFrames) &&
+      fh.error_resilient_mode && seq.enable_order_hint) {
+    for (RefSlot& slot : this->refs_) {
+      uint32_t ref_order_hint = reader.readBits(seq.OrderHintBits);
+      if (ref_order_hint != slot.order_hint) {
+        slot.valid = false;
+        slot.order_hint = ref_order_hint;
+      }
+    }
+  }
+  if (fh.FrameIsIntra) {
+    this->frameSize(reader);
+    this->renderSize(reader);
+    if (fh.allow_screen_content_tools && fh.UpscaledWidth == fh.FrameWidth) {
+      fh.allow_intrabc = reader.readFlag();
+    }
+  } else {
+    if (seq.enable_order_hint) {
+      fh.frame_refs_short_signaling = reader.readFlag();
+      if (fh.frame_refs_short_signaling) {
+        uint8_t last_frame_idx = uint8_t(reader.readBits(3));
+        uint8_t gold_frame_idx = uint8_t(reader.readBits(3));
+        this->setFrameRefs(last_frame_idx, gold_frame_idx);
+      }
+    }
+    for (int i = 0; i < Av1FrameHeader::kRefsPerFrame; ++i) {
+      if (!fh.frame_refs_short_signaling) {
+        fh.ref_frame_idx[i] = int8_t(reader.readBits(3));
+      }
+      if (seq.frame_id_numbers_present_flag) {
+        // delta_frame_id_minus_1
+        reader.skipBits(seq.delta_frame_id_length_minus_2 + 2);
+      }
+      // Conformance requires every reference to hold a frame; without one
+      // (e.g. joined after the key frame) the sizes below are unknown.
+      if (!this->refs_[fh.ref_frame_idx[i]].valid) {
+        return false;
+      }
+    }
+    if (fh.frame_size_override_flag && !fh.error_resilient_mode) {
+      this->frameSizeWithRefs(reader);
+    } else {
+      this->frameSize(reader);
+      this->renderSize(reader);
+    }
+    if (!fh.force_integer_mv) {
+      fh.allow_high_precision_mv = reader.readFlag();
+    }
+    // read_interpolation_filter()
+    if (reader.readFlag()) {
+      fh.interpolation_filter = kSwitchable;
+    } else {
+      fh.interpolation_filter = uint8_t(reader.readBits(2));
+    }
+    fh.is_motion_mode_switchable = reader.readFlag();
+    if (!fh.error_resilient_mode && seq.enable_ref_frame_mvs) {
+      fh.use_ref_frame_mvs = reader.readFlag();
+    }
+  }
+  if (!seq.reduced_still_picture_header && !fh.disable_cdf_update) {
+    fh.disable_frame_end_update_cdf = reader.readFlag();
+  }
+  if (fh.primary_ref_frame == kPrimaryRefNone) {
+    this->setupPastIndependence();
+  } else {
+    this->loadPrevious();
+  }
+  if (!this->tileInfo(reader)) {
+    return false;
+  }
+  this->quantizationParams(reader);
+  this->segmentationParams(reader);
+  this->deltaParams(reader);
+  this->computeLossless();
+  this->loopFilterParams(reader);
+  this->cdefParams(reader);
+  this->lrParams(reader);
+  // read_tx_mode(): ONLY_4X4, TX_MODE_LARGEST or TX_MODE_SELECT.
+  if (fh.CodedLossless) {
+    fh.TxMode = 0;
+  } else {
+    fh.TxMode = reader.readFlag() ? 2 : 1;
+  }
+  // frame_reference_mode()
+  if (!fh.FrameIsIntra) {
+    fh.reference_select = reader.readFlag();
+  }
+  this->skipModeParams(reader);
+  if (!fh.FrameIsIntra && !fh.error_resilient_mode &&
+      seq.enable_warped_motion) {
+    fh.allow_warped_motion = reader.readFlag();
+  }
+  fh.reduced_tx_set = reader.readFlag();
+  this->globalMotionParams(reader);
+  this->filmGrainParams(reader);
+  return true;
+}
+
+// 5.9.5
+void Av1HeaderParser::frameSize(BitReader& reader) {
+  const Av1SequenceHeader& seq = this->sequenceHeader_;
+  Av1FrameHeader& fh = this->frameHeader_;
+  if (fh.frame_size_override_flag) {
+    fh.FrameWidth = reader.readBits(seq.frame_width_bits_minus_1 + 1) + 1;
+    fh.FrameHeight = reader.readBits(seq.frame_height_bits_minus_1 + 1) + 1;
+  } else {
+    fh.FrameWidth = seq.max_frame_width_minus_1 + 1u;
+    fh.FrameHeight = seq.max_frame_height_minus_1 + 1u;
+  }
+  this->superresParams(reader);
+  this->computeImageSize();
+}
+
+// 5.9.8
+void Av1HeaderParser::superresParams(BitReader& reader) {
+  Av1FrameHeader& fh = this->frameHeader_;
+  fh.use_superres =
+      this->sequenceHeader_.enable_superres ? reader.readFlag() : false;
+  // SUPERRES_DENOM_MIN + coded_denom, or SUPERRES_NUM.
+  fh.SuperresDenom = fh.use_superres ? uint8_t(reader.readBits(3) + 9) : 8;
+  fh.UpscaledWidth = fh.FrameWidth;
+  fh.FrameWidth =
+      (fh.UpscaledWidth * 8 + (fh.SuperresDenom / 2)) / fh.SuperresDenom;
+}
+
+// 5.9.9
+void Av1HeaderParser::computeImageSize() {
+  Av1FrameHeader& fh = this->frameHeader_;
+  fh.MiCols = 2 * ((fh.FrameWidth + 7) >> 3);
+  fh.MiRows = 2 * ((fh.FrameHeight + 7) >> 3);
+}
+
+// 5.9.6
+void Av1HeaderParser::renderSize(BitReader& reader) {
+  Av1FrameHeader& fh = this->frameHeader_;
+  fh.render_and_frame_size_different = reader.readFlag();
+  if (fh.render_and_frame_size_different) {
+    fh.RenderWidth = reader.readBits(16) + 1;
+    fh.RenderHeight = reader.readBits(16) + 1;
+  } else {
+    fh.RenderWidth = fh.UpscaledWidth;
+    fh.RenderHeight = fh.FrameHeight;
+  }
+}
+
+// 5.9.7
+void Av1HeaderParser::frameSizeWithRefs(BitReader& reader) {
+  Av1FrameHeader& fh = this->frameHeader_;
+  for (int i = 0; i < Av1FrameHeader::kRefsPerFrame; ++i) {
+    // found_ref
+    if (reader.readFlag()) {
+      const RefSlot& slot = this->refs_[fh.ref_frame_idx[i]];
+      fh.UpscaledWidth = slot.UpscaledWidth;
+      fh.FrameWidth = fh.UpscaledWidth;
+      fh.FrameHeight = slot.FrameHeight;
+      fh.RenderWidth = slot.RenderWidth;
+      fh.RenderHeight = slot.RenderHeight;
+      this->superresParams(reader);
+      this->computeImageSize();
+      return;
+    }
+  }
+  this->frameSize(reader);
+  this->renderSize(reader);
+}
+
+// 7.8
+void Av1HeaderParser::setFrameRefs(uint8_t lastFrameIdx, uint8_t goldFrameIdx) {
+  Av1FrameHeader& fh = this->frameHeader_;
+  for (int8_t& idx : fh.ref_frame_idx) {
+    idx = -1;
+  }
+  fh.ref_frame_idx[kLastFrame - kLastFrame] = int8_t(lastFrameIdx);
+  fh.ref_frame_idx[kGoldenFrame - kLastFrame] = int8_t(goldFrameIdx);
+  bool usedFrame[8]{};
+  usedFrame[lastFrameIdx] = true;
+  usedFrame[goldFrameIdx] = true;
+  int curFrameHint = 1 << (this->sequenceHeader_.OrderHintBits - 1);
+  int shiftedOrderHints[8];
+  for (int i = 0; i < 8; ++i) {
+    shiftedOrderHints[i] =
+        curFrameHint + this->relativeDist(this->refs_[i].order_hint,
+                                          fh.order_hint);
+  }
+
+  auto findLatestBackward = [&]() {
+    int ref = -1;
+    int latestOrderHint = 0;
+    for (int i = 0; i < 8; ++i) {
+      int hint = shiftedOrderHints[i];
+      if (!usedFrame[i] && hint >= curFrameHint &&
+          (ref < 0 || hint >= latestOrderHint)) {
+        ref = i;
+        latestOrderHint = hint;
+      }
+    }
+    return ref;
+  };
+  auto findEarliestBackward = [&]() {
+    int ref = -1;
+    int earliestOrderHint = 0;
+    for (int i = 0; i < 8; ++i) {
+      int hint = shiftedOrderHints[i];
+      if (!usedFrame[i] && hint >= curFrameHint &&
+          (ref < 0 || hint < earliestOrderHint)) {
+        ref = i;
+        earliestOrderHint = hint;
+      }
+    }
+    return ref;
+  };
+  auto findLatestForward = [&]() {
+    int ref = -1;
+    int latestOrderHint = 0;
+    for (int i = 0; i < 8; ++i) {
+      int hint = shiftedOrderHints[i];
+      if (!usedFrame[i] && hint < curFrameHint &&
+          (ref < 0 || hint >= latestOrderHint)) {
+        ref = i;
+        latestOrderHint = hint;
+      }
+    }
+    return ref;
+  };
+  auto assign = [&](int refFrame, int ref) {
+    if (ref >= 0) {
+      fh.ref_frame_idx[refFrame - kLastFrame] = int8_t(ref);
+      usedFrame[ref] = true;
+    }
+  };
+
+  assign(kAltrefFrame, findLatestBackward());
+  assign(kBwdrefFrame, findEarliestBackward());
+  assign(kAltref2Frame, findEarliestBackward());
+  const int refFrameList[] = {kLast2Frame, kLast3Frame, kBwdrefFrame,
+                              kAltref2Frame, kAltrefFrame};
+  for (int refFrame : refFrameList) {
+    if (fh.ref_frame_idx[refFrame - kLastFrame] < 0) {
+      assign(refFrame, findLatestForward());
+    }
+  }
+  int ref = -1;
+  int earliestOrderHint = 0;
+  for (int i = 0; i < 8; ++i) {
+    int hint = shiftedOrderHints[i];
+    if (ref < 0 || hint < earliestOrderHint) {
+      ref = i;
+      earliestOrderHint = hint;
+    }
+  }
+  for (int8_t& idx : fh.ref_frame_idx) {
+    if (idx < 0) {
+      idx = int8_t(ref);
+    }
+  }
+}
+
+// 5.9.15
+bool Av1HeaderParser::tileInfo(BitReader& reader) {
+  const Av1SequenceHeader& seq = this->sequenceHeader_;
+  Av1FrameHeader& fh = this->frameHeader_;
+  Av1TileInfo& tile = fh.tile_info;
+  int sbShift = seq.use_128x128_superblock ? 5 : 4;
+  int sbCols = int((fh.MiCols + (1 << sbShift) - 1) >> sbShift);
+  int sbRows = int((fh.MiRows + (1 << sbShift) - 1) >> sbShift);
+  int sbSize = sbShift + 2;
+  int maxTileWidthSb = kMaxTileWidth >> sbSize;
+  int maxTileAreaSb = kMaxTileArea >> (2 * sbSize);
+  int minLog2TileCols = tileLog2(maxTileWidthSb, sbCols);
+  int maxLog2TileCols = tileLog2(1, std::min(sbCols, kMaxTileCols));
+  int maxLog2TileRows = tileLog2(1, std::min(sbRows, kMaxTileRows));
+  int minLog2Tiles =
+      std::max(minLog2TileCols, tileLog2(maxTileAreaSb, sbRows * sbCols));
+
+  tile.uniform_tile_spacing_flag = reader.readFlag();
+  int i = 0;
+  if (tile.uniform_tile_spacing_flag) {
+    int tileColsLog2 = minLog2TileCols;
+    while (tileColsLog2 < maxLog2TileCols && reader.readFlag()) {
+      ++tileColsLog2;
+    }
+    int tileWidthSb = (sbCols + (1 << tileColsLog2) - 1) >> tileColsLog2;
+    for (int startSb = 0; startSb < sbCols; startSb += tileWidthSb) {
+      tile.MiColStarts[i++] = uint16_t(startSb << sbShift);
+    }
+    tile.MiColStarts[i] = uint16_t(fh.MiCols);
+    tile.TileCols = uint8_t(i);
+    tile.TileColsLog2 = uint8_t(tileColsLog2);
+
+    int tileRowsLog2 = std::max(minLog2Tiles - tileColsLog2, 0);
+    while (tileRowsLog2 < maxLog2TileRows && reader.readFlag()) {
+      ++tileRowsLog2;
+    }
+    int tileHeightSb = (sbRows + (1 << tileRowsLog2) - 1) >> tileRowsLog2;
+    i = 0;
+    for (int startSb = 0; startSb < sbRows; startSb += tileHeightSb) {
+      tile.MiRowStarts[i++] = uint16_t(startSb << sbShift);
+    }
+    tile.MiRowStarts[i] = uint16_t(fh.MiRows);
+    tile.TileRows = uint8_t(i);
+    tile.TileRowsLog2 = uint8_t(tileRowsLog2);
+  } else {
+    int widestTileSb = 0;
+    for (int startSb = 0; startSb < sbCols; ++i) {
+      if (i == Av1TileInfo::kMaxTiles || !reader.ok()) {
+        return false;
+      }
+      tile.MiColStarts[i] = uint16_t(startSb << sbShift);
+      int maxWidth = std::min(sbCols - startSb, maxTileWidthSb);
+      int sizeSb = int(reader.readNs(maxWidth)) + 1;
+      widestTileSb = std::max(sizeSb, widestTileSb);
+      startSb += sizeSb;
+    }
+    tile.MiColStarts[i] = uint16_t(fh.MiCols);
+    tile.TileCols = uint8_t(i);
+    tile.TileColsLog2 = uint8_t(tileLog2(1, tile.TileCols));
+
+    if (minLog2Tiles > 0) {
+      maxTileAreaSb = (sbRows * sbCols) >> (minLog2Tiles + 1);
+    } else {
+      maxTileAreaSb = sbRows * sbCols;
+    }
+    int maxTileHeightSb = std::max(maxTileAreaSb / widestTileSb, 1);
+    i = 0;
+    for (int startSb = 0; startSb < sbRows; ++i) {
+      if (i == Av1TileInfo::kMaxTiles || !reader.ok()) {
+        return false;
+      }
+      tile.MiRowStarts[i] = uint16_t(startSb << sbShift);
+      int maxHeight = std::min(sbRows - startSb, maxTileHeightSb);
+      startSb += int(reader.readNs(maxHeight)) + 1;
+    }
+    tile.MiRowStarts[i] = uint16_t(fh.MiRows);
+    tile.TileRows = uint8_t(i);
+    tile.TileRowsLog2 = uint8_t(tileLog2(1, tile.TileRows));
+  }
+  if (tile.TileCols == 0 || tile.TileRows == 0) {
+    return false;
+  }
+  if (tile.TileColsLog2 > 0 || tile.TileRowsLog2 > 0) {
+    tile.context_update_tile_id =
+        reader.readBits(tile.TileRowsLog2 + tile.TileColsLog2);
+    tile.TileSizeBytes = uint8_t(reader.readBits(2) + 1);
+  }
+  return true;
+}
+
+// 5.9.12
+void Av1HeaderParser::quantizationParams(BitReader& reader) {
+  const Av1SequenceHeader& seq = this->sequenceHeader_;
+  Av1FrameHeader& fh = this->frameHeader_;
+  fh.base_q_idx = uint8_t(reader.readBits(8));
+  fh.DeltaQYDc = readDeltaQ(reader);
+  if (!seq.mono_chrome) {
+    fh.diff_uv_delta = seq.separate_uv_delta_q ? reader.readFlag() : false;
+    fh.DeltaQUDc = readDeltaQ(reader);
+    fh.DeltaQUAc = readDeltaQ(reader);
+    if (fh.diff_uv_delta) {
+      fh.DeltaQVDc = readDeltaQ(reader);
+      fh.DeltaQVAc = readDeltaQ(reader);
+    } else {
+      fh.DeltaQVDc = fh.DeltaQUDc;
+      fh.DeltaQVAc = fh.DeltaQUAc;
+    }
+  }
+  fh.using_qmatrix = reader.readFlag();
+  if (fh.using_qmatrix) {
+    fh.qm_y = uint8_t(reader.readBits(4));
+    fh.qm_u = uint8_t(reader.readBits(4));
+    fh.qm_v = seq.separate_uv_delta_q ? uint8_t(reader.readBits(4)) : fh.qm_u;
+  }
+}
+
+// 5.9.14
+void Av1HeaderParser::segmentationParams(BitReader& reader) {
+  Av1FrameHeader& fh = this->frameHeader_;
+  fh.segmentation_enabled = reader.readFlag();
+  if (!fh.segmentation_enabled) {
+    std::fill(fh.FeatureEnabled, fh.FeatureEnabled + 8, 0);
+    std::fill(&fh.FeatureData[0][0], &fh.FeatureData[0][0] + 8 * 8, 0);
+    return;
+  }
+  if (fh.primary_ref_frame == kPrimaryRefNone) {
+    fh.segmentation_update_map = true;
+    fh.segmentation_temporal_update = false;
+    fh.segmentation_update_data = true;
+  } else {
+    fh.segmentation_update_map = reader.readFlag();
+    if (fh.segmentation_update_map) {
+      fh.segmentation_temporal_update = reader.readFlag();
+    }
+    fh.segmentation_update_data = reader.readFlag();
+  }
+  if (!fh.segmentation_update_data) {
+    return;
+  }
+  for (int i = 0; i < Av1FrameHeader::kMaxSegments; ++i) {
+    fh.FeatureEnabled[i] = 0;
+    for (int j = 0; j < Av1FrameHeader::kSegLvlMax; ++j) {
+      int clippedValue = 0;
+      if (reader.readFlag()) {
+        fh.FeatureEnabled[i] |= 1 << j;
+        int bitsToRead = kSegmentationFeatureBits[j];
+        int limit = kSegmentationFeatureMax[j];
+        if (kSegmentationFeatureSigned[j]) {
+          clippedValue =
+              std::min(std::max(reader.readSu(1 + bitsToRead), -limit), limit);
+        } else {
+          clippedValue = std::min(int(reader.readBits(bitsToRead)), limit);
+        }
+      }
+      fh.FeatureData[i][j] = int16_t(clippedValue);
+    }
+  }
+}
+
+// 5.9.17, 5.9.18
+void Av1HeaderParser::deltaParams(BitReader& reader) {
+  Av1FrameHeader& fh = this->frameHeader_;
+  if (fh.base_q_idx > 0) {
+    fh.delta_q_present = reader.readFlag();
+  }
+  if (!fh.delta_q_present) {
+    return;
+  }
+  fh.delta_q_res = uint8_t(reader.readBits(2));
+  if (!fh.allow_intrabc) {
+    fh.delta_lf_present = reader.readFlag();
+  }
+  if (fh.delta_lf_present) {
+    fh.delta_lf_res = uint8_t(reader.readBits(2));
+    fh.delta_lf_multi = reader.readFlag();
+  }
+}
+
+// CodedLossless and AllLossless of 5.9.2, with get_qindex(1, segmentId).
+void Av1HeaderParser::computeLossless() {
+  Av1FrameHeader& fh = this->frameHeader_;
+  bool zeroDeltas = fh.DeltaQYDc == 0 && fh.DeltaQUAc == 0 &&
+                    fh.DeltaQUDc == 0 && fh.DeltaQVAc == 0 &&
+                    fh.DeltaQVDc == 0;
+  fh.CodedLossless = zeroDeltas;
+  for (int segmentId = 0; segmentId < Av1FrameHeader::kMaxSegments && zeroDeltas;
+       ++segmentId) {
+    int qindex = fh.base_q_idx;
+    // SEG_LVL_ALT_Q
+    if (fh.segmentation_enabled && (fh.FeatureEnabled[segmentId] & 1)) {
+      qindex = std::min(std::max(qindex + fh.FeatureData[segmentId][0], 0),
+                        255);
+    }
+    if (qindex != 0) {
+      fh.CodedLossless = false;
+    }
+  }
+  fh.AllLossless = fh.CodedLossless && fh.FrameWidth == fh.UpscaledWidth;
+}
+
+// 5.9.11
+void Av1HeaderParser::loopFilterParams(BitReader& reader) {
+  Av1FrameHeader& fh = this->frameHeader_;
+  if (fh.CodedLossless || fh.allow_intrabc) {
+    fh.loop_filter_level[0] = fh.loop_filter_level[1] = 0;
+    std::copy(kDefaultLoopFilterRefDeltas, kDefaultLoopFilterRefDeltas + 8,
+              fh.loop_filter_ref_deltas);
+    fh.loop_filter_mode_deltas[0] = fh.loop_filter_mode_deltas[1] = 0;
+    return;
+  }
+  fh.loop_filter_level[0] = uint8_t(reader.readBits(6));
+  fh.loop_filter_level[1] = uint8_t(reader.readBits(6));
+  if (!this->sequenceHeader_.mono_chrome &&
+      (fh.loop_filter_level[0] || fh.loop_filter_level[1])) {
+    fh.loop_filter_level[2] = uint8_t(reader.readBits(6));
+    fh.loop_filter_level[3] = uint8_t(reader.readBits(6));
+  }
+  fh.loop_filter_sharpness = uint8_t(reader.readBits(3));
+  fh.loop_filter_delta_enabled = reader.readFlag();
+  if (!fh.loop_filter_delta_enabled) {
+    return;
+  }
+  fh.loop_filter_delta_update = reader.readFlag();
+  if (!fh.loop_filter_delta_update) {
+    return;
+  }
+  for (int8_t& delta : fh.loop_filter_ref_deltas) {
+    if (reader.readFlag()) {
+      delta = int8_t(reader.readSu(7));
+    }
+  }
+  for (int8_t& delta : fh.loop_filter_mode_deltas) {
+    if (reader.readFlag()) {
+      delta = int8_t(reader.readSu(7));
+    }
+  }
+}
+
+// 5.9.19
+void Av1HeaderParser::cdefParams(BitReader& reader) {
+  Av1FrameHeader& fh = this->frameHeader_;
+  if (fh.CodedLossless || fh.allow_intrabc ||
+      !this->sequenceHeader_.enable_cdef) {
+    return;
+  }
+  fh.cdef_damping_minus_3 = uint8_t(reader.readBits(2));
+  fh.cdef_bits = uint8_t(reader.readBits(2));
+  for (int i = 0; i < (1 << fh.cdef_bits); ++i) {
+    fh.cdef_y_pri_strength[i] = uint8_t(reader.readBits(4));
+    fh.cdef_y_sec_strength[i] = uint8_t(reader.readBits(2));
+    if (fh.cdef_y_sec_strength[i] == 3) {
+      ++fh.cdef_y_sec_strength[i];
+    }
+    if (!this->sequenceHeader_.mono_chrome) {
+      fh.cdef_uv_pri_strength[i] = uint8_t(reader.readBits(4));
+      fh.cdef_uv_sec_strength[i] = uint8_t(reader.readBits(2));
+      if (fh.cdef_uv_sec_strength[i] == 3) {
+        ++fh.cdef_uv_sec_strength[i];
+      }
+    }
+  }
+}
+
+// 5.9.20
+void Av1HeaderParser::lrParams(BitReader& reader) {
+  const Av1SequenceHeader& seq = this->sequenceHeader_;
+  Av1FrameHeader& fh = this->frameHeader_;
+  if (fh.AllLossless || fh.allow_intrabc || !seq.enable_restoration) {
+    return;
+  }
+  bool usesChromaLr = false;
+  int numPlanes = seq.mono_chrome ? 1 : 3;
+  for (int i = 0; i < numPlanes; ++i) {
+    fh.FrameRestorationType[i] = kRemapLrType[reader.readBits(2)];
+    if (fh.FrameRestorationType[i] != 0) {
+      fh.UsesLr = true;
+      usesChromaLr |= i > 0;
+    }
+  }
+  if (!fh.UsesLr) {
+    return;
+  }
+  int lr_unit_shift = reader.readBits(1);
+  if (seq.use_128x128_superblock) {
+    ++lr_unit_shift;
+  } else if (lr_unit_shift) {
+    lr_unit_shift += reader.readBits(1);
+  }
+  // RESTORATION_TILESIZE_MAX
+  fh.LoopRestorationSize[0] = uint16_t(256 >> (2 - lr_unit_shift));
+  int lr_uv_shift = 0;
+  if (seq.subsampling_x && seq.subsampling_y && usesChromaLr) {
+    lr_uv_shift = reader.readBits(1);
+  }
+  fh.LoopRestorationSize[1] = fh.LoopRestorationSize[0] >> lr_uv_shift;
+  fh.LoopRestorationSize[2] = fh.LoopRestorationSize[0] >> lr_uv_shift;
+}
+
+// 5.9.22
+void Av1HeaderParser::skipModeParams(BitReader& reader) {
+  Av1FrameHeader& fh = this->frameHeader_;
+  if (fh.FrameIsIntra || !fh.reference_select ||
+      !this->sequenceHeader_.enable_order_hint) {
+    return;
+  }
+  int forwardIdx = -1;
+  int backwardIdx = -1;
+  uint32_t forwardHint = 0;
+  uint32_t backwardHint = 0;
+  for (int i = 0; i < Av1FrameHeader::kRefsPerFrame; ++i) {
+    uint32_t refHint = this->refs_[fh.ref_frame_idx[i]].order_hint;
+    int dist = this->relativeDist(refHint, fh.order_hint);
+    if (dist < 0) {
+      if (forwardIdx < 0 || this->relativeDist(refHint, forwardHint) > 0) {
+        forwardIdx = i;
+        forwardHint = refHint;
+      }
+    } else if (dist > 0) {
+      if (backwardIdx < 0 || this->relativeDist(refHint, backwardHint) < 0) {
+        backwardIdx = i;
+        backwardHint = refHint;
+      }
+    }
+  }
+  bool skipModeAllowed = false;
+  if (forwardIdx < 0) {
+    skipModeAllowed = false;
+  } else if (backwardIdx >= 0) {
+    skipModeAllowed = true;
+  } else {
+    int secondForwardIdx = -1;
+    uint32_t secondForwardHint = 0;
+    for (int i = 0; i < Av1FrameHeader::kRefsPerFrame; ++i) {
+      uint32_t refHint = this->refs_[fh.ref_frame_idx[i]].order_hint;
+      if (this->relativeDist(refHint, forwardHint) < 0 &&
+          (secondForwardIdx < 0 ||
+           this->relativeDist(refHint, secondForwardHint) > 0)) {
+        secondForwardIdx = i;
+        secondForwardHint = refHint;
+      }
+    }
+    skipModeAllowed = secondForwardIdx >= 0;
+  }
+  if (skipModeAllowed) {
+    fh.skip_mode_present = reader.readFlag();
+  }
+}
+
+// 5.9.23
+void Av1HeaderParser::globalMotionParams(BitReader& reader) {
+  Av1FrameHeader& fh = this->frameHeader_;
+  setDefaultGmParams(fh.gm_params);
+  if (fh.FrameIsIntra) {
+    return;
+  }
+  for (int ref = kLastFrame; ref <= kAltrefFrame; ++ref) {
+    uint8_t type = kIdentity;
+    // is_global
+    if (reader.readFlag()) {
+      // is_rot_zoom, is_translation
+      if (reader.readFlag()) {
+        type = kRotzoom;
+      } else {
+        type = reader.readFlag() ? kTranslation : kAffine;
+      }
+    }
+    fh.GmType[ref] = type;
+    if (type >= kRotzoom) {
+      this->readGlobalParam(reader, type, ref, 2);
+      this->readGlobalParam(reader, type, ref, 3);
+      if (type == kAffine) {
+        this->readGlobalParam(reader, type, ref, 4);
+        this->readGlobalParam(reader, type, ref, 5);
+      } else {
+        fh.gm_params[ref][4] = -fh.gm_params[ref][3];
+        fh.gm_params[ref][5] = fh.gm_params[ref][2];
+      }
+    }
+    if (type >= kTranslation) {
+      this->readGlobalParam(reader, type, ref, 0);
+      this->readGlobalParam(reader, type, ref, 1);
+    }
+  }
+}
+
+// 5.9.24
+void Av1HeaderParser::readGlobalParam(BitReader& reader,
+                                      uint8_t type,
+                                      int ref,
+                                      int idx) {
+  Av1FrameHeader& fh = this->frameHeader_;
+  int absBits = kGmAbsAlphaBits;
+  int precBits = kGmAlphaPrecBits;
+  if (idx < 2) {
+    if (type == kTranslation) {
+      absBits = kGmAbsTransOnlyBits - !fh.allow_high_precision_mv;
+      precBits = kGmTransOnlyPrecBits - !fh.allow_high_precision_mv;
+    } else {
+      absBits = kGmAbsTransBits;
+      precBits = kGmTransPrecBits;
+    }
+  }
+  int precDiff = kWarpedModelPrecBits - precBits;
+  int round = (idx % 3) == 2 ? (1 << kWarpedModelPrecBits) : 0;
+  int sub = (idx % 3) == 2 ? (1 << precBits) : 0;
+  int mx = 1 << absBits;
+  int r = (this->prevGmParams_[ref][idx] >> precDiff) - sub;
+  fh.gm_params[ref][idx] =
+      (decodeSignedSubexpWithRef(reader, -mx, mx + 1, r) * (1 << precDiff)) +
+      round;
+}
+
+// 5.9.30
+void Av1HeaderParser::filmGrainParams(BitReader& reader) {
+  const Av1SequenceHeader& seq = this->sequenceHeader_;
+  Av1FrameHeader& fh = this->frameHeader_;
+  Av1FilmGrainParams& grain = fh.film_grain_params;
+  grain = Av1FilmGrainParams();
+  if (!seq.film_grain_params_present ||
+      (!fh.show_frame && !fh.showable_frame)) {
+    return;
+  }
+  grain.apply_grain = reader.readFlag();
+  if (!grain.apply_grain) {
+    return;
+  }
+  grain.grain_seed = uint16_t(reader.readBits(16));
+  grain.update_grain =
+      fh.frame_type == kAv1InterFrame ? reader.readFlag() : true;
+  if (!grain.update_grain) {
+    grain.film_grain_params_ref_idx = uint8_t(reader.readBits(3));
+    uint16_t tempGrainSeed = grain.grain_seed;
+    // load_grain_params()
+    grain = this->refs_[grain.film_grain_params_ref_idx].film_grain_params;
+    grain.grain_seed = tempGrainSeed;
+    return;
+  }
+  grain.num_y_points = uint8_t(reader.readBits(4));
+  // point_y_value, point_y_scaling
+  reader.skipBits(16 * grain.num_y_points);
+  grain.chroma_scaling_from_luma = seq.mono_chrome ? false : reader.readFlag();
+  if (!seq.mono_chrome && !grain.chroma_scaling_from_luma &&
+      !(seq.subsampling_x == 1 && seq.subsampling_y == 1 &&
+        grain.num_y_points == 0)) {
+    grain.num_cb_points = uint8_t(reader.readBits(4));
+    reader.skipBits(16 * grain.num_cb_points);
+    grain.num_cr_points = uint8_t(reader.readBits(4));
+    reader.skipBits(16 * grain.num_cr_points);
+  }
+  grain.grain_scaling_minus_8 = uint8_t(reader.readBits(2));
+  grain.ar_coeff_lag = uint8_t(reader.readBits(2));
+  int numPosLuma = 2 * grain.ar_coeff_lag * (grain.ar_coeff_lag + 1);
+  int numPosChroma = numPosLuma;
+  if (grain.num_y_points) {
+    numPosChroma = numPosLuma + 1;
+    // ar_coeffs_y_plus_128
+    reader.skipBits(8 * numPosLuma);
+  }
+  if (grain.chroma_scaling_from_luma || grain.num_cb_points) {
+    reader.skipBits(8 * numPosChroma);
+  }
+  if (grain.chroma_scaling_from_luma || grain.num_cr_points) {
+    reader.skipBits(8 * numPosChroma);
+  }
+  grain.ar_coeff_shift_minus_6 = uint8_t(reader.readBits(2));
+  grain.grain_scale_shift = uint8_t(reader.readBits(2));
+  // cb_mult, cb_luma_mult, cb_offset and the same for cr.
+  if (grain.num_cb_points) {
+    reader.skipBits(25);
+  }
+  if (grain.num_cr_points) {
+    reader.skipBits(25);
+  }
+  grain.overlap_flag = reader.readFlag();
+  grain.clip_to_restricted_range = reader.readFlag();
+}
+
+// 7.20 setup_past_independence(), the parts the header syntax depends on.
+void Av1HeaderParser::setupPastIndependence() {
+  Av1FrameHeader& fh = this->frameHeader_;
+  std::fill(fh.FeatureEnabled, fh.FeatureEnabled + 8, 0);
+  std::fill(&fh.FeatureData[0][0], &fh.FeatureData[0][0] + 8 * 8, 0);
+  setDefaultGmParams(this->prevGmParams_);
+  fh.loop_filter_delta_enabled = true;
+  std::copy(kDefaultLoopFilterRefDeltas, kDefaultLoopFilterRefDeltas + 8,
+            fh.loop_filter_ref_deltas);
+  fh.loop_filter_mode_deltas[0] = fh.loop_filter_mode_deltas[1] = 0;
+}
+
+// 7.20 load_previous()
+void Av1HeaderParser::loadPrevious() {
+  Av1FrameHeader& fh = this->frameHeader_;
+  const RefSlot& slot =
+      this->refs_[fh.ref_frame_idx[fh.primary_ref_frame]];
+  std::copy(&slot.gm_params[0][0], &slot.gm_params[0][0] + 8 * 6,
+            &this->prevGmParams_[0][0]);
+  std::copy(slot.loop_filter_ref_deltas, slot.loop_filter_ref_deltas + 8,
+            fh.loop_filter_ref_deltas);
+  std::copy(slot.loop_filter_mode_deltas, slot.loop_filter_mode_deltas + 2,
+            fh.loop_filter_mode_deltas);
+  std::copy(slot.FeatureEnabled, slot.FeatureEnabled + 8, fh.FeatureEnabled);
+  std::copy(&slot.FeatureData[0][0], &slot.FeatureData[0][0] + 8 * 8,
+            &fh.FeatureData[0][0]);
+}
+
+// 7.20 reference frame update process.
+void Av1HeaderParser::referenceFrameUpdate() {
+  const Av1FrameHeader& fh = this->frameHeader_;
+  for (int i = 0; i < 8; ++i) {
+    if (!((fh.refresh_frame_flags >> i) & 1)) {
+      continue;
+    }
+    RefSlot& slot = this->refs_[i];
+    slot.valid = true;
+    slot.frame_type = fh.frame_type;
+    slot.frame_id = fh.current_frame_id;
+    slot.order_hint = fh.order_hint;
+    slot.UpscaledWidth = fh.UpscaledWidth;
+    slot.FrameWidth = fh.FrameWidth;
+    slot.FrameHeight = fh.FrameHeight;
+    slot.RenderWidth = fh.RenderWidth;
+    slot.RenderHeight = fh.RenderHeight;
+    std::copy(&fh.gm_params[0][0], &fh.gm_params[0][0] + 8 * 6,
+              &slot.gm_params[0][0]);
+    std::copy(fh.loop_filter_ref_deltas, fh.loop_filter_ref_deltas + 8,
+              slot.loop_filter_ref_deltas);
+    std::copy(fh.loop_filter_mode_deltas, fh.loop_filter_mode_deltas + 2,
+              slot.loop_filter_mode_deltas);
+    std::copy(fh.FeatureEnabled, fh.FeatureEnabled + 8, slot.FeatureEnabled);
+    std::copy(&fh.FeatureData[0][0], &fh.FeatureData[0][0] + 8 * 8,
+              &slot.FeatureData[0][0]);
+    slot.film_grain_params = fh.film_grain_params;
+  }
+}
+
+// 5.9.27 get_relative_dist()
+int Av1HeaderParser::relativeDist(uint32_t a, uint32_t b) const {
+  const Av1SequenceHeader& seq = this->sequenceHeader_;
+  if (!seq.enable_order_hint) {
+    return 0;
+  }
+  int diff = int(a) - int(b);
+  int m = 1 << (seq.OrderHintBits - 1);
+  return (diff & (m - 1)) - (diff & m);
+}
+
+// 5.11.1
+bool Av1HeaderParser::parseTileGroup(const uint8_t* data,
+                                     size_t size,
+                                     Av1TileGroup* group) {
+  const Av1TileInfo& tile = this->frameHeader_.tile_info;
+  BitReader reader(data, size);
+  *group = Av1TileGroup();
+  group->NumTiles = uint16_t(tile.TileCols * tile.TileRows);
+  if (group->NumTiles > 1) {
+    group->tile_start_and_end_present_flag = reader.readFlag();
+  }
+  if (group->NumTiles == 1 || !group->tile_start_and_end_present_flag) {
+    group->tg_end = uint16_t(group->NumTiles - 1);
+  } else {
+    int tileBits = tile.TileColsLog2 + tile.TileRowsLog2;
+    group->tg_start = uint16_t(reader.readBits(tileBits));
+    group->tg_end = uint16_t(reader.readBits(tileBits));
+  }
+  reader.byteAlign();
+  group->headerBytes = uint32_t(reader.bitOffset() / 8);
+  if (!reader.ok() || !this->seenFrameHeader_) {
+    return false;
+  }
+
+  // Only the tile_size_minus_1 fields are read: the reader is not walked
+  // over the tile data.
+  const uint8_t* ptr = data + group->headerBytes;
+  size_t sz = size - group->headerBytes;
+  for (int tileNum = group->tg_start; tileNum <= group->tg_end; ++tileNum) {
+    uint32_t tileSize;
+    if (tileNum == group->tg_end) {
+      tileSize = uint32_t(sz);
+    } else {
+      if (sz < tile.TileSizeBytes) {
+        group->truncated = true;
+        break;
+      }
+      BitReader le(ptr, tile.TileSizeBytes);
+      tileSize = le.readLe(tile.TileSizeBytes) + 1;
+      if (tileSize > sz - tile.TileSizeBytes) {
+        group->truncated = true;
+        break;
+      }
+      group->tileSizeBytes += tile.TileSizeBytes;
+      ptr += tile.TileSizeBytes + tileSize;
+      sz -= tile.TileSizeBytes;
+    }
+    int index = tileNum - group->tg_start;
+    if (index < Av1TileGroup::kMaxTileSizes) {
+      group->tileSize[index] = tileSize;
+    }
+    group->tileDataBytes += tileSize;
+    sz -= tileSize;
+  }
+  if (group->tg_end == group->NumTiles - 1) {
+    // The last tile group of the frame.
+    this->seenFrameHeader_ = false;
+  }
+  return true;
+}
+
+// 5.8.1
+bool Av1HeaderParser::parseMetadata(const uint8_t* data,
+                                    size_t size,
+                                    Av1Metadata* metadata) {
+  BitReader reader(data, size);
+  metadata->metadata_type = reader.readLeb128();
+  switch (metadata->metadata_type) {
+    case kAv1MetadataHdrCll:
+      metadata->max_cll = uint16_t(reader.readBits(16));
+      metadata->max_fall = uint16_t(reader.readBits(16));
+      break;
+    case kAv1MetadataHdrMdcv:
+      for (int i = 0; i < 3; ++i) {
+        metadata->primary_chromaticity_x[i] = uint16_t(reader.readBits(16));
+        metadata->primary_chromaticity_y[i] = uint16_t(reader.readBits(16));
+      }
+      metadata->white_point_chromaticity_x = uint16_t(reader.readBits(16));
+      metadata->white_point_chromaticity_y = uint16_t(reader.readBits(16));
+      metadata->luminance_max = reader.readBits(32);
+      metadata->luminance_min = reader.readBits(32);
+      break;
+    case kAv1MetadataScalability:
+      metadata->scalability_mode_idc = uint8_t(reader.readBits(8));
+      if (metadata->scalability_mode_idc == kAv1ScalabilitySs) {
+        // 5.8.6 scalability_structure()
+        metadata->spatial_layers_cnt_minus_1 = uint8_t(reader.readBits(2));
+        metadata->spatial_layer_dimensions_present_flag = reader.readFlag();
+        metadata->spatial_layer_description_present_flag = reader.readFlag();
+        metadata->temporal_group_description_present_flag = reader.readFlag();
+        reader.skipBits(3);
+        for (int i = 0; i <= metadata->spatial_layers_cnt_minus_1; ++i) {
+          if (metadata->spatial_layer_dimensions_present_flag) {
+            metadata->spatial_layer_max_width[i] =
+                uint16_t(reader.readBits(16));
+            metadata->spatial_layer_max_height[i] =
+                uint16_t(reader.readBits(16));
+          }
+          if (metadata->spatial_layer_description_present_flag) {
+            metadata->spatial_layer_ref_id[i] = uint8_t(reader.readBits(8));
+          }
+        }
+        if (metadata->temporal_group_description_present_flag) {
+          metadata->temporal_group_size = uint8_t(reader.readBits(8));
+          for (int i = 0; i < metadata->temporal_group_size; ++i) {
+            auto& entry = metadata->temporal_group[i];
+            entry.temporal_group_temporal_id = uint8_t(reader.readBits(3));
+            entry.temporal_group_temporal_switching_up_point_flag =
+                reader.readFlag();
+            entry.temporal_group_spatial_switching_up_point_flag =
+                reader.readFlag();
+            entry.temporal_group_ref_cnt = uint8_t(reader.readBits(3));
+            for (int j = 0; j < entry.temporal_group_ref_cnt; ++j) {
+              entry.temporal_group_ref_pic_diff[j] =
+                  uint8_t(reader.readBits(8));
+            }
+          }
+        }
+      }
+      break;
+    case kAv1MetadataItutT35: {
+      metadata->itu_t_t35_country_code = uint8_t(reader.readBits(8));
+      if (metadata->itu_t_t35_country_code == 0xff) {
+        metadata->itu_t_t35_country_code_extension_byte =
+            uint8_t(reader.readBits(8));
+      }
+      size_t offset = reader.bitOffset() / 8;
+      // The payload runs up to the trailing bits: the last non-zero byte.
+      size_t end = size;
+      while (end > offset && data[end - 1] == 0) {
+        --end;
+      }
+      if (end > offset) {
+        --end;
+      }
+      metadata->itu_t_t35_payload_bytes = uint32_t(end - offset);
+      if (end - offset >= 2) {
+        metadata->itu_t_t35_terminal_provider_code =
+            uint16_t(reader.readBits(16));
+      }
+      break;
+    }
+    case kAv1MetadataTimecode:
+      metadata->counting_type = uint8_t(reader.readBits(5));
+      metadata->full_timestamp_flag = reader.readFlag();
+      metadata->discontinuity_flag = reader.readFlag();
+      metadata->cnt_dropped_flag = reader.readFlag();
+      metadata->n_frames = uint16_t(reader.readBits(9));
+      if (metadata->full_timestamp_flag) {
+        metadata->seconds_value = uint8_t(reader.readBits(6));
+        metadata->minutes_value = uint8_t(reader.readBits(6));
+        metadata->hours_value = uint8_t(reader.readBits(5));
+      } else {
+        metadata->seconds_flag = reader.readFlag();
+        if (metadata->seconds_flag) {
+          metadata->seconds_value = uint8_t(reader.readBits(6));
+          metadata->minutes_flag = reader.readFlag();
+          if (metadata->minutes_flag) {
+            metadata->minutes_value = uint8_t(reader.readBits(6));
+            metadata->hours_flag = reader.readFlag();
+            if (metadata->hours_flag) {
+              metadata->hours_value = uint8_t(reader.readBits(5));
+            }
+          }
+        }
+      }
+      metadata->time_offset_length = uint8_t(reader.readBits(5));
+      metadata->time_offset_value =
+          reader.readBits(metadata->time_offset_length);
+      break;
+  }
+  return reader.ok();
+}
+
+// 5.12.1
+bool Av1HeaderParser::parseTileList(const uint8_t* data,
+                                    size_t size,
+                                    Av1TileList* list) {
+  BitReader reader(data, size);
+  *list = Av1TileList();
+  list->output_frame_width_in_tiles_minus_1 = uint8_t(reader.readBits(8));
+  list->output_frame_height_in_tiles_minus_1 = uint8_t(reader.readBits(8));
+  list->tile_count_minus_1 = uint16_t(reader.readBits(16));
+  size_t offset = 4;
+  for (uint32_t tile = 0; tile <= list->tile_count_minus_1; ++tile) {
+    // 5.12.2 tile_list_entry(): anchor_frame_idx, anchor_tile_row,
+    // anchor_tile_col, tile_data_size_minus_1.
+    if (offset + 5 > size) {
+      return false;
+    }
+    uint32_t tileDataSize = (uint32_t(data[offset + 3]) << 8 |
+                             data[offset + 4]) + 1;
+    offset += 5;
+    if (tileDataSize > size - offset) {
+      return false;
+    }
+    offset += tileDataSize;
+    ++list->entries;
+    list->tileDataBytes += tileDataSize;
+  }
+  return reader.ok();
+}
+}  // namespace chai
@@ -0,0 +1,477 @@
+#ifndef CHAI_AV1_HEADER_PARSER_H
+#define CHAI_AV1_HEADER_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "BitReader.h"
+
+namespace chai {
+// Syntax elements keep the names of the AV1 specification
+// (https://aomediacodec.github.io/av1-spec/av1-spec.pdf), section numbers
+// refer to it.
+enum Av1ObuType : uint8_t {
+  kAv1ObuSequenceHeader = 1,
+  kAv1ObuTemporalDelimiter = 2,
+  kAv1ObuFrameHeader = 3,
+  kAv1ObuTileGroup = 4,
+  kAv1ObuMetadata = 5,
+  kAv1ObuFrame = 6,
+  kAv1ObuRedundantFrameHeader = 7,
+  kAv1ObuTileList = 8,
+  kAv1ObuPadding = 15,
+};
+
+enum Av1FrameType : uint8_t {
+  kAv1KeyFrame = 0,
+  kAv1InterFrame = 1,
+  kAv1IntraOnlyFrame = 2,
+  kAv1SwitchFrame = 3,
+};
+
+// 6.7.1
+enum Av1MetadataType : uint8_t {
+  kAv1MetadataHdrCll = 1,
+  kAv1MetadataHdrMdcv = 2,
+  kAv1MetadataScalability = 3,
+  kAv1MetadataItutT35 = 4,
+  kAv1MetadataTimecode = 5,
+};
+
+// 6.7.5 scalability_mode_idc followed by a scalability_structure().
+const uint8_t kAv1ScalabilitySs{14};
+
+const char* av1ObuTypeName(uint8_t type);
+const char* av1FrameTypeName(uint8_t type);
+const char* av1MetadataTypeName(uint64_t type);
+
+// 5.3.2
+struct Av1ObuHeader {
+  uint8_t obu_type{0};
+  bool obu_extension_flag{false};
+  bool obu_has_size_field{false};
+  uint8_t temporal_id{0};
+  uint8_t spatial_id{0};
+  // obu_size, or what follows the header when there is no size field.
+  uint64_t obu_size{0};
+  // Bytes of obu_header() and obu_size: the payload starts there.
+  uint8_t size{0};
+};
+
+// 5.5
+struct Av1SequenceHeader {
+  static const int kMaxOperatingPoints{32};
+
+  uint8_t seq_profile{0};
+  bool still_picture{false};
+  bool reduced_still_picture_header{false};
+
+  bool timing_info_present_flag{false};
+  uint32_t num_units_in_display_tick{0};
+  uint32_t time_scale{0};
+  bool equal_picture_interval{false};
+  uint32_t num_ticks_per_picture_minus_1{0};
+
+  bool decoder_model_info_present_flag{false};
+  uint8_t buffer_delay_length_minus_1{0};
+  uint32_t num_units_in_decoding_tick{0};
+  uint8_t buffer_removal_time_length_minus_1{0};
+  uint8_t frame_presentation_time_length_minus_1{0};
+
+  bool initial_display_delay_present_flag{false};
+  uint8_t operating_points_cnt_minus_1{0};
+  struct OperatingPoint {
+    uint16_t operating_point_idc{0};
+    uint8_t seq_level_idx{0};
+    uint8_t seq_tier{0};
+    bool decoder_model_present_for_this_op{false};
+    uint32_t decoder_buffer_delay{0};
+    uint32_t encoder_buffer_delay{0};
+    bool low_delay_mode_flag{false};
+    bool initial_display_delay_present_for_this_op{false};
+    uint8_t initial_display_delay_minus_1{0};
+  } operating_points[kMaxOperatingPoints];
+
+  uint8_t frame_width_bits_minus_1{0};
+  uint8_t frame_height_bits_minus_1{0};
+  uint16_t max_frame_width_minus_1{0};
+  uint16_t max_frame_height_minus_1{0};
+  bool frame_id_numbers_present_flag{false};
+  uint8_t delta_frame_id_length_minus_2{0};
+  uint8_t additional_frame_id_length_minus_1{0};
+  bool use_128x128_superblock{false};
+  bool enable_filter_intra{false};
+  bool enable_intra_edge_filter{false};
+  bool enable_interintra_compound{false};
+  bool enable_masked_compound{false};
+  bool enable_warped_motion{false};
+  bool enable_dual_filter{false};
+  bool enable_order_hint{false};
+  bool enable_jnt_comp{false};
+  bool enable_ref_frame_mvs{false};
+  // 0, 1, or 2 for SELECT_SCREEN_CONTENT_TOOLS / SELECT_INTEGER_MV.
+  uint8_t seq_force_screen_content_tools{0};
+  uint8_t seq_force_integer_mv{0};
+  uint8_t OrderHintBits{0};
+  bool enable_superres{false};
+  bool enable_cdef{false};
+  bool enable_restoration{false};
+
+  // 5.5.2 color_config()
+  uint8_t BitDepth{8};
+  bool mono_chrome{false};
+  bool color_description_present_flag{false};
+  uint8_t color_primaries{2};
+  uint8_t transfer_characteristics{2};
+  uint8_t matrix_coefficients{2};
+  bool color_range{false};
+  uint8_t subsampling_x{1};
+  uint8_t subsampling_y{1};
+  uint8_t chroma_sample_position{0};
+  bool separate_uv_delta_q{false};
+
+  bool film_grain_params_present{false};
+};
+
+// 5.9.15
+struct Av1TileInfo {
+  static const int kMaxTiles{64};
+
+  bool uniform_tile_spacing_flag{false};
+  uint8_t TileColsLog2{0};
+  uint8_t TileRowsLog2{0};
+  uint8_t TileCols{1};
+  uint8_t TileRows{1};
+  uint16_t MiColStarts[kMaxTiles + 1]{};
+  uint16_t MiRowStarts[kMaxTiles + 1]{};
+  uint32_t context_update_tile_id{0};
+  uint8_t TileSizeBytes{0};
+};
+
+// 5.9.30, only what the header display needs.
+struct Av1FilmGrainParams {
+  bool apply_grain{false};
+  uint16_t grain_seed{0};
+  bool update_grain{false};
+  uint8_t film_grain_params_ref_idx{0};
+  uint8_t num_y_points{0};
+  bool chroma_scaling_from_luma{false};
+  uint8_t num_cb_points{0};
+  uint8_t num_cr_points{0};
+  uint8_t grain_scaling_minus_8{0};
+  uint8_t ar_coeff_lag{0};
+  uint8_t ar_coeff_shift_minus_6{0};
+  uint8_t grain_scale_shift{0};
+  bool overlap_flag{false};
+  bool clip_to_restricted_range{false};
+};
+
+// 5.9.2 uncompressed_header(), with the values the spec derives from it.
+struct Av1FrameHeader {
+  static const int kRefsPerFrame{7};
+  static const int kTotalRefsPerFrame{8};
+  static const int kMaxSegments{8};
+  static const int kSegLvlMax{8};
+
+  bool show_existing_frame{false};
+  uint8_t frame_to_show_map_idx{0};
+  uint32_t frame_presentation_time{0};
+  uint32_t display_frame_id{0};
+  uint8_t frame_type{kAv1KeyFrame};
+  bool FrameIsIntra{true};
+  bool show_frame{true};
+  bool showable_frame{false};
+  bool error_resilient_mode{false};
+  bool disable_cdf_update{false};
+  bool allow_screen_content_tools{false};
+  bool force_integer_mv{false};
+  uint32_t current_frame_id{0};
+  bool frame_size_override_flag{false};
+  uint32_t order_hint{0};
+  uint8_t primary_ref_frame{7};
+  bool buffer_removal_time_present_flag{false};
+  uint32_t buffer_removal_time[Av1SequenceHeader::kMaxOperatingPoints]{};
+  uint8_t refresh_frame_flags{0};
+  bool frame_refs_short_signaling{false};
+  int8_t ref_frame_idx[kRefsPerFrame]{};
+
+  uint32_t FrameWidth{0};
+  uint32_t FrameHeight{0};
+  uint32_t UpscaledWidth{0};
+  uint32_t RenderWidth{0};
+  uint32_t RenderHeight{0};
+  uint32_t MiCols{0};
+  uint32_t MiRows{0};
+  bool use_superres{false};
+  uint8_t SuperresDenom{8};
+  bool render_and_frame_size_different{false};
+
+  bool allow_intrabc{false};
+  bool allow_high_precision_mv{false};
+  // 4 is SWITCHABLE.
+  uint8_t interpolation_filter{0};
+  bool is_motion_mode_switchable{false};
+  bool use_ref_frame_mvs{false};
+  bool disable_frame_end_update_cdf{true};
+
+  Av1TileInfo tile_info;
+
+  // 5.9.12
+  uint8_t base_q_idx{0};
+  int8_t DeltaQYDc{0};
+  int8_t DeltaQUDc{0};
+  int8_t DeltaQUAc{0};
+  int8_t DeltaQVDc{0};
+  int8_t DeltaQVAc{0};
+  bool diff_uv_delta{false};
+  bool using_qmatrix{false};
+  uint8_t qm_y{0};
+  uint8_t qm_u{0};
+  uint8_t qm_v{0};
+
+  // 5.9.14
+  bool segmentation_enabled{false};
+  bool segmentation_update_map{false};
+  bool segmentation_temporal_update{false};
+  bool segmentation_update_data{false};
+  // Bit j of FeatureEnabled[i] is feature j of segment i.
+  uint8_t FeatureEnabled[kMaxSegments]{};
+  int16_t FeatureData[kMaxSegments][kSegLvlMax]{};
+
+  // 5.9.17, 5.9.18
+  bool delta_q_present{false};
+  uint8_t delta_q_res{0};
+  bool delta_lf_present{false};
+  uint8_t delta_lf_res{0};
+  bool delta_lf_multi{false};
+
+  bool CodedLossless{false};
+  bool AllLossless{false};
+
+  // 5.9.11
+  uint8_t loop_filter_level[4]{};
+  uint8_t loop_filter_sharpness{0};
+  bool loop_filter_delta_enabled{false};
+  bool loop_filter_delta_update{false};
+  int8_t loop_filter_ref_deltas[kTotalRefsPerFrame]{};
+  int8_t loop_filter_mode_deltas[2]{};
+
+  // 5.9.19
+  uint8_t cdef_damping_minus_3{0};
+  uint8_t cdef_bits{0};
+  uint8_t cdef_y_pri_strength[8]{};
+  uint8_t cdef_y_sec_strength[8]{};
+  uint8_t cdef_uv_pri_strength[8]{};
+  uint8_t cdef_uv_sec_strength[8]{};
+
+  // 5.9.20: RESTORE_NONE 0, WIENER 1, SGRPROJ 2, SWITCHABLE 3.
+  uint8_t FrameRestorationType[3]{};
+  bool UsesLr{false};
+  uint16_t LoopRestorationSize[3]{};
+
+  // 5.9.21: ONLY_4X4 0, TX_MODE_LARGEST 1, TX_MODE_SELECT 2.
+  uint8_t TxMode{0};
+  bool reference_select{false};
+  bool skip_mode_present{false};
+  bool allow_warped_motion{false};
+  bool reduced_tx_set{false};
+
+  // 5.9.24: IDENTITY 0, TRANSLATION 1, ROTZOOM 2, AFFINE 3. Indexed by
+  // reference frame, LAST_FRAME (1) to ALTREF_FRAME (7).
+  uint8_t GmType[kTotalRefsPerFrame]{};
+  int32_t gm_params[kTotalRefsPerFrame][6]{};
+
+  Av1FilmGrainParams film_grain_params;
+
+  // Bits of the uncompressed header.
+  uint32_t headerBits{0};
+};
+
+// 5.11.1, the tile group header and the size of each tile.
+struct Av1TileGroup {
+  // Tiles whose size is kept; the byte counts cover all of them.
+  static const int kMaxTileSizes{64};
+
+  bool tile_start_and_end_present_flag{false};
+  uint16_t tg_start{0};
+  uint16_t tg_end{0};
+  uint16_t NumTiles{0};
+  // Header bytes, up to the first tile.
+  uint32_t headerBytes{0};
+  // tile_size_minus_1 fields, TileSizeBytes each but for the last tile.
+  uint32_t tileSizeBytes{0};
+  uint32_t tileDataBytes{0};
+  uint32_t tileSize[kMaxTileSizes]{};
+  // A tile size ran past the end of the OBU.
+  bool truncated{false};
+};
+
+// 5.8, metadata_obu().
+struct Av1Metadata {
+  static const int kMaxSpatialLayers{4};
+  static const int kMaxTemporalGroupSize{255};
+  static const int kMaxRefPicDiffs{7};
+
+  uint64_t metadata_type{0};
+
+  // 5.8.3 metadata_hdr_cll()
+  uint16_t max_cll{0};
+  uint16_t max_fall{0};
+
+  // 5.8.4 metadata_hdr_mdcv()
+  uint16_t primary_chromaticity_x[3]{};
+  uint16_t primary_chromaticity_y[3]{};
+  uint16_t white_point_chromaticity_x{0};
+  uint16_t white_point_chromaticity_y{0};
+  uint32_t luminance_max{0};
+  uint32_t luminance_min{0};
+
+  // 5.8.5 metadata_scalability()
+  uint8_t scalability_mode_idc{0};
+  // 5.8.6 scalability_structure(), for SCALABILITY_SS.
+  uint8_t spatial_layers_cnt_minus_1{0};
+  bool spatial_layer_dimensions_present_flag{false};
+  bool spatial_layer_description_present_flag{false};
+  bool temporal_group_description_present_flag{false};
+  uint16_t spatial_layer_max_width[kMaxSpatialLayers]{};
+  uint16_t spatial_layer_max_height[kMaxSpatialLayers]{};
+  uint8_t spatial_layer_ref_id[kMaxSpatialLayers]{};
+  uint8_t temporal_group_size{0};
+  struct TemporalGroupEntry {
+    uint8_t temporal_group_temporal_id{0};
+    bool temporal_group_temporal_switching_up_point_flag{false};
+    bool temporal_group_spatial_switching_up_point_flag{false};
+    uint8_t temporal_group_ref_cnt{0};
+    uint8_t temporal_group_ref_pic_diff[kMaxRefPicDiffs]{};
+  } temporal_group[kMaxTemporalGroupSize];
+
+  // 5.8.2 metadata_itut_t35(). The payload itself is only measured.
+  uint8_t itu_t_t35_country_code{0};
+  uint8_t itu_t_t35_country_code_extension_byte{0};
+  // The first two payload bytes, the terminal provider code of T.35.
+  uint16_t itu_t_t35_terminal_provider_code{0};
+  uint32_t itu_t_t35_payload_bytes{0};
+
+  // 5.8.7 metadata_timecode()
+  uint8_t counting_type{0};
+  bool full_timestamp_flag{false};
+  bool discontinuity_flag{false};
+  bool cnt_dropped_flag{false};
+  uint16_t n_frames{0};
+  bool seconds_flag{false};
+  bool minutes_flag{false};
+  bool hours_flag{false};
+  uint8_t seconds_value{0};
+  uint8_t minutes_value{0};
+  uint8_t hours_value{0};
+  uint8_t time_offset_length{0};
+  uint32_t time_offset_value{0};
+};
+
+// 5.12, tile_list_obu(). Tile list entries are only counted.
+struct Av1TileList {
+  uint8_t output_frame_width_in_tiles_minus_1{0};
+  uint8_t output_frame_height_in_tiles_minus_1{0};
+  uint16_t tile_count_minus_1{0};
+  // Entries walked, and the coded tile data bytes they carry.
+  uint32_t entries{0};
+  uint32_t tileDataBytes{0};
+};
+
+// Reads the AV1 headers without decoding the frames. Keeps the state the
+// frame header syntax depends on across frames: the last sequence header and
+// what each of the eight reference slots holds (7.20). One per stream; the
+// parse methods fill the structures in place and allocate nothing.
+class Av1HeaderParser {
+ public:
+  // 5.3. Returns false if |size| doesn't hold the header and the payload.
+  static bool parseObuHeader(const uint8_t* data,
+                             size_t size,
+                             Av1ObuHeader* header);
+
+  bool parseSequenceHeader(const uint8_t* data, size_t size);
+  // OBU_FRAME_HEADER, OBU_REDUNDANT_FRAME_HEADER and the header of OBU_FRAME.
+  // Returns false without a sequence header, or if the header is truncated.
+  // A copy of the current frame header (5.9.1) is skipped, |*copy| set.
+  bool parseFrameHeader(const uint8_t* data,
+                        size_t size,
+                        const Av1ObuHeader& obu,
+                        bool* copy);
+  // OBU_TILE_GROUP and the tile group of OBU_FRAME, |data| at the tile group.
+  bool parseTileGroup(const uint8_t* data, size_t size, Av1TileGroup* group);
+  // OBU_METADATA. Unknown types only get |metadata_type| set. Returns false
+  // if the known fields are truncated.
+  static bool parseMetadata(const uint8_t* data,
+                            size_t size,
+                            Av1Metadata* metadata);
+  // OBU_TILE_LIST. Returns false if the entries run past |size|.
+  static bool parseTileList(const uint8_t* data,
+                            size_t size,
+                            Av1TileList* list);
+  // Temporal delimiter: the next frame header is a new one.
+  void startTemporalUnit() { this->seenFrameHeader_ = false; }
+
+  bool hasSequenceHeader() const { return this->hasSequenceHeader_; }
+  const Av1SequenceHeader& sequenceHeader() const {
+    return this->sequenceHeader_;
+  }
+  const Av1FrameHeader& frameHeader() const { return this->frameHeader_; }
+
+ protected:
+  // Saved state of a reference slot, 7.20.
+  struct RefSlot {
+    bool valid{false};
+    uint8_t frame_type{kAv1KeyFrame};
+    uint32_t frame_id{0};
+    uint32_t order_hint{0};
+    uint32_t UpscaledWidth{0};
+    uint32_t FrameWidth{0};
+    uint32_t FrameHeight{0};
+    uint32_t RenderWidth{0};
+    uint32_t RenderHeight{0};
+    int32_t gm_params[Av1FrameHeader::kTotalRefsPerFrame][6]{};
+    int8_t loop_filter_ref_deltas[Av1FrameHeader::kTotalRefsPerFrame]{};
+    int8_t loop_filter_mode_deltas[2]{};
+    uint8_t FeatureEnabled[Av1FrameHeader::kMaxSegments]{};
+    int16_t FeatureData[Av1FrameHeader::kMaxSegments]
+                       [Av1FrameHeader::kSegLvlMax]{};
+    Av1FilmGrainParams film_grain_params;
+  };
+
+  static void colorConfig(BitReader& reader, Av1SequenceHeader& seq);
+  bool uncompressedHeader(BitReader& reader, const Av1ObuHeader& obu);
+  void frameSize(BitReader& reader);
+  void superresParams(BitReader& reader);
+  void computeImageSize();
+  void renderSize(BitReader& reader);
+  void frameSizeWithRefs(BitReader& reader);
+  void setFrameRefs(uint8_t lastFrameIdx, uint8_t goldFrameIdx);
+  bool tileInfo(BitReader& reader);
+  void quantizationParams(BitReader& reader);
+  void segmentationParams(BitReader& reader);
+  void deltaParams(BitReader& reader);
+  void computeLossless();
+  void loopFilterParams(BitReader& reader);
+  void cdefParams(BitReader& reader);
+  void lrParams(BitReader& reader);
+  void skipModeParams(BitReader& reader);
+  void globalMotionParams(BitReader& reader);
+  void readGlobalParam(BitReader& reader, uint8_t type, int ref, int idx);
+  void filmGrainParams(BitReader& reader);
+  void setupPastIndependence();
+  void loadPrevious();
+  void referenceFrameUpdate();
+  int relativeDist(uint32_t a, uint32_t b) const;
+
+ private:
+  bool hasSequenceHeader_{false};
+  bool seenFrameHeader_{false};
+  Av1SequenceHeader sequenceHeader_;
+  Av1FrameHeader frameHeader_;
+  RefSlot refs_[8];
+  // 7.20 PrevGmParams: the global motion of the primary reference frame.
+  int32_t prevGmParams_[Av1FrameHeader::kTotalRefsPerFrame][6]{};
+};
+}  // namespace chai
+
+#endif  // CHAI_AV1_HEADER_PARSER_H
@@ -0,0 +1,233 @@
+#ifndef CHAI_BIT_READER_H
+#define CHAI_BIT_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace chai {
+// MSB-first bit reader over a codec bitstream, meant to live on the stack of
+// a parse function: no allocation, and the next bits sit in a 64-bit cache
+// refilled up to eight bytes at a time.
+//
+// With |rbsp| the input is a NAL unit payload (H.264/H.265): emulation
+// prevention bytes (00 00 03) are dropped while refilling, so the fields are
+// read from the RBSP without copying it first.
+//
+// Reading past the end returns zeros and clears ok(); parsers check ok()
+// once at the end instead of after every field.
+class BitReader {
+ public:
+  BitReader(const uint8_t* data, size_t size, bool rbsp = false)
+      : data_(data), size_(size), rbsp_(rbsp) {}
+
+  bool ok() const { return this->ok_; }
+  // Bits consumed so far, counted in the RBSP.
+  size_t bitOffset() const { return this->consumed_; }
+  bool byteAligned() const { return (this->consumed_ & 7) == 0; }
+
+  // u(n). A width outside 0..32, as a corrupt length field in the stream
+  // gives, fails the read like running past the end does.
+  uint32_t readBits(int n) {
+    if (n == 0) {
+      return 0;
+    }
+    if (n < 0 || n > 32) {
+      return this->overrun();
+    }
+    if (this->cacheBits_ < n) {
+      this->refill();
+      if (this->cacheBits_ < n) {
+        return this->overrun();
+      }
+    }
+    uint32_t value = uint32_t(this->cache_ >> (64 - n));
+    this->consume(n);
+    return value;
+  }
+  bool readFlag() { return this->readBits(1) != 0; }
+  void skipBits(size_t n) {
+    while (n > 0 && this->ok_) {
+      int bits = n > 32 ? 32 : int(n);
+      this->readBits(bits);
+      n -= bits;
+    }
+  }
+  void byteAlign() { this->skipBits((8 - (this->consumed_ & 7)) & 7); }
+
+  // ue(v): the leading zeros are counted with one CLZ on the cache rather
+  // than a bit at a time.
+  uint32_t readUe() {
+    if (this->cacheBits_ < 32) {
+      this->refill();
+    }
+    int zeros = countLeadingZeros(this->cache_);
+    int bits = 2 * zeros + 1;
+    if (zeros < 32 && bits <= this->cacheBits_) {
+      uint32_t value = uint32_t(this->cache_ >> (64 - bits)) - 1;
+      this->consume(bits);
+      return value;
+    }
+    // Near the end of the input, or longer than the cache holds.
+    zeros = 0;
+    while (!this->readFlag()) {
+      if (!this->ok_ || ++zeros > 31) {
+        return this->overrun();
+      }
+    }
+    return ((1u << zeros) | this->readBits(zeros)) - 1;
+  }
+  // se(v).
+  int32_t readSe() {
+    uint32_t value = this->readUe();
+    return (value & 1) ? int32_t((value >> 1) + 1) : -int32_t(value >> 1);
+  }
+
+  // AV1 su(n) (AV1 4.10.6): n-bit two's complement.
+  int32_t readSu(int n) {
+    uint32_t value = this->readBits(n);
+    uint32_t signMask = 1u << (n - 1);
+    return (value & signMask) ? int32_t(value) - int32_t(2 * signMask)
+                              : int32_t(value);
+  }
+  // AV1 ns(n) (AV1 4.10.7): non-symmetric unsigned value below |n|.
+  uint32_t readNs(uint32_t n) {
+    if (n <= 1) {
+      return 0;
+    }
+    // FloorLog2(n) + 1
+    int w = 64 - countLeadingZeros(n);
+    uint32_t m = uint32_t((uint64_t(1) << w) - n);
+    uint32_t value = this->readBits(w - 1);
+    if (value < m) {
+      return value;
+    }
+    return (value << 1) - m + this->readBits(1);
+  }
+  // AV1 leb128() (AV1 4.10.5), byte aligned.
+  uint64_t readLeb128() {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+      uint32_t byte = this->readBits(8);
+      value |= uint64_t(byte & 0x7f) << (i * 7);
+      if (!(byte & 0x80)) {
+        break;
+      }
+    }
+    return value;
+  }
+  // AV1 le(n) (AV1 4.10.4): |n| bytes little-endian, byte aligned, n <= 4.
+  uint32_t readLe(int n) {
+    uint32_t value = 0;
+    for (int i = 0; i < n; ++i) {
+      value |= this->readBits(8) << (i * 8);
+    }
+    return value;
+  }
+  // AV1 uvlc() (AV1 4.10.3).
+  uint32_t readUvlc() {
+    int zeros = 0;
+    while (!this->readFlag()) {
+      if (!this->ok_) {
+        return 0;
+      }
+      ++zeros;
+    }
+    if (zeros >= 32) {
+      return UINT32_MAX;
+    }
+    return this->readBits(zeros) + (1u << zeros) - 1;
+  }
+
+ private:
+  static int countLeadingZeros(uint64_t value) {
+    if (value == 0) {
+      return 64;
+    }
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return 63 - int(index);
+#else
+    return __builtin_clzll(value);
+#endif
+  }
+
+  void consume(int n) {
+    // n is at most 63 here, and the cache holds at least n bits.
+    this->cache_ <<= n;
+    this->cacheBits_ -= n;
+    this->consumed_ += n;
+  }
+
+  uint32_t overrun() {
+    this->ok_ = false;
+    this->consumed_ += this->cacheBits_;
+    this->cache_ = 0;
+    this->cacheBits_ = 0;
+    this->pos_ = this->size_;
+    return 0;
+  }
+
+  // Callers refill only with fewer than 32 bits cached, so the shifts
+  // below stay under 64.
+  void refill() {
+    if (this->size_ - this->pos_ >= 8) {
+      const uint8_t* p = this->data_ + this->pos_;
+      uint64_t word = uint64_t(p[0]) << 56 | uint64_t(p[1]) << 48 |
+                      uint64_t(p[2]) << 40 | uint64_t(p[3]) << 32 |
+                      uint64_t(p[4]) << 24 | uint64_t(p[5]) << 16 |
+                      uint64_t(p[6]) << 8 | uint64_t(p[7]);
+      // Without zero bytes there is no emulation prevention byte in the word
+      // (unless the zeros ending the previous word precede a 03).
+      bool plain = !this->rbsp_ ||
+                   (!hasZeroByte(word) && (this->zeros_ < 2 || p[0] != 0x03));
+      if (plain) {
+        int bytes = (64 - this->cacheBits_) >> 3;
+        // The bits of the word beyond the whole bytes taken are the next
+        // ones of the stream: or-ing them in again on the next refill is
+        // harmless.
+        this->cache_ |= word >> this->cacheBits_;
+        this->cacheBits_ += bytes * 8;
+        this->pos_ += bytes;
+        this->zeros_ = 0;
+        return;
+      }
+    }
+    while (this->cacheBits_ <= 56 && this->pos_ < this->size_) {
+      uint8_t byte = this->data_[this->pos_++];
+      if (this->rbsp_) {
+        if (this->zeros_ >= 2 && byte == 0x03) {
+          this->zeros_ = 0;
+          continue;
+        }
+        this->zeros_ = byte == 0 ? this->zeros_ + 1 : 0;
+      }
+      this->cache_ |= uint64_t(byte) << (56 - this->cacheBits_);
+      this->cacheBits_ += 8;
+    }
+  }
+
+  static bool hasZeroByte(uint64_t word) {
+    return ((word - 0x0101010101010101ull) & ~word & 0x8080808080808080ull) !=
+           0;
+  }
+
+  const uint8_t* data_{nullptr};
+  size_t size_{0};
+  size_t pos_{0};
+  // Next bits of the stream, MSB first; the top |cacheBits_| are valid.
+  uint64_t cache_{0};
+  int cacheBits_{0};
+  size_t consumed_{0};
+  // Zero bytes just read, for emulation prevention.
+  int zeros_{0};
+  bool rbsp_{false};
+  bool ok_{true};
+};
+}  // namespace chai
+
+#endif  // CHAI_BIT_READER_H
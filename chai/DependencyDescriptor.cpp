@@ -0,0 +1,363 @@
+#include "DependencyDescriptor.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "BitReader.h"
+
+namespace {
+using chai::BitReader;
+using chai::FrameDependencyStructure;
+
+const char kDtiNames[] = "-DSR";
+
+// A.8.3.2 template_dependency_structure()
+bool parseStructure(BitReader& reader, FrameDependencyStructure* structure) {
+  structure->templateIdOffset = uint8_t(reader.readBits(6));
+  structure->decodeTargetCount = uint8_t(reader.readBits(5) + 1);
+  int dtCount = structure->decodeTargetCount;
+
+  // template_layers()
+  uint8_t spatialId = 0;
+  uint8_t temporalId = 0;
+  int templateCount = 0;
+  uint32_t nextLayerIdc = 0;
+  structure->maxTemporalId = 0;
+  do {
+    if (templateCount == FrameDependencyStructure::kMaxTemplates ||
+        spatialId >= FrameDependencyStructure::kMaxSpatialLayers ||
+        !reader.ok()) {
+      return false;
+    }
+    auto& tmpl = structure->templates[templateCount++];
+    tmpl = FrameDependencyStructure::Template();
+    tmpl.spatialId = spatialId;
+    tmpl.temporalId = temporalId;
+    nextLayerIdc = reader.readBits(2);
+    if (nextLayerIdc == 1) {
+      ++temporalId;
+      if (temporalId > structure->maxTemporalId) {
+        structure->maxTemporalId = temporalId;
+      }
+    } else if (nextLayerIdc == 2) {
+      temporalId = 0;
+      ++spatialId;
+    }
+  } while (nextLayerIdc != 3);
+  structure->templateCount = uint8_t(templateCount);
+  structure->maxSpatialId = spatialId;
+
+  // template_dtis()
+  for (int i = 0; i < templateCount; ++i) {
+    for (int dt = 0; dt < dtCount; ++dt) {
+      structure->templates[i].dtis[dt] = uint8_t(reader.readBits(2));
+    }
+  }
+  // template_fdiffs()
+  for (int i = 0; i < templateCount; ++i) {
+    auto& tmpl = structure->templates[i];
+    while (reader.readFlag()) {
+      if (tmpl.fdiffCount == FrameDependencyStructure::kMaxTemplateFdiffs ||
+          !reader.ok()) {
+        return false;
+      }
+      tmpl.fdiffs[tmpl.fdiffCount++] = uint8_t(reader.readBits(4) + 1);
+    }
+  }
+  // template_chains()
+  structure->chainCount = uint8_t(reader.readNs(dtCount + 1));
+  if (structure->chainCount > 0) {
+    for (int dt = 0; dt < dtCount; ++dt) {
+      structure->decodeTargetProtectedBy[dt] =
+          uint8_t(reader.readNs(structure->chainCount));
+    }
+    for (int i = 0; i < templateCount; ++i) {
+      for (int chain = 0; chain < structure->chainCount; ++chain) {
+        structure->templates[i].chainFdiffs[chain] =
+            uint8_t(reader.readBits(4));
+      }
+    }
+  }
+  // render_resolutions()
+  structure->resolutionsPresent = reader.readFlag();
+  if (structure->resolutionsPresent) {
+    for (int sid = 0; sid <= structure->maxSpatialId; ++sid) {
+      structure->renderWidth[sid] = uint16_t(reader.readBits(16) + 1);
+      structure->renderHeight[sid] = uint16_t(reader.readBits(16) + 1);
+    }
+  }
+  structure->activeDecodeTargets =
+      dtCount == 32 ? 0xffffffffu : (1u << dtCount) - 1;
+  return reader.ok();
+}
+}  // namespace
+
+namespace chai {
+const int FrameDependencyStructure::kMaxTemplates;
+const int FrameDependencyStructure::kMaxDecodeTargets;
+const int FrameDependencyStructure::kMaxSpatialLayers;
+const int FrameDependencyStructure::kMaxTemplateFdiffs;
+const int FrameDependency::kMaxDecodeTargets;
+const int FrameDependency::kMaxFdiffs;
+const int FrameDependencyGraph::kMaxFrames;
+
+bool parseDependencyDescriptor(const uint8_t* data,
+                               size_t size,
+                               FrameDependencyStructure* structure,
+                               bool* hasStructure,
+                               FrameDependency* frame) {
+  BitReader reader(data, size);
+  frame->valid = false;
+  frame->structureAttached = false;
+  // mandatory_descriptor_fields()
+  frame->startOfFrame = reader.readFlag();
+  frame->endOfFrame = reader.readFlag();
+  frame->templateId = uint8_t(reader.readBits(6));
+  frame->frameNumber = uint16_t(reader.readBits(16));
+  if (!reader.ok()) {
+    return false;
+  }
+
+  bool customDtis = false;
+  bool customFdiffs = false;
+  bool customChains = false;
+  if (size > 3) {
+    // extended_descriptor_fields()
+    frame->structureAttached = reader.readFlag();
+    bool activeDecodeTargetsPresent = reader.readFlag();
+    customDtis = reader.readFlag();
+    customFdiffs = reader.readFlag();
+    customChains = reader.readFlag();
+    if (frame->structureAttached) {
+      FrameDependencyStructure attached;
+      if (!parseStructure(reader, &attached)) {
+        return false;
+      }
+      *structure = attached;
+      *hasStructure = true;
+    }
+    if (activeDecodeTargetsPresent && *hasStructure) {
+      structure->activeDecodeTargets =
+          reader.readBits(structure->decodeTargetCount);
+    }
+  }
+  if (!*hasStructure) {
+    return false;
+  }
+
+  // frame_dependency_definition()
+  int templateIndex =
+      (frame->templateId + 64 - structure->templateIdOffset) % 64;
+  if (templateIndex >= structure->templateCount) {
+    return false;
+  }
+  const auto& tmpl = structure->templates[templateIndex];
+  frame->spatialId = tmpl.spatialId;
+  frame->temporalId = tmpl.temporalId;
+  frame->decodeTargetCount = structure->decodeTargetCount;
+  frame->chainCount = structure->chainCount;
+  frame->activeDecodeTargets = structure->activeDecodeTargets;
+  for (int dt = 0; dt < frame->decodeTargetCount; ++dt) {
+    // frame_dtis()
+    frame->dtis[dt] =
+        customDtis ? uint8_t(reader.readBits(2)) : tmpl.dtis[dt];
+  }
+  if (customFdiffs) {
+    // frame_fdiffs()
+    frame->fdiffCount = 0;
+    while (uint32_t nextFdiffSize = reader.readBits(2)) {
+      if (frame->fdiffCount == FrameDependency::kMaxFdiffs || !reader.ok()) {
+        return false;
+      }
+      frame->fdiffs[frame->fdiffCount++] =
+          uint16_t(reader.readBits(4 * nextFdiffSize) + 1);
+    }
+  } else {
+    frame->fdiffCount = tmpl.fdiffCount;
+    for (int i = 0; i < tmpl.fdiffCount; ++i) {
+      frame->fdiffs[i] = tmpl.fdiffs[i];
+    }
+  }
+  for (int chain = 0; chain < frame->chainCount; ++chain) {
+    // frame_chains()
+    frame->chainFdiffs[chain] =
+        customChains ? uint8_t(reader.readBits(8)) : tmpl.chainFdiffs[chain];
+  }
+  if (frame->structureAttached) {
+    for (int dt = 0; dt < frame->decodeTargetCount; ++dt) {
+      frame->decodeTargetProtectedBy[dt] =
+          structure->decodeTargetProtectedBy[dt];
+    }
+  }
+  if (structure->resolutionsPresent) {
+    frame->renderWidth = structure->renderWidth[frame->spatialId];
+    frame->renderHeight = structure->renderHeight[frame->spatialId];
+  }
+  frame->valid = reader.ok();
+  return frame->valid;
+}
+
+nlohmann::json FrameDependency::toJson() const {
+  nlohmann::json json = {
+      {"start_of_frame", this->startOfFrame},
+      {"end_of_frame", this->endOfFrame},
+      {"template_id", this->templateId},
+      {"frame_number", this->frameNumber},
+  };
+  if (!this->valid) {
+    json["error"] = "unresolved";
+    return json;
+  }
+  json["frame_id"] = this->frameId;
+  json["spatial_id"] = this->spatialId;
+  json["temporal_id"] = this->temporalId;
+  // One character per decode target: - not present, D discardable,
+  // S switch, R required.
+  std::string dtis;
+  for (int dt = 0; dt < this->decodeTargetCount; ++dt) {
+    dtis += kDtiNames[this->dtis[dt] & 3];
+  }
+  json["dtis"] = dtis;
+  json["active_decode_targets"] = this->activeDecodeTargets;
+  nlohmann::json references = nlohmann::json::array();
+  for (int i = 0; i < this->fdiffCount; ++i) {
+    references.push_back(this->frameId - this->fdiffs[i]);
+  }
+  json["references"] = references;
+  if (this->chainCount) {
+    json["chain_fdiffs"] = std::vector<uint8_t>(
+        this->chainFdiffs, this->chainFdiffs + this->chainCount);
+  }
+  if (this->structureAttached) {
+    json["structure"] = {
+        {"decode_target_count", this->decodeTargetCount},
+        {"chain_count", this->chainCount},
+        {"decode_target_protected_by",
+         std::vector<uint8_t>(
+             this->decodeTargetProtectedBy,
+             this->decodeTargetProtectedBy +
+                 (this->chainCount ? this->decodeTargetCount : 0))},
+    };
+  }
+  if (this->renderWidth) {
+    json["render_width"] = this->renderWidth;
+    json["render_height"] = this->renderHeight;
+  }
+  if (this->complete) {
+    json["decodable"] = this->decodable;
+    json["decodable_targets"] = this->decodableTargets;
+  }
+  return json;
+}
+
+bool FrameDependencyGraph::onPacket(const uint8_t* data,
+                                    size_t size,
+                                    uint16_t sequenceNumber,
+                                    FrameDependency* frame) {
+  if (!parseDependencyDescriptor(data, size, &this->structure_,
+                                 &this->hasStructure_, frame)) {
+    return false;
+  }
+  frame->frameId = this->unwrap(frame->frameNumber);
+
+  Node& node = this->slot(frame->frameId);
+  if (node.used && node.frameId > frame->frameId) {
+    // Older than the window.
+    return true;
+  }
+  if (!node.used || node.frameId != frame->frameId) {
+    node = Node();
+    node.used = true;
+    node.frameId = frame->frameId;
+  }
+  if (frame->startOfFrame) {
+    // The first packet carries the extended fields, if any.
+    node.hasFirst = true;
+    node.firstSequenceNumber = sequenceNumber;
+    node.fdiffCount = frame->fdiffCount;
+    std::copy(frame->fdiffs, frame->fdiffs + frame->fdiffCount, node.fdiffs);
+    std::copy(frame->chainFdiffs, frame->chainFdiffs + frame->chainCount,
+              node.chainFdiffs);
+  }
+  if (frame->endOfFrame) {
+    node.hasLast = true;
+    node.lastSequenceNumber = sequenceNumber;
+  }
+  ++node.packets;
+  // Retransmitted duplicates count too, hence >=.
+  if (!node.complete && node.hasFirst && node.hasLast &&
+      node.packets >=
+          uint16_t(node.lastSequenceNumber - node.firstSequenceNumber) + 1) {
+    this->onComplete(node, frame);
+  }
+  return true;
+}
+
+int64_t FrameDependencyGraph::unwrap(uint16_t frameNumber) {
+  if (!this->hasLastFrameId_) {
+    this->hasLastFrameId_ = true;
+    this->lastFrameId_ = frameNumber;
+    return frameNumber;
+  }
+  int64_t frameId =
+      this->lastFrameId_ +
+      int16_t(uint16_t(frameNumber - uint16_t(this->lastFrameId_)));
+  if (frameId > this->lastFrameId_) {
+    this->lastFrameId_ = frameId;
+  }
+  return frameId;
+}
+
+FrameDependencyGraph::Node& FrameDependencyGraph::slot(int64_t frameId) {
+  return this->nodes_[size_t(((frameId % kMaxFrames) + kMaxFrames) %
+                             kMaxFrames)];
+}
+
+FrameDependencyGraph::Node* FrameDependencyGraph::find(int64_t frameId) {
+  Node& node = this->slot(frameId);
+  return node.used && node.frameId == frameId ? &node : nullptr;
+}
+
+void FrameDependencyGraph::onComplete(Node& node, FrameDependency* frame) {
+  node.complete = true;
+  node.decodable = true;
+  for (int i = 0; i < node.fdiffCount; ++i) {
+    const Node* reference = this->find(node.frameId - node.fdiffs[i]);
+    if (!reference || !reference->decodable) {
+      node.decodable = false;
+    }
+  }
+
+  const FrameDependencyStructure& structure = this->structure_;
+  node.chainsIntact = 0;
+  for (int chain = 0; chain < structure.chainCount; ++chain) {
+    bool intact = true;
+    if (node.chainFdiffs[chain] != 0) {
+      const Node* previous = this->find(node.frameId - node.chainFdiffs[chain]);
+      intact = previous && previous->complete &&
+               (previous->chainsIntact & (1u << chain));
+    }
+    if (intact) {
+      node.chainsIntact |= 1u << chain;
+    }
+  }
+
+  frame->complete = true;
+  frame->decodable = node.decodable;
+  frame->decodableTargets = 0;
+  for (int dt = 0; dt < structure.decodeTargetCount; ++dt) {
+    if (!(structure.activeDecodeTargets & (1u << dt))) {
+      continue;
+    }
+    bool decodable =
+        structure.chainCount
+            ? (node.chainsIntact &
+               (1u << structure.decodeTargetProtectedBy[dt])) != 0
+            : node.decodable;
+    if (decodable) {
+      frame->decodableTargets |= 1u << dt;
+    }
+  }
+}
+}  // namespace chai
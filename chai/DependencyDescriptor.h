@@ -0,0 +1,165 @@
+#ifndef CHAI_DEPENDENCY_DESCRIPTOR_H
+#define CHAI_DEPENDENCY_DESCRIPTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <json.hpp>
+
+namespace chai {
+// Dependency descriptor RTP header extension, from the RTP payload format
+// for AV1 (https://aomediacodec.github.io/av1-rtp-spec/), appendix A.
+
+// A.8.3.1 decode target indications.
+enum DecodeTargetIndication : uint8_t {
+  kDtiNotPresent = 0,
+  kDtiDiscardable = 1,
+  kDtiSwitch = 2,
+  kDtiRequired = 3,
+};
+
+// A.8.3.2 template dependency structure. Sent with the key frames; the
+// descriptors of the other frames only carry a template id and what differs
+// from the template, so it is kept per SSRC.
+struct FrameDependencyStructure {
+  static const int kMaxTemplates{64};
+  static const int kMaxDecodeTargets{32};
+  static const int kMaxSpatialLayers{4};
+  // Frame diffs of a template, fdiff_minus_one is 4 bits.
+  static const int kMaxTemplateFdiffs{16};
+
+  struct Template {
+    uint8_t spatialId{0};
+    uint8_t temporalId{0};
+    uint8_t fdiffCount{0};
+    uint8_t dtis[kMaxDecodeTargets]{};
+    uint8_t fdiffs[kMaxTemplateFdiffs]{};
+    uint8_t chainFdiffs[kMaxDecodeTargets]{};
+  };
+
+  uint8_t templateIdOffset{0};
+  uint8_t decodeTargetCount{0};
+  uint8_t chainCount{0};
+  uint8_t templateCount{0};
+  uint8_t maxSpatialId{0};
+  uint8_t maxTemporalId{0};
+  uint8_t decodeTargetProtectedBy[kMaxDecodeTargets]{};
+  bool resolutionsPresent{false};
+  uint16_t renderWidth[kMaxSpatialLayers]{};
+  uint16_t renderHeight[kMaxSpatialLayers]{};
+  Template templates[kMaxTemplates];
+  // Not part of the structure, but reset with it: the last
+  // active_decode_targets_bitmask sent, all targets until then.
+  uint32_t activeDecodeTargets{0};
+};
+
+// The descriptor of one packet, resolved against the template structure,
+// and where its frame stands in the FrameDependencyGraph of the stream.
+struct FrameDependency {
+  static const int kMaxDecodeTargets{
+      FrameDependencyStructure::kMaxDecodeTargets};
+  static const int kMaxFdiffs{16};
+
+  nlohmann::json toJson() const;
+
+  // Mandatory fields, from every descriptor.
+  bool startOfFrame{false};
+  bool endOfFrame{false};
+  uint8_t templateId{0};
+  uint16_t frameNumber{0};
+
+  // The rest is only set when the descriptor was resolved: a structure was
+  // known and the template id fits it.
+  bool valid{false};
+  // The packet carried a template structure.
+  bool structureAttached{false};
+  // frame_number unwrapped.
+  int64_t frameId{0};
+  uint8_t spatialId{0};
+  uint8_t temporalId{0};
+  uint8_t decodeTargetCount{0};
+  uint8_t chainCount{0};
+  uint32_t activeDecodeTargets{0};
+  uint8_t dtis[kMaxDecodeTargets]{};
+  // Frames referenced, as frameId - fdiff.
+  uint8_t fdiffCount{0};
+  uint16_t fdiffs[kMaxFdiffs]{};
+  // Distance to the previous frame of each chain, 0 if this frame starts it.
+  uint8_t chainFdiffs[kMaxDecodeTargets]{};
+  // Of the structure, when attached.
+  uint8_t decodeTargetProtectedBy[kMaxDecodeTargets]{};
+  // Of the frame's spatial layer, 0 if the structure has none.
+  uint16_t renderWidth{0};
+  uint16_t renderHeight{0};
+
+  // Set on the packet completing the frame: whether everything it
+  // references arrived, and which decode targets are still decodable.
+  bool complete{false};
+  bool decodable{false};
+  uint32_t decodableTargets{0};
+};
+
+// A.8.2. Parses |data| into |frame|; a template structure it carries
+// replaces |*structure| and sets |*hasStructure|. Returns false if the
+// descriptor is malformed, or needs a structure we don't have.
+bool parseDependencyDescriptor(const uint8_t* data,
+                               size_t size,
+                               FrameDependencyStructure* structure,
+                               bool* hasStructure,
+                               FrameDependency* frame);
+
+// Frames of one SSRC and their dependencies, built packet by packet from
+// the descriptors. Frames are kept in a ring of kMaxFrames slots by frame
+// id, so memory doesn't grow with the length of the call: a reference to a
+// frame older than that counts as missing.
+//
+// A frame is complete once the packets from its start_of_frame to its
+// end_of_frame all arrived. It is decodable when it is complete and every
+// frame it references is decodable. A decode target stays decodable as long
+// as the chain protecting it (A.4) is intact: every frame of the chain up to
+// this one arrived.
+class FrameDependencyGraph {
+ public:
+  static const int kMaxFrames{512};
+
+  // Parses the descriptor of the packet with |sequenceNumber| into |frame|.
+  // Returns false if it couldn't be resolved.
+  bool onPacket(const uint8_t* data,
+                size_t size,
+                uint16_t sequenceNumber,
+                FrameDependency* frame);
+
+ protected:
+  struct Node {
+    bool used{false};
+    int64_t frameId{0};
+    uint16_t firstSequenceNumber{0};
+    uint16_t lastSequenceNumber{0};
+    uint16_t packets{0};
+    bool hasFirst{false};
+    bool hasLast{false};
+    bool complete{false};
+    bool decodable{false};
+    // Chains intact up to and including this frame.
+    uint32_t chainsIntact{0};
+    uint8_t fdiffCount{0};
+    uint16_t fdiffs[FrameDependency::kMaxFdiffs]{};
+    uint8_t chainFdiffs[FrameDependency::kMaxDecodeTargets]{};
+  };
+
+  int64_t unwrap(uint16_t frameNumber);
+  Node& slot(int64_t frameId);
+  Node* find(int64_t frameId);
+  void onComplete(Node& node, FrameDependency* frame);
+
+ private:
+  bool hasStructure_{false};
+  FrameDependencyStructure structure_;
+  bool hasLastFrameId_{false};
+  int64_t lastFrameId_{0};
+  std::array<Node, kMaxFrames> nodes_;
+};
+}  // namespace chai
+
+#endif  // CHAI_DEPENDENCY_DESCRIPTOR_H
@@ -0,0 +1,249 @@
+#include "FlightRecorder.h"
+
+#include <rtc_base/time_utils.h>
+#include <string.h>
+
+#include <new>
+
+namespace {
+const char kMagic[8] = {'C', 'H', 'A', 'I', 'F', 'R', '0', '1'};
+const uint32_t kVersion{1};
+const uint64_t kHeaderSize{4096};
+const uint64_t kRecordHeaderSize{sizeof(chai::FlightRecorder::RecordHeader)};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the write offset is shared through the mapping");
+static_assert(sizeof(chai::FlightRecorder::FileHeader) <= kHeaderSize,
+              "file header must fit its page");
+
+uint64_t align8(uint64_t value) {
+  return (value + 7) & ~uint64_t(7);
+}
+}  // namespace
+
+namespace chai {
+bool FlightRecorder::open(const std::string& path, uint64_t size) {
+  uint64_t chunks = size / kChunkSize;
+  if (chunks < 2) {
+    this->error_ = "flight recorder needs at least 128 KiB";
+    return false;
+  }
+  uint64_t indexSize =
+      (chunks * sizeof(IndexEntry) + kHeaderSize - 1) / kHeaderSize *
+      kHeaderSize;
+  uint64_t ringSize = chunks * kChunkSize;
+  if (!this->file_.create(path, kHeaderSize + indexSize + ringSize)) {
+    this->error_ = this->file_.error();
+    return false;
+  }
+
+  // The file starts out zeroed: every index entry is invalid.
+  uint8_t* data = this->file_.mutableData();
+  this->header_ = new (data) FileHeader();
+  memcpy(this->header_->magic, kMagic, sizeof(kMagic));
+  this->header_->version = kVersion;
+  this->header_->headerSize = kHeaderSize;
+  this->header_->indexOffset = kHeaderSize;
+  this->header_->indexEntries = chunks;
+  this->header_->dataOffset = kHeaderSize + indexSize;
+  this->header_->dataSize = ringSize;
+  this->header_->createdUs = rtc::TimeUTCMicros();
+  this->header_->createdMonotonicUs = rtc::TimeMicros();
+  this->header_->writeOffset.store(0, std::memory_order_release);
+
+  this->index_ = reinterpret_cast<IndexEntry*>(data + kHeaderSize);
+  this->ring_ = data + kHeaderSize + indexSize;
+  this->ringSize_ = ringSize;
+  this->writeOffset_ = 0;
+  this->seq_ = 0;
+  this->chunk_ = UINT64_MAX;
+  return true;
+}
+
+void FlightRecorder::append(const uint8_t* data,
+                            size_t length,
+                            PacketKind kind,
+                            Direction direction,
+                            int64_t timeUs) {
+  if (this->ring_ == nullptr || length > 0xffff) {
+    return;
+  }
+  uint64_t total = kRecordHeaderSize + align8(length);
+
+  uint64_t position = this->writeOffset_ % this->ringSize_;
+  uint64_t remaining = this->ringSize_ - position;
+  if (remaining < total) {
+    // Records don't wrap; pad the tail of the ring (if there is room for a
+    // header at all, otherwise readers skip the tail by themselves).
+    if (remaining >= kRecordHeaderSize) {
+      RecordHeader padding = {};
+      padding.length = uint32_t(remaining - kRecordHeaderSize);
+      padding.kind = kPadding;
+      memcpy(this->ring_ + position, &padding, kRecordHeaderSize);
+    }
+    this->writeOffset_ += remaining;
+    position = 0;
+  }
+
+  // First record starting in this chunk: point its index entry at it.
+  uint64_t chunk = this->writeOffset_ / kChunkSize;
+  if (chunk != this->chunk_) {
+    IndexEntry& entry = this->index_[position / kChunkSize];
+    entry.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.offset = this->writeOffset_;
+    entry.timeUs = timeUs;
+    entry.seq.store(this->seq_ + 1, std::memory_order_release);
+    this->chunk_ = chunk;
+  }
+
+  RecordHeader header = {};
+  header.length = uint32_t(length);
+  header.kind = kind == PacketKind::kRtcp ? kRtcp : kRtp;
+  header.direction = uint8_t(direction);
+  header.timeUs = timeUs;
+  header.seq = ++this->seq_;
+  memcpy(this->ring_ + position, &header, kRecordHeaderSize);
+  memcpy(this->ring_ + position + kRecordHeaderSize, data, length);
+
+  this->writeOffset_ += total;
+  this->header_->writeOffset.store(this->writeOffset_,
+                                   std::memory_order_release);
+}
+
+bool FlightRecorderReader::probe(const uint8_t* data, size_t size) {
+  return size >= sizeof(kMagic) && memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool FlightRecorderReader::open(const std::string& path) {
+  if (!this->file_.open(path)) {
+    this->error_ = this->file_.error();
+    return false;
+  }
+  const uint8_t* data = this->file_.data();
+  size_t size = this->file_.size();
+  if (size < kHeaderSize || !probe(data, size)) {
+    this->error_ = "not a flight recorder file";
+    return false;
+  }
+
+  this->header_ = reinterpret_cast<const FlightRecorder::FileHeader*>(data);
+  const FlightRecorder::FileHeader& header = *this->header_;
+  if (header.version != kVersion ||
+      header.dataSize != header.indexEntries * FlightRecorder::kChunkSize ||
+      header.indexOffset + header.indexEntries *
+                               sizeof(FlightRecorder::IndexEntry) >
+          header.dataOffset ||
+      header.dataOffset + header.dataSize > size) {
+    this->error_ = "corrupt flight recorder header";
+    return false;
+  }
+  this->index_ = reinterpret_cast<const FlightRecorder::IndexEntry*>(
+      data + header.indexOffset);
+  this->ring_ = data + header.dataOffset;
+  this->ringSize_ = header.dataSize;
+  return true;
+}
+
+bool FlightRecorderReader::seek(int64_t sinceUs, uint64_t* offset) const {
+  uint64_t end = this->header_->writeOffset.load(std::memory_order_acquire);
+  uint64_t start = end > this->ringSize_ ? end - this->ringSize_ : 0;
+
+  // The latest indexed record at or before |sinceUs|, or else the oldest.
+  bool before{false};
+  bool found{false};
+  for (uint64_t i = 0; i < this->header_->indexEntries; ++i) {
+    const FlightRecorder::IndexEntry& entry = this->index_[i];
+    if (entry.seq.load(std::memory_order_acquire) == 0 ||
+        entry.offset < start || entry.offset >= end) {
+      continue;
+    }
+    bool entryBefore = entry.timeUs <= sinceUs;
+    if (!found || (entryBefore && (!before || entry.offset > *offset)) ||
+        (!entryBefore && !before && entry.offset < *offset)) {
+      *offset = entry.offset;
+      before = entryBefore;
+      found = true;
+    }
+  }
+  return found;
+}
+
+void FlightRecorderReader::walk(
+    uint64_t offset,
+    const std::function<void(const FlightRecorder::RecordHeader&,
+                             const uint8_t*)>& visit) const {
+  uint64_t lastSeq{0};
+  uint64_t end = this->header_->writeOffset.load(std::memory_order_acquire);
+  while (offset + kRecordHeaderSize <= end) {
+    uint64_t position = offset % this->ringSize_;
+    uint64_t remaining = this->ringSize_ - position;
+    if (remaining < kRecordHeaderSize) {
+      offset += remaining;
+      continue;
+    }
+
+    FlightRecorder::RecordHeader header;
+    memcpy(&header, this->ring_ + position, kRecordHeaderSize);
+    if (header.kind == FlightRecorder::kPadding) {
+      offset += remaining;
+      continue;
+    }
+    uint64_t total = kRecordHeaderSize + align8(header.length);
+    if (total > remaining || offset + total > end ||
+        (lastSeq && header.seq != lastSeq + 1)) {
+      break;
+    }
+    // A live writer may have lapped us while we looked at the record.
+    if (this->header_->writeOffset.load(std::memory_order_acquire) >
+        offset + this->ringSize_) {
+      break;
+    }
+    lastSeq = header.seq;
+
+    visit(header, this->ring_ + position + kRecordHeaderSize);
+    offset += total;
+  }
+}
+
+uint64_t FlightRecorderReader::forEach(
+    int64_t sinceUs,
+    const std::function<void(const FlightRecord&)>& callback) const {
+  uint64_t offset;
+  if (!this->seek(sinceUs, &offset)) {
+    return 0;
+  }
+
+  uint64_t visited{0};
+  this->walk(offset, [&](const FlightRecorder::RecordHeader& header,
+                         const uint8_t* payload) {
+    if (header.timeUs < sinceUs) {
+      return;
+    }
+    FlightRecord record;
+    record.data = payload;
+    record.length = header.length;
+    record.kind = header.kind == FlightRecorder::kRtcp ? PacketKind::kRtcp
+                                                       : PacketKind::kRtp;
+    record.direction = Direction(header.direction);
+    record.timeUs = header.timeUs;
+    record.seq = header.seq;
+    callback(record);
+    ++visited;
+  });
+  return visited;
+}
+
+int64_t FlightRecorderReader::lastTimeUs() const {
+  uint64_t offset;
+  if (!this->seek(INT64_MAX, &offset)) {
+    return 0;
+  }
+
+  // Walk from the newest indexed record to the end.
+  int64_t timeUs{0};
+  this->walk(offset, [&timeUs](const FlightRecorder::RecordHeader& header,
+                               const uint8_t*) { timeUs = header.timeUs; });
+  return timeUs;
+}
+}  // namespace chai
@@ -0,0 +1,151 @@
+#ifndef CHAI_FLIGHT_RECORDER_H
+#define CHAI_FLIGHT_RECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+#include "MappedFile.h"
+#include "PacketPool.h"
+
+namespace chai {
+/*
+  Always-on capture into a fixed-size memory-mapped ring file.
+
+  +--------------------+---------------------------+--------------------------+
+  | FileHeader (4 KiB) | IndexEntry[chunks]        | ring data (chunks * 64K) |
+  +--------------------+---------------------------+--------------------------+
+
+  Records are appended at a monotonic write offset (position in the ring is
+  the offset modulo the ring size) and never straddle the end of the ring: a
+  padding record fills the tail instead. Each 64 KiB chunk of the ring has an
+  index entry describing the first record that starts in it, so a time window
+  can be located without walking the whole ring.
+
+  Appending is a memcpy into the shared mapping followed by a release store of
+  the write offset: no locks and no syscalls. The pages end up in the page
+  cache, so the data survives a crash of the process.
+*/
+class FlightRecorder {
+ public:
+  static const uint64_t kChunkSize{64 * 1024};
+
+#pragma pack(push, 8)
+  struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t indexOffset;
+    uint64_t indexEntries;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    // Wall clock and rtc::TimeMicros() at creation; record times are on the
+    // latter, like packet_time_us.
+    int64_t createdUs;
+    int64_t createdMonotonicUs;
+    // Total bytes ever appended; the ring holds the last dataSize of them.
+    std::atomic<uint64_t> writeOffset;
+  };
+
+  struct IndexEntry {
+    // Written last; 0 means the entry is not valid (yet).
+    std::atomic<uint64_t> seq;
+    uint64_t offset;
+    int64_t timeUs;
+  };
+
+  struct RecordHeader {
+    uint32_t length;  // payload bytes, not counting this header or padding
+    uint8_t kind;     // RecordKind
+    uint8_t direction;
+    uint16_t reserved;
+    int64_t timeUs;
+    uint64_t seq;
+  };
+#pragma pack(pop)
+
+  enum RecordKind : uint8_t { kRtp = 0, kRtcp = 1, kPadding = 0xff };
+
+  FlightRecorder() = default;
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+  // |size| is rounded down to whole chunks; at least two are needed.
+  bool open(const std::string& path, uint64_t size);
+  const std::string& error() const { return error_; }
+
+  // Single writer (the network thread).
+  void append(const uint8_t* data,
+              size_t length,
+              PacketKind kind,
+              Direction direction,
+              int64_t timeUs);
+
+ private:
+  MappedFile file_;
+  FileHeader* header_{nullptr};
+  IndexEntry* index_{nullptr};
+  uint8_t* ring_{nullptr};
+  uint64_t ringSize_{0};
+  // Writer-side copies of what is published in the mapping.
+  uint64_t writeOffset_{0};
+  uint64_t seq_{0};
+  uint64_t chunk_{UINT64_MAX};
+  std::string error_;
+};
+
+struct FlightRecord {
+  const uint8_t* data{nullptr};
+  uint32_t length{0};
+  PacketKind kind{PacketKind::kRtp};
+  Direction direction{Direction::kRecv};
+  int64_t timeUs{0};
+  uint64_t seq{0};
+};
+
+// Reads a recorder file, typically after an incident and from another
+// process. Reading a file that is still being written is allowed but the
+// oldest records may be overwritten while they are being read; those are
+// detected by their sequence number and skipped.
+class FlightRecorderReader {
+ public:
+  static bool probe(const uint8_t* data, size_t size);
+
+  bool open(const std::string& path);
+  const std::string& error() const { return error_; }
+
+  // Time of the newest record, 0 if the recorder is empty.
+  int64_t lastTimeUs() const;
+  // Converts a record time to wall clock microseconds since the epoch.
+  int64_t wallClockUs(int64_t timeUs) const {
+    return header_->createdUs + timeUs - header_->createdMonotonicUs;
+  }
+  // Calls |callback| for every record at or after |sinceUs| in write order.
+  // Returns the number of records visited.
+  uint64_t forEach(int64_t sinceUs,
+                   const std::function<void(const FlightRecord&)>& callback)
+      const;
+
+ protected:
+  // Offset of the indexed record to start a walk for |sinceUs| from.
+  bool seek(int64_t sinceUs, uint64_t* offset) const;
+  // Visits the records from |offset| up to the write offset in order,
+  // stopping at the first one that has been overwritten.
+  void walk(uint64_t offset,
+            const std::function<void(const FlightRecorder::RecordHeader&,
+                                     const uint8_t*)>& visit) const;
+
+ private:
+  MappedFile file_;
+  const FlightRecorder::FileHeader* header_{nullptr};
+  const FlightRecorder::IndexEntry* index_{nullptr};
+  const uint8_t* ring_{nullptr};
+  uint64_t ringSize_{0};
+  std::string error_;
+};
+}  // namespace chai
+
+#endif  // CHAI_FLIGHT_RECORDER_H
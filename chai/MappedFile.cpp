@@ -0,0 +1,189 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace chai {
+MappedFile::~MappedFile() {
+  this->close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path) {
+  this->close();
+
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    this->error_ = "can't open " + path;
+    return false;
+  }
+  this->file_ = file;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    this->error_ = "empty or unreadable file " + path;
+    this->close();
+    return false;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    this->error_ = "can't map " + path;
+    this->close();
+    return false;
+  }
+  this->mapping_ = mapping;
+
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr) {
+    this->error_ = "can't map " + path;
+    this->close();
+    return false;
+  }
+  this->data_ = static_cast<uint8_t*>(data);
+  this->size_ = static_cast<size_t>(size.QuadPart);
+  return true;
+}
+
+bool MappedFile::create(const std::string& path, size_t size) {
+  this->close();
+
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    this->error_ = "can't create " + path;
+    return false;
+  }
+  this->file_ = file;
+
+  // Mapping a file with a larger size grows it.
+  uint64_t size64 = size;
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                      DWORD(size64 >> 32), DWORD(size64),
+                                      nullptr);
+  if (mapping == nullptr) {
+    this->error_ = "can't map " + path;
+    this->close();
+    return false;
+  }
+  this->mapping_ = mapping;
+
+  void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+  if (data == nullptr) {
+    this->error_ = "can't map " + path;
+    this->close();
+    return false;
+  }
+  this->data_ = static_cast<uint8_t*>(data);
+  this->size_ = size;
+  this->writable_ = true;
+  return true;
+}
+
+void MappedFile::close() {
+  if (this->data_) {
+    UnmapViewOfFile(this->data_);
+  }
+  if (this->mapping_) {
+    CloseHandle(this->mapping_);
+  }
+  if (this->file_) {
+    CloseHandle(this->file_);
+  }
+  this->data_ = nullptr;
+  this->size_ = 0;
+  this->writable_ = false;
+  this->mapping_ = nullptr;
+  this->file_ = nullptr;
+}
+#else
+bool MappedFile::open(const std::string& path) {
+  this->close();
+
+  this->fd_ = ::open(path.c_str(), O_RDONLY);
+  if (this->fd_ < 0) {
+    this->error_ = "can't open " + path + ": " + std::strerror(errno);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(this->fd_, &st) != 0 || st.st_size == 0) {
+    this->error_ = "empty or unreadable file " + path;
+    this->close();
+    return false;
+  }
+
+  void* data =
+      mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, this->fd_, 0);
+  if (data == MAP_FAILED) {
+    this->error_ = "can't map " + path + ": " + std::strerror(errno);
+    this->close();
+    return false;
+  }
+  // Captures are walked front to back exactly once.
+  madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+  this->data_ = static_cast<uint8_t*>(data);
+  this->size_ = static_cast<size_t>(st.st_size);
+  return true;
+}
+
+bool MappedFile::create(const std::string& path, size_t size) {
+  this->close();
+
+  this->fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (this->fd_ < 0) {
+    this->error_ = "can't create " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  if (ftruncate(this->fd_, size) != 0) {
+    this->error_ = "can't size " + path + ": " + std::strerror(errno);
+    this->close();
+    return false;
+  }
+
+  int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  // Fault the whole file in now rather than on the first write to each page.
+  flags |= MAP_POPULATE;
+#endif
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, this->fd_, 0);
+  if (data == MAP_FAILED) {
+    this->error_ = "can't map " + path + ": " + std::strerror(errno);
+    this->close();
+    return false;
+  }
+
+  this->data_ = static_cast<uint8_t*>(data);
+  this->size_ = size;
+  this->writable_ = true;
+  return true;
+}
+
+void MappedFile::close() {
+  if (this->data_) {
+    munmap(this->data_, this->size_);
+  }
+  if (this->fd_ >= 0) {
+    ::close(this->fd_);
+  }
+  this->data_ = nullptr;
+  this->size_ = 0;
+  this->writable_ = false;
+  this->fd_ = -1;
+}
+#endif
+}  // namespace chai
@@ -0,0 +1,49 @@
+#ifndef CHAI_MAPPED_FILE_H
+#define CHAI_MAPPED_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace chai {
+// Memory mapping of a whole file. The kernel pages the file in on demand, so
+// multi-GB captures are walked without read() copies or a heap buffer the
+// size of the file, and writes to a shared mapping reach the page cache
+// without a syscall.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Read-only mapping of an existing file. Returns false and fills error()
+  // if the file can't be mapped.
+  bool open(const std::string& path);
+  // Creates (or truncates) |path| to |size| bytes and maps it read-write and
+  // shared, so the data survives a crash of the process.
+  bool create(const std::string& path, size_t size);
+  void close();
+
+  const uint8_t* data() const { return data_; }
+  // nullptr unless the file was create()d.
+  uint8_t* mutableData() const { return writable_ ? data_ : nullptr; }
+  size_t size() const { return size_; }
+  const std::string& error() const { return error_; }
+
+ private:
+  uint8_t* data_{nullptr};
+  size_t size_{0};
+  bool writable_{false};
+  std::string error_;
+#ifdef _WIN32
+  void* file_{nullptr};
+  void* mapping_{nullptr};
+#else
+  int fd_{-1};
+#endif
+};
+}  // namespace chai
+
+#endif  // CHAI_MAPPED_FILE_H
@@ -0,0 +1,279 @@
+#include "NetDemux.h"
+
+#include <string.h>
+
+#include <sstream>
+#include <tuple>
+
+namespace {
+const uint16_t kEtherTypeIpv4{0x0800};
+const uint16_t kEtherTypeIpv6{0x86dd};
+const uint16_t kEtherTypeVlan{0x8100};
+const uint16_t kEtherTypeQinQ{0x88a8};
+
+const uint8_t kIpProtocolUdp{17};
+const uint8_t kIpv6HopByHop{0};
+const uint8_t kIpv6Routing{43};
+const uint8_t kIpv6Fragment{44};
+const uint8_t kIpv6DestinationOptions{60};
+
+const uint32_t kEthernetHeaderSize{14};
+const uint32_t kLinuxSllHeaderSize{16};
+const uint32_t kLinuxSll2HeaderSize{20};
+const uint32_t kIpv4MinHeaderSize{20};
+const uint32_t kIpv6HeaderSize{40};
+const uint32_t kUdpHeaderSize{8};
+const uint32_t kRtpMinSize{12};
+const uint32_t kRtcpMinSize{8};
+
+uint16_t read16(const uint8_t* ptr) {
+  return (ptr[0] << 8) | ptr[1];
+}
+}  // namespace
+
+namespace chai {
+bool Endpoint::operator<(const Endpoint& other) const {
+  if (this->family != other.family) {
+    return this->family < other.family;
+  }
+  int compare = memcmp(this->address, other.address, sizeof(this->address));
+  if (compare != 0) {
+    return compare < 0;
+  }
+  return this->port < other.port;
+}
+
+bool Endpoint::operator==(const Endpoint& other) const {
+  return this->family == other.family && this->port == other.port &&
+         memcmp(this->address, other.address, sizeof(this->address)) == 0;
+}
+
+std::string Endpoint::toString() const {
+  std::ostringstream oss;
+  if (this->family == 0) {
+    return "unknown";
+  } else if (this->family == 4) {
+    oss << int(this->address[0]) << "." << int(this->address[1]) << "."
+        << int(this->address[2]) << "." << int(this->address[3]);
+  } else {
+    oss << "[" << std::hex;
+    for (int i = 0; i < 16; i += 2) {
+      oss << (i ? ":" : "") << read16(this->address + i);
+    }
+    oss << "]" << std::dec;
+  }
+  oss << ":" << this->port;
+  return oss.str();
+}
+
+bool Flow::operator<(const Flow& other) const {
+  return std::tie(this->source, this->destination) <
+         std::tie(other.source, other.destination);
+}
+
+bool Flow::operator==(const Flow& other) const {
+  return this->source == other.source && this->destination == other.destination;
+}
+
+std::string Flow::toString() const {
+  return this->source.toString() + " > " + this->destination.toString();
+}
+
+bool NetDemux::parse(uint16_t linkType,
+                     const uint8_t* data,
+                     uint32_t length,
+                     UdpDatagram* datagram) {
+  switch (linkType) {
+    case LinkType::kLinkEthernet: {
+      if (length < kEthernetHeaderSize) {
+        return false;
+      }
+      uint32_t offset{12};
+      uint16_t etherType = read16(data + offset);
+      // Stacked VLAN tags.
+      while ((etherType == kEtherTypeVlan || etherType == kEtherTypeQinQ) &&
+             offset + 6 <= length) {
+        offset += 4;
+        etherType = read16(data + offset);
+      }
+      offset += 2;
+      return parseIp(etherType, data + offset, length - offset, datagram);
+    }
+    case LinkType::kLinkLinuxSll:
+      if (length < kLinuxSllHeaderSize) {
+        return false;
+      }
+      return parseIp(read16(data + 14), data + kLinuxSllHeaderSize,
+                     length - kLinuxSllHeaderSize, datagram);
+    case LinkType::kLinkLinuxSll2:
+      if (length < kLinuxSll2HeaderSize) {
+        return false;
+      }
+      return parseIp(read16(data), data + kLinuxSll2HeaderSize,
+                     length - kLinuxSll2HeaderSize, datagram);
+    case LinkType::kLinkNull:
+    case LinkType::kLinkLoop:
+      // 4-byte address family in host (NULL) or network (LOOP) byte order;
+      // the IP version nibble tells us what follows just as well.
+      if (length < 4) {
+        return false;
+      }
+      return parseIp(0, data + 4, length - 4, datagram);
+    case LinkType::kLinkRaw:
+    case LinkType::kLinkIpv4:
+    case LinkType::kLinkIpv6:
+      return parseIp(0, data, length, datagram);
+    default:
+      return false;
+  }
+}
+
+// |etherType| 0 means "look at the IP version nibble".
+bool NetDemux::parseIp(uint16_t etherType,
+                       const uint8_t* data,
+                       uint32_t length,
+                       UdpDatagram* datagram) {
+  if (length == 0) {
+    return false;
+  }
+  uint8_t version = data[0] >> 4;
+  if ((etherType == 0 || etherType == kEtherTypeIpv4) && version == 4) {
+    return parseIpv4(data, length, datagram);
+  }
+  if ((etherType == 0 || etherType == kEtherTypeIpv6) && version == 6) {
+    return parseIpv6(data, length, datagram);
+  }
+  return false;
+}
+
+bool NetDemux::parseIpv4(const uint8_t* data,
+                         uint32_t length,
+                         UdpDatagram* datagram) {
+  if (length < kIpv4MinHeaderSize) {
+    return false;
+  }
+  uint32_t headerLength = (data[0] & 0x0f) * 4;
+  uint32_t totalLength = read16(data + 2);
+  uint16_t fragment = read16(data + 6);
+  // More fragments set, or a non-zero fragment offset.
+  if (headerLength < kIpv4MinHeaderSize || (fragment & 0x3fff) ||
+      data[9] != kIpProtocolUdp) {
+    return false;
+  }
+  // Ethernet pads short frames, and TSO captures may report 0.
+  if (totalLength >= headerLength && totalLength < length) {
+    length = totalLength;
+  }
+  if (length < headerLength) {
+    return false;
+  }
+
+  datagram->flow.source.family = 4;
+  datagram->flow.destination.family = 4;
+  memcpy(datagram->flow.source.address, data + 12, 4);
+  memcpy(datagram->flow.destination.address, data + 16, 4);
+  return parseUdp(data + headerLength, length - headerLength, datagram);
+}
+
+bool NetDemux::parseIpv6(const uint8_t* data,
+                         uint32_t length,
+                         UdpDatagram* datagram) {
+  if (length < kIpv6HeaderSize) {
+    return false;
+  }
+  uint32_t payloadLength = read16(data + 4);
+  if (payloadLength && kIpv6HeaderSize + payloadLength < length) {
+    length = kIpv6HeaderSize + payloadLength;
+  }
+
+  uint8_t next = data[6];
+  uint32_t offset{kIpv6HeaderSize};
+  while (next != kIpProtocolUdp) {
+    if (offset + 8 > length) {
+      return false;
+    }
+    switch (next) {
+      case kIpv6HopByHop:
+      case kIpv6Routing:
+      case kIpv6DestinationOptions:
+        next = data[offset];
+        offset += (data[offset + 1] + 1) * 8;
+        break;
+      case kIpv6Fragment:
+        // Only an unfragmented "atomic" fragment can be demuxed.
+        if (read16(data + offset + 2) & 0xfff9) {
+          return false;
+        }
+        next = data[offset];
+        offset += 8;
+        break;
+      default:
+        return false;
+    }
+  }
+  if (offset > length) {
+    return false;
+  }
+
+  datagram->flow.source.family = 6;
+  datagram->flow.destination.family = 6;
+  memcpy(datagram->flow.source.address, data + 8, 16);
+  memcpy(datagram->flow.destination.address, data + 24, 16);
+  return parseUdp(data + offset, length - offset, datagram);
+}
+
+bool NetDemux::parseUdp(const uint8_t* data,
+                        uint32_t length,
+                        UdpDatagram* datagram) {
+  if (length < kUdpHeaderSize) {
+    return false;
+  }
+  uint32_t udpLength = read16(data + 4);
+  if (udpLength >= kUdpHeaderSize && udpLength < length) {
+    length = udpLength;
+  }
+  datagram->flow.source.port = read16(data);
+  datagram->flow.destination.port = read16(data + 2);
+  datagram->payload = data + kUdpHeaderSize;
+  datagram->length = length - kUdpHeaderSize;
+  return true;
+}
+
+/*
+               +----------------+
+               |        [0..3] -+--> forward to STUN
+               |                |
+               |      [16..19] -+--> forward to ZRTP
+               |                |
+   packet -->  |      [20..63] -+--> forward to DTLS
+               |                |
+               |      [64..79] -+--> forward to TURN Channel
+               |                |
+               |    [128..191] -+--> forward to RTP/RTCP
+               +----------------+
+*/
+PayloadKind NetDemux::classify(const uint8_t* payload, uint32_t length) {
+  if (length < kRtcpMinSize || payload[0] < 128 || payload[0] > 191) {
+    return PayloadKind::kOther;
+  }
+  // RTCP packet types 192..223 collide with RTP payload types 64..95, which
+  // RFC 5761 forbids for RTP when muxing.
+  uint8_t packetType = payload[1];
+  if (packetType >= 192 && packetType <= 223) {
+    return PayloadKind::kRtcp;
+  }
+  return length >= kRtpMinSize ? PayloadKind::kRtp : PayloadKind::kOther;
+}
+
+PayloadKind NetDemux::classify(const uint8_t* payload,
+                               uint32_t length,
+                               bool rtcp) {
+  if (classify(payload, length) == PayloadKind::kOther) {
+    return PayloadKind::kOther;
+  }
+  if (rtcp) {
+    return length >= kRtcpMinSize ? PayloadKind::kRtcp : PayloadKind::kOther;
+  }
+  return length >= kRtpMinSize ? PayloadKind::kRtp : PayloadKind::kOther;
+}
+}  // namespace chai
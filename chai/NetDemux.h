@@ -0,0 +1,87 @@
+#ifndef CHAI_NET_DEMUX_H
+#define CHAI_NET_DEMUX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace chai {
+// LINKTYPE_* values from https://www.tcpdump.org/linktypes.html.
+enum LinkType : uint16_t {
+  kLinkNull = 0,
+  kLinkEthernet = 1,
+  kLinkRaw = 101,
+  kLinkLoop = 108,
+  kLinkLinuxSll = 113,
+  kLinkIpv4 = 228,
+  kLinkIpv6 = 229,
+  kLinkLinuxSll2 = 276,
+};
+
+struct Endpoint {
+  uint8_t family{0};  // 4 or 6
+  uint8_t address[16]{};
+  uint16_t port{0};
+
+  bool operator<(const Endpoint& other) const;
+  bool operator==(const Endpoint& other) const;
+  std::string toString() const;
+};
+
+// A UDP flow, in the direction the datagram was sent.
+struct Flow {
+  Endpoint source;
+  Endpoint destination;
+
+  bool operator<(const Flow& other) const;
+  bool operator==(const Flow& other) const;
+  std::string toString() const;
+};
+
+struct UdpDatagram {
+  Flow flow;
+  const uint8_t* payload{nullptr};
+  uint32_t length{0};
+};
+
+enum class PayloadKind : uint8_t { kOther, kRtp, kRtcp };
+
+// Strips link, IP and UDP headers off a captured frame. Handles Ethernet
+// (with 802.1Q/802.1ad tags), Linux cooked v1/v2, BSD loopback and raw IP;
+// IPv4 fragments other than a complete first fragment are skipped since they
+// can't be demuxed without reassembly.
+class NetDemux {
+ public:
+  static bool parse(uint16_t linkType,
+                    const uint8_t* data,
+                    uint32_t length,
+                    UdpDatagram* datagram);
+  // RTP/RTCP multiplexing (RFC 5761, RFC 7983): tells media from STUN, DTLS
+  // and TURN channel data sharing the same 5-tuple.
+  static PayloadKind classify(const uint8_t* payload, uint32_t length);
+  // For captures that record whether a packet is RTCP (rtpdump, the flight
+  // recorder): |rtcp| decides between the two, but only if classify() sees
+  // media and the packet is long enough for that header. Otherwise kOther.
+  static PayloadKind classify(const uint8_t* payload,
+                              uint32_t length,
+                              bool rtcp);
+
+ protected:
+  static bool parseIp(uint16_t etherType,
+                      const uint8_t* data,
+                      uint32_t length,
+                      UdpDatagram* datagram);
+  static bool parseIpv4(const uint8_t* data,
+                        uint32_t length,
+                        UdpDatagram* datagram);
+  static bool parseIpv6(const uint8_t* data,
+                        uint32_t length,
+                        UdpDatagram* datagram);
+  static bool parseUdp(const uint8_t* data,
+                       uint32_t length,
+                       UdpDatagram* datagram);
+};
+}  // namespace chai
+
+#endif  // CHAI_NET_DEMUX_H
@@ -0,0 +1,281 @@
+#include "OpusPacket.h"
+
+#include <vector>
+
+namespace {
+using chai::OpusBandwidth;
+using chai::OpusMode;
+
+// RFC 6716 3.2.1: no frame is longer than this.
+const uint16_t kMaxFrameSize{1275};
+// 3.2.5: nor is a packet longer than 120 ms.
+const uint32_t kMaxPacketSamples{5760};
+// SILK codes 40 and 60 ms frames as 20 ms frames, 4.2.2.
+const uint16_t kSilkFrameSamples{960};
+
+struct TocConfig {
+  OpusMode mode;
+  OpusBandwidth bandwidth;
+  // Samples at 48 kHz.
+  uint16_t frameSamples;
+};
+
+/*
+   +-----------------------+-----------+-----------+-------------------+
+   | Configuration         | Mode      | Bandwidth | Frame Sizes       |
+   | Number(s)             |           |           |                   |
+   +-----------------------+-----------+-----------+-------------------+
+   | 0...3                 | SILK-only | NB        | 10, 20, 40, 60 ms |
+   | 4...7                 | SILK-only | MB        | 10, 20, 40, 60 ms |
+   | 8...11                | SILK-only | WB        | 10, 20, 40, 60 ms |
+   | 12...13               | Hybrid    | SWB       | 10, 20 ms         |
+   | 14...15               | Hybrid    | FB        | 10, 20 ms         |
+   | 16...19               | CELT-only | NB        | 2.5, 5, 10, 20 ms |
+   | 20...23               | CELT-only | WB        | 2.5, 5, 10, 20 ms |
+   | 24...27               | CELT-only | SWB       | 2.5, 5, 10, 20 ms |
+   | 28...31               | CELT-only | FB        | 2.5, 5, 10, 20 ms |
+   +-----------------------+-----------+-----------+-------------------+
+                                Table 2: TOC Byte Configuration Parameters
+*/
+const TocConfig kTocConfigs[32] = {
+    {OpusMode::kSilk, OpusBandwidth::kNarrowband, 480},
+    {OpusMode::kSilk, OpusBandwidth::kNarrowband, 960},
+    {OpusMode::kSilk, OpusBandwidth::kNarrowband, 1920},
+    {OpusMode::kSilk, OpusBandwidth::kNarrowband, 2880},
+    {OpusMode::kSilk, OpusBandwidth::kMediumband, 480},
+    {OpusMode::kSilk, OpusBandwidth::kMediumband, 960},
+    {OpusMode::kSilk, OpusBandwidth::kMediumband, 1920},
+    {OpusMode::kSilk, OpusBandwidth::kMediumband, 2880},
+    {OpusMode::kSilk, OpusBandwidth::kWideband, 480},
+    {OpusMode::kSilk, OpusBandwidth::kWideband, 960},
+    {OpusMode::kSilk, OpusBandwidth::kWideband, 1920},
+    {OpusMode::kSilk, OpusBandwidth::kWideband, 2880},
+    {OpusMode::kHybrid, OpusBandwidth::kSuperWideband, 480},
+    {OpusMode::kHybrid, OpusBandwidth::kSuperWideband, 960},
+    {OpusMode::kHybrid, OpusBandwidth::kFullband, 480},
+    {OpusMode::kHybrid, OpusBandwidth::kFullband, 960},
+    {OpusMode::kCelt, OpusBandwidth::kNarrowband, 120},
+    {OpusMode::kCelt, OpusBandwidth::kNarrowband, 240},
+    {OpusMode::kCelt, OpusBandwidth::kNarrowband, 480},
+    {OpusMode::kCelt, OpusBandwidth::kNarrowband, 960},
+    {OpusMode::kCelt, OpusBandwidth::kWideband, 120},
+    {OpusMode::kCelt, OpusBandwidth::kWideband, 240},
+    {OpusMode::kCelt, OpusBandwidth::kWideband, 480},
+    {OpusMode::kCelt, OpusBandwidth::kWideband, 960},
+    {OpusMode::kCelt, OpusBandwidth::kSuperWideband, 120},
+    {OpusMode::kCelt, OpusBandwidth::kSuperWideband, 240},
+    {OpusMode::kCelt, OpusBandwidth::kSuperWideband, 480},
+    {OpusMode::kCelt, OpusBandwidth::kSuperWideband, 960},
+    {OpusMode::kCelt, OpusBandwidth::kFullband, 120},
+    {OpusMode::kCelt, OpusBandwidth::kFullband, 240},
+    {OpusMode::kCelt, OpusBandwidth::kFullband, 480},
+    {OpusMode::kCelt, OpusBandwidth::kFullband, 960},
+};
+
+const char* const kModeNames[] = {"SILK-only", "Hybrid", "CELT-only"};
+
+/*
+   +----------------------+-----------------+-------------------------+
+   | Abbreviation         | Audio Bandwidth | Sample Rate (Effective) |
+   +----------------------+-----------------+-------------------------+
+   | NB (narrowband)      |           4 kHz |                   8 kHz |
+   | MB (medium-band)     |           6 kHz |                  12 kHz |
+   | WB (wideband)        |           8 kHz |                  16 kHz |
+   | SWB (super-wideband) |          12 kHz |                  24 kHz |
+   | FB (fullband)        |      20 kHz (*) |                  48 kHz |
+   +----------------------+-----------------+-------------------------+
+*/
+const char* const kBandwidthNames[] = {"NB", "MB", "WB", "SWB", "FB"};
+
+// 3.2.1: one byte below 252, two bytes otherwise.
+bool readFrameLength(const uint8_t* data,
+                     size_t size,
+                     size_t* offset,
+                     uint16_t* length) {
+  if (*offset >= size) {
+    return false;
+  }
+  uint16_t first = data[(*offset)++];
+  if (first < 252) {
+    *length = first;
+    return true;
+  }
+  if (*offset >= size) {
+    return false;
+  }
+  *length = first + 4 * data[(*offset)++];
+  return true;
+}
+
+// 4.2.3: the SILK layer starts with, per channel, one VAD flag for each
+// 20 ms SILK frame and then the LBRR flag. They are coded with probability
+// 1/2, so they are the leading bits of the range coded frame as is.
+void silkHeaderFlags(uint8_t first,
+                     int silkFrames,
+                     bool stereo,
+                     chai::OpusPacketInfo* packet) {
+  uint8_t vadMask = uint8_t((1 << silkFrames) - 1);
+  int shift = 8 - silkFrames;
+  packet->voiceActivity |= ((first >> shift) & vadMask) != 0;
+  packet->lbrr |= (first >> (shift - 1)) & 0x01;
+  if (stereo) {
+    shift -= silkFrames + 1;
+    packet->voiceActivity |= ((first >> shift) & vadMask) != 0;
+    packet->lbrr |= (first >> (shift - 1)) & 0x01;
+  }
+}
+}  // namespace
+
+namespace chai {
+const int OpusPacketInfo::kMaxFrames;
+
+nlohmann::json OpusPacketInfo::toJson() const {
+  nlohmann::json json = {
+      {"config", this->config},
+      {"mode", kModeNames[int(this->mode)]},
+      {"bandwidth", kBandwidthNames[int(this->bandwidth)]},
+      {"stereo", this->stereo},
+      {"code", this->code},
+      {"frame_duration_ms", this->frameSamples / 48.0},
+      {"frame_count", this->frameCount},
+      {"duration_ms", this->durationSamples() / 48.0},
+      {"frame_sizes", std::vector<uint16_t>(
+                          this->frameSizes, this->frameSizes + this->frameCount)},
+      {"dtx", this->dtx},
+  };
+  if (this->code == 3) {
+    json["vbr"] = this->vbr;
+    json["padding_length"] = this->paddingLength;
+  }
+  if (this->hasSilk) {
+    json["voice_activity"] = this->voiceActivity;
+    json["lbrr"] = this->lbrr;
+  }
+  if (this->bandwidthChanged) {
+    json["previous_bandwidth"] =
+        kBandwidthNames[int(this->previousBandwidth)];
+  }
+  return json;
+}
+
+bool parseOpusPacket(const uint8_t* data, size_t size, OpusPacketInfo* packet) {
+  *packet = OpusPacketInfo();
+  // R1: at least the TOC byte.
+  if (size == 0) {
+    return false;
+  }
+  uint8_t toc = data[0];
+  packet->config = toc >> 3;
+  const TocConfig& config = kTocConfigs[packet->config];
+  packet->mode = config.mode;
+  packet->bandwidth = config.bandwidth;
+  packet->frameSamples = config.frameSamples;
+  packet->stereo = toc & 0x04;
+  packet->code = toc & 0x03;
+
+  size_t offset = 1;
+  switch (packet->code) {
+    case 0:
+      // R2: one frame, the rest of the packet.
+      packet->frameCount = 1;
+      if (size - offset > kMaxFrameSize) {
+        return false;
+      }
+      packet->frameSizes[0] = uint16_t(size - offset);
+      break;
+    case 1:
+      // R3: two frames of equal size.
+      packet->frameCount = 2;
+      if ((size - offset) % 2 || (size - offset) / 2 > kMaxFrameSize) {
+        return false;
+      }
+      packet->frameSizes[0] = packet->frameSizes[1] =
+          uint16_t((size - offset) / 2);
+      break;
+    case 2: {
+      // R4: N1 is coded, the second frame is the rest.
+      packet->frameCount = 2;
+      uint16_t first = 0;
+      if (!readFrameLength(data, size, &offset, &first) ||
+          first > size - offset || size - offset - first > kMaxFrameSize) {
+        return false;
+      }
+      packet->frameSizes[0] = first;
+      packet->frameSizes[1] = uint16_t(size - offset - first);
+      break;
+    }
+    default: {
+      // R5: the frame count byte, |v|p|   M   |.
+      if (offset >= size) {
+        return false;
+      }
+      uint8_t count = data[offset++];
+      packet->vbr = count & 0x80;
+      packet->frameCount = count & 0x3f;
+      if (packet->frameCount == 0 ||
+          packet->durationSamples() > kMaxPacketSamples) {
+        return false;
+      }
+      // R6/R7: a padding length byte of 255 adds 254 bytes and another
+      // length byte.
+      if (count & 0x40) {
+        uint8_t pad = 255;
+        while (pad == 255) {
+          if (offset >= size) {
+            return false;
+          }
+          pad = data[offset++];
+          packet->paddingLength += pad == 255 ? 254 : pad;
+        }
+      }
+      if (packet->paddingLength > size - offset) {
+        return false;
+      }
+      size_t end = size - packet->paddingLength;
+      if (packet->vbr) {
+        size_t total = 0;
+        for (int i = 0; i + 1 < packet->frameCount; ++i) {
+          if (!readFrameLength(data, end, &offset,
+                               &packet->frameSizes[i])) {
+            return false;
+          }
+          total += packet->frameSizes[i];
+        }
+        if (total > end - offset || end - offset - total > kMaxFrameSize) {
+          return false;
+        }
+        packet->frameSizes[packet->frameCount - 1] =
+            uint16_t(end - offset - total);
+      } else {
+        size_t bytes = end - offset;
+        if (bytes % packet->frameCount ||
+            bytes / packet->frameCount > kMaxFrameSize) {
+          return false;
+        }
+        for (int i = 0; i < packet->frameCount; ++i) {
+          packet->frameSizes[i] = uint16_t(bytes / packet->frameCount);
+        }
+      }
+      break;
+    }
+  }
+
+  // Decoders conceal frames of a byte or less instead of decoding them.
+  packet->hasSilk = packet->mode != OpusMode::kCelt;
+  int silkFrames = packet->frameSamples > kSilkFrameSamples
+                       ? packet->frameSamples / kSilkFrameSamples
+                       : 1;
+  packet->dtx = true;
+  for (int i = 0; i < packet->frameCount; ++i) {
+    uint16_t frameSize = packet->frameSizes[i];
+    if (frameSize > 1) {
+      packet->dtx = false;
+      if (packet->hasSilk) {
+        silkHeaderFlags(data[offset], silkFrames, packet->stereo, packet);
+      }
+    }
+    offset += frameSize;
+  }
+  return true;
+}
+}  // namespace chai
@@ -0,0 +1,69 @@
+#ifndef CHAI_OPUS_PACKET_H
+#define CHAI_OPUS_PACKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <json.hpp>
+
+namespace chai {
+enum class OpusMode : uint8_t { kSilk, kHybrid, kCelt };
+
+enum class OpusBandwidth : uint8_t {
+  kNarrowband,
+  kMediumband,
+  kWideband,
+  kSuperWideband,
+  kFullband,
+};
+
+// One Opus packet, RFC 6716 3.1: the TOC byte and the framing of its code,
+//
+//       0 1 2 3 4 5 6 7
+//      +-+-+-+-+-+-+-+-+
+//      | config  |s| c |
+//      +-+-+-+-+-+-+-+-+
+//
+// and what the frames tell without decoding them: the VAD and LBRR flags
+// at the start of the SILK layer (4.2.3), and DTX.
+struct OpusPacketInfo {
+  // 3.2.5: at most 120 ms of 2.5 ms frames.
+  static const int kMaxFrames{48};
+
+  nlohmann::json toJson() const;
+
+  uint8_t config{0};
+  OpusMode mode{OpusMode::kSilk};
+  OpusBandwidth bandwidth{OpusBandwidth::kNarrowband};
+  bool stereo{false};
+  uint8_t code{0};
+
+  // Samples at 48 kHz, so 2.5 ms frames are whole.
+  uint16_t frameSamples{0};
+  uint8_t frameCount{0};
+  uint16_t frameSizes[kMaxFrames]{};
+  // Code 3 only.
+  bool vbr{false};
+  uint16_t paddingLength{0};
+
+  // SILK-only and hybrid packets: whether any frame has voice activity or
+  // carries LBRR (in-band FEC) data for the previous packet.
+  bool hasSilk{false};
+  bool voiceActivity{false};
+  bool lbrr{false};
+  // No more than a TOC and an empty frame, as sent while DTX is on.
+  bool dtx{false};
+
+  // Filled by PayloadOpus from the stream.
+  bool bandwidthChanged{false};
+  OpusBandwidth previousBandwidth{OpusBandwidth::kNarrowband};
+
+  uint32_t durationSamples() const { return frameSamples * frameCount; }
+};
+
+// Parses the Opus packet |data| into |packet|. Returns false if it breaks
+// the framing rules of RFC 6716 3.4.
+bool parseOpusPacket(const uint8_t* data, size_t size, OpusPacketInfo* packet);
+}  // namespace chai
+
+#endif  // CHAI_OPUS_PACKET_H
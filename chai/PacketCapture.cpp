@@ -0,0 +1,266 @@
+#define MSC_CLASS "PacketCapture"
+
+#include "PacketCapture.h"
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "NetDemux.h"
+
+namespace {
+std::string systemError(const char* call) {
+  return std::string(call) + ": " + std::strerror(errno);
+}
+}  // namespace
+
+namespace chai {
+PacketCapture::~PacketCapture() {
+  this->close();
+}
+
+bool PacketCapture::open(const std::string& interface,
+                         const std::string& filterPath) {
+  this->close();
+
+  unsigned int ifindex = if_nametoindex(interface.c_str());
+  if (ifindex == 0) {
+    this->error_ = "no such interface " + interface;
+    return false;
+  }
+
+  // Protocol 0 receives nothing until bind() below sets ETH_P_ALL, so no
+  // frame is queued outside the ring and the filter.
+  this->fd_ = ::socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, 0);
+  if (this->fd_ < 0) {
+    this->error_ = systemError("socket");
+    return false;
+  }
+
+  // The link layer decides how NetDemux strips the frames.
+  ifreq ifr{};
+  std::strncpy(ifr.ifr_name, interface.c_str(), IFNAMSIZ - 1);
+  if (ioctl(this->fd_, SIOCGIFHWADDR, &ifr) != 0) {
+    this->error_ = systemError("SIOCGIFHWADDR");
+    this->close();
+    return false;
+  }
+  switch (ifr.ifr_hwaddr.sa_family) {
+    case ARPHRD_LOOPBACK:
+      this->loopback_ = true;
+      // Loopback frames carry an Ethernet header with zero addresses.
+      this->linkType_ = kLinkEthernet;
+      break;
+    case ARPHRD_ETHER:
+      this->linkType_ = kLinkEthernet;
+      break;
+    case ARPHRD_NONE:
+#ifdef ARPHRD_RAWIP
+    case ARPHRD_RAWIP:
+#endif
+      // tun devices: bare IP packets.
+      this->linkType_ = kLinkRaw;
+      break;
+    default:
+      this->error_ = "unsupported link type " +
+                     std::to_string(ifr.ifr_hwaddr.sa_family) + " on " +
+                     interface;
+      this->close();
+      return false;
+  }
+
+  // Filter before the ring is set up, so nothing unfiltered gets queued.
+  if (!filterPath.empty() && !this->attachFilter(filterPath)) {
+    this->close();
+    return false;
+  }
+
+  int version = TPACKET_V3;
+  if (setsockopt(this->fd_, SOL_PACKET, PACKET_VERSION, &version,
+                 sizeof(version)) != 0) {
+    this->error_ = systemError("PACKET_VERSION");
+    this->close();
+    return false;
+  }
+
+  tpacket_req3 req{};
+  req.tp_block_size = kBlockSize;
+  req.tp_block_nr = kBlockCount;
+  req.tp_frame_size = kFrameSize;
+  req.tp_frame_nr = kBlockSize / kFrameSize * kBlockCount;
+  req.tp_retire_blk_tov = kBlockTimeoutMs;
+  if (setsockopt(this->fd_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) !=
+      0) {
+    this->error_ = systemError("PACKET_RX_RING");
+    this->close();
+    return false;
+  }
+
+  this->ringSize_ = size_t(kBlockSize) * kBlockCount;
+  void* ring = mmap(nullptr, this->ringSize_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_LOCKED, this->fd_, 0);
+  if (ring == MAP_FAILED) {
+    // MAP_LOCKED fails beyond RLIMIT_MEMLOCK; the ring works without it.
+    ring = mmap(nullptr, this->ringSize_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                this->fd_, 0);
+  }
+  if (ring == MAP_FAILED) {
+    this->error_ = systemError("mmap");
+    this->ringSize_ = 0;
+    this->close();
+    return false;
+  }
+  this->ring_ = static_cast<uint8_t*>(ring);
+
+  sockaddr_ll address{};
+  address.sll_family = AF_PACKET;
+  address.sll_protocol = htons(ETH_P_ALL);
+  address.sll_ifindex = int(ifindex);
+  if (bind(this->fd_, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0) {
+    this->error_ = systemError("bind");
+    this->close();
+    return false;
+  }
+
+  this->current_ = 0;
+  this->drops_ = 0;
+  return true;
+}
+
+void PacketCapture::close() {
+  if (this->ring_) {
+    munmap(this->ring_, this->ringSize_);
+    this->ring_ = nullptr;
+    this->ringSize_ = 0;
+  }
+  if (this->fd_ >= 0) {
+    ::close(this->fd_);
+    this->fd_ = -1;
+  }
+  this->loopback_ = false;
+}
+
+/*
+  tcpdump -ddd output: the instruction count, then one instruction per line
+  as decimal "code jt jf k".
+
+  4
+  40 0 0 12
+  21 0 1 2048
+  6 0 0 262144
+  6 0 0 0
+*/
+bool PacketCapture::attachFilter(const std::string& filterPath) {
+  std::ifstream file(filterPath);
+  if (!file) {
+    this->error_ = "can't open " + filterPath;
+    return false;
+  }
+
+  size_t count{0};
+  file >> count;
+  if (!file || count == 0 || count > BPF_MAXINSNS) {
+    this->error_ = filterPath + ": not a tcpdump -ddd program";
+    return false;
+  }
+  std::vector<sock_filter> program(count);
+  for (auto& instruction : program) {
+    unsigned code, jt, jf, k;
+    if (!(file >> code >> jt >> jf >> k)) {
+      this->error_ = filterPath + ": truncated program";
+      return false;
+    }
+    instruction.code = uint16_t(code);
+    instruction.jt = uint8_t(jt);
+    instruction.jf = uint8_t(jf);
+    instruction.k = uint32_t(k);
+  }
+
+  sock_fprog fprog{};
+  fprog.len = uint16_t(program.size());
+  fprog.filter = program.data();
+  if (setsockopt(this->fd_, SOL_SOCKET, SO_ATTACH_FILTER, &fprog,
+                 sizeof(fprog)) != 0) {
+    this->error_ = systemError("SO_ATTACH_FILTER");
+    return false;
+  }
+  return true;
+}
+
+bool PacketCapture::next(int timeoutMs, CaptureBlock* block) {
+  auto* desc =
+      reinterpret_cast<tpacket_block_desc*>(this->block(this->current_));
+  while ((__atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_ACQUIRE) &
+          TP_STATUS_USER) == 0) {
+    pollfd pfd{this->fd_, POLLIN | POLLERR, 0};
+    int ready = poll(&pfd, 1, timeoutMs);
+    if (ready < 0 && errno != EINTR) {
+      this->error_ = systemError("poll");
+      return false;
+    }
+    if (ready <= 0) {
+      return false;
+    }
+  }
+
+  block->index = this->current_;
+  block->frame =
+      this->block(this->current_) + desc->hdr.bh1.offset_to_first_pkt;
+  block->remaining = desc->hdr.bh1.num_pkts;
+  this->current_ = (this->current_ + 1) % kBlockCount;
+  return true;
+}
+
+bool PacketCapture::nextFrame(CaptureBlock* block, PcapRecord* record) {
+  while (block->remaining > 0) {
+    const auto* header = reinterpret_cast<const tpacket3_hdr*>(block->frame);
+    const auto* address = reinterpret_cast<const sockaddr_ll*>(
+        block->frame + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+    --block->remaining;
+    block->frame += header->tp_next_offset;
+
+    if (this->loopback_ && address->sll_pkttype == PACKET_OUTGOING) {
+      continue;
+    }
+    record->data = reinterpret_cast<const uint8_t*>(header) + header->tp_mac;
+    record->length = header->tp_snaplen;
+    record->originalLength = header->tp_len;
+    record->timeUs =
+        int64_t(header->tp_sec) * 1000000 + header->tp_nsec / 1000;
+    record->linkType = this->linkType_;
+    return true;
+  }
+  return false;
+}
+
+void PacketCapture::release(const CaptureBlock& block) {
+  auto* desc = reinterpret_cast<tpacket_block_desc*>(this->block(block.index));
+  __atomic_store_n(&desc->hdr.bh1.block_status, TP_STATUS_KERNEL,
+                   __ATOMIC_RELEASE);
+}
+
+uint64_t PacketCapture::drops() {
+  // The kernel resets the counters on every read.
+  tpacket_stats_v3 stats{};
+  socklen_t size = sizeof(stats);
+  if (this->fd_ >= 0 && getsockopt(this->fd_, SOL_PACKET, PACKET_STATISTICS,
+                                   &stats, &size) == 0) {
+    this->drops_ += stats.tp_drops;
+  }
+  return this->drops_;
+}
+}  // namespace chai
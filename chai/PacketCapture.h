@@ -0,0 +1,80 @@
+#ifndef CHAI_PACKET_CAPTURE_H
+#define CHAI_PACKET_CAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "PcapReader.h"
+
+namespace chai {
+// A block of the capture ring handed over by the kernel. Its frames stay
+// valid until PacketCapture::release().
+struct CaptureBlock {
+  uint32_t index{0};
+  // Next frame header to read, and frames left.
+  const uint8_t* frame{nullptr};
+  uint32_t remaining{0};
+};
+
+// Live capture from an AF_PACKET socket with a TPACKET_V3 ring mapped into
+// our address space. The kernel fills whole blocks of frames; the reader
+// walks them in place and hands each block back once nothing refers to its
+// frames any more, so captured bytes are never copied.
+//
+// Linux only; needs CAP_NET_RAW.
+class PacketCapture {
+ public:
+  static const uint32_t kBlockSize{1 << 20};
+  static const uint32_t kBlockCount{64};
+  static const uint32_t kFrameSize{2048};
+  // A block is handed over when full or after this long, whichever comes
+  // first.
+  static const uint32_t kBlockTimeoutMs{10};
+
+  PacketCapture() = default;
+  ~PacketCapture();
+  PacketCapture(const PacketCapture&) = delete;
+  PacketCapture& operator=(const PacketCapture&) = delete;
+
+  // |filterPath| optionally names a classic BPF program in the format of
+  // tcpdump -ddd, e.g. tcpdump -i lo -ddd udp > rtp.bpf
+  bool open(const std::string& interface, const std::string& filterPath = "");
+  void close();
+
+  // Waits up to |timeoutMs| for the kernel to hand over the next block.
+  // Returns false on timeout or on error (see error()).
+  bool next(int timeoutMs, CaptureBlock* block);
+  // The next frame of |block|, with its link layer header. Returns false
+  // once the block is exhausted.
+  bool nextFrame(CaptureBlock* block, PcapRecord* record);
+  // Gives |block| back to the kernel. Blocks must be released in the order
+  // next() returned them.
+  void release(const CaptureBlock& block);
+
+  // Frames the kernel dropped because every block was held by us.
+  uint64_t drops();
+  const std::string& error() const { return error_; }
+
+ protected:
+  bool attachFilter(const std::string& filterPath);
+  uint8_t* block(uint32_t index) const {
+    return ring_ + size_t(index) * kBlockSize;
+  }
+
+ private:
+  int fd_{-1};
+  uint8_t* ring_{nullptr};
+  size_t ringSize_{0};
+  uint16_t linkType_{0};
+  // On loopback every packet shows up twice, outgoing and incoming.
+  bool loopback_{false};
+  // Next block the kernel will hand over.
+  uint32_t current_{0};
+  uint64_t drops_{0};
+  std::string error_;
+};
+}  // namespace chai
+
+#endif  // CHAI_PACKET_CAPTURE_H
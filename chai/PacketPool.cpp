@@ -0,0 +1,44 @@
+#include "PacketPool.h"
+
+namespace chai {
+PacketPool::PacketPool(size_t capacity) : slots_(capacity) {
+  for (auto& slot : slots_) {
+    slot.next = free_.load(std::memory_order_relaxed);
+    free_.store(&slot, std::memory_order_relaxed);
+  }
+}
+
+PacketSlot* PacketPool::Acquire() {
+  // Single popper: a node can't be popped and pushed back behind our back, so
+  // reading head->next before the CAS is safe (no ABA).
+  PacketSlot* head = free_.load(std::memory_order_acquire);
+  while (head && !free_.compare_exchange_weak(head, head->next,
+                                              std::memory_order_acquire,
+                                              std::memory_order_acquire)) {
+  }
+  if (!head) {
+    exhausted_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  head->next = nullptr;
+  return head;
+}
+
+void PacketPool::Release(PacketSlot* slot) {
+  // Drop our reference without touching the allocator. CopyOnWriteBuffer's
+  // Clear() would allocate a fresh buffer while the storage is still shared.
+  slot->buffer = rtc::CopyOnWriteBuffer();
+  slot->data = nullptr;
+  slot->size = 0;
+  slot->timeUs = 0;
+  slot->kind = PacketKind::kRtp;
+  slot->direction = Direction::kRecv;
+  slot->dropped = 0;
+
+  PacketSlot* head = free_.load(std::memory_order_relaxed);
+  do {
+    slot->next = head;
+  } while (!free_.compare_exchange_weak(head, slot, std::memory_order_release,
+                                        std::memory_order_relaxed));
+}
+}  // namespace chai
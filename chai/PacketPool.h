@@ -0,0 +1,59 @@
+#ifndef CHAI_PACKET_POOL_H
+#define CHAI_PACKET_POOL_H
+
+#include <rtc_base/copy_on_write_buffer.h>
+
+#include <atomic>
+#include <vector>
+
+namespace chai {
+enum class PacketKind : uint8_t { kRtp, kRtcp };
+enum class Direction : uint8_t { kRecv, kSend };
+
+// A tapped packet waiting to be parsed. |buffer| shares the storage of the
+// rtc::CopyOnWriteBuffer handed to the tap, so filling a slot only bumps a
+// reference count: no allocation and no memcpy.
+struct PacketSlot {
+  rtc::CopyOnWriteBuffer buffer;
+  // Bytes to parse: either |buffer|'s data, or memory the producer keeps
+  // alive until the slot is released (e.g. a memory-mapped capture file).
+  const uint8_t* data{nullptr};
+  size_t size{0};
+  // Capture time, 0 if unknown.
+  int64_t timeUs{0};
+  PacketKind kind{PacketKind::kRtp};
+  Direction direction{Direction::kRecv};
+  // Packets of the same SSRC dropped by the tap since the previous slot.
+  uint32_t dropped{0};
+  PacketSlot* next{nullptr};
+};
+
+// Fixed set of packet slots shared between the producer (the network thread,
+// or the capture reader) and the parse threads. Acquire() must only be called
+// from the producer thread, Release() may be called from any thread.
+class PacketPool {
+ public:
+  explicit PacketPool(size_t capacity);
+  PacketPool(const PacketPool&) = delete;
+  PacketPool& operator=(const PacketPool&) = delete;
+
+  // Returns nullptr and bumps exhausted() when every slot is in flight.
+  PacketSlot* Acquire();
+  void Release(PacketSlot* slot);
+
+  size_t capacity() const { return slots_.size(); }
+  // Position of |slot| in the pool, for producers that keep storage of their
+  // own next to each slot.
+  size_t index(const PacketSlot* slot) const { return slot - slots_.data(); }
+  uint64_t exhausted() const {
+    return exhausted_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::vector<PacketSlot> slots_;
+  std::atomic<PacketSlot*> free_{nullptr};
+  std::atomic<uint64_t> exhausted_{0};
+};
+}  // namespace chai
+
+#endif  // CHAI_PACKET_POOL_H
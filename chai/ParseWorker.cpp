@@ -0,0 +1,281 @@
+#define MSC_CLASS "ParseWorker"
+
+#include "ParseWorker.h"
+
+#include <modules/rtp_rtcp/source/byte_io.h>
+#include <rtc_base/logging.h>
+
+#include <chrono>
+
+namespace {
+// Upper bound on how long an idle worker sleeps before re-checking the ring,
+// in case a wakeup raced with going to sleep.
+const int kIdleWaitMs{100};
+const int kDrainWaitMs{1};
+
+// Codecs whose RtpPacket keeps state between the packets of a stream: frame
+// assembly for video, the last bandwidth for Opus. The others share one.
+bool keepsStreamState(chai::Codec codec) {
+  switch (codec) {
+    case chai::Codec::kOpus:
+    case chai::Codec::kH264:
+    case chai::Codec::kH265:
+    case chai::Codec::kVp8:
+    case chai::Codec::kVp9:
+    case chai::Codec::kAv1:
+      return true;
+    default:
+      return false;
+  }
+}
+}  // namespace
+
+namespace chai {
+const size_t ParseWorker::kMaxStreams;
+
+ParseWorker::ParseWorker(PacketPool* pool, ParseObserver* observer)
+    : pool_(pool),
+      observer_(observer),
+      payloadTypes_(PayloadTypeTable::defaults()),
+      thread_(&ParseWorker::Run, this) {}
+
+ParseWorker::~ParseWorker() {
+  this->running_.store(false);
+  this->wakeup_.Set();
+  if (this->thread_.joinable()) {
+    this->thread_.join();
+  }
+
+  // Hand back whatever never got parsed.
+  PacketSlot* batch[kBatchSize];
+  while (size_t count = this->ring_.Pop(batch, kBatchSize)) {
+    for (size_t i = 0; i < count; ++i) {
+      this->pool_->Release(batch[i]);
+    }
+  }
+}
+
+bool ParseWorker::Post(PacketSlot* slot) {
+  if (!this->ring_.Push(slot)) {
+    return false;
+  }
+  ++this->posted_;
+  // Pairs with the fence in Run(): either the worker sees the new slot before
+  // sleeping, or we see it asleep and wake it.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (this->sleeping_.load(std::memory_order_relaxed)) {
+    this->wakeup_.Set();
+  }
+  return true;
+}
+
+void ParseWorker::setPayloadTypes(
+    std::shared_ptr<const PayloadTypeTable> payloadTypes) {
+  if (!payloadTypes) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(this->pendingMutex_);
+  this->pendingPayloadTypes_ = std::move(payloadTypes);
+  this->payloadTypesChanged_.store(true, std::memory_order_release);
+}
+
+void ParseWorker::Drain() {
+  while (this->completed_.load(std::memory_order_acquire) != this->posted_) {
+    this->wakeup_.Set();
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDrainWaitMs));
+  }
+}
+
+void ParseWorker::Run() {
+  PacketSlot* batch[kBatchSize];
+  while (this->running_.load(std::memory_order_relaxed)) {
+    size_t count = this->ring_.Pop(batch, kBatchSize);
+    if (count == 0) {
+      this->sleeping_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (this->ring_.empty()) {
+        this->wakeup_.Wait(kIdleWaitMs);
+      }
+      this->sleeping_.store(false, std::memory_order_relaxed);
+      continue;
+    }
+
+    if (this->payloadTypesChanged_.exchange(false,
+                                             std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock(this->pendingMutex_);
+      this->payloadTypes_ = std::move(this->pendingPayloadTypes_);
+    }
+    this->updateOverload();
+    for (size_t i = 0; i < count; ++i) {
+      this->Parse(batch[i]);
+    }
+    this->completed_.fetch_add(count, std::memory_order_release);
+  }
+}
+
+void ParseWorker::updateOverload() {
+  size_t backlog = this->ring_.size();
+  size_t highWaterMark = this->highWaterMark_.load(std::memory_order_relaxed);
+  if (!this->overloaded_ && backlog > highWaterMark) {
+    this->overloaded_ = true;
+    RTC_LOG(LS_WARNING) << "parse backlog " << backlog
+                        << " above high-water mark, parsing headers only";
+  } else if (this->overloaded_ && backlog <= highWaterMark / 2) {
+    this->overloaded_ = false;
+    RTC_LOG(LS_INFO) << "parse backlog drained, resuming full parsing";
+  }
+}
+
+void ParseWorker::Parse(PacketSlot* slot) {
+  if (slot->kind == PacketKind::kRtcp) {
+    this->ParseRtcp(slot);
+    return;
+  }
+
+  const uint8_t* buff = slot->data;
+  uint32_t len = slot->size;
+  int64_t timeUs = slot->timeUs;
+  Direction direction = slot->direction;
+  bool headerOnly =
+      this->overloaded_ || this->headerOnly_.load(std::memory_order_relaxed);
+  uint8_t payloadType = buff[1] & 0x7f;
+  uint32_t ssrc = webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 8);
+
+  const PayloadTypeEntry& entry =
+      this->payloadTypes_->lookup(direction, payloadType);
+  if (entry.codec == Codec::kUnknown) {
+    // Not negotiated: nothing we know how to parse, and no stream to keep.
+    this->pool_->Release(slot);
+    return;
+  }
+
+  Stream& stream = this->stream(ssrc);
+  stream.dropped += slot->dropped;
+
+  // parse payload
+  RtpRecord record;
+  bool parsed{false};
+  switch (entry.codec) {
+    case Codec::kRtx: {
+      this->rtxPacket_.setHeaderOnly(headerOnly);
+      parsed = this->rtxPacket_.parse(buff, len, &record);
+      record.apt = entry.apt;
+      break;
+    }
+    default: {
+      RtpPacket* rtpPacket = &this->statelessPacket_;
+      if (keepsStreamState(entry.codec)) {
+        if (!stream.rtpPacket) {
+          stream.rtpPacket.reset(new RtpPacket);
+        }
+        rtpPacket = stream.rtpPacket.get();
+      }
+      rtpPacket->setCodec(entry.codec);
+      rtpPacket->setHeaderOnly(headerOnly);
+      rtpPacket->setArrivalTime(timeUs);
+      parsed = rtpPacket->parse(buff, len, &record);
+      break;
+    }
+  }
+  this->pool_->Release(slot);
+  if (!parsed) {
+    return;
+  }
+
+  if (!headerOnly) {
+    record.decodeExtensions(this->payloadTypes_->extensions(direction));
+    this->ParseDependency(stream, &record);
+  }
+  record.codec = entry.codec;
+  record.direction = direction;
+  record.setMid(this->payloadTypes_->mid(direction, ssrc));
+  record.timeUs = timeUs;
+
+  if (this->overloaded_) {
+    ++stream.degraded;
+  }
+  record.overloaded = this->overloaded_;
+  record.dropped = stream.dropped;
+  record.degraded = stream.degraded;
+  this->observer_->onRtpRecord(record);
+}
+
+void ParseWorker::ParseRtcp(PacketSlot* slot) {
+  // RTCP is a small fraction of the traffic and carries the feedback needed to
+  // make sense of an overload, so it is always parsed in full.
+  nlohmann::json json = this->rtcpPacket_.parse(slot->data, slot->size);
+  json["direction"] = slot->direction == Direction::kSend ? "send" : "recv";
+  const std::string& mid = this->payloadTypes_->mid(
+      slot->direction,
+      webrtc::ByteReader<uint32_t>::ReadBigEndian(slot->data + 4));
+  if (!mid.empty()) {
+    json["mid"] = mid;
+  }
+  if (slot->timeUs) {
+    json["time_us"] = slot->timeUs;
+  }
+  this->pool_->Release(slot);
+
+  this->observer_->onRtcpPakcet(json);
+}
+
+void ParseWorker::ParseDependency(Stream& stream, RtpRecord* record) {
+  if (!record->extensionValues.has(ExtensionType::kDependencyDescriptor)) {
+    return;
+  }
+  const RtpExtensionView* element = nullptr;
+  for (uint8_t i = 0; i < record->extensionCount; ++i) {
+    if (record->extensions[i].type == ExtensionType::kDependencyDescriptor) {
+      element = &record->extensions[i];
+      break;
+    }
+  }
+  if (!stream.dependencyGraph) {
+    stream.dependencyGraph.reset(new FrameDependencyGraph);
+  }
+  record->hasDependency = true;
+  FrameDependency& dependency = record->dependency;
+  if (!stream.dependencyGraph->onPacket(
+          record->extensionData + element->offset, element->length,
+          record->header.sequenceNumber, &dependency)) {
+    return;
+  }
+
+  if (dependency.structureAttached) {
+    record->color1 = record->color2 = VIDEO_KEY_COLOR;
+    return;
+  }
+  switch (dependency.temporalId) {
+    case 0:
+      record->color1 = record->color2 = VIDEO_L0T0_COLOR;
+      break;
+    case 1:
+      record->color1 = record->color2 = VIDEO_L0T1_COLOR;
+      break;
+    default:
+      record->color1 = record->color2 = VIDEO_L0T2_COLOR;
+      break;
+  }
+}
+
+ParseWorker::Stream& ParseWorker::stream(uint32_t ssrc) {
+  ++this->packets_;
+  auto it = this->streams_.find(ssrc);
+  if (it == this->streams_.end()) {
+    if (this->streams_.size() >= kMaxStreams) {
+      // Only on a new SSRC with the table full, so the scan is rare.
+      auto idlest = this->streams_.begin();
+      for (auto s = this->streams_.begin(); s != this->streams_.end(); ++s) {
+        if (s->second.lastPacket < idlest->second.lastPacket) {
+          idlest = s;
+        }
+      }
+      RTC_LOG(LS_INFO) << "evicting idle ssrc " << idlest->first;
+      this->streams_.erase(idlest);
+    }
+    it = this->streams_.emplace(ssrc, Stream()).first;
+  }
+  it->second.lastPacket = this->packets_;
+  return it->second;
+}
+}  // namespace chai
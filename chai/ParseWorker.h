@@ -0,0 +1,152 @@
+#ifndef CHAI_PARSE_WORKER_H
+#define CHAI_PARSE_WORKER_H
+
+#include <rtc_base/event.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "DependencyDescriptor.h"
+#include "PacketPool.h"
+#include "PayloadTypeTable.h"
+#include "RtcpPacket.h"
+#include "RtpPakcet.h"
+#include "RtpRecord.h"
+#include "SpscRing.h"
+
+namespace chai {
+// Called from the parse threads. Packets of different SSRCs may be delivered
+// concurrently from different threads; packets of one SSRC are delivered in
+// order from a single thread.
+class ParseObserver {
+ public:
+  virtual ~ParseObserver() = default;
+  // Typed result of an RTP packet. Observers that only look at some packets,
+  // or keep them to show later, override this and call toJson() themselves;
+  // by default every record is rendered and passed to onRtpPakcet().
+  virtual void onRtpRecord(const RtpRecord& record) {
+    nlohmann::json json = record.toJson();
+    this->onRtpPakcet(json);
+  }
+  virtual void onRtpPakcet(nlohmann::json& json) {}
+  virtual void onRtcpPakcet(nlohmann::json& json) = 0;
+};
+
+// Parse thread fed by the network thread through a lock-free ring of packet
+// slots. The network thread pays a couple of atomics per packet and only
+// signals the worker when it has gone to sleep; the worker drains the ring in
+// batches of up to kBatchSize.
+//
+// RtpTransport shards packets across several workers by SSRC. A worker keeps
+// one RtpPacket (packet buffer, reference finder, payload parser) per SSRC of
+// a negotiated codec that needs one, and since each SSRC always lands on the
+// same worker its packets are parsed in arrival order. Packets of payload
+// types that aren't negotiated get no stream at all, and past kMaxStreams the
+// stream idle the longest is evicted, so a port sprayed with SSRCs can't grow
+// a worker without bound.
+//
+// RTCP compounds are sharded by sender SSRC and reported through
+// ParseObserver::onRtcpPakcet().
+//
+// Results are tagged with the direction, and with the mid the payload type
+// table maps the SSRC to.
+//
+// Streams that carry the AV1 dependency descriptor get a
+// FrameDependencyGraph, which keeps their template structure and resolves
+// each descriptor; the layer colours of their packets then come from the
+// descriptor rather than from the OBU extension headers.
+//
+// When the backlog in the ring rises above the high-water mark the worker
+// degrades to header-only parsing, and goes back to full parsing once the
+// backlog has drained below half of it.
+class ParseWorker {
+ public:
+  static const size_t kRingSize{4096};
+  static const size_t kBatchSize{64};
+  static const size_t kDefaultHighWaterMark{kRingSize / 2};
+  static const size_t kMaxStreams{256};
+
+  ParseWorker(PacketPool* pool, ParseObserver* observer);
+  ~ParseWorker();
+
+  // Producer thread only. Returns false if the ring is full; the caller keeps
+  // ownership of |slot| in that case.
+  bool Post(PacketSlot* slot);
+  // Producer thread only. Blocks until every slot posted so far is parsed.
+  void Drain();
+  // Producer thread only. Slots posted so far.
+  uint64_t posted() const { return posted_; }
+  // Any thread. Slots parsed and released so far: once this reaches a value
+  // of posted(), the memory of every slot posted before it is free to reuse.
+  uint64_t completed() const {
+    return completed_.load(std::memory_order_acquire);
+  }
+
+  // Backlog, in packets, above which parsing degrades to header-only.
+  void setHighWaterMark(size_t highWaterMark) {
+    highWaterMark_.store(highWaterMark, std::memory_order_relaxed);
+  }
+  // Any thread. Picked up by the worker before its next batch; until then
+  // PayloadTypeTable::defaults() is used.
+  void setPayloadTypes(std::shared_ptr<const PayloadTypeTable> payloadTypes);
+  // Parse headers only regardless of the backlog.
+  void setHeaderOnly(bool headerOnly) {
+    headerOnly_.store(headerOnly, std::memory_order_relaxed);
+  }
+
+ protected:
+  struct Stream {
+    // Created on the first packet of a codec that keeps state.
+    std::unique_ptr<RtpPacket> rtpPacket;
+    // Created on the first dependency descriptor.
+    std::unique_ptr<FrameDependencyGraph> dependencyGraph;
+    // Packets the tap dropped because the pool ran out.
+    uint64_t dropped{0};
+    // Packets parsed header-only because the worker was overloaded.
+    uint64_t degraded{0};
+    // Value of packets_ at the last packet, for eviction.
+    uint64_t lastPacket{0};
+  };
+
+  void Run();
+  void Parse(PacketSlot* slot);
+  void ParseRtcp(PacketSlot* slot);
+  void ParseDependency(Stream& stream, RtpRecord* record);
+  void updateOverload();
+  Stream& stream(uint32_t ssrc);
+
+ private:
+  PacketPool* pool_{nullptr};
+  ParseObserver* observer_{nullptr};
+  std::map<uint32_t, Stream> streams_;
+  // RTP packets that went through stream().
+  uint64_t packets_{0};
+  RtcpPacket rtcpPacket_;
+  // Stateless, shared by the RTX streams of this worker.
+  RtxPacket rtxPacket_;
+  // Shared by the streams of codecs that keep no state, e.g. G.711 or FEC.
+  RtpPacket statelessPacket_;
+  // Worker thread only.
+  std::shared_ptr<const PayloadTypeTable> payloadTypes_;
+  std::mutex pendingMutex_;
+  std::shared_ptr<const PayloadTypeTable> pendingPayloadTypes_;
+  std::atomic<bool> payloadTypesChanged_{false};
+  std::atomic<size_t> highWaterMark_{kDefaultHighWaterMark};
+  std::atomic<bool> headerOnly_{false};
+  bool overloaded_{false};
+
+  SpscRing<PacketSlot*, kRingSize> ring_;
+  rtc::Event wakeup_;
+  std::atomic<bool> sleeping_{false};
+  // Slots posted by the producer, and slots the worker is done with.
+  uint64_t posted_{0};
+  std::atomic<uint64_t> completed_{0};
+  std::atomic<bool> running_{true};
+  std::thread thread_;
+};
+}  // namespace chai
+
+#endif  // CHAI_PARSE_WORKER_H
@@ -1,10 +1,7 @@
 #include "PayloadAV1.h"
 
-#include <rtc_base/logging.h>
-#include <modules/desktop_capture/desktop_capture_options.h>
-#include <api/task_queue/default_task_queue_factory.h>
-#include <libyuv/convert.h>
-#include <libyuv/video_common.h>
+#include <algorithm>
+#include <vector>
 
 namespace chai {
 
@@ -13,111 +10,116 @@ PayloadAV1::PayloadAV1() {
   color2_ = VIDEO_L0T0_COLOR;
 }
 
-nlohmann::json PayloadAV1::parse(const uint8_t* buff, uint16_t length) {
-  if (!context_) {
-    context_.reset(new aom_codec_ctx_t);
-
-    aom_codec_dec_cfg_t config = {8u,  // Max # of threads.
-                                  0,   // Frame width set after decode.
-                                  0,   // Frame height set after decode.
-                                  1};  // Enable low-bit-depth code path.
-    aom_codec_err_t ret =
-        aom_codec_dec_init(context_.get(), aom_codec_av1_dx(), &config, 0);
-
-    if (ret != AOM_CODEC_OK) {
-      RTC_LOG(LS_WARNING) << "LibaomAv1Decoder::InitDecode returned " << ret
-                          << " on aom_codec_dec_init.";
-      context_.reset();
-      return WEBRTC_VIDEO_CODEC_OK;
+// |buff| is one assembled frame: the OBUs of a temporal unit, without the
+// temporal delimiter the depacketizer drops.
+// The result has the OBUs and a breakdown of the frame's bytes by syntax
+// structure.
+nlohmann::json PayloadAV1::parse(const uint8_t* buff, size_t length) {
+  this->parser_.startTemporalUnit();
+  this->bytes_ = ByteBreakdown();
+  nlohmann::json obus = nlohmann::json::array();
+  size_t offset = 0;
+  while (offset < length) {
+    Av1ObuHeader header;
+    if (!Av1HeaderParser::parseObuHeader(buff + offset, length - offset,
+                                         &header)) {
+      obus.push_back({{"error", "truncated"}});
+      this->bytes_.other += length - offset;
+      break;
     }
+    this->bytes_.obu_headers += header.size;
+    obus.push_back(open_bitstream_unit(header, buff + offset + header.size,
+                                       size_t(header.obu_size)));
+    offset += header.size + header.obu_size;
   }
+  return {
+      {"obus", obus},
+      {"bytes", bytes_json(length)},
+  };
+}
 
-  aom_codec_err_t ret = aom_codec_decode(context_.get(), buff, length,
-                                         /*user_priv=*/nullptr);
-  if (ret != AOM_CODEC_OK) {
-    RTC_LOG(LS_WARNING) << "LibaomAv1Decoder::Decode returned " << ret
-                        << " on aom_codec_decode.";
-    return nlohmann::json();
-  }
-
-  // Get decoded frame data.
-  aom_codec_iter_t iter = nullptr;
-  while (aom_image_t* decoded_image =
-             aom_codec_get_frame(context_.get(), &iter)) {  }
-
-  this->buff_ = buff;
-  nlohmann::json obus = nlohmann::json::array();
-  while (buff + length != this->buff_) {
-    obus.push_back(open_bitstream_unit(buff - this->buff_));
-  }
-  return obus;
+nlohmann::json PayloadAV1::bytes_json(size_t length) const {
+  const ByteBreakdown& bytes = this->bytes_;
+  return {
+      {"total", length},
+      {"obu_headers", bytes.obu_headers},
+      {"sequence_header", bytes.sequence_header},
+      {"frame_header", bytes.frame_header},
+      {"redundant_frame_header", bytes.redundant_frame_header},
+      {"tile_group_header", bytes.tile_group_header},
+      {"tile_sizes", bytes.tile_sizes},
+      {"tile_data", bytes.tile_data},
+      {"metadata", bytes.metadata},
+      {"tile_list", bytes.tile_list},
+      {"padding", bytes.padding},
+      {"other", bytes.other},
+  };
 }
 
 // https://aomediacodec.github.io/av1-spec/av1-spec.pdf 5.3.1  Last modified:
 // 2019-01-08 11:48 PT
-nlohmann::json PayloadAV1::open_bitstream_unit(uint64_t sz) {
+nlohmann::json PayloadAV1::open_bitstream_unit(const Av1ObuHeader& header,
+                                               const uint8_t* buff,
+                                               size_t size) {
   nlohmann::json obu;
-  uint64_t obu_size{0};
-  obu["header"] = obu_header();
-  if (header.has_size_field) {
-    uint32_t len = leb128(this->buff_ + header.size, obu_size);
-    this->buff_ += header.size + len + obu_size;
-  } else {
-    obu_size = sz - header.size;
-    this->buff_ += sz;
-  }
-  OBU_TYPE type = header.type;
-
-  auto* ctx = (aom_codec_alg_priv_t*)context_->priv;
-  if (type == OBU_SEQUENCE_HEADER) {
-    obu["sequence_header"] = obu_sequence_header();
-  } else if (type == OBU_TEMPORAL_DELIMITER) {
-  } else if (type == OBU_FRAME_HEADER) {
-  } else if (type == OBU_REDUNDANT_FRAME_HEADER) {
-  } else if (type == OBU_TILE_GROUP) {
-  } else if (type == OBU_METADATA) {
-  } else if (type == OBU_FRAME) {
-    obu["frame"] = obu_frame(obu_size);
-  } else if (type == OBU_TILE_LIST) {
-  } else if (type == OBU_PADDING) {
-  } else {
-  }
-  return obu;
-}
-
-uint32_t PayloadAV1::leb128(const uint8_t* buff, uint64_t& value) {
-  value = 0;
-  uint16_t i{0};
-  for (i = 0; i < 8; i++) {
-    uint8_t leb128_byte = buff[i];
-    value |= ((leb128_byte & 0x7f) << (i * 7));
-    if (!(leb128_byte & 0x80)) {
+  obu["header"] = obu_header(header);
+  obu["obu_size"] = size;
+  switch (header.obu_type) {
+    case kAv1ObuSequenceHeader:
+      this->bytes_.sequence_header += size;
+      if (this->parser_.parseSequenceHeader(buff, size)) {
+        obu["sequence_header"] = obu_sequence_header();
+      } else {
+        obu["error"] = "truncated";
+      }
+      break;
+    case kAv1ObuTemporalDelimiter:
+      this->bytes_.other += size;
+      this->parser_.startTemporalUnit();
+      break;
+    case kAv1ObuFrameHeader:
+      this->bytes_.frame_header += size;
+      obu["frame_header_obu"] = frame_header_obu(header, buff, size);
+      break;
+    case kAv1ObuRedundantFrameHeader:
+      this->bytes_.redundant_frame_header += size;
+      obu["frame_header_obu"] = frame_header_obu(header, buff, size);
+      break;
+    case kAv1ObuTileGroup:
+      obu["tile_group_obu"] = tile_group_obu(buff, size);
+      break;
+    case kAv1ObuFrame:
+      obu["frame"] = obu_frame(header, buff, size);
+      break;
+    case kAv1ObuMetadata:
+      this->bytes_.metadata += size;
+      obu["metadata_obu"] = metadata_obu(buff, size);
+      break;
+    case kAv1ObuTileList:
+      this->bytes_.tile_list += size;
+      obu["tile_list_obu"] = tile_list_obu(buff, size);
+      break;
+    case kAv1ObuPadding:
+      // 5.7: opaque payload bytes.
+      this->bytes_.padding += size;
+      obu["padding_obu"] = {{"padding_bytes", size}};
+      break;
+    default:
+      this->bytes_.other += size;
       break;
-    }
   }
-  return i + 1;
+  return obu;
 }
 
-nlohmann::json PayloadAV1::obu_header() {
-  uint8_t byte1 = buff_[0];
-  header.type = OBU_TYPE((byte1 & 0b0111'1000) >> 3);
-  header.has_extension = (byte1 & 0b0000'0100) >> 2;
-  header.has_size_field = (byte1 & 0b0000'0010) >> 1;
-  header.size = 1;
-  header.temporal_layer_id = 0;
-  header.spatial_layer_id = 0;
-
-  if (!header.has_extension) {
+nlohmann::json PayloadAV1::obu_header(const Av1ObuHeader& header) {
+  if (!header.obu_extension_flag) {
     color1_ = color2_ = VIDEO_L0T0_COLOR;
-    return {{"obu_type", header.type},
+    return {{"obu_type", header.obu_type},
+            {"obu_type_name", av1ObuTypeName(header.obu_type)},
             {"size", header.size}};
   }
 
-  byte1 = this->buff_[1];
-  header.temporal_layer_id = (byte1 & 0b1110'0000) >> 5;
-  header.spatial_layer_id = (byte1 & 0b0001'1000) >> 3;
-  header.size += 1;
-  switch (header.temporal_layer_id) {
+  switch (header.temporal_id) {
     case 1:
       color1_ = color2_ = VIDEO_L0T1_COLOR;
       break;
@@ -126,367 +128,625 @@ nlohmann::json PayloadAV1::obu_header() {
       break;
   }
 
-  return {{"obu_type", header.type},
+  return {{"obu_type", header.obu_type},
+          {"obu_type_name", av1ObuTypeName(header.obu_type)},
           {"size", header.size},
-          {"temporal_id", header.temporal_layer_id},
-          {"spatial_id", header.spatial_layer_id}};
+          {"temporal_id", header.temporal_id},
+          {"spatial_id", header.spatial_id}};
 }
 
 nlohmann::json PayloadAV1::obu_sequence_header() {
-  auto* ctx = (aom_codec_alg_priv_t*)context_->priv;
-  AVxWorker* worker = get_worker(ctx);
-  FrameWorkerData* const frame_worker_data = (FrameWorkerData*)worker->data1;
-  AV1Decoder* pbi = frame_worker_data->pbi;
-
-  SequenceHeader* const seq_params = pbi->common.seq_params;
-
+  const Av1SequenceHeader& seq = this->parser_.sequenceHeader();
   nlohmann::json obu = {
-      {"seq_profile", seq_params->profile},
-      {"still_picture", seq_params->still_picture},
-      {"reduced_still_picture_header", seq_params->reduced_still_picture_hdr},
+      {"seq_profile", seq.seq_profile},
+      {"still_picture", seq.still_picture},
+      {"reduced_still_picture_header", seq.reduced_still_picture_header},
   };
-  if (seq_params->reduced_still_picture_hdr) {
-    obu["seq_level_idx"] = seq_params->seq_level_idx[0];
+  if (seq.reduced_still_picture_header) {
+    obu["seq_level_idx"] = seq.operating_points[0].seq_level_idx;
   } else {
-    obu["timing_info_present_flag"] = seq_params->timing_info_present;
-    if (seq_params->timing_info_present) {
-      obu["timing_info"] = timing_info(seq_params->timing_info);
+    obu["timing_info_present_flag"] = seq.timing_info_present_flag;
+    if (seq.timing_info_present_flag) {
+      obu["timing_info"] = timing_info(seq);
       obu["decoder_model_info_present_flag"] =
-          seq_params->decoder_model_info_present_flag;
-      if (seq_params->decoder_model_info_present_flag) {
-        obu["decoder_model_info"] =
-            decoder_model_info(seq_params->decoder_model_info);
+          seq.decoder_model_info_present_flag;
+      if (seq.decoder_model_info_present_flag) {
+        obu["decoder_model_info"] = decoder_model_info(seq);
       }
-    } 
+    }
     obu["initial_display_delay_present_flag"] =
-        seq_params->display_model_info_present_flag;
-    obu["operating_points_cnt_minus_1"] =
-        seq_params->operating_points_cnt_minus_1;
+        seq.initial_display_delay_present_flag;
+    obu["operating_points_cnt_minus_1"] = seq.operating_points_cnt_minus_1;
     obu["operating_points"] = nlohmann::json::array();
-    for (int i = 0; i <= seq_params->operating_points_cnt_minus_1; ++i) {
+    for (int i = 0; i <= seq.operating_points_cnt_minus_1; ++i) {
+      const auto& op = seq.operating_points[i];
       nlohmann::json operating_point = {
-          {"operating_point_idc", seq_params->operating_point_idc[i]},
-          {"seq_level_idx", seq_params->seq_level_idx[i]},
-          {"seq_tier", seq_params->tier[i]},
+          {"operating_point_idc", op.operating_point_idc},
+          {"seq_level_idx", op.seq_level_idx},
+          {"seq_tier", op.seq_tier},
       };
-
-      if (seq_params->decoder_model_info_present_flag) {
+      if (seq.decoder_model_info_present_flag) {
         operating_point["decoder_model_present_for_this_op"] =
-            seq_params->op_params[i].decoder_model_param_present_flag;
-        if (seq_params->op_params[i].decoder_model_param_present_flag) {
+            op.decoder_model_present_for_this_op;
+        if (op.decoder_model_present_for_this_op) {
           operating_point["operating_parameters_info"] =
-              operating_parameters_info(seq_params->op_params[i]);
+              operating_parameters_info(op);
         }
       }
-      if (seq_params->display_model_info_present_flag) {
+      if (seq.initial_display_delay_present_flag) {
         operating_point["initial_display_delay_present_for_this_op"] =
-            seq_params->op_params[i].display_model_param_present_flag;
-        if (seq_params->op_params[i].display_model_param_present_flag) {
+            op.initial_display_delay_present_for_this_op;
+        if (op.initial_display_delay_present_for_this_op) {
           operating_point["initial_display_delay"] =
-              seq_params->op_params[i].initial_display_delay;
+              op.initial_display_delay_minus_1 + 1;
         }
       }
       obu["operating_points"].push_back(operating_point);
     }
   }
 
-  obu["frame_width_bits"] = seq_params->num_bits_width;
-  obu["frame_height_bits"] = seq_params->num_bits_height;
-  obu["max_frame_width"] = seq_params->max_frame_width;
-  obu["max_frame_height"] = seq_params->max_frame_height;
-  obu["frame_id_numbers_present_flag"] =
-      seq_params->frame_id_numbers_present_flag;
-  obu["frame_id_numbers_present_flag"] =
-      seq_params->frame_id_numbers_present_flag;
-  if (seq_params->frame_id_numbers_present_flag) {
-    obu["delta_frame_id_length"] = seq_params->delta_frame_id_length;
-    obu["additional_frame_id_length"] = seq_params->frame_id_length;
-  }
-  obu["sb_size"] = seq_params->sb_size; // 128X128->15  64X64:12
-  obu["enable_filter_intra"] = seq_params->enable_filter_intra;
-  obu["enable_intra_edge_filter"] = seq_params->enable_intra_edge_filter;
-
-  obu["enable_interintra_compound"] = seq_params->enable_interintra_compound;
-  obu["enable_masked_compound"] = seq_params->enable_masked_compound;
-  obu["enable_warped_motion"] = seq_params->enable_warped_motion;
-  obu["enable_dual_filter"] = seq_params->enable_dual_filter;
-  obu["enable_order_hint"] = seq_params->order_hint_info.enable_order_hint;
-  obu["enable_jnt_comp"] = obu["enable_ref_frame_mvs"] =
-      seq_params->order_hint_info.enable_dist_wtd_comp;
-  obu["enable_ref_frame_mvs"] =
-      seq_params->order_hint_info.enable_ref_frame_mvs;
-  obu["seq_force_screen_content_tools"] =
-      seq_params->force_screen_content_tools;
-  obu["seq_choose_integer_mv"] = seq_params->force_integer_mv;
-  if (seq_params->order_hint_info.enable_order_hint) {
-    obu["order_hint_bits_minus_1"] =
-        seq_params->order_hint_info.order_hint_bits_minus_1;
-  }
-
-  obu["enable_superres"] = seq_params->enable_superres;
-  obu["enable_cdef"] = seq_params->enable_cdef;
-  obu["enable_restoration"] = seq_params->enable_restoration;
-  obu["color_config"] = color_config(seq_params);
-  obu["film_grain_params_present"] = seq_params->film_grain_params_present;
+  obu["frame_width_bits"] = seq.frame_width_bits_minus_1 + 1;
+  obu["frame_height_bits"] = seq.frame_height_bits_minus_1 + 1;
+  obu["max_frame_width"] = seq.max_frame_width_minus_1 + 1;
+  obu["max_frame_height"] = seq.max_frame_height_minus_1 + 1;
+  obu["frame_id_numbers_present_flag"] = seq.frame_id_numbers_present_flag;
+  if (seq.frame_id_numbers_present_flag) {
+    obu["delta_frame_id_length"] = seq.delta_frame_id_length_minus_2 + 2;
+    obu["additional_frame_id_length"] =
+        seq.additional_frame_id_length_minus_1 + 1;
+  }
+  obu["use_128x128_superblock"] = seq.use_128x128_superblock;
+  obu["enable_filter_intra"] = seq.enable_filter_intra;
+  obu["enable_intra_edge_filter"] = seq.enable_intra_edge_filter;
+
+  obu["enable_interintra_compound"] = seq.enable_interintra_compound;
+  obu["enable_masked_compound"] = seq.enable_masked_compound;
+  obu["enable_warped_motion"] = seq.enable_warped_motion;
+  obu["enable_dual_filter"] = seq.enable_dual_filter;
+  obu["enable_order_hint"] = seq.enable_order_hint;
+  obu["enable_jnt_comp"] = seq.enable_jnt_comp;
+  obu["enable_ref_frame_mvs"] = seq.enable_ref_frame_mvs;
+  obu["seq_force_screen_content_tools"] = seq.seq_force_screen_content_tools;
+  obu["seq_force_integer_mv"] = seq.seq_force_integer_mv;
+  if (seq.enable_order_hint) {
+    obu["order_hint_bits"] = seq.OrderHintBits;
+  }
+
+  obu["enable_superres"] = seq.enable_superres;
+  obu["enable_cdef"] = seq.enable_cdef;
+  obu["enable_restoration"] = seq.enable_restoration;
+  obu["color_config"] = color_config(seq);
+  obu["film_grain_params_present"] = seq.film_grain_params_present;
 
   return obu;
 }
 
-nlohmann::json PayloadAV1::timing_info(aom_timing_info_t& timing_info) {
+nlohmann::json PayloadAV1::timing_info(const Av1SequenceHeader& seq) {
   nlohmann::json json = {
-      {"num_units_in_display_tick", timing_info.num_units_in_display_tick},
-      {"time_scale", timing_info.time_scale},
-      {"equal_picture_interval", timing_info.equal_picture_interval},
+      {"num_units_in_display_tick", seq.num_units_in_display_tick},
+      {"time_scale", seq.time_scale},
+      {"equal_picture_interval", seq.equal_picture_interval},
   };
-  if (timing_info.equal_picture_interval) {
-    json["num_ticks_per_picture"] = timing_info.num_ticks_per_picture;
+  if (seq.equal_picture_interval) {
+    json["num_ticks_per_picture"] =
+        uint64_t(seq.num_ticks_per_picture_minus_1) + 1;
   }
   return json;
 }
 
-nlohmann::json PayloadAV1::decoder_model_info(
-    aom_dec_model_info_t& decoder_model_info) {
+nlohmann::json PayloadAV1::decoder_model_info(const Av1SequenceHeader& seq) {
   return {
-      {"buffer_delay_length",
-       decoder_model_info.encoder_decoder_buffer_delay_length},
-      {"num_units_in_decoding_tick",
-       decoder_model_info.num_units_in_decoding_tick},
+      {"buffer_delay_length", seq.buffer_delay_length_minus_1 + 1},
+      {"num_units_in_decoding_tick", seq.num_units_in_decoding_tick},
       {"buffer_removal_time_length",
-       decoder_model_info.buffer_removal_time_length},
+       seq.buffer_removal_time_length_minus_1 + 1},
       {"frame_presentation_time_length",
-       decoder_model_info.frame_presentation_time_length},
+       seq.frame_presentation_time_length_minus_1 + 1},
   };
 }
 
 nlohmann::json PayloadAV1::operating_parameters_info(
-    aom_dec_model_op_parameters_t& op_params) {
+    const Av1SequenceHeader::OperatingPoint& op) {
   return {
-      {"decoder_buffer_delay", op_params.decoder_buffer_delay},
-      {"encoder_buffer_delay", op_params.encoder_buffer_delay},
-      {"low_delay_mode_flag", op_params.low_delay_mode_flag},
+      {"decoder_buffer_delay", op.decoder_buffer_delay},
+      {"encoder_buffer_delay", op.encoder_buffer_delay},
+      {"low_delay_mode_flag", op.low_delay_mode_flag},
   };
 }
 
-nlohmann::json PayloadAV1::color_config(SequenceHeader* const seq_params) {
+nlohmann::json PayloadAV1::color_config(const Av1SequenceHeader& seq) {
   return {
-      {"bit_depth", seq_params->bit_depth},
-      {"mono_chrome", seq_params->monochrome},
-      {"color_primaries", seq_params->color_primaries},
-      {"transfer_characteristics", seq_params->transfer_characteristics},
-      {"matrix_coefficients", seq_params->matrix_coefficients},
-      {"color_range", seq_params->color_range},
-      {"subsampling_x", seq_params->subsampling_x},
-      {"subsampling_y", seq_params->subsampling_y},
-      {"chroma_sample_position", seq_params->chroma_sample_position},
-      {"separate_uv_delta_q", seq_params->separate_uv_delta_q},
+      {"bit_depth", seq.BitDepth},
+      {"mono_chrome", seq.mono_chrome},
+      {"color_primaries", seq.color_primaries},
+      {"transfer_characteristics", seq.transfer_characteristics},
+      {"matrix_coefficients", seq.matrix_coefficients},
+      {"color_range", seq.color_range},
+      {"subsampling_x", seq.subsampling_x},
+      {"subsampling_y", seq.subsampling_y},
+      {"chroma_sample_position", seq.chroma_sample_position},
+      {"separate_uv_delta_q", seq.separate_uv_delta_q},
   };
 }
 
-nlohmann::json PayloadAV1::obu_frame(uint64_t sz) {
-  return {
-      {"frame_header_obu", frame_header_obu()},
-      //{"byte_alignment", byte_alignment()},
-      //{"tile_group_obu", tile_group_obu()},
+nlohmann::json PayloadAV1::obu_frame(const Av1ObuHeader& header,
+                                     const uint8_t* buff,
+                                     size_t size) {
+  nlohmann::json frame = {
+      {"frame_header_obu", frame_header_obu(header, buff, size)},
   };
+  if (frame["frame_header_obu"].contains("uncompressed_header")) {
+    // byte_alignment()
+    size_t offset = (this->parser_.frameHeader().headerBits + 7) / 8;
+    this->bytes_.frame_header += offset;
+    frame["tile_group_obu"] = tile_group_obu(buff + offset, size - offset);
+  } else {
+    this->bytes_.other += size;
+  }
+  return frame;
 }
-nlohmann::json PayloadAV1::frame_header_obu() {
+
+nlohmann::json PayloadAV1::frame_header_obu(const Av1ObuHeader& header,
+                                            const uint8_t* buff,
+                                            size_t size) {
+  bool copy = false;
+  if (!this->parser_.parseFrameHeader(buff, size, header, &copy)) {
+    return {{"error", this->parser_.hasSequenceHeader()
+                          ? "invalid frame header"
+                          : "no sequence header"}};
+  }
+  if (copy) {
+    return {{"frame_header_copy", true}};
+  }
   return {
       {"uncompressed_header", uncompressed_header()},
-      //{"decode_frame_wrapup", decode_frame_wrapup()},
   };
 }
+
 nlohmann::json PayloadAV1::uncompressed_header() {
-  auto* ctx = (aom_codec_alg_priv_t*)context_->priv;
-  AVxWorker* worker = get_worker(ctx);
-  FrameWorkerData* const frame_worker_data = (FrameWorkerData*)worker->data1;
-  AV1Decoder* pbi = frame_worker_data->pbi;
-  AV1_COMMON* const cm = &pbi->common;
-  const SequenceHeader* const seq_params = cm->seq_params;
-  CurrentFrame* const current_frame = &cm->current_frame;
-  FeatureFlags* const features = &cm->features;
-
-  frame_type_ = current_frame->frame_type;
+  const Av1SequenceHeader& seq = this->parser_.sequenceHeader();
+  const Av1FrameHeader& fh = this->parser_.frameHeader();
+
+  frame_type_ = fh.frame_type;
+  if (fh.frame_type == kAv1KeyFrame) {
+    color1_ = color2_ = VIDEO_KEY_COLOR;
+  }
+
   nlohmann::json uncompressed;
-  if (seq_params->reduced_still_picture_hdr) {
-    uncompressed["show_existing_frame"] = cm->show_existing_frame;
-    uncompressed["frame_type"] = current_frame->frame_type;
-    uncompressed["show_frame"] = cm->show_frame;
-    uncompressed["showable_frame"] = cm->showable_frame;
-  } else {
-    uncompressed["show_existing_frame"] = cm->show_existing_frame;
-    if (cm->show_existing_frame) {
-      if (seq_params->decoder_model_info_present_flag &&
-          seq_params->timing_info.equal_picture_interval == 0) {
-        uncompressed["temporal_point_info"] = temporal_point_info(cm);
-      }
-      if (seq_params->frame_id_numbers_present_flag) {
-      }
-      return uncompressed;
+  uncompressed["show_existing_frame"] = fh.show_existing_frame;
+  if (fh.show_existing_frame) {
+    uncompressed["frame_to_show_map_idx"] = fh.frame_to_show_map_idx;
+    if (seq.decoder_model_info_present_flag && !seq.equal_picture_interval) {
+      uncompressed["frame_presentation_time"] = fh.frame_presentation_time;
     }
-    uncompressed["frame_type"] = current_frame->frame_type;
-    uncompressed["show_frame"] = cm->show_frame;
-    if (cm->show_frame && seq_params->decoder_model_info_present_flag &&
-        seq_params->timing_info.equal_picture_interval == 0) {
-      uncompressed["temporal_point_info"] = temporal_point_info(cm);
+    if (seq.frame_id_numbers_present_flag) {
+      uncompressed["display_frame_id"] = fh.display_frame_id;
     }
-    uncompressed["showable_frame"] = cm->showable_frame;
-    uncompressed["error_resilient_mode"] = features->error_resilient_mode;
-  }
-  uncompressed["disable_cdf_update"] = features->disable_cdf_update;
-  uncompressed["allow_screen_content_tools"] =
-      features->allow_screen_content_tools;
-  uncompressed["force_integer_mv"] = features->allow_screen_content_tools;
-  uncompressed["current_frame_id"] = cm->current_frame_id;
-  uncompressed["order_hint"] = current_frame->order_hint;
-  uncompressed["primary_ref_frame"] = features->primary_ref_frame;
-  if (seq_params->decoder_model_info_present_flag) {
+    uncompressed["frame_type"] = av1FrameTypeName(fh.frame_type);
+    uncompressed["frame_size"] = frame_size(fh);
+    return uncompressed;
+  }
+  uncompressed["frame_type"] = av1FrameTypeName(fh.frame_type);
+  uncompressed["show_frame"] = fh.show_frame;
+  if (fh.show_frame && seq.decoder_model_info_present_flag &&
+      !seq.equal_picture_interval) {
+    uncompressed["frame_presentation_time"] = fh.frame_presentation_time;
+  }
+  uncompressed["showable_frame"] = fh.showable_frame;
+  uncompressed["error_resilient_mode"] = fh.error_resilient_mode;
+  uncompressed["disable_cdf_update"] = fh.disable_cdf_update;
+  uncompressed["allow_screen_content_tools"] = fh.allow_screen_content_tools;
+  uncompressed["force_integer_mv"] = fh.force_integer_mv;
+  if (seq.frame_id_numbers_present_flag) {
+    uncompressed["current_frame_id"] = fh.current_frame_id;
+  }
+  uncompressed["frame_size_override_flag"] = fh.frame_size_override_flag;
+  uncompressed["order_hint"] = fh.order_hint;
+  uncompressed["primary_ref_frame"] = fh.primary_ref_frame;
+  if (seq.decoder_model_info_present_flag) {
     uncompressed["buffer_removal_time_present_flag"] =
-        pbi->buffer_removal_time_present;
-    if (pbi->buffer_removal_time_present) {
+        fh.buffer_removal_time_present_flag;
+    if (fh.buffer_removal_time_present_flag) {
       uncompressed["buffer_removal_time"] = nlohmann::json::array();
-      for (int op_num = 0;
-           op_num <= seq_params->operating_points_cnt_minus_1; ++op_num) {
+      for (int op_num = 0; op_num <= seq.operating_points_cnt_minus_1;
+           ++op_num) {
         uncompressed["buffer_removal_time"].push_back(
-            {{"buffer_removal_time", cm->buffer_removal_times[op_num]}});
+            fh.buffer_removal_time[op_num]);
       }
     }
   }
-  uncompressed["refresh_frame_flags"] = current_frame->refresh_frame_flags;
-  if (current_frame->frame_type == KEY_FRAME) {
-    uncompressed["frame_size"] = frame_size(cm);
-    uncompressed["render_size"] = render_size(cm);
-    if (features->allow_screen_content_tools &&
-        (cm->width == cm->superres_upscaled_width)) {
-      uncompressed["allow_intrabc"] = features->allow_intrabc;
-    }
+  uncompressed["refresh_frame_flags"] = fh.refresh_frame_flags;
+  uncompressed["frame_size"] = frame_size(fh);
+  uncompressed["render_size"] = render_size(fh);
+  if (fh.FrameIsIntra) {
+    uncompressed["allow_intrabc"] = fh.allow_intrabc;
   } else {
-    uncompressed["frame_size"] = frame_size(cm);
-    uncompressed["render_size"] = render_size(cm);
-    uncompressed["allow_high_precision_mv"] = features->allow_high_precision_mv;
-    uncompressed["read_interpolation_filter"] = features->interp_filter;
-    uncompressed["is_motion_mode_switchable"] =
-        features->switchable_motion_mode;
-    uncompressed["use_ref_frame_mvs"] = features->allow_ref_frame_mvs;
-  }
-  uncompressed["refresh_frame_context"] = features->refresh_frame_context;
-  uncompressed["tile_info"] = tile_info(pbi);
-  uncompressed["quantization_params"] = quantization_params(cm);
-  uncompressed["segmentation_params"] = segmentation_params(cm);
-  uncompressed["delta_q_params"] = delta_q_params(cm);
-  uncompressed["delta_lf_params"] = delta_lf_params(cm);
-  uncompressed["loop_filter_params"] = loop_filter_params();
-  uncompressed["cdef_params"] = cdef_params();
-  uncompressed["lr_params"] = lr_params();
-  uncompressed["read_tx_mode"] = read_tx_mode();
-  uncompressed["frame_reference_mode"] = frame_reference_mode();
-  uncompressed["skip_mode_params"] = skip_mode_params();
-  uncompressed["allow_warped_motion"] = features->allow_warped_motion;
-  uncompressed["reduced_tx_set"] = features->reduced_tx_set_used;
-  uncompressed["global_motion_params"] = global_motion_params();
-  uncompressed["film_grain_params"] = film_grain_params();
-
-  if (current_frame->frame_type == KEY_FRAME) {
-    color1_ = color2_ = VIDEO_KEY_COLOR;
+    uncompressed["frame_refs_short_signaling"] =
+        fh.frame_refs_short_signaling;
+    uncompressed["ref_frame_idx"] = fh.ref_frame_idx;
+    uncompressed["allow_high_precision_mv"] = fh.allow_high_precision_mv;
+    uncompressed["interpolation_filter"] = fh.interpolation_filter;
+    uncompressed["is_motion_mode_switchable"] = fh.is_motion_mode_switchable;
+    uncompressed["use_ref_frame_mvs"] = fh.use_ref_frame_mvs;
   }
+  uncompressed["disable_frame_end_update_cdf"] =
+      fh.disable_frame_end_update_cdf;
+  uncompressed["tile_info"] = tile_info(fh.tile_info);
+  uncompressed["quantization_params"] = quantization_params(fh);
+  uncompressed["segmentation_params"] = segmentation_params(fh);
+  uncompressed["delta_q_params"] = delta_q_params(fh);
+  uncompressed["delta_lf_params"] = delta_lf_params(fh);
+  uncompressed["coded_lossless"] = fh.CodedLossless;
+  uncompressed["all_lossless"] = fh.AllLossless;
+  uncompressed["loop_filter_params"] = loop_filter_params(fh);
+  uncompressed["cdef_params"] = cdef_params(fh);
+  uncompressed["lr_params"] = lr_params(fh);
+  uncompressed["tx_mode"] = fh.TxMode;
+  uncompressed["reference_select"] = fh.reference_select;
+  uncompressed["skip_mode_params"] = skip_mode_params(fh);
+  uncompressed["allow_warped_motion"] = fh.allow_warped_motion;
+  uncompressed["reduced_tx_set"] = fh.reduced_tx_set;
+  uncompressed["global_motion_params"] = global_motion_params(fh);
+  uncompressed["film_grain_params"] = film_grain_params(fh);
+  uncompressed["header_bytes"] = (fh.headerBits + 7) / 8;
   return uncompressed;
 }
-nlohmann::json PayloadAV1::temporal_point_info(AV1_COMMON* const cm) {
-  return {{"frame_presentation_time", cm->frame_presentation_time}};
-}
-nlohmann::json PayloadAV1::frame_size(AV1_COMMON* cm) {
-  return {
-      {"frame_width", cm->superres_upscaled_width},
-      {"frame_height", cm->superres_upscaled_height},
-      //{"superres_params", superres_params()},
-      //{"compute_image_size", compute_image_size()}
+
+nlohmann::json PayloadAV1::frame_size(const Av1FrameHeader& fh) {
+  nlohmann::json size = {
+      {"frame_width", fh.FrameWidth},
+      {"frame_height", fh.FrameHeight},
   };
+  if (fh.use_superres) {
+    size["superres_denom"] = fh.SuperresDenom;
+    size["upscaled_width"] = fh.UpscaledWidth;
+  }
+  return size;
 }
-nlohmann::json PayloadAV1::render_size(AV1_COMMON* cm) {
+
+nlohmann::json PayloadAV1::render_size(const Av1FrameHeader& fh) {
   return {
-      {"render_width", cm->render_width},
-      {"render_height", cm->render_height},
+      {"render_width", fh.RenderWidth},
+      {"render_height", fh.RenderHeight},
   };
 }
-nlohmann::json PayloadAV1::tile_info(AV1Decoder* const pbi) {
-  AV1_COMMON* const cm = &pbi->common;
-  CommonTileParams* const tiles = &cm->tiles;
-  nlohmann::json tile = {
-      {"uniform_tile_spacing_flag", tiles->uniform_spacing},
+
+nlohmann::json PayloadAV1::tile_info(const Av1TileInfo& tile) {
+  nlohmann::json json = {
+      {"uniform_tile_spacing_flag", tile.uniform_tile_spacing_flag},
+      {"tile_cols", tile.TileCols},
+      {"tile_rows", tile.TileRows},
   };
-  if (cm->tiles.rows * cm->tiles.cols > 1) {
-    tile["context_update_tile_id"] = pbi->context_update_tile_id;
-    tile["tile_size_bytes"] = pbi->tile_size_bytes;
+  if (tile.TileColsLog2 > 0 || tile.TileRowsLog2 > 0) {
+    json["context_update_tile_id"] = tile.context_update_tile_id;
+    json["tile_size_bytes"] = tile.TileSizeBytes;
   }
-  return tile;
+  return json;
 }
-nlohmann::json PayloadAV1::quantization_params(AV1_COMMON* cm) {
-  CommonQuantParams* const quant_params = &cm->quant_params;
+
+nlohmann::json PayloadAV1::quantization_params(const Av1FrameHeader& fh) {
   nlohmann::json quantization = {
-      {"base_q_idx", quant_params->base_qindex},
-      {"y_dc_delta_q", quant_params->y_dc_delta_q},
+      {"base_q_idx", fh.base_q_idx},
+      {"y_dc_delta_q", fh.DeltaQYDc},
   };
-  int num_planes = cm->seq_params->monochrome ? 1 : MAX_MB_PLANE;
-  if (num_planes > 1) {
-    quantization["u_dc_delta_q"] = quant_params->u_dc_delta_q;
-    quantization["u_ac_delta_q"] = quant_params->u_ac_delta_q;
-    quantization["v_dc_delta_q"] = quant_params->v_dc_delta_q;
-    quantization["v_ac_delta_q"] = quant_params->v_ac_delta_q;
-  }
-  quantization["using_qmatrix"] = quant_params->using_qmatrix;
-  if (quant_params->using_qmatrix) {
-    quantization["qm_y"] = quant_params->qmatrix_level_y;
-    quantization["qm_u"] = quant_params->qmatrix_level_u;
-    quantization["qm_v"] = quant_params->qmatrix_level_v;
+  if (!this->parser_.sequenceHeader().mono_chrome) {
+    quantization["u_dc_delta_q"] = fh.DeltaQUDc;
+    quantization["u_ac_delta_q"] = fh.DeltaQUAc;
+    quantization["v_dc_delta_q"] = fh.DeltaQVDc;
+    quantization["v_ac_delta_q"] = fh.DeltaQVAc;
+  }
+  quantization["using_qmatrix"] = fh.using_qmatrix;
+  if (fh.using_qmatrix) {
+    quantization["qm_y"] = fh.qm_y;
+    quantization["qm_u"] = fh.qm_u;
+    quantization["qm_v"] = fh.qm_v;
   }
   return quantization;
 }
-nlohmann::json PayloadAV1::segmentation_params(AV1_COMMON* const cm) {
-  struct segmentation* const seg = &cm->seg;
+
+nlohmann::json PayloadAV1::segmentation_params(const Av1FrameHeader& fh) {
   nlohmann::json segmentation = {
-      {"segmentation_enabled", seg->enabled},
+      {"segmentation_enabled", fh.segmentation_enabled},
   };
-  if (!seg->enabled) {
-    segmentation["segmentation_update_map"] = seg->update_map;
-    segmentation["segmentation_temporal_update"] = seg->temporal_update;
-    segmentation["segmentation_update_data"] = seg->update_data;
+  if (!fh.segmentation_enabled) {
+    return segmentation;
+  }
+  segmentation["segmentation_update_map"] = fh.segmentation_update_map;
+  segmentation["segmentation_temporal_update"] =
+      fh.segmentation_temporal_update;
+  segmentation["segmentation_update_data"] = fh.segmentation_update_data;
+  // Enabled features only, by segment: SEG_LVL_ALT_Q, SEG_LVL_ALT_LF_Y_V,
+  // ..., SEG_LVL_REF_FRAME, SEG_LVL_SKIP, SEG_LVL_GLOBALMV.
+  nlohmann::json segments = nlohmann::json::array();
+  for (int i = 0; i < Av1FrameHeader::kMaxSegments; ++i) {
+    nlohmann::json features = nlohmann::json::object();
+    for (int j = 0; j < Av1FrameHeader::kSegLvlMax; ++j) {
+      if (fh.FeatureEnabled[i] & (1 << j)) {
+        features[std::to_string(j)] = fh.FeatureData[i][j];
+      }
+    }
+    segments.push_back(features);
   }
+  segmentation["feature_data"] = segments;
   return segmentation;
 }
-nlohmann::json PayloadAV1::delta_q_params(AV1_COMMON* const cm) {
+
+nlohmann::json PayloadAV1::delta_q_params(const Av1FrameHeader& fh) {
   return {
-      {"delta_q_res", cm->delta_q_info.delta_q_res},
-      {"delta_q_present", cm->delta_q_info.delta_q_present_flag},
+      {"delta_q_res", fh.delta_q_res},
+      {"delta_q_present", fh.delta_q_present},
   };
 }
-nlohmann::json PayloadAV1::delta_lf_params(AV1_COMMON* const cm) {
+
+nlohmann::json PayloadAV1::delta_lf_params(const Av1FrameHeader& fh) {
   return {
-      {"delta_lf_present", cm->delta_q_info.delta_lf_present_flag},
-      {"delta_lf_res", cm->delta_q_info.delta_lf_res},
-      {"delta_lf_multi", cm->delta_q_info.delta_lf_multi},
+      {"delta_lf_present", fh.delta_lf_present},
+      {"delta_lf_res", fh.delta_lf_res},
+      {"delta_lf_multi", fh.delta_lf_multi},
   };
 }
-nlohmann::json PayloadAV1::loop_filter_params() {
-  return nlohmann::json();
+
+nlohmann::json PayloadAV1::loop_filter_params(const Av1FrameHeader& fh) {
+  nlohmann::json loop_filter = {
+      {"loop_filter_level", fh.loop_filter_level},
+      {"loop_filter_sharpness", fh.loop_filter_sharpness},
+      {"loop_filter_delta_enabled", fh.loop_filter_delta_enabled},
+  };
+  if (fh.loop_filter_delta_enabled) {
+    loop_filter["loop_filter_delta_update"] = fh.loop_filter_delta_update;
+    loop_filter["loop_filter_ref_deltas"] = fh.loop_filter_ref_deltas;
+    loop_filter["loop_filter_mode_deltas"] = fh.loop_filter_mode_deltas;
+  }
+  return loop_filter;
 }
-nlohmann::json PayloadAV1::cdef_params() {
-  return nlohmann::json();
+
+nlohmann::json PayloadAV1::cdef_params(const Av1FrameHeader& fh) {
+  if (!this->parser_.sequenceHeader().enable_cdef || fh.CodedLossless ||
+      fh.allow_intrabc) {
+    return nlohmann::json();
+  }
+  int count = 1 << fh.cdef_bits;
+  return {
+      {"cdef_damping", fh.cdef_damping_minus_3 + 3},
+      {"cdef_bits", fh.cdef_bits},
+      {"cdef_y_pri_strength",
+       std::vector<uint8_t>(fh.cdef_y_pri_strength,
+                            fh.cdef_y_pri_strength + count)},
+      {"cdef_y_sec_strength",
+       std::vector<uint8_t>(fh.cdef_y_sec_strength,
+                            fh.cdef_y_sec_strength + count)},
+      {"cdef_uv_pri_strength",
+       std::vector<uint8_t>(fh.cdef_uv_pri_strength,
+                            fh.cdef_uv_pri_strength + count)},
+      {"cdef_uv_sec_strength",
+       std::vector<uint8_t>(fh.cdef_uv_sec_strength,
+                            fh.cdef_uv_sec_strength + count)},
+  };
 }
-nlohmann::json PayloadAV1::lr_params() {
-  return nlohmann::json();
+
+nlohmann::json PayloadAV1::lr_params(const Av1FrameHeader& fh) {
+  if (!fh.UsesLr) {
+    return nlohmann::json();
+  }
+  return {
+      {"frame_restoration_type", fh.FrameRestorationType},
+      {"loop_restoration_size", fh.LoopRestorationSize},
+  };
 }
-nlohmann::json PayloadAV1::read_tx_mode() {
-  return nlohmann::json();
+
+nlohmann::json PayloadAV1::skip_mode_params(const Av1FrameHeader& fh) {
+  return {{"skip_mode_present", fh.skip_mode_present}};
 }
-nlohmann::json PayloadAV1::frame_reference_mode() {
-  return nlohmann::json();
+
+nlohmann::json PayloadAV1::global_motion_params(const Av1FrameHeader& fh) {
+  if (fh.FrameIsIntra) {
+    return nlohmann::json();
+  }
+  // Non-identity models only, by reference frame (LAST_FRAME is 1).
+  nlohmann::json global_motion = nlohmann::json::object();
+  for (int ref = 1; ref < Av1FrameHeader::kTotalRefsPerFrame; ++ref) {
+    if (fh.GmType[ref] != 0) {
+      global_motion[std::to_string(ref)] = {
+          {"gm_type", fh.GmType[ref]},
+          {"gm_params", fh.gm_params[ref]},
+      };
+    }
+  }
+  return global_motion;
 }
-nlohmann::json PayloadAV1::skip_mode_params() {
-  return nlohmann::json();
+
+nlohmann::json PayloadAV1::film_grain_params(const Av1FrameHeader& fh) {
+  const Av1FilmGrainParams& grain = fh.film_grain_params;
+  if (!this->parser_.sequenceHeader().film_grain_params_present) {
+    return nlohmann::json();
+  }
+  nlohmann::json json = {{"apply_grain", grain.apply_grain}};
+  if (!grain.apply_grain) {
+    return json;
+  }
+  json["grain_seed"] = grain.grain_seed;
+  json["update_grain"] = grain.update_grain;
+  if (!grain.update_grain) {
+    json["film_grain_params_ref_idx"] = grain.film_grain_params_ref_idx;
+  }
+  json["num_y_points"] = grain.num_y_points;
+  json["chroma_scaling_from_luma"] = grain.chroma_scaling_from_luma;
+  json["num_cb_points"] = grain.num_cb_points;
+  json["num_cr_points"] = grain.num_cr_points;
+  json["grain_scaling_minus_8"] = grain.grain_scaling_minus_8;
+  json["ar_coeff_lag"] = grain.ar_coeff_lag;
+  json["ar_coeff_shift_minus_6"] = grain.ar_coeff_shift_minus_6;
+  json["grain_scale_shift"] = grain.grain_scale_shift;
+  json["overlap_flag"] = grain.overlap_flag;
+  json["clip_to_restricted_range"] = grain.clip_to_restricted_range;
+  return json;
 }
-nlohmann::json PayloadAV1::global_motion_params() {
-  return nlohmann::json();
+
+nlohmann::json PayloadAV1::tile_group_obu(const uint8_t* buff, size_t size) {
+  Av1TileGroup group;
+  if (!this->parser_.parseTileGroup(buff, size, &group)) {
+    this->bytes_.other += size;
+    return {{"error", "no frame header"}};
+  }
+  this->bytes_.tile_group_header += group.headerBytes;
+  this->bytes_.tile_sizes += group.tileSizeBytes;
+  // Tiles past a truncated size field count as tile data too.
+  this->bytes_.tile_data += size - group.headerBytes - group.tileSizeBytes;
+
+  nlohmann::json tile_sizes = nlohmann::json::array();
+  int tiles = std::min(group.tg_end - group.tg_start + 1,
+                       int(Av1TileGroup::kMaxTileSizes));
+  for (int i = 0; i < tiles; ++i) {
+    tile_sizes.push_back(group.tileSize[i]);
+  }
+  nlohmann::json json = {
+      {"num_tiles", group.NumTiles},
+      {"tile_start_and_end_present_flag",
+       group.tile_start_and_end_present_flag},
+      {"tg_start", group.tg_start},
+      {"tg_end", group.tg_end},
+      {"tile_data_size", size - group.headerBytes},
+      {"tile_sizes", tile_sizes},
+  };
+  if (group.truncated) {
+    json["error"] = "truncated tile size";
+  }
+  return json;
 }
-nlohmann::json PayloadAV1::film_grain_params() {
-  return nlohmann::json();
+
+// 5.8.1
+nlohmann::json PayloadAV1::metadata_obu(const uint8_t* buff, size_t size) {
+  Av1Metadata metadata;
+  bool ok = Av1HeaderParser::parseMetadata(buff, size, &metadata);
+  nlohmann::json json = {
+      {"metadata_type", metadata.metadata_type},
+      {"metadata_type_name", av1MetadataTypeName(metadata.metadata_type)},
+  };
+  if (!ok) {
+    json["error"] = "truncated";
+    return json;
+  }
+  switch (metadata.metadata_type) {
+    case kAv1MetadataHdrCll:
+      json["max_cll"] = metadata.max_cll;
+      json["max_fall"] = metadata.max_fall;
+      break;
+    case kAv1MetadataHdrMdcv: {
+      nlohmann::json primaries = nlohmann::json::array();
+      for (int i = 0; i < 3; ++i) {
+        primaries.push_back({metadata.primary_chromaticity_x[i],
+                             metadata.primary_chromaticity_y[i]});
+      }
+      // 0.16 fixed point chromaticities, 24.8 and 18.14 luminances.
+      json["primary_chromaticity"] = primaries;
+      json["white_point_chromaticity"] = {
+          metadata.white_point_chromaticity_x,
+          metadata.white_point_chromaticity_y};
+      json["luminance_max"] = metadata.luminance_max;
+      json["luminance_min"] = metadata.luminance_min;
+      break;
+    }
+    case kAv1MetadataScalability:
+      json["scalability_mode_idc"] = metadata.scalability_mode_idc;
+      if (metadata.scalability_mode_idc == kAv1ScalabilitySs) {
+        json["scalability_structure"] = scalability_structure(metadata);
+      }
+      break;
+    case kAv1MetadataItutT35:
+      json["itu_t_t35_country_code"] = metadata.itu_t_t35_country_code;
+      if (metadata.itu_t_t35_country_code == 0xff) {
+        json["itu_t_t35_country_code_extension_byte"] =
+            metadata.itu_t_t35_country_code_extension_byte;
+      }
+      json["itu_t_t35_terminal_provider_code"] =
+          metadata.itu_t_t35_terminal_provider_code;
+      json["itu_t_t35_payload_bytes"] = metadata.itu_t_t35_payload_bytes;
+      break;
+    case kAv1MetadataTimecode:
+      json["counting_type"] = metadata.counting_type;
+      json["full_timestamp_flag"] = metadata.full_timestamp_flag;
+      json["discontinuity_flag"] = metadata.discontinuity_flag;
+      json["cnt_dropped_flag"] = metadata.cnt_dropped_flag;
+      json["n_frames"] = metadata.n_frames;
+      if (metadata.full_timestamp_flag || metadata.seconds_flag) {
+        json["seconds_value"] = metadata.seconds_value;
+      }
+      if (metadata.full_timestamp_flag || metadata.minutes_flag) {
+        json["minutes_value"] = metadata.minutes_value;
+      }
+      if (metadata.full_timestamp_flag || metadata.hours_flag) {
+        json["hours_value"] = metadata.hours_value;
+      }
+      json["time_offset_length"] = metadata.time_offset_length;
+      if (metadata.time_offset_length) {
+        json["time_offset_value"] = metadata.time_offset_value;
+      }
+      break;
+  }
+  return json;
+}
+
+// 5.8.6
+nlohmann::json PayloadAV1::scalability_structure(const Av1Metadata& metadata) {
+  nlohmann::json structure = {
+      {"spatial_layers_cnt_minus_1", metadata.spatial_layers_cnt_minus_1},
+      {"spatial_layer_dimensions_present_flag",
+       metadata.spatial_layer_dimensions_present_flag},
+      {"spatial_layer_description_present_flag",
+       metadata.spatial_layer_description_present_flag},
+      {"temporal_group_description_present_flag",
+       metadata.temporal_group_description_present_flag},
+  };
+  nlohmann::json layers = nlohmann::json::array();
+  for (int i = 0; i <= metadata.spatial_layers_cnt_minus_1; ++i) {
+    nlohmann::json layer = nlohmann::json::object();
+    if (metadata.spatial_layer_dimensions_present_flag) {
+      layer["spatial_layer_max_width"] = metadata.spatial_layer_max_width[i];
+      layer["spatial_layer_max_height"] = metadata.spatial_layer_max_height[i];
+    }
+    if (metadata.spatial_layer_description_present_flag) {
+      layer["spatial_layer_ref_id"] = metadata.spatial_layer_ref_id[i];
+    }
+    layers.push_back(layer);
+  }
+  structure["spatial_layers"] = layers;
+  if (metadata.temporal_group_description_present_flag) {
+    nlohmann::json group = nlohmann::json::array();
+    for (int i = 0; i < metadata.temporal_group_size; ++i) {
+      const auto& entry = metadata.temporal_group[i];
+      group.push_back({
+          {"temporal_group_temporal_id", entry.temporal_group_temporal_id},
+          {"temporal_group_temporal_switching_up_point_flag",
+           entry.temporal_group_temporal_switching_up_point_flag},
+          {"temporal_group_spatial_switching_up_point_flag",
+           entry.temporal_group_spatial_switching_up_point_flag},
+          {"temporal_group_ref_pic_diff",
+           std::vector<uint8_t>(entry.temporal_group_ref_pic_diff,
+                                entry.temporal_group_ref_pic_diff +
+                                    entry.temporal_group_ref_cnt)},
+      });
+    }
+    structure["temporal_group"] = group;
+  }
+  return structure;
+}
+
+// 5.12.1
+nlohmann::json PayloadAV1::tile_list_obu(const uint8_t* buff, size_t size) {
+  Av1TileList list;
+  bool ok = Av1HeaderParser::parseTileList(buff, size, &list);
+  nlohmann::json json = {
+      {"output_frame_width_in_tiles_minus_1",
+       list.output_frame_width_in_tiles_minus_1},
+      {"output_frame_height_in_tiles_minus_1",
+       list.output_frame_height_in_tiles_minus_1},
+      {"tile_count_minus_1", list.tile_count_minus_1},
+      {"tile_list_entries", list.entries},
+      {"tile_data_size", list.tileDataBytes},
+  };
+  if (!ok) {
+    json["error"] = "truncated";
+  }
+  return json;
 }
-}  // namespace chai
\ No newline at end of file
+}  // namespace chai
@@ -1,53 +1,77 @@
 #ifndef CHAI_PAYLOAD_AV1_H
 #define CHAI_PAYLOAD_AV1_H
 
-#include <av1/common/obu_util.h>
+#include "Av1HeaderParser.h"
 #include "RtpPakcet.h"
 
 namespace chai {
 class PayloadAV1 : public PayloadBase {
  public:
   PayloadAV1();
-  nlohmann::json parse(const uint8_t* buff, uint16_t length) override;
+  nlohmann::json parse(const uint8_t* buff, size_t length) override;
 
  protected:
-  nlohmann::json open_bitstream_unit(uint64_t sz);
-  uint32_t leb128(const uint8_t* buff, uint64_t& value);
+  nlohmann::json open_bitstream_unit(const Av1ObuHeader& header,
+                                     const uint8_t* buff,
+                                     size_t size);
 
  protected:
-  nlohmann::json obu_header();
+  nlohmann::json obu_header(const Av1ObuHeader& header);
 
   nlohmann::json obu_sequence_header();
-  nlohmann::json timing_info(aom_timing_info_t& timing_info);
-  nlohmann::json decoder_model_info(aom_dec_model_info_t& decoder_model_info);
+  nlohmann::json timing_info(const Av1SequenceHeader& seq);
+  nlohmann::json decoder_model_info(const Av1SequenceHeader& seq);
   nlohmann::json operating_parameters_info(
-      aom_dec_model_op_parameters_t& op_params);
-  nlohmann::json color_config(SequenceHeader* const seq_params);
+      const Av1SequenceHeader::OperatingPoint& op);
+  nlohmann::json color_config(const Av1SequenceHeader& seq);
 
-  nlohmann::json obu_frame(uint64_t sz);
-  nlohmann::json frame_header_obu();
+  nlohmann::json obu_frame(const Av1ObuHeader& header,
+                           const uint8_t* buff,
+                           size_t size);
+  nlohmann::json frame_header_obu(const Av1ObuHeader& header,
+                                  const uint8_t* buff,
+                                  size_t size);
   nlohmann::json uncompressed_header();
-  nlohmann::json temporal_point_info(AV1_COMMON* const cm);
-  nlohmann::json frame_size(AV1_COMMON* cm);
-  nlohmann::json render_size(AV1_COMMON* cm);
-  nlohmann::json tile_info(AV1Decoder* const pbi);
-  nlohmann::json quantization_params(AV1_COMMON* cm);
-  nlohmann::json segmentation_params(AV1_COMMON* const cm);
-  nlohmann::json delta_q_params(AV1_COMMON* const cm);
-  nlohmann::json delta_lf_params(AV1_COMMON* const cm);
-  nlohmann::json loop_filter_params();
-  nlohmann::json cdef_params();
-  nlohmann::json lr_params();
-  nlohmann::json read_tx_mode();
-  nlohmann::json frame_reference_mode();
-  nlohmann::json skip_mode_params();
-  nlohmann::json global_motion_params();
-  nlohmann::json film_grain_params();
- private:
-  const uint8_t* buff_{nullptr};
+  nlohmann::json frame_size(const Av1FrameHeader& fh);
+  nlohmann::json render_size(const Av1FrameHeader& fh);
+  nlohmann::json tile_info(const Av1TileInfo& tile);
+  nlohmann::json quantization_params(const Av1FrameHeader& fh);
+  nlohmann::json segmentation_params(const Av1FrameHeader& fh);
+  nlohmann::json delta_q_params(const Av1FrameHeader& fh);
+  nlohmann::json delta_lf_params(const Av1FrameHeader& fh);
+  nlohmann::json loop_filter_params(const Av1FrameHeader& fh);
+  nlohmann::json cdef_params(const Av1FrameHeader& fh);
+  nlohmann::json lr_params(const Av1FrameHeader& fh);
+  nlohmann::json skip_mode_params(const Av1FrameHeader& fh);
+  nlohmann::json global_motion_params(const Av1FrameHeader& fh);
+  nlohmann::json film_grain_params(const Av1FrameHeader& fh);
+  nlohmann::json tile_group_obu(const uint8_t* buff, size_t size);
+  nlohmann::json metadata_obu(const uint8_t* buff, size_t size);
+  nlohmann::json scalability_structure(const Av1Metadata& metadata);
+  nlohmann::json tile_list_obu(const uint8_t* buff, size_t size);
+  nlohmann::json bytes_json(size_t length) const;
+
+ protected:
+  // Where the bytes of one frame went, by syntax structure.
+  struct ByteBreakdown {
+    size_t obu_headers{0};
+    size_t sequence_header{0};
+    size_t frame_header{0};
+    size_t redundant_frame_header{0};
+    size_t tile_group_header{0};
+    size_t tile_sizes{0};
+    size_t tile_data{0};
+    size_t metadata{0};
+    size_t tile_list{0};
+    size_t padding{0};
+    // Temporal delimiters, reserved OBU types and what couldn't be parsed.
+    size_t other{0};
+  };
 
-  std::unique_ptr<aom_codec_ctx_t> context_;
-  ObuHeader header;
+ private:
+  // Sequence header and reference state carried from frame to frame.
+  Av1HeaderParser parser_;
+  ByteBreakdown bytes_;
 };
 }  // namespace chai
-#endif  // CHAI_AV1_H
\ No newline at end of file
+#endif  // CHAI_AV1_H
@@ -10,16 +10,32 @@
 
 #include "PayloadH264.h"
 
+#include "BitReader.h"
+
 namespace {
 const uint16_t kNalHeaderSize{1};
-const uint16_t kLengthFieldSize{2};
-const uint16_t kStapAHeaderSize = kNalHeaderSize + kLengthFieldSize;
-// Bit masks for FU (A and B) indicators.
+// 7.4.2.1.1: log2_max_frame_num_minus4 and
+// log2_max_pic_order_cnt_lsb_minus4 are in 0..12.
+const uint32_t kMaxLog2Minus4{12};
+// A.2.1: at most 8 slice groups; the count sizes slice_group_id.
+const uint32_t kMaxSliceGroupsMinus1{7};
+// Bit masks of the NAL unit header.
 enum NalDefs : uint8_t { kFBit = 0x80, kNriMask = 0x60, kTypeMask = 0x1F };
-// Bit masks for FU (A and B) headers.
-enum FuDefs : uint8_t { kSBit = 0x80, kEBit = 0x40, kRBit = 0x20 };
 
-std::map<uint8_t, std::string> nalType2String = {
+// The tables are shared by all parse workers, so they are only read: a miss
+// with operator[] would insert into them from several threads.
+template <typename Key>
+const std::string& nameOf(const std::map<Key, std::string>& names,
+                          uint32_t value) {
+  static const std::string kUnknown{"unknown"};
+  if (value != Key(value)) {
+    return kUnknown;
+  }
+  auto it = names.find(Key(value));
+  return it != names.end() ? it->second : kUnknown;
+}
+
+const std::map<uint8_t, std::string> nalType2String = {
     {webrtc::H264::NaluType::kSlice, "slice"},
     {webrtc::H264::NaluType::kIdr, "idr"},
     {webrtc::H264::NaluType::kSei, "sei"},
@@ -33,24 +49,33 @@ std::map<uint8_t, std::string> nalType2String = {
     {webrtc::H264::NaluType::kFuA, "fu A"},
 };
 
-std::map<uint8_t, std::string> profileIdc2String = {
+const std::map<uint8_t, std::string> profileIdc2String = {
     {66, "Baseline"}, {77, "Main"},        {88, "Extended"},    {100, "High"},
     {110, "High 10"}, {122, "High 4:2:2"}, {144, "High 4:4:4"},
 };
 
-std::map<uint8_t, std::string> sliceType2String = {
+const std::map<uint8_t, std::string> sliceType2String = {
     {webrtc::H264::SliceType::kP, "P slice"},
     {webrtc::H264::SliceType::kB, "B slice"},
     {webrtc::H264::SliceType::kI, "I slice"},
     {webrtc::H264::SliceType::kSp, "SP slice"},
     {webrtc::H264::SliceType::kSi, "SI slice"},
 };
-std::map<uint8_t, std::string> entropyCodingMode2String = {
+const std::map<uint8_t, std::string> entropyCodingMode2String = {
     {0, "CAVLC"},
     {1, "CABAC"},
 };
 
-std::map<uint8_t, std::string> chromaFormatIdc2String = {
+// FNV-1a, to tell a repeated parameter set from a changed one.
+uint64_t hashNalu(const uint8_t* buff, size_t length) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < length; ++i) {
+    hash = (hash ^ buff[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+const std::map<uint8_t, std::string> chromaFormatIdc2String = {
     {0, "4:0:0"},
     {1, "4:2:0"},
     {2, "4:2:2"},
@@ -59,165 +84,86 @@ std::map<uint8_t, std::string> chromaFormatIdc2String = {
 }
 
 namespace chai {
-nlohmann::json PayloadH264::parse(const uint8_t* buff, uint16_t length) {
-  const uint8_t* ptr = buff;
-  uint16_t offset{0};
-  std::ostringstream oss;
+const int PayloadH264::kMaxSps;
+const int PayloadH264::kMaxPps;
 
-  uint8_t forbidden_zero_bit = (ptr[0] & kFBit) >> 7;
-  uint8_t nal_ref_idc = (ptr[0] & kNriMask) >> 5;
-  uint8_t nal_type = ptr[0] & kTypeMask;
-  oss << uint16_t(nal_type) << "(" << nalType2String[nal_type] << ")";
+// |buff| is one access unit in Annex B byte stream format: the depacketizer
+// has undone STAP-A and FU-A and put a start code before every NAL unit.
+nlohmann::json PayloadH264::parse(const uint8_t* buff, size_t length) {
+  std::ostringstream oss;
   nlohmann::json nalus = {
-      {"forbidden_zero_bit", forbidden_zero_bit},
-      {"nal_ref_idc", nal_ref_idc},
-      {"nalu_type", oss.str()},
-      {"payload_length", length},
+      {"access_unit_length", length},
       {"video_codec", "h264"},
       {"frame_key", 0},
+      {"nalus", nlohmann::json::array()},
   };
-  // header
-  if (nal_type == webrtc::H264::NaluType::kFuA) {
-    /*
-             0                   1                   2                   3
-             0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-            +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-            | FU indicator  |   FU header   |                               |
-            +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+                               |
-            |                                                               |
-            |                         FU payload                            |
-            |                                                               |
-            |                               +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-            |                               :...OPTIONAL RTP padding        |
-            +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-
-       The FU indicator octet has the following format:
-               +---------------+
-               |0|1|2|3|4|5|6|7|
-               +-+-+-+-+-+-+-+-+
-               |F|NRI|  Type   |
-               +---------------+
-
-       The FU header has the following format:
-              +---------------+
-              |0|1|2|3|4|5|6|7|
-              +-+-+-+-+-+-+-+-+
-              |S|E|R|  Type   |
-              +---------------+
-    */
-    nalus["nalus"] = nlohmann::json::array();
-    offset += kNalHeaderSize;
-    uint8_t first_fragment = (ptr[offset] & kSBit) >> 7;
-    uint8_t last_fragment = (ptr[offset] & kEBit) >> 6;
-    uint8_t reserved = (ptr[offset] & kRBit) >> 5;
-    nal_type = ptr[offset] & kTypeMask;
-    uint16_t len = length - offset;
+  color1_ = color2_ = VIDEO_L0T0_COLOR;
+  frame_type_ = 0;
+
+  for (const auto& index : webrtc::H264::FindNaluIndices(buff, length)) {
+    const uint8_t* ptr = buff + index.payload_start_offset;
+    size_t len = index.payload_size;
+    if (len < kNalHeaderSize) {
+      continue;
+    }
+    uint8_t forbidden_zero_bit = (ptr[0] & kFBit) >> 7;
+    uint8_t nal_ref_idc = (ptr[0] & kNriMask) >> 5;
+    uint8_t nal_type = ptr[0] & kTypeMask;
     oss.str("");
-    oss << uint16_t(nal_type) << "(" << nalType2String[nal_type] << ")";
+    oss << uint16_t(nal_type) << "(" << nameOf(nalType2String, nal_type)
+        << ")";
     nlohmann::json nalu = {
-        {"first_fragment", first_fragment},
-        {"last_fragment", last_fragment},
-        {"reserved", reserved},
+        {"forbidden_zero_bit", forbidden_zero_bit},
+        {"nal_ref_idc", nal_ref_idc},
         {"nalu_type", oss.str()},
         {"nalu_length", len},
     };
-    if (first_fragment) {
-      offset += kNalHeaderSize;
-      nalu["slice_header"] = this->parseSliceHeader(ptr + offset, len - 1);
-    }
 
-    if (nal_type == webrtc::H264::kIdr) {
-      nalus["frame_key"] = 1;
+    const uint8_t* rbsp = ptr + kNalHeaderSize;
+    size_t rbspLength = len - kNalHeaderSize;
+    switch (nal_type) {
+      case webrtc::H264::kIdr:
+        nalus["frame_key"] = 1;
+        frame_type_ = 1;
+        color1_ = color2_ = VIDEO_KEY_COLOR;
+        nalu["slice_header"] =
+            this->parseSliceHeader(nal_type, rbsp, rbspLength);
+        break;
+      case webrtc::H264::kSlice:
+        nalu["slice_header"] =
+            this->parseSliceHeader(nal_type, rbsp, rbspLength);
+        break;
+      case webrtc::H264::kSps:
+        nalu["sps"] = this->parseSps(rbsp, rbspLength);
+        break;
+      case webrtc::H264::kPps:
+        nalu["pps"] = this->parsePps(rbsp, rbspLength);
+        break;
+      default:
+        break;
     }
     nalus["nalus"].push_back(nalu);
-  } else if (nal_type == webrtc::H264::NaluType::kStapA) {
-    /*
-             0                   1                   2                   3
-             0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-            +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-            |                          RTP Header                           |
-            +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-            |STAP-A NAL HDR |         NALU 1 Size           | NALU 1 HDR    |
-            +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-            |                         NALU 1 Data                           |
-            :                                                               :
-            +               +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-            |               | NALU 2 Size                   | NALU 2 HDR    |
-            +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-            |                         NALU 2 Data                           |
-            :                                                               :
-            |                               +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-            |                               :...OPTIONAL RTP padding        |
-            +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    */
-    nalus["nalus"] = nlohmann::json::array();
-    offset += kNalHeaderSize;
-    while (offset < length) {
-      uint16_t len = webrtc::ByteReader<uint16_t>::ReadBigEndian(ptr + offset);
-      offset += kLengthFieldSize;
-      forbidden_zero_bit = (ptr[offset] & kFBit) >> 7;
-      nal_ref_idc = (ptr[offset] & kNriMask) >> 5;
-      nal_type = ptr[offset] & kTypeMask;
-      oss.str("");
-      oss << uint16_t(nal_type) << "(" << nalType2String[nal_type] << ")";
-      nlohmann::json nalu = {
-          {"forbidden_zero_bit", forbidden_zero_bit},
-          {"nal_ref_idc", nal_ref_idc},
-          {"nalu_type", oss.str()},
-          {"nalu_length", len},
-      };
-
-      uint16_t offset2 = offset + kNalHeaderSize;
-      switch (nal_type) {
-        case webrtc::H264::kSlice: {
-          nalu["slice_header"] = this->parseSliceHeader(ptr + offset2, len - 1);
-        } break;
-        case webrtc::H264::kIdr:
-          nalus["frame_key"] = 1;
-          break;
-        case webrtc::H264::kSei:
-          break;
-        case webrtc::H264::kSps: {
-          nalu["sps"] = this->parseSps(ptr + offset2, len - 1);
-        } break;
-        case webrtc::H264::kPps: {
-          nalu["pps"] = this->parsePps(ptr + offset2, len - 1);
-        } break;
-        case webrtc::H264::kAud:
-          break;
-        case webrtc::H264::kEndOfSequence:
-          break;
-        case webrtc::H264::kEndOfStream:
-          break;
-        case webrtc::H264::kFiller:
-          break;
-        case webrtc::H264::kStapA:
-          break;
-        case webrtc::H264::kFuA:
-          break;
-        default:
-          break;
-      }
-      nalus["nalus"].push_back(nalu);
-      offset += len;
-    }
-  } else {
-    nalus["nalu_length"] = length;
   }
   return nalus;
 }
 
 // https://www.itu.int/rec/T-REC-H.264 T-REC-H.264-201402-S 7.3.2.1.1
-nlohmann::json PayloadH264::parseSps(const uint8_t* buff, uint16_t length) {
-  this->separate_colour_plane_flag = 0;
-  this->frame_mbs_only_flag = 0;
-  this->pic_order_cnt_type = 0;
-  this->delta_pic_order_always_zero_flag = 0;
-  this->log2_max_frame_num = 0;
-  this->log2_max_pic_order_cnt_lsb = 0;
+nlohmann::json PayloadH264::parseSps(const uint8_t* buff, size_t length) {
+  uint64_t hash = hashNalu(buff, length);
+  BitReader peek(buff, length, true);
+  peek.skipBits(24);
+  uint32_t id = peek.readUe();
+  if (peek.ok() && id < kMaxSps) {
+    const ParameterSet<SpsState>& set = this->sps_[id];
+    if (set.valid && set.hash == hash && set.length == length) {
+      nlohmann::json psp = set.json;
+      psp["unchanged"] = true;
+      return psp;
+    }
+  }
 
   // framerate = sps->vui.vui_time_scale / sps->vui.vui_num_units_in_tick / 2;
-  std::unique_ptr<rtc::BitBuffer> buffer(new rtc::BitBuffer(buff, length));
+  BitReader reader(buff, length, true);
 
   // profile_idclevel_idcָʾƵзϵļͼ
   uint8_t profile_idc{0};
@@ -253,10 +199,10 @@ nlohmann::json PayloadH264::parseSps(const uint8_t* buff, uint16_t length) {
   uint32_t pic_order_cnt_type{0};
   uint32_t log2_max_pic_order_cnt_lsb_minus4{0};
   uint32_t delta_pic_order_always_zero_flag{0};
-  uint32_t offset_for_non_ref_pic{0};
-  uint32_t offset_for_top_to_bottom_field{0};
+  int32_t offset_for_non_ref_pic{0};
+  int32_t offset_for_top_to_bottom_field{0};
   uint32_t num_ref_frames_in_pic_order_cnt_cycle{0};
-  uint32_t offset_for_ref_frame{0};
+  int32_t offset_for_ref_frame{0};
 
   // ο֡
   uint32_t max_num_ref_frames{0};
@@ -285,105 +231,115 @@ nlohmann::json PayloadH264::parseSps(const uint8_t* buff, uint16_t length) {
   std::ostringstream oss;
   nlohmann::json psp;
 
-  buffer->ReadUInt8(&profile_idc);  // u(8)
-  oss << uint16_t(profile_idc) << "(" << profileIdc2String[profile_idc] << ")";
+  profile_idc = reader.readBits(8);  // u(8)
+  oss << uint16_t(profile_idc) << "(" << nameOf(profileIdc2String, profile_idc)
+      << ")";
   psp["profile_idc"] = oss.str();
-  buffer->ReadBits(&constraint_set0_flag, 1);  // u(1)
+  constraint_set0_flag = reader.readBits(1);  // u(1)
   psp["constraint_set0_flag"] = constraint_set0_flag;
-  buffer->ReadBits(&constraint_set1_flag, 1);  // u(1)
+  constraint_set1_flag = reader.readBits(1);  // u(1)
   psp["constraint_set1_flag"] = constraint_set1_flag;
-  buffer->ReadBits(&constraint_set2_flag, 1);  // u(1)
+  constraint_set2_flag = reader.readBits(1);  // u(1)
   psp["constraint_set2_flag"] = constraint_set2_flag;
-  buffer->ReadBits(&constraint_set3_flag, 1);  // u(1)
+  constraint_set3_flag = reader.readBits(1);  // u(1)
   psp["constraint_set3_flag"] = constraint_set3_flag;
-  buffer->ReadBits(&constraint_set4_flag, 1);  // u(1)
+  constraint_set4_flag = reader.readBits(1);  // u(1)
   psp["constraint_set4_flag"] = constraint_set4_flag;
-  buffer->ReadBits(&constraint_set5_flag, 1);  // u(1)
+  constraint_set5_flag = reader.readBits(1);  // u(1)
   psp["constraint_set5_flag"] = constraint_set5_flag;
-  buffer->ReadBits(&reserved_zero_2bit, 2);  // u(2)
+  reserved_zero_2bit = reader.readBits(2);  // u(2)
   psp["reserved_zero_2bit"] = reserved_zero_2bit;
-  buffer->ReadUInt8(&level_idc);  // u(8)
+  level_idc = reader.readBits(8);  // u(8)
   psp["level_idc"] = level_idc;
-  buffer->ReadExponentialGolomb(&seq_parameter_set_id);  // ue(v)
+  seq_parameter_set_id = reader.readUe();  // ue(v)
   psp["seq_parameter_set_id"] = seq_parameter_set_id;
   if (profile_idc == 100 || profile_idc == 110 || profile_idc == 122 ||
       profile_idc == 244 || profile_idc == 44 || profile_idc == 83 ||
       profile_idc == 86 || profile_idc == 118 || profile_idc == 128 ||
       profile_idc == 138 || profile_idc == 139 || profile_idc == 134) {
-    buffer->ReadExponentialGolomb(&chroma_format_idc);  // ue(v)
+    chroma_format_idc = reader.readUe();  // ue(v)
     oss.str("");
-    oss << chroma_format_idc << "(" << chromaFormatIdc2String[chroma_format_idc]
-        << ")";
+    oss << chroma_format_idc << "("
+        << nameOf(chromaFormatIdc2String, chroma_format_idc) << ")";
     psp["chroma_format_idc"] = oss.str();
     if (chroma_format_idc == 3) {
-      buffer->ReadBits(&separate_colour_plane_flag, 1);  // u(1)
+      separate_colour_plane_flag = reader.readBits(1);  // u(1)
       psp["separate_colour_plane_flag"] = separate_colour_plane_flag;
     }
-    buffer->ReadExponentialGolomb(&bit_depth_luma_minus8);  // ue(v)
+    bit_depth_luma_minus8 = reader.readUe();  // ue(v)
     oss.str("");
     oss << bit_depth_luma_minus8 << "(" << 8 + bit_depth_luma_minus8 << ")";
     psp["bit_depth_luma_minus8"] = oss.str();
-    buffer->ReadExponentialGolomb(&bit_depth_chroma_minus8);  // ue(v)
+    bit_depth_chroma_minus8 = reader.readUe();  // ue(v)
     oss.str("");
     oss << bit_depth_chroma_minus8 << "(" << 8 + bit_depth_chroma_minus8 << ")";
     psp["bit_depth_chroma_minus8"] = oss.str();
-    buffer->ReadBits(&qpprime_y_zero_transform_bypass_flag, 1);  // u(1)
+    qpprime_y_zero_transform_bypass_flag = reader.readBits(1);  // u(1)
     psp["qpprime_y_zero_transform_bypass_flag"] =
         qpprime_y_zero_transform_bypass_flag;
-    buffer->ReadBits(&seq_scaling_matrix_present_flag, 1);  // u(1)
+    seq_scaling_matrix_present_flag = reader.readBits(1);  // u(1)
     psp["seq_scaling_matrix_present_flag"] = seq_scaling_matrix_present_flag;
     if (seq_scaling_matrix_present_flag) {
       psp["seq_scaling_list_present_flag"] = nlohmann::json::array();
       uint32_t scaling_list_count = (chroma_format_idc != 3 ? 8 : 12);
       for (uint32_t i = 0; i < scaling_list_count; ++i) {
-        buffer->ReadBits(&seq_scaling_list_present_flag, 1);  // u(1)
+        seq_scaling_list_present_flag = reader.readBits(1);  // u(1)
         psp["seq_scaling_list_present_flag"].push_back(
             seq_scaling_list_present_flag);
       }
     }
   }
-  buffer->ReadExponentialGolomb(&log2_max_frame_num_minus4);  // ue(v)
+  log2_max_frame_num_minus4 = reader.readUe();  // ue(v)
+  // Both size u(v) fields of the slice headers.
+  if (log2_max_frame_num_minus4 > kMaxLog2Minus4) {
+    psp["error"] = "log2_max_frame_num_minus4 out of range";
+    return psp;
+  }
   oss.str("");
   oss << log2_max_frame_num_minus4 << "("
       << std::pow(2, log2_max_frame_num_minus4 + 4) << ")";
   psp["log2_max_frame_num_minus4"] = oss.str();
-  buffer->ReadExponentialGolomb(&pic_order_cnt_type);  // ue(v)
+  pic_order_cnt_type = reader.readUe();  // ue(v)
   psp["pic_order_cnt_type"] = pic_order_cnt_type;
   if (pic_order_cnt_type == 0) {
-    buffer->ReadExponentialGolomb(&log2_max_pic_order_cnt_lsb_minus4);  // ue(v)
+    log2_max_pic_order_cnt_lsb_minus4 = reader.readUe();  // ue(v)
+    if (log2_max_pic_order_cnt_lsb_minus4 > kMaxLog2Minus4) {
+      psp["error"] = "log2_max_pic_order_cnt_lsb_minus4 out of range";
+      return psp;
+    }
     oss.str("");
     oss << log2_max_pic_order_cnt_lsb_minus4 << "("
         << std::pow(2, log2_max_pic_order_cnt_lsb_minus4 + 4) << ")";
     psp["log2_max_pic_order_cnt_lsb_minus4"] = oss.str();
   } else if (pic_order_cnt_type == 1) {
-    buffer->ReadBits(&delta_pic_order_always_zero_flag, 1);  // u(1)
+    delta_pic_order_always_zero_flag = reader.readBits(1);  // u(1)
     psp["delta_pic_order_always_zero_flag"] = delta_pic_order_always_zero_flag;
-    buffer->ReadExponentialGolomb(&offset_for_non_ref_pic);  // se(v)
+    offset_for_non_ref_pic = reader.readSe();  // se(v)
     psp["offset_for_non_ref_pic"] = offset_for_non_ref_pic;
-    buffer->ReadExponentialGolomb(&offset_for_top_to_bottom_field);  // se(v)
+    offset_for_top_to_bottom_field = reader.readSe();  // se(v)
     psp["offset_for_top_to_bottom_field"] = offset_for_top_to_bottom_field;
-    buffer->ReadExponentialGolomb(
-        &num_ref_frames_in_pic_order_cnt_cycle);  // ue(v)
+    num_ref_frames_in_pic_order_cnt_cycle = reader.readUe();  // ue(v)
     psp["num_ref_frames_in_pic_order_cnt_cycle"] =
         num_ref_frames_in_pic_order_cnt_cycle;
     psp["offset_for_ref_frame"] = nlohmann::json::array();
-    for (uint32_t i = 0; i < num_ref_frames_in_pic_order_cnt_cycle; ++i) {
-      buffer->ReadExponentialGolomb(&offset_for_ref_frame);  // se(v)
+    for (uint32_t i = 0;
+         i < num_ref_frames_in_pic_order_cnt_cycle && reader.ok(); ++i) {
+      offset_for_ref_frame = reader.readSe();  // se(v)
       psp["offset_for_ref_frame"].push_back(offset_for_ref_frame);
     }
   }
-  buffer->ReadExponentialGolomb(&max_num_ref_frames);  // ue(v)
+  max_num_ref_frames = reader.readUe();  // ue(v)
   psp["max_num_ref_frames"] = max_num_ref_frames;
-  buffer->ReadBits(&gaps_in_frame_num_value_allowed_flag, 1);  // u(1)
+  gaps_in_frame_num_value_allowed_flag = reader.readBits(1);  // u(1)
   psp["max_num_regaps_in_frame_num_value_allowed_flagf_frames"] =
       gaps_in_frame_num_value_allowed_flag;
-  buffer->ReadExponentialGolomb(&pic_width_in_mbs_minus1);  // ue(v)
+  pic_width_in_mbs_minus1 = reader.readUe();  // ue(v)
   oss.str("");
   oss << pic_width_in_mbs_minus1 << "(" << (pic_width_in_mbs_minus1 + 1) * 16
       << ")";
   psp["pic_width_in_mbs_minus1"] = oss.str();
-  buffer->ReadExponentialGolomb(&pic_height_in_map_units_minus1);  // ue(v)
-  buffer->ReadBits(&frame_mbs_only_flag, 1);                       // u(1)
+  pic_height_in_map_units_minus1 = reader.readUe();  // ue(v)
+  frame_mbs_only_flag = reader.readBits(1);                       // u(1)
   oss.str("");
   oss << pic_height_in_map_units_minus1 << "("
       << (pic_height_in_map_units_minus1 + 1) * (2 - frame_mbs_only_flag) * 16
@@ -391,46 +347,68 @@ nlohmann::json PayloadH264::parseSps(const uint8_t* buff, uint16_t length) {
   psp["pic_height_in_map_units_minus1"] = pic_height_in_map_units_minus1;
   psp["frame_mbs_only_flag"] = frame_mbs_only_flag;
   if (!frame_mbs_only_flag) {
-    buffer->ReadBits(&mb_adaptive_frame_field_flag, 1);  // u(1)
+    mb_adaptive_frame_field_flag = reader.readBits(1);  // u(1)
     psp["mb_adaptive_frame_field_flag"] = mb_adaptive_frame_field_flag;
   }
-  buffer->ReadBits(&direct_8x8_inference_flag, 1);  // u(1)
+  direct_8x8_inference_flag = reader.readBits(1);  // u(1)
   psp["direct_8x8_inference_flag"] = direct_8x8_inference_flag;
-  buffer->ReadBits(&frame_cropping_flag, 1);  // u(1)
+  frame_cropping_flag = reader.readBits(1);  // u(1)
   psp["frame_cropping_flag"] = frame_cropping_flag;
   if (frame_cropping_flag) {
-    buffer->ReadExponentialGolomb(&frame_crop_left_offset);  // ue(v)
+    frame_crop_left_offset = reader.readUe();  // ue(v)
     psp["frame_crop_left_offset"] = frame_crop_left_offset;
-    buffer->ReadExponentialGolomb(&frame_crop_right_offset);  // ue(v)
+    frame_crop_right_offset = reader.readUe();  // ue(v)
     psp["frame_crop_right_offset"] = frame_crop_right_offset;
-    buffer->ReadExponentialGolomb(&frame_crop_top_offset);  // ue(v)
+    frame_crop_top_offset = reader.readUe();  // ue(v)
     psp["frame_crop_top_offset"] = frame_crop_top_offset;
-    buffer->ReadExponentialGolomb(&frame_crop_bottom_offset);  // ue(v)
+    frame_crop_bottom_offset = reader.readUe();  // ue(v)
     psp["frame_crop_bottom_offset"] = frame_crop_bottom_offset;
   }
-  buffer->ReadBits(&vui_parameters_present_flag, 1);  // u(1)
+  vui_parameters_present_flag = reader.readBits(1);  // u(1)
   psp["vui_parameters_present_flag"] = vui_parameters_present_flag;
   if (vui_parameters_present_flag) {
   }
 
-  this->separate_colour_plane_flag = separate_colour_plane_flag;
-  this->frame_mbs_only_flag = frame_mbs_only_flag;
-  this->pic_order_cnt_type = pic_order_cnt_type;
-  this->delta_pic_order_always_zero_flag = delta_pic_order_always_zero_flag;
-  this->log2_max_frame_num = log2_max_frame_num_minus4 + 4;
-  this->log2_max_pic_order_cnt_lsb = log2_max_pic_order_cnt_lsb_minus4 + 4;
+  if (!reader.ok()) {
+    // Keep the state of the last complete parameter set.
+    psp["truncated"] = true;
+    return psp;
+  }
+
+  if (seq_parameter_set_id >= kMaxSps) {
+    psp["error"] = "seq_parameter_set_id out of range";
+    return psp;
+  }
+
+  ParameterSet<SpsState>& set = this->sps_[seq_parameter_set_id];
+  set.valid = true;
+  set.hash = hash;
+  set.length = length;
+  set.state.separate_colour_plane_flag = separate_colour_plane_flag;
+  set.state.frame_mbs_only_flag = frame_mbs_only_flag;
+  set.state.pic_order_cnt_type = pic_order_cnt_type;
+  set.state.delta_pic_order_always_zero_flag = delta_pic_order_always_zero_flag;
+  set.state.log2_max_frame_num = log2_max_frame_num_minus4 + 4;
+  set.state.log2_max_pic_order_cnt_lsb = log2_max_pic_order_cnt_lsb_minus4 + 4;
+  set.json = psp;
   return psp;
 }
 
 // https://www.itu.int/rec/T-REC-H.264 T-REC-H.264-201402-S 7.3.2.2
-nlohmann::json PayloadH264::parsePps(const uint8_t* buff, uint16_t length) {
-  this->bottom_field_pic_order_in_frame_present_flag = 0;
-  this->redundant_pic_cnt_present_flag = 0;
-  this->entropy_coding_mode_flag = 0;
-  this->deblocking_filter_control_present_flag = 0;
-  this->num_slice_groups_minus1 = 0;
-  this->slice_group_map_type = 0;
-  std::unique_ptr<rtc::BitBuffer> buffer(new rtc::BitBuffer(buff, length));
+nlohmann::json PayloadH264::parsePps(const uint8_t* buff, size_t length) {
+  uint64_t hash = hashNalu(buff, length);
+  BitReader peek(buff, length, true);
+  uint32_t id = peek.readUe();
+  if (peek.ok() && id < kMaxPps) {
+    const ParameterSet<PpsState>& set = this->pps_[id];
+    if (set.valid && set.hash == hash && set.length == length) {
+      nlohmann::json pps = set.json;
+      pps["unchanged"] = true;
+      return pps;
+    }
+  }
+
+  BitReader reader(buff, length, true);
 
   uint32_t pic_parameter_set_id{0};
   uint32_t seq_parameter_set_id{0};
@@ -457,10 +435,10 @@ nlohmann::json PayloadH264::parsePps(const uint8_t* buff, uint16_t length) {
   // B sliceмȨԤķid
   uint32_t weighted_bipred_idc{0};
   // ʼʵʲslice header
-  uint32_t pic_init_qp_minus26{0};
-  uint32_t pic_init_qs_minus26{0};
+  int32_t pic_init_qp_minus26{0};
+  int32_t pic_init_qs_minus26{0};
   // ڼɫȷ
-  uint32_t chroma_qp_index_offset{0};
+  int32_t chroma_qp_index_offset{0};
   // ʾslice headerǷȥ˲ƵϢ
   uint32_t deblocking_filter_control_present_flag{0};
   // ʾIڽ֡ԤʱֻʹISI͵ĺϢ
@@ -476,49 +454,53 @@ nlohmann::json PayloadH264::parsePps(const uint8_t* buff, uint16_t length) {
   std::ostringstream oss;
   nlohmann::json pps;
 
-  buffer->ReadExponentialGolomb(&pic_parameter_set_id);  // ue(v)
+  pic_parameter_set_id = reader.readUe();  // ue(v)
   pps["pic_parameter_set_id"] = pic_parameter_set_id;
-  buffer->ReadExponentialGolomb(&seq_parameter_set_id);  // ue(v)
+  seq_parameter_set_id = reader.readUe();  // ue(v)
   pps["seq_parameter_set_id"] = seq_parameter_set_id;
-  buffer->ReadBits(&entropy_coding_mode_flag, 1);  // u(1)
+  entropy_coding_mode_flag = reader.readBits(1);  // u(1)
   oss << entropy_coding_mode_flag << "("
-      << entropyCodingMode2String[entropy_coding_mode_flag] << ")";
+      << nameOf(entropyCodingMode2String, entropy_coding_mode_flag) << ")";
   pps["entropy_coding_mode_flag"] = oss.str();
-  buffer->ReadBits(&bottom_field_pic_order_in_frame_present_flag, 1);  // u(1)
+  bottom_field_pic_order_in_frame_present_flag = reader.readBits(1);  // u(1)
   pps["bottom_field_pic_order_in_frame_present_flag"] =
       bottom_field_pic_order_in_frame_present_flag;
-  buffer->ReadExponentialGolomb(&num_slice_groups_minus1);  // ue(v)
+  num_slice_groups_minus1 = reader.readUe();  // ue(v)
   oss.str("");
   oss << num_slice_groups_minus1 << "(" << num_slice_groups_minus1 + 1 << ")";
   pps["num_slice_groups_minus1"] = oss.str();
+  if (num_slice_groups_minus1 > kMaxSliceGroupsMinus1) {
+    pps["error"] = "num_slice_groups_minus1 out of range";
+    return pps;
+  }
   if (num_slice_groups_minus1 > 0) {
-    buffer->ReadExponentialGolomb(&slice_group_map_type);  // ue(v)
+    slice_group_map_type = reader.readUe();  // ue(v)
     pps["slice_group_map_type"] = slice_group_map_type;
     if (slice_group_map_type == 0) {
       pps["run_length_minus1"] = nlohmann::json::array();
-      for (uint32_t i = 0; i <= num_slice_groups_minus1; ++i) {
-        buffer->ReadExponentialGolomb(&run_length_minus1);  // ue(v)
+      for (uint32_t i = 0; i <= num_slice_groups_minus1 && reader.ok(); ++i) {
+        run_length_minus1 = reader.readUe();  // ue(v)
         pps["run_length_minus1"].push_back(run_length_minus1);
       }
     } else if (slice_group_map_type == 2) {
       pps["top_left_bottom_right"] = nlohmann::json::array();
-      for (uint32_t i = 0; i <= num_slice_groups_minus1; ++i) {
+      for (uint32_t i = 0; i <= num_slice_groups_minus1 && reader.ok(); ++i) {
         nlohmann::json top_left_bottom_right;
-        buffer->ReadExponentialGolomb(&top_left);  // ue(v)
+        top_left = reader.readUe();  // ue(v)
         top_left_bottom_right["top_left"] = top_left;
-        buffer->ReadExponentialGolomb(&bottom_right);  // ue(v)
+        bottom_right = reader.readUe();  // ue(v)
         top_left_bottom_right["bottom_right"] = bottom_right;
         pps["top_left_bottom_right"].push_back(top_left_bottom_right);
       }
     } else if (slice_group_map_type == 3 || slice_group_map_type == 4 ||
                slice_group_map_type == 5) {
-      buffer->ReadBits(&slice_group_change_direction_flag, 1);  // u(1)
+      slice_group_change_direction_flag = reader.readBits(1);  // u(1)
       pps["slice_group_change_direction_flag"] =
           slice_group_change_direction_flag;
-      buffer->ReadExponentialGolomb(&slice_group_change_rate_minus1);  // ue(v)
+      slice_group_change_rate_minus1 = reader.readUe();  // ue(v)
       pps["slice_group_change_rate_minus1"] = slice_group_change_rate_minus1;
     } else if (slice_group_map_type == 6) {
-      buffer->ReadExponentialGolomb(&pic_size_in_map_units_minus1);  // ue(v)
+      pic_size_in_map_units_minus1 = reader.readUe();  // ue(v)
       pps["pic_size_in_map_units_minus1"] = pic_size_in_map_units_minus1;
 
       uint32_t slice_group_id_bits = 0;
@@ -531,52 +513,69 @@ nlohmann::json PayloadH264::parsePps(const uint8_t* buff, uint16_t length) {
         ++slice_group_id_bits;
       }
       pps["slice_group_id"] = nlohmann::json::array();
-      for (uint32_t i = 0; i <= pic_size_in_map_units_minus1; ++i) {
-        buffer->ReadBits(&slice_group_id, slice_group_id_bits);  // u(v)
+      for (uint32_t i = 0; i <= pic_size_in_map_units_minus1 && reader.ok();
+           ++i) {
+        slice_group_id = reader.readBits(slice_group_id_bits);  // u(v)
         pps["slice_group_id"].push_back(slice_group_id);
       }
     }
   }
-  buffer->ReadExponentialGolomb(
-      &num_ref_idx_l0_default_active_minus1);  // ue(v)
+  num_ref_idx_l0_default_active_minus1 = reader.readUe();  // ue(v)
   pps["num_ref_idx_l0_default_active_minus1"] =
       num_ref_idx_l0_default_active_minus1;
-  buffer->ReadExponentialGolomb(
-      &num_ref_idx_l1_default_active_minus1);  // ue(v)
+  num_ref_idx_l1_default_active_minus1 = reader.readUe();  // ue(v)
   pps["num_ref_idx_l1_default_active_minus1"] =
       num_ref_idx_l1_default_active_minus1;
-  buffer->ReadBits(&weighted_pred_flag, 1);  // u(1)
+  weighted_pred_flag = reader.readBits(1);  // u(1)
   pps["weighted_pred_flag"] = weighted_pred_flag;
-  buffer->ReadBits(&weighted_bipred_idc, 2);  // u(2)
+  weighted_bipred_idc = reader.readBits(2);  // u(2)
   pps["weighted_bipred_idc"] = weighted_bipred_idc;
-  buffer->ReadExponentialGolomb(&pic_init_qp_minus26);  // se(v)
+  pic_init_qp_minus26 = reader.readSe();  // se(v)
   pps["pic_init_qp_minus26"] = pic_init_qp_minus26;
-  buffer->ReadExponentialGolomb(&pic_init_qs_minus26);  // se(v)
+  pic_init_qs_minus26 = reader.readSe();  // se(v)
   pps["pic_init_qs_minus26"] = pic_init_qs_minus26;
-  buffer->ReadExponentialGolomb(&chroma_qp_index_offset);  // se(v)
+  chroma_qp_index_offset = reader.readSe();  // se(v)
   pps["chroma_qp_index_offset"] = chroma_qp_index_offset;
-  buffer->ReadBits(&deblocking_filter_control_present_flag, 1);  // u(1)
+  deblocking_filter_control_present_flag = reader.readBits(1);  // u(1)
   pps["deblocking_filter_control_present_flag"] =
       deblocking_filter_control_present_flag;
-  buffer->ReadBits(&constrained_intra_pred_flag, 1);  // u(1)
+  constrained_intra_pred_flag = reader.readBits(1);  // u(1)
   pps["constrained_intra_pred_flag"] = constrained_intra_pred_flag;
-  buffer->ReadBits(&redundant_pic_cnt_present_flag, 1);  // u(1)
+  redundant_pic_cnt_present_flag = reader.readBits(1);  // u(1)
   pps["redundant_pic_cnt_present_flag"] = redundant_pic_cnt_present_flag;
 
-  this->bottom_field_pic_order_in_frame_present_flag =
+  if (!reader.ok()) {
+    // Keep the state of the last complete parameter set.
+    pps["truncated"] = true;
+    return pps;
+  }
+
+  if (pic_parameter_set_id >= kMaxPps || seq_parameter_set_id >= kMaxSps) {
+    pps["error"] = "parameter set id out of range";
+    return pps;
+  }
+
+  ParameterSet<PpsState>& set = this->pps_[pic_parameter_set_id];
+  set.valid = true;
+  set.hash = hash;
+  set.length = length;
+  set.state.seq_parameter_set_id = seq_parameter_set_id;
+  set.state.bottom_field_pic_order_in_frame_present_flag =
       bottom_field_pic_order_in_frame_present_flag;
-  this->redundant_pic_cnt_present_flag = redundant_pic_cnt_present_flag;
-  this->entropy_coding_mode_flag = entropy_coding_mode_flag;
-  this->deblocking_filter_control_present_flag =
+  set.state.redundant_pic_cnt_present_flag = redundant_pic_cnt_present_flag;
+  set.state.entropy_coding_mode_flag = entropy_coding_mode_flag;
+  set.state.deblocking_filter_control_present_flag =
       deblocking_filter_control_present_flag;
-  this->num_slice_groups_minus1 = num_slice_groups_minus1;
-  this->slice_group_map_type = slice_group_map_type;
+  set.state.num_slice_groups_minus1 = num_slice_groups_minus1;
+  set.state.slice_group_map_type = slice_group_map_type;
+  set.json = pps;
   return pps;
 }
 
-nlohmann::json PayloadH264::parseSliceHeader(const uint8_t* buff,
-                                             uint16_t length) {
-  std::unique_ptr<rtc::BitBuffer> buffer(new rtc::BitBuffer(buff, length));
+nlohmann::json PayloadH264::parseSliceHeader(uint8_t nal_type,
+                                             const uint8_t* buff,
+                                             size_t length) {
+  BitReader reader(buff, length, true);
 
   uint32_t first_mb_in_slice{0};
   uint32_t slice_type{0};
@@ -589,130 +588,144 @@ nlohmann::json PayloadH264::parseSliceHeader(const uint8_t* buff,
   uint32_t bottom_field_flag{0};
   uint32_t idr_pic_id{0};
   uint32_t pic_order_cnt_lsb{0};
-  uint32_t delta_pic_order_cnt_bottom{0};
-  uint32_t delta_pic_order_cnt{0};
+  int32_t delta_pic_order_cnt_bottom{0};
+  int32_t delta_pic_order_cnt{0};
   uint32_t redundant_pic_cnt{0};
   uint32_t direct_spatial_mv_pred_flag{0};
   uint32_t num_ref_idx_active_override_flag{0};
   uint32_t num_ref_idx_l0_active_minus1{0};
   uint32_t num_ref_idx_l1_active_minus1{0};
   uint32_t cabac_init_idc{0};
-  uint32_t slice_qp_delta{0};
+  int32_t slice_qp_delta{0};
   uint32_t sp_for_switch_flag{0};
-  uint32_t slice_qs_delta{0};
+  int32_t slice_qs_delta{0};
   // ˲
   uint32_t disable_deblocking_filter_idc{0};
 
-  uint32_t slice_alpha_c0_offset_div2{0};
-  uint32_t slice_beta_offset_div2{0};
+  int32_t slice_alpha_c0_offset_div2{0};
+  int32_t slice_beta_offset_div2{0};
   uint32_t slice_group_change_cycle{0};
 
   std::ostringstream oss;
   nlohmann::json slice_header;
 
-  buffer->ReadExponentialGolomb(&first_mb_in_slice);  // ue(v)
+  first_mb_in_slice = reader.readUe();  // ue(v)
   slice_header["first_mb_in_slice"] = first_mb_in_slice;
-  buffer->ReadExponentialGolomb(&slice_type);  // ue(v)
-  oss << slice_type << "(" << sliceType2String[slice_type] << ")";
+  // 5 to 9 mean the same types as 0 to 4, for every slice of the picture.
+  slice_type = reader.readUe() % 5;  // ue(v)
+  oss << slice_type << "(" << nameOf(sliceType2String, slice_type) << ")";
   slice_header["slice_type"] = oss.str();
-  buffer->ReadExponentialGolomb(&pic_parameter_set_id);  // ue(v)
+  pic_parameter_set_id = reader.readUe();  // ue(v)
   slice_header["pic_parameter_set_id"] = pic_parameter_set_id;
-  if (this->separate_colour_plane_flag == 1) {
-    buffer->ReadBits(&colour_plane_id, 2);  // u(2)
+  if (!reader.ok() || pic_parameter_set_id >= kMaxPps ||
+      !this->pps_[pic_parameter_set_id].valid) {
+    slice_header["error"] = "unknown pps";
+    return slice_header;
+  }
+  const PpsState& pps = this->pps_[pic_parameter_set_id].state;
+  if (!this->sps_[pps.seq_parameter_set_id].valid) {
+    slice_header["error"] = "unknown sps";
+    return slice_header;
+  }
+  const SpsState& sps = this->sps_[pps.seq_parameter_set_id].state;
+  if (sps.separate_colour_plane_flag == 1) {
+    colour_plane_id = reader.readBits(2);  // u(2)
     slice_header["colour_plane_id"] = colour_plane_id;
   }
-  buffer->ReadBits(&frame_num, this->log2_max_frame_num);  // u(v)
+  frame_num = reader.readBits(sps.log2_max_frame_num);  // u(v)
   slice_header["frame_num"] = frame_num;
-  if (!this->frame_mbs_only_flag) {
-    buffer->ReadBits(&field_pic_flag, 1);  // u(1)
+  if (!sps.frame_mbs_only_flag) {
+    field_pic_flag = reader.readBits(1);  // u(1)
     slice_header["field_pic_flag"] = field_pic_flag;
     if (field_pic_flag) {
-      buffer->ReadBits(&bottom_field_flag, 1);  // u(1)
+      bottom_field_flag = reader.readBits(1);  // u(1)
       slice_header["bottom_field_flag"] = bottom_field_flag;
     }
   }
-  bool is_idr = (buff[0] & 0x0F) == webrtc::H264::NaluType::kIdr;
-  if (is_idr) {
-    buffer->ReadExponentialGolomb(&idr_pic_id);  // ue(v)
+  if (nal_type == webrtc::H264::NaluType::kIdr) {
+    idr_pic_id = reader.readUe();  // ue(v)
     slice_header["idr_pic_id"] = idr_pic_id;
   }
-  if (this->pic_order_cnt_type == 0) {
-    buffer->ReadBits(&pic_order_cnt_lsb,
-                     this->log2_max_pic_order_cnt_lsb);  // u(v)
+  if (sps.pic_order_cnt_type == 0) {
+    pic_order_cnt_lsb =
+        reader.readBits(sps.log2_max_pic_order_cnt_lsb);  // u(v)
     slice_header["pic_order_cnt_lsb"] = pic_order_cnt_lsb;
-    if (bottom_field_pic_order_in_frame_present_flag && !field_pic_flag) {
-      buffer->ReadExponentialGolomb(&delta_pic_order_cnt_bottom);  // se(v)
+    if (pps.bottom_field_pic_order_in_frame_present_flag && !field_pic_flag) {
+      delta_pic_order_cnt_bottom = reader.readSe();  // se(v)
       slice_header["delta_pic_order_cnt_bottom"] = delta_pic_order_cnt_bottom;
     }
   }
-  if (this->pic_order_cnt_type == 1 &&
-      !this->delta_pic_order_always_zero_flag) {
+  if (sps.pic_order_cnt_type == 1 &&
+      !sps.delta_pic_order_always_zero_flag) {
     slice_header["delta_pic_order_cnt"] = nlohmann::json::array();
-    buffer->ReadExponentialGolomb(&delta_pic_order_cnt);  // se(v)
+    delta_pic_order_cnt = reader.readSe();  // se(v)
     slice_header["delta_pic_order_cnt"].push_back(delta_pic_order_cnt);
-    if (bottom_field_pic_order_in_frame_present_flag && !field_pic_flag) {
-      buffer->ReadExponentialGolomb(&delta_pic_order_cnt);  // se(v)
+    if (pps.bottom_field_pic_order_in_frame_present_flag && !field_pic_flag) {
+      delta_pic_order_cnt = reader.readSe();  // se(v)
       slice_header["delta_pic_order_cnt"].push_back(delta_pic_order_cnt);
     }
   }
-  if (this->redundant_pic_cnt_present_flag) {
-    buffer->ReadExponentialGolomb(&redundant_pic_cnt);  // ue(v)
+  if (pps.redundant_pic_cnt_present_flag) {
+    redundant_pic_cnt = reader.readUe();  // ue(v)
     slice_header["redundant_pic_cnt"] = redundant_pic_cnt;
   }
   if (slice_type == webrtc::H264::SliceType::kB) {
-    buffer->ReadBits(&direct_spatial_mv_pred_flag, 1);  // u(1)
+    direct_spatial_mv_pred_flag = reader.readBits(1);  // u(1)
     slice_header["direct_spatial_mv_pred_flag"] = direct_spatial_mv_pred_flag;
   }
   if (slice_type == webrtc::H264::SliceType::kP ||
       slice_type == webrtc::H264::SliceType::kSp ||
       slice_type == webrtc::H264::SliceType::kB) {
-    buffer->ReadBits(&num_ref_idx_active_override_flag, 1);  // u(1)
+    num_ref_idx_active_override_flag = reader.readBits(1);  // u(1)
     slice_header["num_ref_idx_active_override_flag"] =
         num_ref_idx_active_override_flag;
     if (num_ref_idx_active_override_flag) {
-      buffer->ReadExponentialGolomb(&num_ref_idx_l0_active_minus1);  // ue(v)
+      num_ref_idx_l0_active_minus1 = reader.readUe();  // ue(v)
       slice_header["num_ref_idx_l0_active_minus1"] =
           num_ref_idx_l0_active_minus1;
       if (slice_type == webrtc::H264::SliceType::kB) {
-        buffer->ReadExponentialGolomb(&num_ref_idx_l1_active_minus1);  // ue(v)
+        num_ref_idx_l1_active_minus1 = reader.readUe();  // ue(v)
         slice_header["num_ref_idx_l1_active_minus1"] =
             num_ref_idx_l1_active_minus1;
       }
     }
   }
-  if (this->entropy_coding_mode_flag &&
+  if (pps.entropy_coding_mode_flag &&
       slice_type != webrtc::H264::SliceType::kI &&
       slice_type != webrtc::H264::SliceType::kSi) {
-    buffer->ReadExponentialGolomb(&cabac_init_idc);  // ue(v)
+    cabac_init_idc = reader.readUe();  // ue(v)
     slice_header["cabac_init_idc"] = cabac_init_idc;
   }
-  buffer->ReadExponentialGolomb(&slice_qp_delta);  // se(v)
+  slice_qp_delta = reader.readSe();  // se(v)
   slice_header["slice_qp_delta"] = slice_qp_delta;
   if (slice_type == webrtc::H264::SliceType::kSp ||
       slice_type == webrtc::H264::SliceType::kSi) {
     if (slice_type == webrtc::H264::SliceType::kSp) {
-      buffer->ReadBits(&sp_for_switch_flag, 1);  // u(1)
+      sp_for_switch_flag = reader.readBits(1);  // u(1)
       slice_header["sp_for_switch_flag"] = sp_for_switch_flag;
     }
-    buffer->ReadExponentialGolomb(&slice_qs_delta);  // se(v)
+    slice_qs_delta = reader.readSe();  // se(v)
     slice_header["slice_qs_delta"] = slice_qs_delta;
   }
-  if (this->deblocking_filter_control_present_flag) {
-    buffer->ReadExponentialGolomb(&disable_deblocking_filter_idc);  // ue(v)
+  if (pps.deblocking_filter_control_present_flag) {
+    disable_deblocking_filter_idc = reader.readUe();  // ue(v)
     slice_header["disable_deblocking_filter_idc"] =
         disable_deblocking_filter_idc;
     if (disable_deblocking_filter_idc != 1) {
-      buffer->ReadExponentialGolomb(&slice_alpha_c0_offset_div2);  // se(v)
+      slice_alpha_c0_offset_div2 = reader.readSe();  // se(v)
       slice_header["slice_alpha_c0_offset_div2"] = slice_alpha_c0_offset_div2;
-      buffer->ReadExponentialGolomb(&slice_beta_offset_div2);  // se(v)
+      slice_beta_offset_div2 = reader.readSe();  // se(v)
       slice_header["slice_beta_offset_div2"] = slice_beta_offset_div2;
     }
   }
-  if (this->num_slice_groups_minus1 > 0 && this->slice_group_map_type >= 3 &&
-      this->slice_group_map_type <= 5) {
-    // buffer->ReadBits(&slice_group_change_cycle, v); // u(v)
+  if (pps.num_slice_groups_minus1 > 0 && pps.slice_group_map_type >= 3 &&
+      pps.slice_group_map_type <= 5) {
+    // slice_group_change_cycle = reader.readBits(v); // u(v)
     slice_header["slice_group_change_cycle"] = "null";
   }
+  if (!reader.ok()) {
+    slice_header["truncated"] = true;
+  }
   return slice_header;
 }
 }  // namespace chai
\ No newline at end of file
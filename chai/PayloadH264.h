@@ -13,26 +13,53 @@
 namespace chai {
 class PayloadH264 : public PayloadBase {
  public:
-  nlohmann::json parse(const uint8_t* buff, uint16_t length) override;
+  nlohmann::json parse(const uint8_t* buff, size_t length) override;
 
  protected:
-  nlohmann::json parseSps(const uint8_t* buff, uint16_t length);
-  nlohmann::json parsePps(const uint8_t* buff, uint16_t length);
-  nlohmann::json parseSliceHeader(const uint8_t* buff, uint16_t length);
+  nlohmann::json parseSps(const uint8_t* buff, size_t length);
+  nlohmann::json parsePps(const uint8_t* buff, size_t length);
+  nlohmann::json parseSliceHeader(uint8_t nal_type,
+                                  const uint8_t* buff,
+                                  size_t length);
+
+  static const int kMaxSps{32};
+  static const int kMaxPps{256};
+
+  // What the slice header syntax needs from an SPS.
+  struct SpsState {
+    uint32_t separate_colour_plane_flag{0};
+    uint32_t frame_mbs_only_flag{0};
+    uint32_t pic_order_cnt_type{0};
+    uint32_t delta_pic_order_always_zero_flag{0};
+    uint32_t log2_max_frame_num{0};
+    uint32_t log2_max_pic_order_cnt_lsb{0};
+  };
+  // What the slice header syntax needs from a PPS.
+  struct PpsState {
+    uint32_t seq_parameter_set_id{0};
+    uint32_t bottom_field_pic_order_in_frame_present_flag{0};
+    uint32_t redundant_pic_cnt_present_flag{0};
+    uint32_t entropy_coding_mode_flag{0};
+    uint32_t deblocking_filter_control_present_flag{0};
+    uint32_t num_slice_groups_minus1{0};
+    uint32_t slice_group_map_type{0};
+  };
+  // One parameter set id. Senders repeat the SPS and PPS before every key
+  // frame; |hash| and |length| of the raw NAL unit tell a repeat, which gets
+  // the cached |json| instead of being parsed again.
+  template <typename State>
+  struct ParameterSet {
+    bool valid{false};
+    uint64_t hash{0};
+    size_t length{0};
+    State state;
+    nlohmann::json json;
+  };
 
  private:
-  uint32_t separate_colour_plane_flag{0};
-  uint32_t frame_mbs_only_flag{0};
-  uint32_t pic_order_cnt_type{0};
-  uint32_t bottom_field_pic_order_in_frame_present_flag{0};
-  uint32_t delta_pic_order_always_zero_flag{0};
-  uint32_t redundant_pic_cnt_present_flag{0};
-  uint32_t entropy_coding_mode_flag{0};
-  uint32_t deblocking_filter_control_present_flag{0};
-  uint32_t num_slice_groups_minus1{0};
-  uint32_t slice_group_map_type{0};
-  uint32_t log2_max_frame_num{0};
-  uint32_t log2_max_pic_order_cnt_lsb{0};
+  // One PayloadH264 per SSRC, so the sets are keyed by SSRC and id.
+  ParameterSet<SpsState> sps_[kMaxSps];
+  ParameterSet<PpsState> pps_[kMaxPps];
 };
 }  // namespace chai
 #endif  // CHAI_AV1_H
\ No newline at end of file
@@ -0,0 +1,1118 @@
+#include "PayloadH265.h"
+
+#include <common_video/h264/h264_common.h>
+
+#include "BitReader.h"
+
+namespace {
+const uint16_t kNalHeaderSize{2};
+// 7.4.3.2.1: log2_max_pic_order_cnt_lsb_minus4 is in 0..12.
+const uint32_t kMaxLog2MaxPicOrderCntLsbMinus4{12};
+// A.4.1: Sqrt(MaxLumaPs * 8) of the highest level, the widest or tallest
+// picture any level allows.
+const uint32_t kMaxPicDimension{16888};
+
+// slice_type, H.265 Table 7-7.
+enum SliceType : uint32_t { kB = 0, kP = 1, kI = 2 };
+
+// The tables are shared by all parse workers, so they are only read: a miss
+// with operator[] would insert into them from several threads.
+template <typename Key>
+const std::string& nameOf(const std::map<Key, std::string>& names,
+                          uint32_t value) {
+  static const std::string kUnknown{"unknown"};
+  if (value != Key(value)) {
+    return kUnknown;
+  }
+  auto it = names.find(Key(value));
+  return it != names.end() ? it->second : kUnknown;
+}
+
+const std::map<uint8_t, std::string> nalType2String = {
+    {chai::kH265TrailN, "trail n"},
+    {chai::kH265TrailR, "trail r"},
+    {2, "tsa n"},
+    {3, "tsa r"},
+    {4, "stsa n"},
+    {5, "stsa r"},
+    {6, "radl n"},
+    {7, "radl r"},
+    {8, "rasl n"},
+    {9, "rasl r"},
+    {chai::kH265BlaWLp, "bla w lp"},
+    {chai::kH265BlaWRadl, "bla w radl"},
+    {chai::kH265BlaNLp, "bla n lp"},
+    {chai::kH265IdrWRadl, "idr w radl"},
+    {chai::kH265IdrNLp, "idr n lp"},
+    {chai::kH265Cra, "cra"},
+    {chai::kH265Vps, "vps"},
+    {chai::kH265Sps, "sps"},
+    {chai::kH265Pps, "pps"},
+    {chai::kH265Aud, "aud"},
+    {chai::kH265Eos, "end of sequence"},
+    {chai::kH265Eob, "end of bitstream"},
+    {chai::kH265Fd, "filler"},
+    {chai::kH265PrefixSei, "prefix sei"},
+    {chai::kH265SuffixSei, "suffix sei"},
+};
+
+const std::map<uint8_t, std::string> profileIdc2String = {
+    {1, "Main"},
+    {2, "Main 10"},
+    {3, "Main Still Picture"},
+    {4, "Range Extensions"},
+    {5, "High Throughput"},
+    {9, "Screen Content Coding"},
+};
+
+const std::map<uint32_t, std::string> sliceType2String = {
+    {kB, "B slice"},
+    {kP, "P slice"},
+    {kI, "I slice"},
+};
+
+const std::map<uint32_t, std::string> chromaFormatIdc2String = {
+    {0, "4:0:0"},
+    {1, "4:2:0"},
+    {2, "4:2:2"},
+    {3, "4:4:4"},
+};
+
+// FNV-1a, to tell a repeated parameter set from a changed one.
+uint64_t hashNalu(const uint8_t* buff, size_t length) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < length; ++i) {
+    hash = (hash ^ buff[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// Ceil(Log2(x)), the width of the u(v) fields that index a list of x.
+int ceilLog2(uint32_t x) {
+  int bits = 0;
+  while (bits < 32 && (uint64_t(1) << bits) < x) {
+    ++bits;
+  }
+  return bits;
+}
+
+// The sub-layer part of profile_tier_level(), H.265 7.3.3.
+void skipSubLayers(chai::BitReader& reader, uint32_t max_sub_layers_minus1) {
+  uint32_t sub_layer_profile_present_flags{0};
+  uint32_t sub_layer_level_present_flags{0};
+  for (uint32_t i = 0; i < max_sub_layers_minus1; ++i) {
+    sub_layer_profile_present_flags |= reader.readBits(1) << i;  // u(1)
+    sub_layer_level_present_flags |= reader.readBits(1) << i;    // u(1)
+  }
+  if (max_sub_layers_minus1 > 0) {
+    // reserved_zero_2bits
+    reader.skipBits(2 * (8 - max_sub_layers_minus1));
+  }
+  for (uint32_t i = 0; i < max_sub_layers_minus1; ++i) {
+    if (sub_layer_profile_present_flags & (1 << i)) {
+      // sub_layer_profile_space to sub_layer_inbld_flag.
+      reader.skipBits(88);
+    }
+    if (sub_layer_level_present_flags & (1 << i)) {
+      reader.skipBits(8);  // sub_layer_level_idc
+    }
+  }
+}
+}  // namespace
+
+namespace chai {
+const int PayloadH265::kMaxVps;
+const int PayloadH265::kMaxSps;
+const int PayloadH265::kMaxPps;
+const int PayloadH265::kMaxStRps;
+const int PayloadH265::kMaxLtRefPics;
+const int PayloadH265::kMaxDpbSize;
+
+// |buff| is one access unit in Annex B byte stream format, as
+// VideoRtpDepacketizerH265 assembles it.
+nlohmann::json PayloadH265::parse(const uint8_t* buff, size_t length) {
+  std::ostringstream oss;
+  nlohmann::json nalus = {
+      {"access_unit_length", length},
+      {"video_codec", "h265"},
+      {"frame_key", 0},
+      {"nalus", nlohmann::json::array()},
+  };
+  color1_ = color2_ = VIDEO_L0T0_COLOR;
+  frame_type_ = 0;
+
+  for (const auto& index : webrtc::H264::FindNaluIndices(buff, length)) {
+    const uint8_t* ptr = buff + index.payload_start_offset;
+    size_t len = index.payload_size;
+    if (len < kNalHeaderSize) {
+      continue;
+    }
+    /*
+      7.3.1.2:
+      +---------------+---------------+
+      |0|1|2|3|4|5|6|7|0|1|2|3|4|5|6|7|
+      +-------------+-----------------+
+      |F|   Type    |  LayerId  | TID |
+      +-------------+-----------------+
+    */
+    uint8_t forbidden_zero_bit = ptr[0] >> 7;
+    uint8_t nal_type = (ptr[0] >> 1) & 0x3f;
+    uint8_t nuh_layer_id = ((ptr[0] & 0x01) << 5) | (ptr[1] >> 3);
+    uint8_t nuh_temporal_id_plus1 = ptr[1] & 0x07;
+    oss.str("");
+    oss << uint16_t(nal_type) << "(" << nameOf(nalType2String, nal_type)
+        << ")";
+    nlohmann::json nalu = {
+        {"forbidden_zero_bit", forbidden_zero_bit},
+        {"nalu_type", oss.str()},
+        {"nuh_layer_id", nuh_layer_id},
+        {"nuh_temporal_id_plus1", nuh_temporal_id_plus1},
+        {"nalu_length", len},
+    };
+
+    const uint8_t* rbsp = ptr + kNalHeaderSize;
+    size_t rbspLength = len - kNalHeaderSize;
+    if (nal_type < kH265Vps) {
+      if (h265IsIrap(nal_type)) {
+        nalus["frame_key"] = 1;
+        frame_type_ = 1;
+        color1_ = color2_ = VIDEO_KEY_COLOR;
+      } else if (frame_type_ == 0) {
+        uint8_t temporal_id =
+            nuh_temporal_id_plus1 ? nuh_temporal_id_plus1 - 1 : 0;
+        color1_ = color2_ = temporal_id == 0   ? VIDEO_L0T0_COLOR
+                            : temporal_id == 1 ? VIDEO_L0T1_COLOR
+                                               : VIDEO_L0T2_COLOR;
+      }
+      nalu["slice_segment_header"] =
+          this->parseSliceHeader(nal_type, rbsp, rbspLength);
+    } else {
+      switch (nal_type) {
+        case kH265Vps:
+          nalu["vps"] = this->parseVps(rbsp, rbspLength);
+          break;
+        case kH265Sps:
+          nalu["sps"] = this->parseSps(rbsp, rbspLength);
+          break;
+        case kH265Pps:
+          nalu["pps"] = this->parsePps(rbsp, rbspLength);
+          break;
+        default:
+          break;
+      }
+    }
+    nalus["nalus"].push_back(nalu);
+  }
+  return nalus;
+}
+
+// https://www.itu.int/rec/T-REC-H.265 7.3.3
+nlohmann::json PayloadH265::parseProfileTierLevel(
+    BitReader& reader,
+    uint32_t max_sub_layers_minus1) {
+  std::ostringstream oss;
+  nlohmann::json ptl;
+
+  uint32_t general_profile_space = reader.readBits(2);  // u(2)
+  ptl["general_profile_space"] = general_profile_space;
+  uint32_t general_tier_flag = reader.readBits(1);  // u(1)
+  ptl["general_tier_flag"] = general_tier_flag ? "High" : "Main";
+  uint8_t general_profile_idc = reader.readBits(5);  // u(5)
+  oss << uint16_t(general_profile_idc) << "("
+      << nameOf(profileIdc2String, general_profile_idc) << ")";
+  ptl["general_profile_idc"] = oss.str();
+  uint32_t general_profile_compatibility_flags = reader.readBits(32);  // u(32)
+  ptl["general_profile_compatibility_flags"] =
+      general_profile_compatibility_flags;
+  ptl["general_progressive_source_flag"] = reader.readBits(1);    // u(1)
+  ptl["general_interlaced_source_flag"] = reader.readBits(1);     // u(1)
+  ptl["general_non_packed_constraint_flag"] = reader.readBits(1);  // u(1)
+  ptl["general_frame_only_constraint_flag"] = reader.readBits(1);  // u(1)
+  // 43 bits of constraint flags and general_inbld_flag.
+  reader.skipBits(44);
+  uint32_t general_level_idc = reader.readBits(8);  // u(8)
+  oss.str("");
+  oss << general_level_idc << "(" << general_level_idc / 30 << "."
+      << general_level_idc % 30 / 3 << ")";
+  ptl["general_level_idc"] = oss.str();
+
+  skipSubLayers(reader, max_sub_layers_minus1);
+  return ptl;
+}
+
+// https://www.itu.int/rec/T-REC-H.265 7.3.4
+void PayloadH265::skipScalingListData(BitReader& reader) {
+  for (int sizeId = 0; sizeId < 4 && reader.ok(); ++sizeId) {
+    for (int matrixId = 0; matrixId < 6; matrixId += (sizeId == 3) ? 3 : 1) {
+      uint32_t scaling_list_pred_mode_flag = reader.readBits(1);  // u(1)
+      if (!scaling_list_pred_mode_flag) {
+        reader.readUe();  // scaling_list_pred_matrix_id_delta
+        continue;
+      }
+      int coefNum = std::min(64, 1 << (4 + (sizeId << 1)));
+      if (sizeId > 1) {
+        reader.readSe();  // scaling_list_dc_coef_minus8
+      }
+      for (int i = 0; i < coefNum && reader.ok(); ++i) {
+        reader.readSe();  // scaling_list_delta_coef
+      }
+    }
+  }
+}
+
+// https://www.itu.int/rec/T-REC-H.265 7.3.7 and 7.4.8
+nlohmann::json PayloadH265::parseStRefPicSet(
+    BitReader& reader,
+    uint32_t idx,
+    uint32_t num_short_term_ref_pic_sets,
+    StRps* sets) {
+  nlohmann::json rps;
+  StRps& set = sets[idx];
+  set = StRps();
+
+  uint32_t inter_ref_pic_set_prediction_flag{0};
+  if (idx != 0) {
+    inter_ref_pic_set_prediction_flag = reader.readBits(1);  // u(1)
+    rps["inter_ref_pic_set_prediction_flag"] =
+        inter_ref_pic_set_prediction_flag;
+  }
+  if (inter_ref_pic_set_prediction_flag) {
+    uint32_t delta_idx_minus1{0};
+    if (idx == num_short_term_ref_pic_sets) {
+      delta_idx_minus1 = reader.readUe();  // ue(v)
+      rps["delta_idx_minus1"] = delta_idx_minus1;
+    }
+    if (delta_idx_minus1 >= idx) {
+      rps["error"] = "delta_idx_minus1 out of range";
+      return rps;
+    }
+    const StRps& ref = sets[idx - (delta_idx_minus1 + 1)];
+    uint32_t delta_rps_sign = reader.readBits(1);  // u(1)
+    uint32_t abs_delta_rps_minus1 = reader.readUe();  // ue(v)
+    rps["delta_rps"] = (delta_rps_sign ? -1 : 1) *
+                       (int64_t(abs_delta_rps_minus1) + 1);
+    // One entry per picture of the reference set, and one for the reference
+    // picture itself; each entry kept makes a picture of this set.
+    for (uint32_t j = 0; j <= ref.num_delta_pocs && reader.ok(); ++j) {
+      uint32_t used_by_curr_pic_flag = reader.readBits(1);  // u(1)
+      uint32_t use_delta_flag{1};
+      if (!used_by_curr_pic_flag) {
+        use_delta_flag = reader.readBits(1);  // u(1)
+      }
+      set.num_delta_pocs += use_delta_flag;
+      set.num_used += used_by_curr_pic_flag;
+    }
+  } else {
+    uint32_t num_negative_pics = reader.readUe();  // ue(v)
+    rps["num_negative_pics"] = num_negative_pics;
+    uint32_t num_positive_pics = reader.readUe();  // ue(v)
+    rps["num_positive_pics"] = num_positive_pics;
+    if (num_negative_pics > kMaxDpbSize || num_positive_pics > kMaxDpbSize) {
+      rps["error"] = "too many pictures";
+      return rps;
+    }
+    for (uint32_t i = 0; i < num_negative_pics + num_positive_pics; ++i) {
+      reader.readUe();  // delta_poc_s0_minus1, delta_poc_s1_minus1
+      set.num_used += reader.readBits(1);  // used_by_curr_pic_s0/s1_flag
+    }
+    set.num_delta_pocs = num_negative_pics + num_positive_pics;
+  }
+  if (set.num_delta_pocs > kMaxDpbSize) {
+    rps["error"] = "too many pictures";
+    set = StRps();
+    return rps;
+  }
+  rps["num_delta_pocs"] = set.num_delta_pocs;
+  rps["num_used"] = set.num_used;
+  return rps;
+}
+
+// https://www.itu.int/rec/T-REC-H.265 7.3.2.1
+nlohmann::json PayloadH265::parseVps(const uint8_t* buff, size_t length) {
+  uint64_t hash = hashNalu(buff, length);
+  uint32_t id = length ? buff[0] >> 4 : kMaxVps;
+  if (id < kMaxVps) {
+    const ParameterSet<VpsState>& set = this->vps_[id];
+    if (set.valid && set.hash == hash && set.length == length) {
+      nlohmann::json vps = set.json;
+      vps["unchanged"] = true;
+      return vps;
+    }
+  }
+
+  BitReader reader(buff, length, true);
+  nlohmann::json vps;
+
+  uint32_t vps_video_parameter_set_id = reader.readBits(4);  // u(4)
+  vps["vps_video_parameter_set_id"] = vps_video_parameter_set_id;
+  vps["vps_base_layer_internal_flag"] = reader.readBits(1);   // u(1)
+  vps["vps_base_layer_available_flag"] = reader.readBits(1);  // u(1)
+  vps["vps_max_layers_minus1"] = reader.readBits(6);          // u(6)
+  uint32_t vps_max_sub_layers_minus1 = reader.readBits(3);    // u(3)
+  vps["vps_max_sub_layers_minus1"] = vps_max_sub_layers_minus1;
+  vps["vps_temporal_id_nesting_flag"] = reader.readBits(1);  // u(1)
+  reader.skipBits(16);  // vps_reserved_0xffff_16bits
+  vps["profile_tier_level"] =
+      parseProfileTierLevel(reader, vps_max_sub_layers_minus1);
+  uint32_t vps_sub_layer_ordering_info_present_flag =
+      reader.readBits(1);  // u(1)
+  vps["vps_sub_layer_ordering_info_present_flag"] =
+      vps_sub_layer_ordering_info_present_flag;
+  vps["sub_layer_ordering_info"] = nlohmann::json::array();
+  for (uint32_t i = vps_sub_layer_ordering_info_present_flag
+                        ? 0
+                        : vps_max_sub_layers_minus1;
+       i <= vps_max_sub_layers_minus1; ++i) {
+    nlohmann::json info;
+    info["vps_max_dec_pic_buffering_minus1"] = reader.readUe();  // ue(v)
+    info["vps_max_num_reorder_pics"] = reader.readUe();          // ue(v)
+    info["vps_max_latency_increase_plus1"] = reader.readUe();    // ue(v)
+    vps["sub_layer_ordering_info"].push_back(info);
+  }
+  uint32_t vps_max_layer_id = reader.readBits(6);  // u(6)
+  vps["vps_max_layer_id"] = vps_max_layer_id;
+  uint32_t vps_num_layer_sets_minus1 = reader.readUe();  // ue(v)
+  vps["vps_num_layer_sets_minus1"] = vps_num_layer_sets_minus1;
+  if (vps_num_layer_sets_minus1 > 1023) {
+    vps["error"] = "vps_num_layer_sets_minus1 out of range";
+    return vps;
+  }
+  // layer_id_included_flag
+  reader.skipBits(size_t(vps_num_layer_sets_minus1) * (vps_max_layer_id + 1));
+  uint32_t vps_timing_info_present_flag = reader.readBits(1);  // u(1)
+  vps["vps_timing_info_present_flag"] = vps_timing_info_present_flag;
+  if (vps_timing_info_present_flag) {
+    vps["vps_num_units_in_tick"] = reader.readBits(32);  // u(32)
+    vps["vps_time_scale"] = reader.readBits(32);         // u(32)
+    uint32_t vps_poc_proportional_to_timing_flag = reader.readBits(1);
+    vps["vps_poc_proportional_to_timing_flag"] =
+        vps_poc_proportional_to_timing_flag;
+    if (vps_poc_proportional_to_timing_flag) {
+      vps["vps_num_ticks_poc_diff_one_minus1"] = reader.readUe();  // ue(v)
+    }
+    // hrd_parameters() follow, nothing of interest after them.
+    vps["vps_num_hrd_parameters"] = reader.readUe();  // ue(v)
+  }
+
+  if (!reader.ok()) {
+    // Keep the state of the last complete parameter set.
+    vps["truncated"] = true;
+    return vps;
+  }
+
+  ParameterSet<VpsState>& set = this->vps_[vps_video_parameter_set_id];
+  set.valid = true;
+  set.hash = hash;
+  set.length = length;
+  set.state.vps_max_sub_layers_minus1 = vps_max_sub_layers_minus1;
+  set.json = vps;
+  return vps;
+}
+
+// https://www.itu.int/rec/T-REC-H.265 7.3.2.2.1
+nlohmann::json PayloadH265::parseSps(const uint8_t* buff, size_t length) {
+  uint64_t hash = hashNalu(buff, length);
+  // sps_seq_parameter_set_id follows profile_tier_level(), whose size depends
+  // on the sub-layer flags.
+  BitReader peek(buff, length, true);
+  peek.skipBits(4);
+  uint32_t max_sub_layers_minus1 = peek.readBits(3);
+  // sps_temporal_id_nesting_flag and the 96 general profile/level bits.
+  peek.skipBits(1 + 96);
+  skipSubLayers(peek, max_sub_layers_minus1);
+  uint32_t id = peek.readUe();
+  if (peek.ok() && id < kMaxSps) {
+    const ParameterSet<SpsState>& set = this->sps_[id];
+    if (set.valid && set.hash == hash && set.length == length) {
+      nlohmann::json sps = set.json;
+      sps["unchanged"] = true;
+      return sps;
+    }
+  }
+
+  BitReader reader(buff, length, true);
+  // Filled as the SPS is read, stored only if all of it was there.
+  SpsState state;
+
+  uint32_t sps_video_parameter_set_id{0};
+  uint32_t sps_max_sub_layers_minus1{0};
+  uint32_t sps_temporal_id_nesting_flag{0};
+  uint32_t sps_seq_parameter_set_id{0};
+  uint32_t chroma_format_idc{0};
+  uint32_t pic_width_in_luma_samples{0};
+  uint32_t pic_height_in_luma_samples{0};
+  uint32_t conformance_window_flag{0};
+  uint32_t conf_win_left_offset{0};
+  uint32_t conf_win_right_offset{0};
+  uint32_t conf_win_top_offset{0};
+  uint32_t conf_win_bottom_offset{0};
+  uint32_t bit_depth_luma_minus8{0};
+  uint32_t bit_depth_chroma_minus8{0};
+  uint32_t log2_max_pic_order_cnt_lsb_minus4{0};
+  uint32_t sps_sub_layer_ordering_info_present_flag{0};
+  uint32_t log2_min_luma_coding_block_size_minus3{0};
+  uint32_t log2_diff_max_min_luma_coding_block_size{0};
+  uint32_t scaling_list_enabled_flag{0};
+  uint32_t sps_scaling_list_data_present_flag{0};
+  uint32_t pcm_enabled_flag{0};
+  uint32_t vui_parameters_present_flag{0};
+
+  std::ostringstream oss;
+  nlohmann::json sps;
+
+  sps_video_parameter_set_id = reader.readBits(4);  // u(4)
+  sps["sps_video_parameter_set_id"] = sps_video_parameter_set_id;
+  sps_max_sub_layers_minus1 = reader.readBits(3);  // u(3)
+  sps["sps_max_sub_layers_minus1"] = sps_max_sub_layers_minus1;
+  sps_temporal_id_nesting_flag = reader.readBits(1);  // u(1)
+  sps["sps_temporal_id_nesting_flag"] = sps_temporal_id_nesting_flag;
+  sps["profile_tier_level"] =
+      parseProfileTierLevel(reader, sps_max_sub_layers_minus1);
+  sps_seq_parameter_set_id = reader.readUe();  // ue(v)
+  sps["sps_seq_parameter_set_id"] = sps_seq_parameter_set_id;
+  chroma_format_idc = reader.readUe();  // ue(v)
+  oss << chroma_format_idc << "("
+      << nameOf(chromaFormatIdc2String, chroma_format_idc) << ")";
+  sps["chroma_format_idc"] = oss.str();
+  if (chroma_format_idc == 3) {
+    state.separate_colour_plane_flag = reader.readBits(1);  // u(1)
+    sps["separate_colour_plane_flag"] = state.separate_colour_plane_flag;
+  }
+  state.chroma_array_type =
+      state.separate_colour_plane_flag ? 0 : chroma_format_idc;
+  pic_width_in_luma_samples = reader.readUe();  // ue(v)
+  sps["pic_width_in_luma_samples"] = pic_width_in_luma_samples;
+  pic_height_in_luma_samples = reader.readUe();  // ue(v)
+  sps["pic_height_in_luma_samples"] = pic_height_in_luma_samples;
+  // The size in CTBs sizes slice_segment_address in the slice headers.
+  if (reader.ok() && (pic_width_in_luma_samples == 0 ||
+      pic_width_in_luma_samples > kMaxPicDimension ||
+      pic_height_in_luma_samples == 0 ||
+      pic_height_in_luma_samples > kMaxPicDimension)) {
+    sps["error"] = "picture size out of range";
+    return sps;
+  }
+  conformance_window_flag = reader.readBits(1);  // u(1)
+  sps["conformance_window_flag"] = conformance_window_flag;
+  if (conformance_window_flag) {
+    conf_win_left_offset = reader.readUe();  // ue(v)
+    sps["conf_win_left_offset"] = conf_win_left_offset;
+    conf_win_right_offset = reader.readUe();  // ue(v)
+    sps["conf_win_right_offset"] = conf_win_right_offset;
+    conf_win_top_offset = reader.readUe();  // ue(v)
+    sps["conf_win_top_offset"] = conf_win_top_offset;
+    conf_win_bottom_offset = reader.readUe();  // ue(v)
+    sps["conf_win_bottom_offset"] = conf_win_bottom_offset;
+  }
+  // Table 6-1: SubWidthC and SubHeightC.
+  uint32_t sub_width_c = (chroma_format_idc == 1 || chroma_format_idc == 2) &&
+                                 !state.separate_colour_plane_flag
+                             ? 2
+                             : 1;
+  uint32_t sub_height_c =
+      chroma_format_idc == 1 && !state.separate_colour_plane_flag ? 2 : 1;
+  oss.str("");
+  oss << int64_t(pic_width_in_luma_samples) -
+             int64_t(sub_width_c) *
+                 (conf_win_left_offset + conf_win_right_offset)
+      << "x"
+      << int64_t(pic_height_in_luma_samples) -
+             int64_t(sub_height_c) *
+                 (conf_win_top_offset + conf_win_bottom_offset);
+  sps["resolution"] = oss.str();
+  bit_depth_luma_minus8 = reader.readUe();  // ue(v)
+  oss.str("");
+  oss << bit_depth_luma_minus8 << "(" << 8 + bit_depth_luma_minus8 << ")";
+  sps["bit_depth_luma_minus8"] = oss.str();
+  bit_depth_chroma_minus8 = reader.readUe();  // ue(v)
+  oss.str("");
+  oss << bit_depth_chroma_minus8 << "(" << 8 + bit_depth_chroma_minus8 << ")";
+  sps["bit_depth_chroma_minus8"] = oss.str();
+  log2_max_pic_order_cnt_lsb_minus4 = reader.readUe();  // ue(v)
+  sps["log2_max_pic_order_cnt_lsb_minus4"] = log2_max_pic_order_cnt_lsb_minus4;
+  // It sizes slice_pic_order_cnt_lsb and the long-term POC LSBs.
+  if (log2_max_pic_order_cnt_lsb_minus4 > kMaxLog2MaxPicOrderCntLsbMinus4) {
+    sps["error"] = "log2_max_pic_order_cnt_lsb_minus4 out of range";
+    return sps;
+  }
+  state.log2_max_pic_order_cnt_lsb = log2_max_pic_order_cnt_lsb_minus4 + 4;
+  sps_sub_layer_ordering_info_present_flag = reader.readBits(1);  // u(1)
+  sps["sps_sub_layer_ordering_info_present_flag"] =
+      sps_sub_layer_ordering_info_present_flag;
+  sps["sub_layer_ordering_info"] = nlohmann::json::array();
+  for (uint32_t i = sps_sub_layer_ordering_info_present_flag
+                        ? 0
+                        : sps_max_sub_layers_minus1;
+       i <= sps_max_sub_layers_minus1; ++i) {
+    nlohmann::json info;
+    info["sps_max_dec_pic_buffering_minus1"] = reader.readUe();  // ue(v)
+    info["sps_max_num_reorder_pics"] = reader.readUe();          // ue(v)
+    info["sps_max_latency_increase_plus1"] = reader.readUe();    // ue(v)
+    sps["sub_layer_ordering_info"].push_back(info);
+  }
+  log2_min_luma_coding_block_size_minus3 = reader.readUe();  // ue(v)
+  sps["log2_min_luma_coding_block_size_minus3"] =
+      log2_min_luma_coding_block_size_minus3;
+  log2_diff_max_min_luma_coding_block_size = reader.readUe();  // ue(v)
+  sps["log2_diff_max_min_luma_coding_block_size"] =
+      log2_diff_max_min_luma_coding_block_size;
+  uint32_t ctb_log2_size_y = log2_min_luma_coding_block_size_minus3 + 3 +
+                             log2_diff_max_min_luma_coding_block_size;
+  if (ctb_log2_size_y > 6) {
+    sps["error"] = "CtbLog2SizeY out of range";
+    return sps;
+  }
+  uint32_t ctb_size_y = 1 << ctb_log2_size_y;
+  sps["ctb_size_y"] = ctb_size_y;
+  state.pic_size_in_ctbs_y =
+      ((pic_width_in_luma_samples + ctb_size_y - 1) >> ctb_log2_size_y) *
+      ((pic_height_in_luma_samples + ctb_size_y - 1) >> ctb_log2_size_y);
+  sps["log2_min_luma_transform_block_size_minus2"] = reader.readUe();
+  sps["log2_diff_max_min_luma_transform_block_size"] = reader.readUe();
+  sps["max_transform_hierarchy_depth_inter"] = reader.readUe();  // ue(v)
+  sps["max_transform_hierarchy_depth_intra"] = reader.readUe();  // ue(v)
+  scaling_list_enabled_flag = reader.readBits(1);  // u(1)
+  sps["scaling_list_enabled_flag"] = scaling_list_enabled_flag;
+  if (scaling_list_enabled_flag) {
+    sps_scaling_list_data_present_flag = reader.readBits(1);  // u(1)
+    sps["sps_scaling_list_data_present_flag"] =
+        sps_scaling_list_data_present_flag;
+    if (sps_scaling_list_data_present_flag) {
+      skipScalingListData(reader);
+    }
+  }
+  sps["amp_enabled_flag"] = reader.readBits(1);  // u(1)
+  state.sample_adaptive_offset_enabled_flag = reader.readBits(1);  // u(1)
+  sps["sample_adaptive_offset_enabled_flag"] =
+      state.sample_adaptive_offset_enabled_flag;
+  pcm_enabled_flag = reader.readBits(1);  // u(1)
+  sps["pcm_enabled_flag"] = pcm_enabled_flag;
+  if (pcm_enabled_flag) {
+    sps["pcm_sample_bit_depth_luma_minus1"] = reader.readBits(4);    // u(4)
+    sps["pcm_sample_bit_depth_chroma_minus1"] = reader.readBits(4);  // u(4)
+    sps["log2_min_pcm_luma_coding_block_size_minus3"] = reader.readUe();
+    sps["log2_diff_max_min_pcm_luma_coding_block_size"] = reader.readUe();
+    sps["pcm_loop_filter_disabled_flag"] = reader.readBits(1);  // u(1)
+  }
+  state.num_short_term_ref_pic_sets = reader.readUe();  // ue(v)
+  sps["num_short_term_ref_pic_sets"] = state.num_short_term_ref_pic_sets;
+  if (state.num_short_term_ref_pic_sets >= kMaxStRps) {
+    sps["error"] = "num_short_term_ref_pic_sets out of range";
+    return sps;
+  }
+  sps["st_ref_pic_set"] = nlohmann::json::array();
+  for (uint32_t i = 0; i < state.num_short_term_ref_pic_sets && reader.ok();
+       ++i) {
+    nlohmann::json rps = parseStRefPicSet(
+        reader, i, state.num_short_term_ref_pic_sets, state.st_rps);
+    if (rps.contains("error")) {
+      sps["error"] = rps["error"];
+      return sps;
+    }
+    sps["st_ref_pic_set"].push_back(rps);
+  }
+  state.long_term_ref_pics_present_flag = reader.readBits(1);  // u(1)
+  sps["long_term_ref_pics_present_flag"] =
+      state.long_term_ref_pics_present_flag;
+  if (state.long_term_ref_pics_present_flag) {
+    state.num_long_term_ref_pics_sps = reader.readUe();  // ue(v)
+    sps["num_long_term_ref_pics_sps"] = state.num_long_term_ref_pics_sps;
+    if (state.num_long_term_ref_pics_sps > kMaxLtRefPics) {
+      sps["error"] = "num_long_term_ref_pics_sps out of range";
+      return sps;
+    }
+    for (uint32_t i = 0; i < state.num_long_term_ref_pics_sps; ++i) {
+      // lt_ref_pic_poc_lsb_sps
+      reader.skipBits(state.log2_max_pic_order_cnt_lsb);
+      state.used_by_curr_pic_lt_sps_flags |= reader.readBits(1) << i;
+    }
+  }
+  state.sps_temporal_mvp_enabled_flag = reader.readBits(1);  // u(1)
+  sps["sps_temporal_mvp_enabled_flag"] = state.sps_temporal_mvp_enabled_flag;
+  sps["strong_intra_smoothing_enabled_flag"] = reader.readBits(1);  // u(1)
+  vui_parameters_present_flag = reader.readBits(1);  // u(1)
+  sps["vui_parameters_present_flag"] = vui_parameters_present_flag;
+  // Parsing stops here: nothing in vui_parameters() or the SPS extensions
+  // feeds the slice segment header.
+
+  if (!reader.ok()) {
+    // Keep the state of the last complete parameter set.
+    sps["truncated"] = true;
+    return sps;
+  }
+
+  if (sps_seq_parameter_set_id >= kMaxSps) {
+    sps["error"] = "sps_seq_parameter_set_id out of range";
+    return sps;
+  }
+
+  ParameterSet<SpsState>& set = this->sps_[sps_seq_parameter_set_id];
+  set.valid = true;
+  set.hash = hash;
+  set.length = length;
+  set.state = state;
+  set.json = sps;
+  return sps;
+}
+
+// https://www.itu.int/rec/T-REC-H.265 7.3.2.3.1
+nlohmann::json PayloadH265::parsePps(const uint8_t* buff, size_t length) {
+  uint64_t hash = hashNalu(buff, length);
+  BitReader peek(buff, length, true);
+  uint32_t id = peek.readUe();
+  if (peek.ok() && id < kMaxPps) {
+    const ParameterSet<PpsState>& set = this->pps_[id];
+    if (set.valid && set.hash == hash && set.length == length) {
+      nlohmann::json pps = set.json;
+      pps["unchanged"] = true;
+      return pps;
+    }
+  }
+
+  BitReader reader(buff, length, true);
+  PpsState state;
+
+  uint32_t pps_pic_parameter_set_id{0};
+  uint32_t cu_qp_delta_enabled_flag{0};
+  uint32_t transform_skip_enabled_flag{0};
+  uint32_t num_tile_columns_minus1{0};
+  uint32_t num_tile_rows_minus1{0};
+  uint32_t uniform_spacing_flag{0};
+  uint32_t deblocking_filter_control_present_flag{0};
+  uint32_t pps_scaling_list_data_present_flag{0};
+  uint32_t pps_extension_present_flag{0};
+  uint32_t pps_range_extension_flag{0};
+
+  nlohmann::json pps;
+
+  pps_pic_parameter_set_id = reader.readUe();  // ue(v)
+  pps["pps_pic_parameter_set_id"] = pps_pic_parameter_set_id;
+  state.pps_seq_parameter_set_id = reader.readUe();  // ue(v)
+  pps["pps_seq_parameter_set_id"] = state.pps_seq_parameter_set_id;
+  state.dependent_slice_segments_enabled_flag = reader.readBits(1);  // u(1)
+  pps["dependent_slice_segments_enabled_flag"] =
+      state.dependent_slice_segments_enabled_flag;
+  state.output_flag_present_flag = reader.readBits(1);  // u(1)
+  pps["output_flag_present_flag"] = state.output_flag_present_flag;
+  state.num_extra_slice_header_bits = reader.readBits(3);  // u(3)
+  pps["num_extra_slice_header_bits"] = state.num_extra_slice_header_bits;
+  pps["sign_data_hiding_enabled_flag"] = reader.readBits(1);  // u(1)
+  state.cabac_init_present_flag = reader.readBits(1);  // u(1)
+  pps["cabac_init_present_flag"] = state.cabac_init_present_flag;
+  state.num_ref_idx_l0_default_active_minus1 = reader.readUe();  // ue(v)
+  pps["num_ref_idx_l0_default_active_minus1"] =
+      state.num_ref_idx_l0_default_active_minus1;
+  state.num_ref_idx_l1_default_active_minus1 = reader.readUe();  // ue(v)
+  pps["num_ref_idx_l1_default_active_minus1"] =
+      state.num_ref_idx_l1_default_active_minus1;
+  pps["init_qp_minus26"] = reader.readSe();  // se(v)
+  pps["constrained_intra_pred_flag"] = reader.readBits(1);  // u(1)
+  transform_skip_enabled_flag = reader.readBits(1);  // u(1)
+  pps["transform_skip_enabled_flag"] = transform_skip_enabled_flag;
+  cu_qp_delta_enabled_flag = reader.readBits(1);  // u(1)
+  pps["cu_qp_delta_enabled_flag"] = cu_qp_delta_enabled_flag;
+  if (cu_qp_delta_enabled_flag) {
+    pps["diff_cu_qp_delta_depth"] = reader.readUe();  // ue(v)
+  }
+  pps["pps_cb_qp_offset"] = reader.readSe();  // se(v)
+  pps["pps_cr_qp_offset"] = reader.readSe();  // se(v)
+  state.pps_slice_chroma_qp_offsets_present_flag = reader.readBits(1);
+  pps["pps_slice_chroma_qp_offsets_present_flag"] =
+      state.pps_slice_chroma_qp_offsets_present_flag;
+  state.weighted_pred_flag = reader.readBits(1);  // u(1)
+  pps["weighted_pred_flag"] = state.weighted_pred_flag;
+  state.weighted_bipred_flag = reader.readBits(1);  // u(1)
+  pps["weighted_bipred_flag"] = state.weighted_bipred_flag;
+  pps["transquant_bypass_enabled_flag"] = reader.readBits(1);  // u(1)
+  state.tiles_enabled_flag = reader.readBits(1);  // u(1)
+  pps["tiles_enabled_flag"] = state.tiles_enabled_flag;
+  state.entropy_coding_sync_enabled_flag = reader.readBits(1);  // u(1)
+  pps["entropy_coding_sync_enabled_flag"] =
+      state.entropy_coding_sync_enabled_flag;
+  if (state.tiles_enabled_flag) {
+    num_tile_columns_minus1 = reader.readUe();  // ue(v)
+    pps["num_tile_columns_minus1"] = num_tile_columns_minus1;
+    num_tile_rows_minus1 = reader.readUe();  // ue(v)
+    pps["num_tile_rows_minus1"] = num_tile_rows_minus1;
+    uniform_spacing_flag = reader.readBits(1);  // u(1)
+    pps["uniform_spacing_flag"] = uniform_spacing_flag;
+    if (!uniform_spacing_flag) {
+      pps["column_width_minus1"] = nlohmann::json::array();
+      for (uint32_t i = 0; i < num_tile_columns_minus1 && reader.ok(); ++i) {
+        pps["column_width_minus1"].push_back(reader.readUe());  // ue(v)
+      }
+      pps["row_height_minus1"] = nlohmann::json::array();
+      for (uint32_t i = 0; i < num_tile_rows_minus1 && reader.ok(); ++i) {
+        pps["row_height_minus1"].push_back(reader.readUe());  // ue(v)
+      }
+    }
+    pps["loop_filter_across_tiles_enabled_flag"] = reader.readBits(1);
+  }
+  state.pps_loop_filter_across_slices_enabled_flag = reader.readBits(1);
+  pps["pps_loop_filter_across_slices_enabled_flag"] =
+      state.pps_loop_filter_across_slices_enabled_flag;
+  deblocking_filter_control_present_flag = reader.readBits(1);  // u(1)
+  pps["deblocking_filter_control_present_flag"] =
+      deblocking_filter_control_present_flag;
+  if (deblocking_filter_control_present_flag) {
+    state.deblocking_filter_override_enabled_flag = reader.readBits(1);
+    pps["deblocking_filter_override_enabled_flag"] =
+        state.deblocking_filter_override_enabled_flag;
+    state.pps_deblocking_filter_disabled_flag = reader.readBits(1);  // u(1)
+    pps["pps_deblocking_filter_disabled_flag"] =
+        state.pps_deblocking_filter_disabled_flag;
+    if (!state.pps_deblocking_filter_disabled_flag) {
+      pps["pps_beta_offset_div2"] = reader.readSe();  // se(v)
+      pps["pps_tc_offset_div2"] = reader.readSe();    // se(v)
+    }
+  }
+  pps_scaling_list_data_present_flag = reader.readBits(1);  // u(1)
+  pps["pps_scaling_list_data_present_flag"] =
+      pps_scaling_list_data_present_flag;
+  if (pps_scaling_list_data_present_flag) {
+    skipScalingListData(reader);
+  }
+  state.lists_modification_present_flag = reader.readBits(1);  // u(1)
+  pps["lists_modification_present_flag"] =
+      state.lists_modification_present_flag;
+  pps["log2_parallel_merge_level_minus2"] = reader.readUe();  // ue(v)
+  state.slice_segment_header_extension_present_flag = reader.readBits(1);
+  pps["slice_segment_header_extension_present_flag"] =
+      state.slice_segment_header_extension_present_flag;
+  pps_extension_present_flag = reader.readBits(1);  // u(1)
+  pps["pps_extension_present_flag"] = pps_extension_present_flag;
+  if (pps_extension_present_flag) {
+    pps_range_extension_flag = reader.readBits(1);  // u(1)
+    pps["pps_range_extension_flag"] = pps_range_extension_flag;
+    pps["pps_multilayer_extension_flag"] = reader.readBits(1);  // u(1)
+    pps["pps_3d_extension_flag"] = reader.readBits(1);          // u(1)
+    pps["pps_scc_extension_flag"] = reader.readBits(1);         // u(1)
+    reader.skipBits(4);  // pps_extension_4bits
+  }
+  if (pps_range_extension_flag) {
+    // 7.3.2.3.2, for the one flag the slice segment header depends on.
+    if (transform_skip_enabled_flag) {
+      reader.readUe();  // log2_max_transform_skip_block_size_minus2
+    }
+    reader.readBits(1);  // cross_component_prediction_enabled_flag
+    state.chroma_qp_offset_list_enabled_flag = reader.readBits(1);  // u(1)
+    pps["chroma_qp_offset_list_enabled_flag"] =
+        state.chroma_qp_offset_list_enabled_flag;
+  }
+
+  if (!reader.ok()) {
+    // Keep the state of the last complete parameter set.
+    pps["truncated"] = true;
+    return pps;
+  }
+
+  if (pps_pic_parameter_set_id >= kMaxPps ||
+      state.pps_seq_parameter_set_id >= kMaxSps) {
+    pps["error"] = "parameter set id out of range";
+    return pps;
+  }
+
+  ParameterSet<PpsState>& set = this->pps_[pps_pic_parameter_set_id];
+  set.valid = true;
+  set.hash = hash;
+  set.length = length;
+  set.state = state;
+  set.json = pps;
+  return pps;
+}
+
+// https://www.itu.int/rec/T-REC-H.265 7.3.6.1
+nlohmann::json PayloadH265::parseSliceHeader(uint8_t nal_type,
+                                             const uint8_t* buff,
+                                             size_t length) {
+  BitReader reader(buff, length, true);
+
+  uint32_t first_slice_segment_in_pic_flag{0};
+  uint32_t slice_pic_parameter_set_id{0};
+  uint32_t dependent_slice_segment_flag{0};
+  uint32_t slice_type{0};
+  uint32_t short_term_ref_pic_set_sps_flag{0};
+  uint32_t short_term_ref_pic_set_idx{0};
+  uint32_t num_long_term_sps{0};
+  uint32_t num_long_term_pics{0};
+  uint32_t slice_temporal_mvp_enabled_flag{0};
+  uint32_t slice_sao_luma_flag{0};
+  uint32_t slice_sao_chroma_flag{0};
+  uint32_t num_ref_idx_l0_active_minus1{0};
+  uint32_t num_ref_idx_l1_active_minus1{0};
+  uint32_t collocated_from_l0_flag{1};
+  uint32_t deblocking_filter_override_flag{0};
+  uint32_t slice_deblocking_filter_disabled_flag{0};
+  uint32_t num_entry_point_offsets{0};
+  // Pictures the current one may refer to, (7-55).
+  uint32_t num_pic_total_curr{0};
+
+  std::ostringstream oss;
+  nlohmann::json slice_header;
+
+  first_slice_segment_in_pic_flag = reader.readBits(1);  // u(1)
+  slice_header["first_slice_segment_in_pic_flag"] =
+      first_slice_segment_in_pic_flag;
+  if (h265IsIrap(nal_type)) {
+    slice_header["no_output_of_prior_pics_flag"] = reader.readBits(1);
+  }
+  slice_pic_parameter_set_id = reader.readUe();  // ue(v)
+  slice_header["slice_pic_parameter_set_id"] = slice_pic_parameter_set_id;
+  if (!reader.ok() || slice_pic_parameter_set_id >= kMaxPps ||
+      !this->pps_[slice_pic_parameter_set_id].valid) {
+    slice_header["error"] = "unknown pps";
+    return slice_header;
+  }
+  const PpsState& pps = this->pps_[slice_pic_parameter_set_id].state;
+  if (!this->sps_[pps.pps_seq_parameter_set_id].valid) {
+    slice_header["error"] = "unknown sps";
+    return slice_header;
+  }
+  const SpsState& sps = this->sps_[pps.pps_seq_parameter_set_id].state;
+
+  if (!first_slice_segment_in_pic_flag) {
+    if (pps.dependent_slice_segments_enabled_flag) {
+      dependent_slice_segment_flag = reader.readBits(1);  // u(1)
+      slice_header["dependent_slice_segment_flag"] =
+          dependent_slice_segment_flag;
+    }
+    slice_header["slice_segment_address"] =
+        reader.readBits(ceilLog2(sps.pic_size_in_ctbs_y));  // u(v)
+  }
+  if (!dependent_slice_segment_flag) {
+    // slice_reserved_flag
+    reader.skipBits(pps.num_extra_slice_header_bits);
+    slice_type = reader.readUe();  // ue(v)
+    oss << slice_type << "(" << nameOf(sliceType2String, slice_type) << ")";
+    slice_header["slice_type"] = oss.str();
+    if (pps.output_flag_present_flag) {
+      slice_header["pic_output_flag"] = reader.readBits(1);  // u(1)
+    }
+    if (sps.separate_colour_plane_flag) {
+      slice_header["colour_plane_id"] = reader.readBits(2);  // u(2)
+    }
+    if (nal_type != kH265IdrWRadl && nal_type != kH265IdrNLp) {
+      slice_header["slice_pic_order_cnt_lsb"] =
+          reader.readBits(sps.log2_max_pic_order_cnt_lsb);  // u(v)
+      short_term_ref_pic_set_sps_flag = reader.readBits(1);  // u(1)
+      slice_header["short_term_ref_pic_set_sps_flag"] =
+          short_term_ref_pic_set_sps_flag;
+      if (!short_term_ref_pic_set_sps_flag) {
+        // The slice's own set goes after the SPS ones, which it may predict
+        // from.
+        StRps sets[kMaxStRps];
+        std::copy(sps.st_rps, sps.st_rps + sps.num_short_term_ref_pic_sets,
+                  sets);
+        nlohmann::json rps =
+            parseStRefPicSet(reader, sps.num_short_term_ref_pic_sets,
+                             sps.num_short_term_ref_pic_sets, sets);
+        slice_header["st_ref_pic_set"] = rps;
+        if (rps.contains("error")) {
+          slice_header["error"] = rps["error"];
+          return slice_header;
+        }
+        num_pic_total_curr = sets[sps.num_short_term_ref_pic_sets].num_used;
+      } else {
+        if (sps.num_short_term_ref_pic_sets > 1) {
+          short_term_ref_pic_set_idx = reader.readBits(
+              ceilLog2(sps.num_short_term_ref_pic_sets));  // u(v)
+          slice_header["short_term_ref_pic_set_idx"] =
+              short_term_ref_pic_set_idx;
+        }
+        if (short_term_ref_pic_set_idx >= sps.num_short_term_ref_pic_sets) {
+          slice_header["error"] = "short_term_ref_pic_set_idx out of range";
+          return slice_header;
+        }
+        num_pic_total_curr = sps.st_rps[short_term_ref_pic_set_idx].num_used;
+      }
+      if (sps.long_term_ref_pics_present_flag) {
+        if (sps.num_long_term_ref_pics_sps > 0) {
+          num_long_term_sps = reader.readUe();  // ue(v)
+          slice_header["num_long_term_sps"] = num_long_term_sps;
+        }
+        num_long_term_pics = reader.readUe();  // ue(v)
+        slice_header["num_long_term_pics"] = num_long_term_pics;
+        if (num_long_term_sps > sps.num_long_term_ref_pics_sps ||
+            num_long_term_sps + num_long_term_pics > kMaxLtRefPics) {
+          slice_header["error"] = "too many long-term pictures";
+          return slice_header;
+        }
+        for (uint32_t i = 0; i < num_long_term_sps + num_long_term_pics; ++i) {
+          if (i < num_long_term_sps) {
+            uint32_t lt_idx_sps{0};
+            if (sps.num_long_term_ref_pics_sps > 1) {
+              lt_idx_sps = reader.readBits(
+                  ceilLog2(sps.num_long_term_ref_pics_sps));  // u(v)
+            }
+            num_pic_total_curr +=
+                (sps.used_by_curr_pic_lt_sps_flags >> lt_idx_sps) & 1;
+          } else {
+            reader.skipBits(sps.log2_max_pic_order_cnt_lsb);  // poc_lsb_lt
+            num_pic_total_curr += reader.readBits(1);  // used_by_curr_pic_lt
+          }
+          if (reader.readBits(1)) {  // delta_poc_msb_present_flag
+            reader.readUe();         // delta_poc_msb_cycle_lt
+          }
+        }
+      }
+      if (sps.sps_temporal_mvp_enabled_flag) {
+        slice_temporal_mvp_enabled_flag = reader.readBits(1);  // u(1)
+        slice_header["slice_temporal_mvp_enabled_flag"] =
+            slice_temporal_mvp_enabled_flag;
+      }
+    }
+    slice_header["num_pic_total_curr"] = num_pic_total_curr;
+    if (sps.sample_adaptive_offset_enabled_flag) {
+      slice_sao_luma_flag = reader.readBits(1);  // u(1)
+      slice_header["slice_sao_luma_flag"] = slice_sao_luma_flag;
+      if (sps.chroma_array_type != 0) {
+        slice_sao_chroma_flag = reader.readBits(1);  // u(1)
+        slice_header["slice_sao_chroma_flag"] = slice_sao_chroma_flag;
+      }
+    }
+    if (slice_type == kP || slice_type == kB) {
+      num_ref_idx_l0_active_minus1 = pps.num_ref_idx_l0_default_active_minus1;
+      num_ref_idx_l1_active_minus1 = pps.num_ref_idx_l1_default_active_minus1;
+      uint32_t num_ref_idx_active_override_flag = reader.readBits(1);  // u(1)
+      slice_header["num_ref_idx_active_override_flag"] =
+          num_ref_idx_active_override_flag;
+      if (num_ref_idx_active_override_flag) {
+        num_ref_idx_l0_active_minus1 = reader.readUe();  // ue(v)
+        if (slice_type == kB) {
+          num_ref_idx_l1_active_minus1 = reader.readUe();  // ue(v)
+        }
+      }
+      slice_header["num_ref_idx_l0_active_minus1"] =
+          num_ref_idx_l0_active_minus1;
+      if (slice_type == kB) {
+        slice_header["num_ref_idx_l1_active_minus1"] =
+            num_ref_idx_l1_active_minus1;
+      }
+      if (num_ref_idx_l0_active_minus1 > 14 ||
+          num_ref_idx_l1_active_minus1 > 14) {
+        slice_header["error"] = "num_ref_idx_active_minus1 out of range";
+        return slice_header;
+      }
+      if (pps.lists_modification_present_flag && num_pic_total_curr > 1) {
+        // ref_pic_lists_modification(), 7.3.6.2.
+        int list_entry_bits = ceilLog2(num_pic_total_curr);
+        if (reader.readBits(1)) {  // ref_pic_list_modification_flag_l0
+          reader.skipBits(size_t(list_entry_bits) *
+                          (num_ref_idx_l0_active_minus1 + 1));
+        }
+        if (slice_type == kB && reader.readBits(1)) {
+          reader.skipBits(size_t(list_entry_bits) *
+                          (num_ref_idx_l1_active_minus1 + 1));
+        }
+      }
+      if (slice_type == kB) {
+        slice_header["mvd_l1_zero_flag"] = reader.readBits(1);  // u(1)
+      }
+      if (pps.cabac_init_present_flag) {
+        slice_header["cabac_init_flag"] = reader.readBits(1);  // u(1)
+      }
+      if (slice_temporal_mvp_enabled_flag) {
+        if (slice_type == kB) {
+          collocated_from_l0_flag = reader.readBits(1);  // u(1)
+          slice_header["collocated_from_l0_flag"] = collocated_from_l0_flag;
+        }
+        if ((collocated_from_l0_flag && num_ref_idx_l0_active_minus1 > 0) ||
+            (!collocated_from_l0_flag && num_ref_idx_l1_active_minus1 > 0)) {
+          slice_header["collocated_ref_idx"] = reader.readUe();  // ue(v)
+        }
+      }
+      if ((pps.weighted_pred_flag && slice_type == kP) ||
+          (pps.weighted_bipred_flag && slice_type == kB)) {
+        // pred_weight_table(), 7.3.6.3. Without pps_curr_pic_ref (screen
+        // content coding) every entry has its flags.
+        reader.readUe();  // luma_log2_weight_denom
+        if (sps.chroma_array_type != 0) {
+          reader.readSe();  // delta_chroma_log2_weight_denom
+        }
+        for (int list = 0; list < (slice_type == kB ? 2 : 1); ++list) {
+          uint32_t count = (list == 0 ? num_ref_idx_l0_active_minus1
+                                      : num_ref_idx_l1_active_minus1) +
+                           1;
+          uint32_t luma_weight_flags{0};
+          uint32_t chroma_weight_flags{0};
+          for (uint32_t i = 0; i < count; ++i) {
+            luma_weight_flags |= reader.readBits(1) << i;
+          }
+          if (sps.chroma_array_type != 0) {
+            for (uint32_t i = 0; i < count; ++i) {
+              chroma_weight_flags |= reader.readBits(1) << i;
+            }
+          }
+          for (uint32_t i = 0; i < count && reader.ok(); ++i) {
+            if (luma_weight_flags & (1 << i)) {
+              reader.readSe();  // delta_luma_weight
+              reader.readSe();  // luma_offset
+            }
+            if (chroma_weight_flags & (1 << i)) {
+              for (int j = 0; j < 4; ++j) {
+                reader.readSe();  // delta_chroma_weight, delta_chroma_offset
+              }
+            }
+          }
+        }
+        slice_header["pred_weight_table"] = true;
+      }
+      slice_header["five_minus_max_num_merge_cand"] = reader.readUe();
+    }
+    slice_header["slice_qp_delta"] = reader.readSe();  // se(v)
+    if (pps.pps_slice_chroma_qp_offsets_present_flag) {
+      slice_header["slice_cb_qp_offset"] = reader.readSe();  // se(v)
+      slice_header["slice_cr_qp_offset"] = reader.readSe();  // se(v)
+    }
+    if (pps.chroma_qp_offset_list_enabled_flag) {
+      slice_header["cu_chroma_qp_offset_enabled_flag"] = reader.readBits(1);
+    }
+    if (pps.deblocking_filter_override_enabled_flag) {
+      deblocking_filter_override_flag = reader.readBits(1);  // u(1)
+      slice_header["deblocking_filter_override_flag"] =
+          deblocking_filter_override_flag;
+    }
+    slice_deblocking_filter_disabled_flag =
+        pps.pps_deblocking_filter_disabled_flag;
+    if (deblocking_filter_override_flag) {
+      slice_deblocking_filter_disabled_flag = reader.readBits(1);  // u(1)
+      slice_header["slice_deblocking_filter_disabled_flag"] =
+          slice_deblocking_filter_disabled_flag;
+      if (!slice_deblocking_filter_disabled_flag) {
+        slice_header["slice_beta_offset_div2"] = reader.readSe();  // se(v)
+        slice_header["slice_tc_offset_div2"] = reader.readSe();    // se(v)
+      }
+    }
+    if (pps.pps_loop_filter_across_slices_enabled_flag &&
+        (slice_sao_luma_flag || slice_sao_chroma_flag ||
+         !slice_deblocking_filter_disabled_flag)) {
+      slice_header["slice_loop_filter_across_slices_enabled_flag"] =
+          reader.readBits(1);  // u(1)
+    }
+  }
+  if (pps.tiles_enabled_flag || pps.entropy_coding_sync_enabled_flag) {
+    num_entry_point_offsets = reader.readUe();  // ue(v)
+    slice_header["num_entry_point_offsets"] = num_entry_point_offsets;
+    if (num_entry_point_offsets > 0) {
+      uint32_t offset_len_minus1 = reader.readUe();  // ue(v)
+      if (offset_len_minus1 > 31) {
+        slice_header["error"] = "offset_len_minus1 out of range";
+        return slice_header;
+      }
+      // entry_point_offset_minus1
+      reader.skipBits(size_t(offset_len_minus1 + 1) * num_entry_point_offsets);
+    }
+  }
+  if (pps.slice_segment_header_extension_present_flag) {
+    uint32_t slice_segment_header_extension_length = reader.readUe();
+    reader.skipBits(size_t(slice_segment_header_extension_length) * 8);
+  }
+  if (!reader.ok()) {
+    slice_header["truncated"] = true;
+  } else {
+    // byte_alignment(): the slice data start in the RBSP.
+    slice_header["slice_header_bits"] = reader.bitOffset();
+  }
+  return slice_header;
+}
+}  // namespace chai
@@ -0,0 +1,131 @@
+#ifndef CHAI_PAYLOAD_H265_H
+#define CHAI_PAYLOAD_H265_H
+
+#include "RtpPakcet.h"
+
+namespace chai {
+class BitReader;
+
+// nal_unit_type, H.265 Table 7-1, and the RTP packet types of RFC 7798.
+enum H265NaluType : uint8_t {
+  kH265TrailN = 0,
+  kH265TrailR = 1,
+  kH265BlaWLp = 16,
+  kH265BlaWRadl = 17,
+  kH265BlaNLp = 18,
+  kH265IdrWRadl = 19,
+  kH265IdrNLp = 20,
+  kH265Cra = 21,
+  kH265RsvIrap23 = 23,
+  kH265Vps = 32,
+  kH265Sps = 33,
+  kH265Pps = 34,
+  kH265Aud = 35,
+  kH265Eos = 36,
+  kH265Eob = 37,
+  kH265Fd = 38,
+  kH265PrefixSei = 39,
+  kH265SuffixSei = 40,
+  kH265Ap = 48,
+  kH265Fu = 49,
+  kH265Paci = 50,
+};
+
+// Intra random access point: BLA, IDR, CRA and the reserved IRAP types.
+inline bool h265IsIrap(uint8_t type) {
+  return type >= kH265BlaWLp && type <= kH265RsvIrap23;
+}
+
+class PayloadH265 : public PayloadBase {
+ public:
+  nlohmann::json parse(const uint8_t* buff, size_t length) override;
+
+ protected:
+  nlohmann::json parseVps(const uint8_t* buff, size_t length);
+  nlohmann::json parseSps(const uint8_t* buff, size_t length);
+  nlohmann::json parsePps(const uint8_t* buff, size_t length);
+  nlohmann::json parseSliceHeader(uint8_t nal_type,
+                                  const uint8_t* buff,
+                                  size_t length);
+
+  static const int kMaxVps{16};
+  static const int kMaxSps{16};
+  static const int kMaxPps{64};
+  // num_short_term_ref_pic_sets is at most 64; one more for the set a slice
+  // header codes itself.
+  static const int kMaxStRps{65};
+  static const int kMaxLtRefPics{32};
+  // sps_max_dec_pic_buffering_minus1 + 1.
+  static const int kMaxDpbSize{16};
+
+  // What the slice segment header needs from one st_ref_pic_set().
+  struct StRps {
+    uint32_t num_delta_pocs{0};
+    uint32_t num_used{0};
+  };
+  struct VpsState {
+    uint32_t vps_max_sub_layers_minus1{0};
+  };
+  // What the slice segment header syntax needs from an SPS.
+  struct SpsState {
+    uint32_t chroma_array_type{1};
+    uint32_t separate_colour_plane_flag{0};
+    uint32_t pic_size_in_ctbs_y{0};
+    uint32_t log2_max_pic_order_cnt_lsb{4};
+    uint32_t num_short_term_ref_pic_sets{0};
+    StRps st_rps[kMaxStRps];
+    uint32_t long_term_ref_pics_present_flag{0};
+    uint32_t num_long_term_ref_pics_sps{0};
+    uint32_t used_by_curr_pic_lt_sps_flags{0};
+    uint32_t sps_temporal_mvp_enabled_flag{0};
+    uint32_t sample_adaptive_offset_enabled_flag{0};
+  };
+  // What the slice segment header syntax needs from a PPS.
+  struct PpsState {
+    uint32_t pps_seq_parameter_set_id{0};
+    uint32_t dependent_slice_segments_enabled_flag{0};
+    uint32_t output_flag_present_flag{0};
+    uint32_t num_extra_slice_header_bits{0};
+    uint32_t cabac_init_present_flag{0};
+    uint32_t num_ref_idx_l0_default_active_minus1{0};
+    uint32_t num_ref_idx_l1_default_active_minus1{0};
+    uint32_t pps_slice_chroma_qp_offsets_present_flag{0};
+    uint32_t weighted_pred_flag{0};
+    uint32_t weighted_bipred_flag{0};
+    uint32_t tiles_enabled_flag{0};
+    uint32_t entropy_coding_sync_enabled_flag{0};
+    uint32_t pps_loop_filter_across_slices_enabled_flag{0};
+    uint32_t deblocking_filter_override_enabled_flag{0};
+    uint32_t pps_deblocking_filter_disabled_flag{0};
+    uint32_t lists_modification_present_flag{0};
+    uint32_t slice_segment_header_extension_present_flag{0};
+    uint32_t chroma_qp_offset_list_enabled_flag{0};
+  };
+  // One parameter set id, as in PayloadH264: a repeat with the same |hash|
+  // and |length| gets the cached |json| instead of being parsed again.
+  template <typename State>
+  struct ParameterSet {
+    bool valid{false};
+    uint64_t hash{0};
+    size_t length{0};
+    State state;
+    nlohmann::json json;
+  };
+
+  static nlohmann::json parseProfileTierLevel(BitReader& reader,
+                                              uint32_t max_sub_layers_minus1);
+  static void skipScalingListData(BitReader& reader);
+  // st_ref_pic_set(|idx|), 7.3.7; |sets| holds the sets before |idx|.
+  static nlohmann::json parseStRefPicSet(BitReader& reader,
+                                         uint32_t idx,
+                                         uint32_t num_short_term_ref_pic_sets,
+                                         StRps* sets);
+
+ private:
+  // One PayloadH265 per SSRC, so the sets are keyed by SSRC and id.
+  ParameterSet<VpsState> vps_[kMaxVps];
+  ParameterSet<SpsState> sps_[kMaxSps];
+  ParameterSet<PpsState> pps_[kMaxPps];
+};
+}  // namespace chai
+#endif  // CHAI_PAYLOAD_H265_H
@@ -0,0 +1,28 @@
+#include "PayloadOpus.h"
+
+namespace chai {
+nlohmann::json PayloadOpus::parse(const uint8_t* buff, size_t length) {
+  OpusPacketInfo packet;
+  if (!this->parsePacket(buff, length, &packet)) {
+    return {{"payload_length", length}, {"error", "malformed packet"}};
+  }
+  nlohmann::json opus = packet.toJson();
+  opus["payload_length"] = length;
+  return opus;
+}
+
+bool PayloadOpus::parsePacket(const uint8_t* buff,
+                              size_t length,
+                              OpusPacketInfo* packet) {
+  if (!parseOpusPacket(buff, length, packet)) {
+    return false;
+  }
+  if (this->hasBandwidth_ && packet->bandwidth != this->bandwidth_) {
+    packet->bandwidthChanged = true;
+    packet->previousBandwidth = this->bandwidth_;
+  }
+  this->hasBandwidth_ = true;
+  this->bandwidth_ = packet->bandwidth;
+  return true;
+}
+}  // namespace chai
@@ -0,0 +1,27 @@
+#ifndef CHAI_PAYLOAD_OPUS_H
+#define CHAI_PAYLOAD_OPUS_H
+
+#include "OpusPacket.h"
+#include "RtpPakcet.h"
+
+namespace chai {
+// Opus (RFC 7587). Every packet is one Opus packet, parsed into the record
+// from its TOC byte and framing alone: nothing is decoded, and nothing is
+// allocated. The stream's last bandwidth is kept to flag changes.
+class PayloadOpus : public PayloadBase {
+ public:
+  PayloadOpus() { color1_ = color2_ = AUDIO_COLOR; }
+
+  nlohmann::json parse(const uint8_t* buff, size_t length) override;
+
+  // |buff| is the payload of one RTP packet.
+  bool parsePacket(const uint8_t* buff,
+                   size_t length,
+                   OpusPacketInfo* packet);
+
+ private:
+  bool hasBandwidth_{false};
+  OpusBandwidth bandwidth_{OpusBandwidth::kNarrowband};
+};
+}  // namespace chai
+#endif  // CHAI_PAYLOAD_OPUS_H
@@ -0,0 +1,212 @@
+#define MSC_CLASS "PayloadTypeTable"
+
+#include "PayloadTypeTable.h"
+
+#include <rtc_base/logging.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <sdptransform.hpp>
+
+namespace {
+// rtpmap encoding names, lower-cased.
+const std::map<std::string, chai::Codec> name2Codec = {
+    {"opus", chai::Codec::kOpus},
+    {"pcmu", chai::Codec::kPcmu},
+    {"pcma", chai::Codec::kPcma},
+    {"g722", chai::Codec::kG722},
+    {"cn", chai::Codec::kComfortNoise},
+    {"telephone-event", chai::Codec::kTelephoneEvent},
+    {"h264", chai::Codec::kH264},
+    {"h265", chai::Codec::kH265},
+    {"vp8", chai::Codec::kVp8},
+    {"vp9", chai::Codec::kVp9},
+    {"av1", chai::Codec::kAv1},
+    {"av1x", chai::Codec::kAv1},
+    {"rtx", chai::Codec::kRtx},
+    {"red", chai::Codec::kRed},
+    {"ulpfec", chai::Codec::kUlpFec},
+    {"flexfec", chai::Codec::kFlexFec},
+    {"flexfec-03", chai::Codec::kFlexFec},
+};
+
+std::string toLower(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return value;
+}
+}  // namespace
+
+namespace chai {
+const char* codecName(Codec codec) {
+  switch (codec) {
+    case Codec::kOpus:
+      return "opus";
+    case Codec::kPcmu:
+      return "PCMU";
+    case Codec::kPcma:
+      return "PCMA";
+    case Codec::kG722:
+      return "G722";
+    case Codec::kComfortNoise:
+      return "CN";
+    case Codec::kTelephoneEvent:
+      return "telephone-event";
+    case Codec::kH264:
+      return "H264";
+    case Codec::kH265:
+      return "H265";
+    case Codec::kVp8:
+      return "VP8";
+    case Codec::kVp9:
+      return "VP9";
+    case Codec::kAv1:
+      return "AV1";
+    case Codec::kRtx:
+      return "rtx";
+    case Codec::kRed:
+      return "red";
+    case Codec::kUlpFec:
+      return "ulpfec";
+    case Codec::kFlexFec:
+      return "flexfec";
+    case Codec::kUnknown:
+    default:
+      return "unknown";
+  }
+}
+
+std::shared_ptr<const PayloadTypeTable> PayloadTypeTable::fromSdp(
+    const std::string& localSdp,
+    const std::string& remoteSdp,
+    const std::set<std::string>& mids) {
+  std::shared_ptr<PayloadTypeTable> table(new PayloadTypeTable);
+  std::set<std::string> seenMids;
+  // Received packets: payload types from the local description, SSRCs from
+  // the remote one; the other way round for sent packets.
+  bool local = parseSdp(localSdp, mids, &table->entries_[0],
+                        &table->extensions_[0], &table->mids_[1], &seenMids);
+  bool remote = parseSdp(remoteSdp, mids, &table->entries_[1],
+                         &table->extensions_[1], &table->mids_[0], &seenMids);
+  if (!local && !remote) {
+    return nullptr;
+  }
+  if (seenMids.size() == 1) {
+    table->defaultMid_ = *seenMids.begin();
+  }
+  // With only one side known, assume symmetric payload types.
+  if (!local) {
+    table->entries_[0] = table->entries_[1];
+    table->extensions_[0] = table->extensions_[1];
+  } else if (!remote) {
+    table->entries_[1] = table->entries_[0];
+    table->extensions_[1] = table->extensions_[0];
+  }
+  return table;
+}
+
+std::shared_ptr<const PayloadTypeTable> PayloadTypeTable::defaults() {
+  std::shared_ptr<PayloadTypeTable> table(new PayloadTypeTable);
+  Entries& entries = table->entries_[0];
+  entries[111] = {Codec::kOpus, 0, 48000};
+  entries[124] = {Codec::kH264, 0, 90000};
+  entries[107] = {Codec::kRtx, 124, 90000};
+  entries[35] = {Codec::kAv1, 0, 90000};
+  entries[36] = {Codec::kRtx, 35, 90000};
+  entries[115] = {Codec::kFlexFec, 0, 90000};
+  table->entries_[1] = entries;
+  return table;
+}
+
+/*
+  m=video 9 UDP/TLS/RTP/SAVPF 96 97
+  a=rtpmap:96 VP8/90000
+  a=rtpmap:97 rtx/90000
+  a=fmtp:97 apt=96
+  a=extmap:3 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01
+*/
+bool PayloadTypeTable::parseSdp(const std::string& sdp,
+                                const std::set<std::string>& mids,
+                                Entries* entries,
+                                ExtensionMap* extensions,
+                                Mids* ssrcMids,
+                                std::set<std::string>* seenMids) {
+  if (sdp.empty()) {
+    return false;
+  }
+
+  nlohmann::json session;
+  try {
+    session = sdptransform::parse(sdp);
+  } catch (const std::exception& e) {
+    RTC_LOG(LS_WARNING) << "can't parse SDP: " << e.what();
+    return false;
+  }
+  if (!session.contains("media")) {
+    return false;
+  }
+
+  for (const auto& media : session["media"]) {
+    std::string mid;
+    if (media.contains("mid")) {
+      // sdptransform turns numeric mids into numbers.
+      const auto& value = media["mid"];
+      mid = value.is_string() ? value.get<std::string>() : value.dump();
+    }
+    if (!mids.empty() && mids.count(mid) == 0) {
+      continue;
+    }
+    if (!mid.empty()) {
+      seenMids->insert(mid);
+    }
+
+    /*
+      a=ssrc:1001 cname:user@example.com
+    */
+    if (media.contains("ssrcs")) {
+      for (const auto& ssrc : media["ssrcs"]) {
+        (*ssrcMids)[ssrc.value("id", 0u)] = mid;
+      }
+    }
+    if (media.contains("rtp")) {
+      for (const auto& rtp : media["rtp"]) {
+        uint8_t payloadType = rtp.value("payload", 0) & 0x7f;
+        auto it = name2Codec.find(toLower(rtp.value("codec", "")));
+        PayloadTypeEntry& entry = (*entries)[payloadType];
+        entry.codec = it != name2Codec.end() ? it->second : Codec::kUnknown;
+        entry.clockRate = rtp.value("rate", 0);
+      }
+    }
+    if (media.contains("ext")) {
+      for (const auto& ext : media["ext"]) {
+        uint8_t id = ext.value("value", 0) & 0xff;
+        if (id != 0) {
+          (*extensions)[id] = extensionTypeFromUri(ext.value("uri", ""));
+        }
+      }
+    }
+    if (media.contains("fmtp")) {
+      for (const auto& fmtp : media["fmtp"]) {
+        uint8_t payloadType = fmtp.value("payload", 0) & 0x7f;
+        PayloadTypeEntry& entry = (*entries)[payloadType];
+        if (entry.codec != Codec::kRtx) {
+          continue;
+        }
+        auto params = sdptransform::parseParams(fmtp.value("config", ""));
+        if (!params.contains("apt")) {
+          continue;
+        }
+        const auto& apt = params["apt"];
+        if (apt.is_number()) {
+          entry.apt = apt.get<int>() & 0x7f;
+        } else if (apt.is_string()) {
+          entry.apt = std::atoi(apt.get<std::string>().c_str()) & 0x7f;
+        }
+      }
+    }
+  }
+  return true;
+}
+}  // namespace chai
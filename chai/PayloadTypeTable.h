@@ -0,0 +1,103 @@
+#ifndef CHAI_PAYLOAD_TYPE_TABLE_H
+#define CHAI_PAYLOAD_TYPE_TABLE_H
+
+#include <stdint.h>
+
+#include <array>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "PacketPool.h"
+#include "RtpExtensions.h"
+
+namespace chai {
+enum class Codec : uint8_t {
+  kUnknown,
+  kOpus,
+  kPcmu,
+  kPcma,
+  kG722,
+  kComfortNoise,
+  kTelephoneEvent,
+  kH264,
+  kH265,
+  kVp8,
+  kVp9,
+  kAv1,
+  kRtx,
+  kRed,
+  kUlpFec,
+  kFlexFec,
+};
+
+const char* codecName(Codec codec);
+
+struct PayloadTypeEntry {
+  Codec codec{Codec::kUnknown};
+  // RTX only: payload type of the retransmitted stream (fmtp apt).
+  uint8_t apt{0};
+  uint32_t clockRate{0};
+};
+
+// Payload type to codec mapping, one 128-entry array per direction so a
+// lookup is a single index on the parse path. Packets we receive use the
+// payload types of the local description, packets we send those of the
+// remote one.
+//
+// Header extension ids map to types the same way, from the a=extmap lines.
+//
+// Also maps SSRCs to the mid of their m-section: packets we receive carry
+// the SSRCs announced in the remote description (a=ssrc), packets we send
+// those of the local one.
+//
+// Tables are immutable once built; renegotiation builds a new one and hands
+// it to the parse workers.
+class PayloadTypeTable {
+ public:
+  // Returns nullptr if neither description can be parsed. With |mids| only
+  // the m-sections of those mids are read, i.e. the ones of one transport.
+  static std::shared_ptr<const PayloadTypeTable> fromSdp(
+      const std::string& localSdp,
+      const std::string& remoteSdp,
+      const std::set<std::string>& mids = {});
+  // The mapping this tool used before it read the SDP, for captures that
+  // come without one.
+  static std::shared_ptr<const PayloadTypeTable> defaults();
+
+  const PayloadTypeEntry& lookup(Direction direction,
+                                 uint8_t payloadType) const {
+    return entries_[direction == Direction::kSend][payloadType & 0x7f];
+  }
+  const ExtensionMap& extensions(Direction direction) const {
+    return extensions_[direction == Direction::kSend];
+  }
+  // Mid of the m-section announcing |ssrc|. Falls back to the only mid of
+  // the table, or "" if there are several.
+  const std::string& mid(Direction direction, uint32_t ssrc) const {
+    const auto& mids = mids_[direction == Direction::kSend];
+    auto it = mids.find(ssrc);
+    return it != mids.end() ? it->second : defaultMid_;
+  }
+
+ protected:
+  using Entries = std::array<PayloadTypeEntry, 128>;
+  using Mids = std::unordered_map<uint32_t, std::string>;
+  static bool parseSdp(const std::string& sdp,
+                       const std::set<std::string>& mids,
+                       Entries* entries,
+                       ExtensionMap* extensions,
+                       Mids* ssrcMids,
+                       std::set<std::string>* seenMids);
+
+ private:
+  // Indexed by Direction::kRecv (0) and Direction::kSend (1).
+  Entries entries_[2];
+  ExtensionMap extensions_[2]{};
+  Mids mids_[2];
+  std::string defaultMid_;
+};
+}  // namespace chai
+
+#endif  // CHAI_PAYLOAD_TYPE_TABLE_H
@@ -0,0 +1,106 @@
+#include "PayloadVP8.h"
+
+#include <string.h>
+
+namespace {
+// RFC 6386 9.1.
+const uint16_t kFrameTagSize{3};
+const uint16_t kKeyFrameHeaderSize{7};
+const uint8_t kStartCode[] = {0x9d, 0x01, 0x2a};
+}  // namespace
+
+namespace chai {
+nlohmann::json PayloadVP8::parse(const uint8_t* buff, size_t length) {
+  nlohmann::json frame = {
+      {"frame_length", length},
+      {"video_codec", "vp8"},
+      {"frame_key", 0},
+  };
+  frame_type_ = 0;
+  if (length < kFrameTagSize) {
+    frame["error"] = "truncated";
+    return frame;
+  }
+
+  /*
+    RFC 6386 9.1, the frame tag:
+     0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    |P|VER  |S|       first_part_size               |
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    with the bits of each byte from least to most significant.
+  */
+  uint32_t tag = buff[0] | (buff[1] << 8) | (buff[2] << 16);
+  bool key_frame = !(tag & 0x01);
+  uint32_t first_part_size = tag >> 5;
+  frame["frame_tag"] = {
+      {"key_frame", key_frame},
+      {"version", (tag >> 1) & 0x07},
+      {"show_frame", (tag >> 4) & 0x01},
+      {"first_part_size", first_part_size},
+  };
+  uint16_t header_size = kFrameTagSize;
+  if (key_frame) {
+    frame["frame_key"] = 1;
+    frame_type_ = 1;
+    header_size += kKeyFrameHeaderSize;
+    if (length < header_size ||
+        memcmp(buff + kFrameTagSize, kStartCode, sizeof(kStartCode)) != 0) {
+      frame["error"] = "bad key frame start code";
+      return frame;
+    }
+    // 9.2: 14 bits of size and 2 bits of upscaling, little endian.
+    const uint8_t* ptr = buff + kFrameTagSize + sizeof(kStartCode);
+    uint16_t horizontal = ptr[0] | (ptr[1] << 8);
+    uint16_t vertical = ptr[2] | (ptr[3] << 8);
+    frame["key_frame_header"] = {
+        {"width", horizontal & 0x3fff},
+        {"horizontal_scale", horizontal >> 14},
+        {"height", vertical & 0x3fff},
+        {"vertical_scale", vertical >> 14},
+    };
+  }
+  // The first partition holds the modes and motion vectors, the DCT
+  // partitions the residual.
+  if (header_size + first_part_size > length) {
+    frame["error"] = "first_part_size beyond the frame";
+    return frame;
+  }
+  frame["bytes"] = {
+      {"frame_header", header_size},
+      {"first_partition", first_part_size},
+      {"dct_partitions", length - header_size - first_part_size},
+  };
+  return frame;
+}
+
+bool PayloadVP8::parseDescriptor(const uint8_t* buff,
+                                 uint16_t length,
+                                 Vp8Descriptor* descriptor) {
+  if (!parseVp8Descriptor(buff, length, descriptor)) {
+    return false;
+  }
+  if (descriptor->startOfFrame) {
+    this->keyFrame_ = descriptor->keyFrame;
+  }
+  descriptor->keyFrame = this->keyFrame_;
+
+  if (this->keyFrame_) {
+    color1_ = color2_ = VIDEO_KEY_COLOR;
+    return true;
+  }
+  // Without a TID every frame is in the base layer.
+  switch (descriptor->hasTid ? descriptor->tid : 0) {
+    case 0:
+      color1_ = color2_ = VIDEO_L0T0_COLOR;
+      break;
+    case 1:
+      color1_ = color2_ = VIDEO_L0T1_COLOR;
+      break;
+    default:
+      color1_ = color2_ = VIDEO_L0T2_COLOR;
+      break;
+  }
+  return true;
+}
+}  // namespace chai
@@ -0,0 +1,28 @@
+#ifndef CHAI_PAYLOAD_VP8_H
+#define CHAI_PAYLOAD_VP8_H
+
+#include "RtpPakcet.h"
+#include "Vp8Descriptor.h"
+
+namespace chai {
+// VP8 (RFC 7741). Every packet has its payload descriptor parsed into the
+// record, and colours the packet list row: by TID, key frames apart. The
+// frames assembled by webrtc's depacketizer are parsed for the frame header,
+// RFC 6386 9.1 and 9.2.
+class PayloadVP8 : public PayloadBase {
+ public:
+  // |buff| is one frame, without the payload descriptors.
+  nlohmann::json parse(const uint8_t* buff, size_t length) override;
+
+  // |buff| is the payload of one RTP packet.
+  bool parseDescriptor(const uint8_t* buff,
+                       uint16_t length,
+                       Vp8Descriptor* descriptor);
+
+ private:
+  // Whether the frame of the last start-of-frame packet is a key frame; the
+  // other packets of the frame don't tell.
+  bool keyFrame_{false};
+};
+}  // namespace chai
+#endif  // CHAI_PAYLOAD_VP8_H
@@ -0,0 +1,228 @@
+#include "PayloadVP9.h"
+
+#include "BitReader.h"
+
+namespace {
+// VP9 bitstream specification 7.2.
+const uint32_t kFrameSyncCode{0x498342};
+const uint32_t kCsRgb{7};
+
+// Indexed by the 3-bit color_space.
+const char* const kColorSpaceNames[8] = {
+    "CS_UNKNOWN",   "CS_BT_601",  "CS_BT_709",   "CS_SMPTE_170",
+    "CS_SMPTE_240", "CS_BT_2020", "CS_RESERVED", "CS_RGB",
+};
+
+// 6.2.2 color_config()
+nlohmann::json colorConfig(chai::BitReader& reader, uint32_t profile) {
+  nlohmann::json color;
+  uint32_t bit_depth = 8;
+  if (profile >= 2) {
+    bit_depth = reader.readBits(1) ? 12 : 10;  // ten_or_twelve_bit
+  }
+  color["bit_depth"] = bit_depth;
+  uint32_t color_space = reader.readBits(3);  // f(3)
+  color["color_space"] = kColorSpaceNames[color_space];
+  uint32_t subsampling_x = 1;
+  uint32_t subsampling_y = 1;
+  if (color_space != kCsRgb) {
+    color["color_range"] = reader.readBits(1);  // f(1)
+    if (profile == 1 || profile == 3) {
+      subsampling_x = reader.readBits(1);  // f(1)
+      subsampling_y = reader.readBits(1);  // f(1)
+      reader.skipBits(1);                  // reserved_zero
+    }
+  } else {
+    color["color_range"] = 1;
+    if (profile == 1 || profile == 3) {
+      subsampling_x = subsampling_y = 0;
+      reader.skipBits(1);  // reserved_zero
+    }
+  }
+  color["subsampling_x"] = subsampling_x;
+  color["subsampling_y"] = subsampling_y;
+  return color;
+}
+
+// 6.2.5 frame_size() and 6.2.6 render_size()
+void frameSize(chai::BitReader& reader, nlohmann::json& header) {
+  header["frame_width"] = reader.readBits(16) + 1;   // frame_width_minus_1
+  header["frame_height"] = reader.readBits(16) + 1;  // frame_height_minus_1
+  if (reader.readBits(1)) {  // render_and_frame_size_different
+    header["render_width"] = reader.readBits(16) + 1;
+    header["render_height"] = reader.readBits(16) + 1;
+  }
+}
+}  // namespace
+
+namespace chai {
+const int PayloadVP9::kMaxSpatialLayers;
+const int PayloadVP9::kMaxTemporalLayers;
+const int64_t PayloadVP9::kRateWindowUs;
+
+// 6.2 uncompressed_header(), up to the frame size: the rest needs the
+// reference frame sizes and loop filter state of the decoder.
+nlohmann::json PayloadVP9::parse(const uint8_t* buff, size_t length) {
+  nlohmann::json frame = {
+      {"frame_length", length},
+      {"video_codec", "vp9"},
+      {"frame_key", 0},
+      {"layers", this->layersJson()},
+  };
+  frame_type_ = 0;
+  BitReader reader(buff, length);
+  nlohmann::json header;
+
+  uint32_t frame_marker = reader.readBits(2);  // f(2)
+  if (frame_marker != 2) {
+    frame["error"] = "bad frame_marker";
+    return frame;
+  }
+  uint32_t profile = reader.readBits(1);  // profile_low_bit
+  profile |= reader.readBits(1) << 1;     // profile_high_bit
+  if (profile == 3) {
+    reader.skipBits(1);  // reserved_zero
+  }
+  header["profile"] = profile;
+  uint32_t show_existing_frame = reader.readBits(1);  // f(1)
+  header["show_existing_frame"] = show_existing_frame;
+  if (show_existing_frame) {
+    header["frame_to_show_map_idx"] = reader.readBits(3);  // f(3)
+  } else {
+    uint32_t frame_type = reader.readBits(1);  // f(1), 0 is KEY_FRAME
+    header["frame_type"] = frame_type ? "NON_KEY_FRAME" : "KEY_FRAME";
+    uint32_t show_frame = reader.readBits(1);  // f(1)
+    header["show_frame"] = show_frame;
+    uint32_t error_resilient_mode = reader.readBits(1);  // f(1)
+    header["error_resilient_mode"] = error_resilient_mode;
+    if (frame_type == 0) {
+      frame["frame_key"] = 1;
+      frame_type_ = 1;
+      if (reader.readBits(24) != kFrameSyncCode) {
+        frame["error"] = "bad frame_sync_code";
+        frame["uncompressed_header"] = header;
+        return frame;
+      }
+      header["color_config"] = colorConfig(reader, profile);
+      frameSize(reader, header);
+    } else {
+      uint32_t intra_only = show_frame ? 0 : reader.readBits(1);  // f(1)
+      header["intra_only"] = intra_only;
+      if (!error_resilient_mode) {
+        header["reset_frame_context"] = reader.readBits(2);  // f(2)
+      }
+      if (intra_only) {
+        if (reader.readBits(24) != kFrameSyncCode) {
+          frame["error"] = "bad frame_sync_code";
+          frame["uncompressed_header"] = header;
+          return frame;
+        }
+        if (profile > 0) {
+          header["color_config"] = colorConfig(reader, profile);
+        }
+        header["refresh_frame_flags"] = reader.readBits(8);  // f(8)
+        frameSize(reader, header);
+      } else {
+        header["refresh_frame_flags"] = reader.readBits(8);  // f(8)
+        nlohmann::json refs = nlohmann::json::array();
+        for (int i = 0; i < 3; ++i) {
+          nlohmann::json ref;
+          ref["ref_frame_idx"] = reader.readBits(3);        // f(3)
+          ref["ref_frame_sign_bias"] = reader.readBits(1);  // f(1)
+          refs.push_back(ref);
+        }
+        header["refs"] = refs;
+      }
+    }
+  }
+  if (!reader.ok()) {
+    header["truncated"] = true;
+  }
+  frame["uncompressed_header"] = header;
+  return frame;
+}
+
+bool PayloadVP9::parseDescriptor(const uint8_t* buff,
+                                 uint16_t length,
+                                 int64_t timeUs,
+                                 Vp9Descriptor* descriptor) {
+  if (!parseVp9Descriptor(buff, length, descriptor)) {
+    return false;
+  }
+  if (descriptor->ssAttached) {
+    this->hasSs_ = true;
+    this->ss_ = descriptor->ss;
+  }
+  uint8_t sid = descriptor->sid;
+  uint8_t tid = descriptor->tid;
+  if (this->hasSs_ && this->ss_.resolutionsPresent &&
+      sid < this->ss_.spatialLayers) {
+    descriptor->width = this->ss_.width[sid];
+    descriptor->height = this->ss_.height[sid];
+  }
+
+  // The payload bytes count towards the layer of the packet.
+  this->lastTimeUs_ = timeUs;
+  LayerRate& rate = this->rates_[sid][tid];
+  if (!rate.started) {
+    rate.started = true;
+    rate.windowStartUs = timeUs;
+  }
+  rate.bytes += length;
+  int64_t elapsedUs = timeUs - rate.windowStartUs;
+  if (elapsedUs >= kRateWindowUs) {
+    rate.bitrate = uint32_t(rate.bytes * 8 * 1000000 / uint64_t(elapsedUs));
+    rate.bytes = 0;
+    rate.windowStartUs = timeUs;
+  }
+  descriptor->layerBitrate = rate.bitrate;
+
+  // Upper spatial layers of a key picture only predict from the layer
+  // below, so they have P clear as well.
+  if (descriptor->startOfFrame && sid == 0) {
+    this->keyFrame_ = !descriptor->interPicturePredicted;
+  }
+  descriptor->keyFrame =
+      this->keyFrame_ && !descriptor->interPicturePredicted;
+
+  if (descriptor->keyFrame) {
+    color1_ = color2_ = VIDEO_KEY_COLOR;
+    return true;
+  }
+  switch (tid) {
+    case 0:
+      color1_ = color2_ = VIDEO_L0T0_COLOR;
+      break;
+    case 1:
+      color1_ = color2_ = VIDEO_L0T1_COLOR;
+      break;
+    default:
+      color1_ = color2_ = VIDEO_L0T2_COLOR;
+      break;
+  }
+  return true;
+}
+
+nlohmann::json PayloadVP9::layersJson() const {
+  nlohmann::json layers = nlohmann::json::array();
+  for (int sid = 0; sid < kMaxSpatialLayers; ++sid) {
+    for (int tid = 0; tid < kMaxTemporalLayers; ++tid) {
+      const LayerRate& rate = this->rates_[sid][tid];
+      if (!rate.started) {
+        continue;
+      }
+      // A layer that stopped sending would keep the rate of its last
+      // window; it shows as idle instead.
+      bool stopped = this->lastTimeUs_ - rate.windowStartUs > 2 * kRateWindowUs;
+      layers.push_back({{"sid", sid},
+                        {"tid", tid},
+                        {"bitrate", stopped ? 0 : rate.bitrate}});
+    }
+  }
+  nlohmann::json json = {{"bitrates", layers}};
+  if (this->hasSs_) {
+    json["ss"] = this->ss_.toJson();
+  }
+  return json;
+}
+}  // namespace chai
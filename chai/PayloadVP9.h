@@ -0,0 +1,53 @@
+#ifndef CHAI_PAYLOAD_VP9_H
+#define CHAI_PAYLOAD_VP9_H
+
+#include "RtpPakcet.h"
+#include "Vp9Descriptor.h"
+
+namespace chai {
+// VP9 (RFC 9628). Every packet has its payload descriptor parsed into the
+// record and read against the last scalability structure of the stream;
+// it also counts towards the bitrate of its spatial/temporal layer. The
+// layer frames assembled by webrtc's depacketizer are parsed for the
+// uncompressed header, VP9 bitstream specification 6.2.
+class PayloadVP9 : public PayloadBase {
+ public:
+  static const int kMaxSpatialLayers{
+      Vp9ScalabilityStructure::kMaxSpatialLayers};
+  // TID is 3 bits.
+  static const int kMaxTemporalLayers{8};
+  // Layer bitrates are over windows of this length.
+  static const int64_t kRateWindowUs{1000000};
+
+  // |buff| is one layer frame, without the payload descriptors.
+  nlohmann::json parse(const uint8_t* buff, size_t length) override;
+
+  // |buff| is the payload of one RTP packet, which arrived at |timeUs|.
+  bool parseDescriptor(const uint8_t* buff,
+                       uint16_t length,
+                       int64_t timeUs,
+                       Vp9Descriptor* descriptor);
+
+ protected:
+  // Bytes of one layer in the current window; only the rate of the last
+  // complete window is kept, so the cost per packet is constant.
+  struct LayerRate {
+    bool started{false};
+    int64_t windowStartUs{0};
+    uint64_t bytes{0};
+    uint32_t bitrate{0};
+  };
+
+  nlohmann::json layersJson() const;
+
+ private:
+  bool hasSs_{false};
+  Vp9ScalabilityStructure ss_;
+  // Whether the picture of the last start-of-frame packet in the base
+  // spatial layer is a key picture.
+  bool keyFrame_{false};
+  int64_t lastTimeUs_{0};
+  LayerRate rates_[kMaxSpatialLayers][kMaxTemporalLayers];
+};
+}  // namespace chai
+#endif  // CHAI_PAYLOAD_VP9_H
@@ -0,0 +1,256 @@
+#include "PcapReader.h"
+
+namespace {
+const uint32_t kPcapMagic{0xa1b2c3d4};
+const uint32_t kPcapNanoMagic{0xa1b23c4d};
+const uint32_t kPcapngByteOrderMagic{0x1a2b3c4d};
+
+const size_t kPcapFileHeaderSize{24};
+const size_t kPcapRecordHeaderSize{16};
+
+enum PcapngBlock : uint32_t {
+  kInterfaceDescription = 0x00000001,
+  kSimplePacket = 0x00000003,
+  kEnhancedPacket = 0x00000006,
+  kSectionHeader = 0x0a0d0d0a,
+};
+// Block type + block total length ... block total length.
+const uint32_t kPcapngBlockOverhead{12};
+const uint16_t kOptionEndOfOpt{0};
+const uint16_t kOptionIfTsresol{9};
+
+uint32_t swap32(uint32_t value) {
+  return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) |
+         (value << 24);
+}
+
+uint32_t readLittleEndian32(const uint8_t* ptr) {
+  return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | (uint32_t(ptr[3]) << 24);
+}
+}  // namespace
+
+namespace chai {
+bool PcapReader::open(const std::string& path) {
+  if (!this->file_.open(path)) {
+    this->error_ = this->file_.error();
+    return false;
+  }
+  this->offset_ = 0;
+
+  const uint8_t* data = this->file_.data();
+  if (this->file_.size() < kPcapFileHeaderSize) {
+    this->error_ = "not a pcap/pcapng file";
+    return false;
+  }
+
+  uint32_t magic = readLittleEndian32(data);
+  if (magic == PcapngBlock::kSectionHeader) {
+    this->pcapng_ = true;
+    return true;  // the section header is parsed by nextPcapng()
+  }
+
+  if (magic == kPcapMagic || magic == kPcapNanoMagic) {
+    this->swapped_ = false;
+  } else if (swap32(magic) == kPcapMagic || swap32(magic) == kPcapNanoMagic) {
+    this->swapped_ = true;
+  } else {
+    this->error_ = "not a pcap/pcapng file";
+    return false;
+  }
+  magic = this->read32(data);
+  this->nanosecond_ = magic == kPcapNanoMagic;
+  // The upper bits of the link type field carry FCS information.
+  this->linkType_ = this->read32(data + 20) & 0xffff;
+  this->offset_ = kPcapFileHeaderSize;
+  return true;
+}
+
+bool PcapReader::next(PcapRecord* record) {
+  return this->pcapng_ ? this->nextPcapng(record) : this->nextPcap(record);
+}
+
+/*
+  struct pcaprec_hdr_s {
+    uint32 ts_sec;
+    uint32 ts_usec;  // or ts_nsec
+    uint32 incl_len;
+    uint32 orig_len;
+  };
+*/
+bool PcapReader::nextPcap(PcapRecord* record) {
+  size_t size = this->file_.size();
+  if (this->offset_ + kPcapRecordHeaderSize > size) {
+    return false;
+  }
+  const uint8_t* ptr = this->file_.data() + this->offset_;
+  uint32_t seconds = this->read32(ptr);
+  uint32_t fraction = this->read32(ptr + 4);
+  uint32_t length = this->read32(ptr + 8);
+  if (this->offset_ + kPcapRecordHeaderSize + length > size) {
+    this->error_ = "truncated record";
+    return false;
+  }
+
+  record->data = ptr + kPcapRecordHeaderSize;
+  record->length = length;
+  record->originalLength = this->read32(ptr + 12);
+  record->timeUs = int64_t(seconds) * 1000000 +
+                   (this->nanosecond_ ? fraction / 1000 : fraction);
+  record->linkType = this->linkType_;
+  this->offset_ += kPcapRecordHeaderSize + length;
+  return true;
+}
+
+/*
+    0                   1                   2                   3
+    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+   +---------------------------------------------------------------+
+ 0 |                          Block Type                           |
+   +---------------------------------------------------------------+
+ 4 |                      Block Total Length                       |
+   +---------------------------------------------------------------+
+ 8 /                          Block Body                           /
+   +---------------------------------------------------------------+
+   |                      Block Total Length                       |
+   +---------------------------------------------------------------+
+*/
+bool PcapReader::nextPcapng(PcapRecord* record) {
+  size_t size = this->file_.size();
+  while (this->offset_ + kPcapngBlockOverhead <= size) {
+    const uint8_t* block = this->file_.data() + this->offset_;
+    // The section header type reads the same in both byte orders and sets
+    // the byte order of everything up to the next one.
+    if (readLittleEndian32(block) == PcapngBlock::kSectionHeader &&
+        !this->parseSectionHeader(block, size - this->offset_)) {
+      return false;
+    }
+    uint32_t type = this->read32(block);
+
+    uint32_t length = this->read32(block + 4);
+    if (length < kPcapngBlockOverhead || (length & 3) ||
+        this->offset_ + length > size) {
+      this->error_ = "corrupt pcapng block";
+      return false;
+    }
+    this->offset_ += length;
+
+    switch (type) {
+      case PcapngBlock::kInterfaceDescription:
+        this->parseInterface(block, length);
+        break;
+      case PcapngBlock::kEnhancedPacket: {
+        /*
+          interface id, timestamp (high), timestamp (low),
+          captured length, original length, packet data, options
+        */
+        if (length < kPcapngBlockOverhead + 20) {
+          break;
+        }
+        uint32_t id = this->read32(block + 8);
+        uint32_t captured = this->read32(block + 20);
+        if (id >= this->interfaces_.size() ||
+            captured > length - kPcapngBlockOverhead - 20) {
+          break;
+        }
+        const Interface& interface = this->interfaces_[id];
+        uint64_t timestamp =
+            (uint64_t(this->read32(block + 12)) << 32) | this->read32(block + 16);
+        record->data = block + 28;
+        record->length = captured;
+        record->originalLength = this->read32(block + 24);
+        record->timeUs =
+            interface.unitsPerSecond == 1000000
+                ? int64_t(timestamp)
+                : int64_t(timestamp / interface.unitsPerSecond * 1000000 +
+                          timestamp % interface.unitsPerSecond * 1000000 /
+                              interface.unitsPerSecond);
+        record->linkType = interface.linkType;
+        return true;
+      }
+      case PcapngBlock::kSimplePacket: {
+        // Original length, packet data; always refers to interface 0.
+        if (length < kPcapngBlockOverhead + 4 || this->interfaces_.empty()) {
+          break;
+        }
+        uint32_t original = this->read32(block + 8);
+        uint32_t available = length - kPcapngBlockOverhead - 4;
+        record->data = block + 12;
+        record->length = original < available ? original : available;
+        record->originalLength = original;
+        record->timeUs = 0;
+        record->linkType = this->interfaces_[0].linkType;
+        return true;
+      }
+      default:
+        // Name resolution, statistics, custom blocks...
+        break;
+    }
+  }
+  return false;
+}
+
+bool PcapReader::parseSectionHeader(const uint8_t* block, size_t available) {
+  // Block type, block total length, byte-order magic.
+  if (available < kPcapngBlockOverhead + 4) {
+    this->error_ = "truncated section header";
+    return false;
+  }
+  uint32_t magic = readLittleEndian32(block + 8);
+  if (magic == kPcapngByteOrderMagic) {
+    this->swapped_ = false;
+  } else if (swap32(magic) == kPcapngByteOrderMagic) {
+    this->swapped_ = true;
+  } else {
+    this->error_ = "corrupt pcapng section header";
+    return false;
+  }
+  // Interface ids are scoped to their section.
+  this->interfaces_.clear();
+  return true;
+}
+
+/*
+  LinkType (16), Reserved (16), SnapLen (32), options
+*/
+void PcapReader::parseInterface(const uint8_t* block, uint32_t length) {
+  Interface interface;
+  if (length >= kPcapngBlockOverhead + 8) {
+    interface.linkType = this->read16(block + 8);
+  }
+
+  uint32_t offset{16};
+  uint32_t end = length - 4;
+  while (offset + 4 <= end) {
+    uint16_t code = this->read16(block + offset);
+    uint16_t optionLength = this->read16(block + offset + 2);
+    if (code == kOptionEndOfOpt || offset + 4 + optionLength > end) {
+      break;
+    }
+    if (code == kOptionIfTsresol && optionLength >= 1) {
+      // MSB clear: negative power of 10, set: negative power of 2.
+      uint8_t resolution = block[offset + 4];
+      uint8_t exponent = resolution & 0x7f;
+      uint64_t base = (resolution & 0x80) ? 2 : 10;
+      uint64_t unitsPerSecond = 1;
+      for (uint8_t i = 0; i < exponent && unitsPerSecond < (1ull << 60) / base;
+           ++i) {
+        unitsPerSecond *= base;
+      }
+      interface.unitsPerSecond = unitsPerSecond;
+    }
+    offset += 4 + ((optionLength + 3) & ~3u);
+  }
+
+  this->interfaces_.push_back(interface);
+}
+
+uint16_t PcapReader::read16(const uint8_t* ptr) const {
+  uint16_t value = ptr[0] | (ptr[1] << 8);
+  return this->swapped_ ? uint16_t((value >> 8) | (value << 8)) : value;
+}
+
+uint32_t PcapReader::read32(const uint8_t* ptr) const {
+  uint32_t value = readLittleEndian32(ptr);
+  return this->swapped_ ? swap32(value) : value;
+}
+}  // namespace chai
@@ -0,0 +1,66 @@
+#ifndef CHAI_PCAP_READER_H
+#define CHAI_PCAP_READER_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace chai {
+// One captured frame. |data| points into the mapped file and stays valid for
+// as long as the PcapReader is open.
+struct PcapRecord {
+  const uint8_t* data{nullptr};
+  uint32_t length{0};          // captured bytes
+  uint32_t originalLength{0};  // bytes on the wire
+  int64_t timeUs{0};
+  uint16_t linkType{0};  // LINKTYPE_* of the interface
+};
+
+// Sequential reader for pcap (microsecond and nanosecond) and pcapng files of
+// either byte order, on top of a read-only mapping of the whole file.
+class PcapReader {
+ public:
+  bool open(const std::string& path);
+  // Returns false at the end of the file or on a truncated/corrupt record.
+  bool next(PcapRecord* record);
+
+  // Bytes consumed so far, for progress reporting.
+  size_t offset() const { return offset_; }
+  size_t size() const { return file_.size(); }
+  const std::string& error() const { return error_; }
+
+ protected:
+  bool nextPcap(PcapRecord* record);
+  bool nextPcapng(PcapRecord* record);
+  // |available| is what is left of the file from |block|, which may be more
+  // than 4 GB.
+  bool parseSectionHeader(const uint8_t* block, size_t available);
+  void parseInterface(const uint8_t* block, uint32_t length);
+
+  uint16_t read16(const uint8_t* ptr) const;
+  uint32_t read32(const uint8_t* ptr) const;
+
+ private:
+  struct Interface {
+    uint16_t linkType{0};
+    // Timestamp units per second (if_tsresol), 1e6 by default.
+    uint64_t unitsPerSecond{1000000};
+  };
+
+  MappedFile file_;
+  size_t offset_{0};
+  bool pcapng_{false};
+  bool swapped_{false};
+  // pcap only.
+  bool nanosecond_{false};
+  uint16_t linkType_{0};
+  // pcapng only, reset by every section header block.
+  std::vector<Interface> interfaces_;
+  std::string error_;
+};
+}  // namespace chai
+
+#endif  // CHAI_PCAP_READER_H
@@ -32,6 +32,7 @@
 #include <pc/video_track_source.h>
 #include <rtc_base/bit_buffer.h>
 #include <rtc_base/ssl_adapter.h>
+#include <rtc_base/time_utils.h>
 #include <system_wrappers/include/field_trial.h>
 
 #include <algorithm>
@@ -39,16 +40,26 @@
 #include <iomanip>
 #include <iostream>
 #include <sdptransform.hpp>
+#include <thread>
 
 #include "test/vcm_capturer.h"
 #include "ScreenCapturer.h"
 
 using json = nlohmann::json;
 
-const std::string videoMid = "1";
 const size_t kWidth{1920};
 const size_t kHeight{1080};
 const size_t kFps{30};
+// Tapped packets allowed in flight between the network and parse threads.
+// Never larger than a ParseWorker ring, so Post() can't fail for lack of room.
+const size_t kPacketPoolSize{chai::ParseWorker::kRingSize};
+const size_t kMaxParseWorkers{8};
+const uint16_t kRtpFixedHeaderSize{12};
+// Common header plus sender SSRC.
+const uint16_t kRtcpMinSize{8};
+// A receive timestamp further in the past than this was not taken on the
+// rtc::TimeMicros() clock.
+const int64_t kMaxArrivalAgeUs{1000000};
 
 const char kAudioLabel[] = "audio_label";
 const char kVideoLabel[] = "video_label";
@@ -120,6 +131,39 @@ class CapturerTrackSource : public webrtc::VideoTrackSource {
   std::unique_ptr<webrtc::test::VcmCapturer> capturer_{nullptr};
   std::unique_ptr<chai::ScreenCapturer> screenCapturer_{nullptr};
 };
+
+// Send times are stamped with rtc::TimeMicros(), which is monotonic.
+// |packet_time_us| normally comes from the same clock, but it is 0 when the
+// socket doesn't provide it, and a wall-clock time when the socket reports
+// SO_TIMESTAMP. Fall back to the arrival at the tap in both cases, so send
+// and receive times of one session can always be subtracted.
+int64_t ArrivalTimeUs(int64_t packetTimeUs) {
+  int64_t nowUs = rtc::TimeMicros();
+  if (packetTimeUs <= 0 || packetTimeUs > nowUs ||
+      nowUs - packetTimeUs > kMaxArrivalAgeUs) {
+    return nowUs;
+  }
+  return packetTimeUs;
+}
+
+// Transports of the m-sections of the current descriptions, data channels
+// included. JsepTransportController destroys a transport once no m-section
+// maps to it, so these are the ones still alive. Signaling thread.
+std::set<webrtc::RtpTransportInternal*> LiveTransports(
+    webrtc::PeerConnection* pc) {
+  std::set<webrtc::RtpTransportInternal*> transports;
+  for (const auto* desc : {pc->local_description(), pc->remote_description()}) {
+    if (!desc) {
+      continue;
+    }
+    for (const auto& content : desc->description()->contents()) {
+      if (auto* transport = pc->GetRtpTransport(content.name)) {
+        transports.insert(transport);
+      }
+    }
+  }
+  return transports;
+}
 }  // namespace
 
 namespace chai {
@@ -190,12 +234,17 @@ PeerConnection::~PeerConnection() {
       webrtc::PeerConnectionInterface>*>(this->pc.get());
   auto* pc = static_cast<webrtc::PeerConnection*>(pci->internal());
 
-  signalingThread->Invoke<void>(RTC_FROM_HERE, [this, pc] {
-    auto channel = pc->GetRtpTransport(videoMid);
-    if (channel) {
-      channel->rtpTransport = nullptr;
+  // Every transport still alive that a tap is hooked into.
+  std::vector<std::pair<webrtc::RtpTransportInternal*, RtpTransport*>> hooks;
+  signalingThread->Invoke<void>(RTC_FROM_HERE, [this, pc, &hooks] {
+    auto live = LiveTransports(pc);
+    for (const auto& tap : this->taps) {
+      if (live.count(tap.first)) {
+        hooks.emplace_back(tap.first, nullptr);
+      }
     }
   });
+  this->setHooks(hooks);
 }
 
 void PeerConnection::Close() {
@@ -269,8 +318,10 @@ void PeerConnection::SetLocalDescription(webrtc::SdpType type,
   }
 
   this->pc->SetLocalDescription(observer, sessionDescription);
+  future.get();
 
-  return future.get();
+  this->attachTaps();
+  this->updatePayloadTypes();
 }
 
 void PeerConnection::SetRemoteDescription(webrtc::SdpType type,
@@ -297,21 +348,8 @@ void PeerConnection::SetRemoteDescription(webrtc::SdpType type,
   this->pc->SetRemoteDescription(observer, sessionDescription);
   future.get();
 
-  if (typeStr == "answer") {
-    // 新增 rtp回调
-    auto* pci = static_cast<webrtc::PeerConnectionProxyWithInternal<
-        webrtc::PeerConnectionInterface>*>(this->pc.get());
-    auto* pc = static_cast<webrtc::PeerConnection*>(pci->internal());
-
-    signalingThread->Invoke<void>(RTC_FROM_HERE, [this, pc] {
-      auto channel = pc->GetRtpTransport(videoMid);
-      if (this->observer && channel && !this->rtpTransport) {
-        this->rtpTransport.reset(
-            new PeerConnection::RtpTransport(this->observer));
-        channel->rtpTransport = this->rtpTransport.get();
-      }
-    });
-  }
+  this->attachTaps();
+  this->updatePayloadTypes();
 }
 
 std::string PeerConnection::GetLocalDescription() const {
@@ -502,6 +540,183 @@ void PeerConnection::CreateTrack(const cricket::AudioOptions& audio,
   }
 }
 
+void PeerConnection::SetParseHighWaterMark(size_t packets) {
+  this->parseHighWaterMark = packets;
+  for (auto& tap : this->taps) {
+    tap.second.rtpTransport->setParseHighWaterMark(packets);
+  }
+}
+
+bool PeerConnection::StartRtpDump(const std::string& path) {
+  std::unique_ptr<RtpDumpWriter> rtpDump(new RtpDumpWriter);
+  if (!rtpDump->open(path)) {
+    return false;
+  }
+
+  this->StopRtpDump();
+  RtpDumpWriter* writer = rtpDump.get();
+  this->rtpDump = std::move(rtpDump);
+  this->forEachTap([writer](RtpTransport* rtpTransport) {
+    rtpTransport->setRtpDump(writer);
+  });
+  return true;
+}
+
+void PeerConnection::StopRtpDump() {
+  this->forEachTap(
+      [](RtpTransport* rtpTransport) { rtpTransport->setRtpDump(nullptr); });
+  // Flush and close here rather than on the network thread.
+  this->rtpDump.reset();
+}
+
+bool PeerConnection::StartFlightRecorder(const std::string& path,
+                                         uint64_t size) {
+  std::unique_ptr<FlightRecorder> flightRecorder(new FlightRecorder);
+  if (!flightRecorder->open(path, size)) {
+    RTC_LOG(LS_ERROR) << "flight recorder: " << flightRecorder->error();
+    return false;
+  }
+
+  this->StopFlightRecorder();
+  FlightRecorder* recorder = flightRecorder.get();
+  this->flightRecorder = std::move(flightRecorder);
+  this->forEachTap([recorder](RtpTransport* rtpTransport) {
+    rtpTransport->setFlightRecorder(recorder);
+  });
+  return true;
+}
+
+void PeerConnection::StopFlightRecorder() {
+  this->forEachTap([](RtpTransport* rtpTransport) {
+    rtpTransport->setFlightRecorder(nullptr);
+  });
+  // Unmap here rather than on the network thread.
+  this->flightRecorder.reset();
+}
+
+uint64_t PeerConnection::GetTapDrops() {
+  uint64_t drops{0};
+  this->forEachTap([&drops](RtpTransport* rtpTransport) {
+    drops += rtpTransport->poolExhausted();
+  });
+  return drops;
+}
+
+void PeerConnection::attachTaps() {
+  if (!this->observer) {
+    return;
+  }
+
+  auto* pci = static_cast<webrtc::PeerConnectionProxyWithInternal<
+      webrtc::PeerConnectionInterface>*>(this->pc.get());
+  auto* pc = static_cast<webrtc::PeerConnection*>(pci->internal());
+
+  std::vector<std::pair<webrtc::RtpTransportInternal*, RtpTransport*>> hooks;
+  std::vector<std::unique_ptr<RtpTransport>> retired;
+  signalingThread->Invoke<void>(RTC_FROM_HERE, [this, pc, &hooks, &retired] {
+    std::map<webrtc::RtpTransportInternal*, Tap> taps;
+    for (const auto& transceiver : pc->GetTransceivers()) {
+      auto mid = transceiver->mid();
+      if (!mid) {
+        continue;
+      }
+      auto channel = pc->GetRtpTransport(*mid);
+      if (!channel) {
+        continue;
+      }
+
+      Tap& tap = taps[channel];
+      if (!tap.rtpTransport) {
+        auto it = this->taps.find(channel);
+        if (it != this->taps.end()) {
+          tap.rtpTransport = std::move(it->second.rtpTransport);
+        } else {
+          tap.rtpTransport.reset(
+              new PeerConnection::RtpTransport(this->observer));
+          tap.rtpTransport->setParseHighWaterMark(this->parseHighWaterMark);
+          tap.rtpTransport->setRtpDump(this->rtpDump.get());
+          tap.rtpTransport->setFlightRecorder(this->flightRecorder.get());
+        }
+        hooks.emplace_back(channel, tap.rtpTransport.get());
+      }
+      tap.mids.insert(*mid);
+    }
+
+    // Taps whose transport no transceiver uses any more, e.g. once BUNDLE
+    // folded every mid onto the first transport. A transport webrtc keeps,
+    // for a data channel say, gets its hook cleared below; the others were
+    // destroyed on the network thread when the description was applied.
+    auto live = LiveTransports(pc);
+    for (auto& tap : this->taps) {
+      if (tap.second.rtpTransport) {
+        if (live.count(tap.first)) {
+          hooks.emplace_back(tap.first, nullptr);
+        }
+        retired.push_back(std::move(tap.second.rtpTransport));
+      }
+    }
+    this->taps = std::move(taps);
+  });
+  // Once this returns the network thread is done with the retired taps: it
+  // is not inside one and can no longer reach one. Their workers finish what
+  // was posted, then the taps go, pools and threads with them.
+  this->setHooks(hooks);
+  for (auto& rtpTransport : retired) {
+    rtpTransport->drain();
+  }
+  retired.clear();
+
+  for (const auto& tap : this->taps) {
+    std::string mids;
+    for (const auto& mid : tap.second.mids) {
+      mids += (mids.empty() ? "" : ",") + mid;
+    }
+    RTC_LOG(LS_INFO) << "tap on transport for mids " << mids;
+  }
+}
+
+void PeerConnection::forEachTap(std::function<void(RtpTransport*)> fn) {
+  if (this->taps.empty()) {
+    return;
+  }
+  networkThread->Invoke<void>(RTC_FROM_HERE, [this, &fn] {
+    for (auto& tap : this->taps) {
+      fn(tap.second.rtpTransport.get());
+    }
+  });
+}
+
+void PeerConnection::setHooks(
+    const std::vector<std::pair<webrtc::RtpTransportInternal*,
+                                RtpTransport*>>& hooks) {
+  // Invoked even with nothing to set, as a barrier for retired taps.
+  networkThread->Invoke<void>(RTC_FROM_HERE, [&hooks] {
+    for (const auto& hook : hooks) {
+      hook.first->rtpTransport = hook.second;
+    }
+  });
+}
+
+void PeerConnection::updatePayloadTypes() {
+  std::string localSdp;
+  std::string remoteSdp;
+  if (auto* desc = this->pc->local_description()) {
+    desc->ToString(&localSdp);
+  }
+  if (auto* desc = this->pc->remote_description()) {
+    desc->ToString(&remoteSdp);
+  }
+
+  // Each transport only sees the payload types and SSRCs of its own mids.
+  for (auto& tap : this->taps) {
+    auto payloadTypes =
+        PayloadTypeTable::fromSdp(localSdp, remoteSdp, tap.second.mids);
+    if (payloadTypes) {
+      tap.second.rtpTransport->setPayloadTypes(payloadTypes);
+    }
+  }
+}
+
 /* SetSessionDescriptionObserver */
 
 std::future<void> PeerConnection::SetSessionDescriptionObserver::GetFuture() {
@@ -780,7 +995,14 @@ void PeerConnection::PrivateListener::OnInterestingUsage(int /*usagePattern*/) {
 //}
 
 PeerConnection::RtpTransport::RtpTransport(PeerConnectionObserver* observer)
-    : observer(observer) {
+    : packetPool(kPacketPoolSize), observer(observer) {
+  // One worker per core, keeping one core for the network thread.
+  size_t workers = std::thread::hardware_concurrency();
+  workers = std::min(workers > 1 ? workers - 1 : 1, kMaxParseWorkers);
+  for (size_t i = 0; i < workers; ++i) {
+    this->parseWorkers.emplace_back(new ParseWorker(&packetPool, observer));
+  }
+
   // frame_buffer_option_t option;
   // option.initial_time_us = 0;
   // option.start_buffer_size = 64;
@@ -798,73 +1020,135 @@ void PeerConnection::RtpTransport::SendRtpPacket(
     rtc::CopyOnWriteBuffer* packet,
     const rtc::PacketOptions& options,
     int flags) {
-  this->parseRtpPacket(packet);
+  this->parseRtpPacket(packet, Direction::kSend, rtc::TimeMicros());
 }
 
 void PeerConnection::RtpTransport::SendRtcpPacket(
     rtc::CopyOnWriteBuffer* packet,
     const rtc::PacketOptions& options,
     int flags) {
-  // RTC_LOG(LS_VERBOSE) << "SendRtcpPacket:" << packet->size();
+  this->parseRtcpPacket(packet, Direction::kSend, rtc::TimeMicros());
 }
 
 void PeerConnection::RtpTransport::OnRtpPacketReceived(
     rtc::CopyOnWriteBuffer* packet,
     int64_t packet_time_us) {
-  this->parseRtpPacket(packet);
+  this->parseRtpPacket(packet, Direction::kRecv, ArrivalTimeUs(packet_time_us));
 }
 
 void PeerConnection::RtpTransport::OnRtcpPacketReceived(
     rtc::CopyOnWriteBuffer* packet,
-    int64_t packet_time_us) {}
+    int64_t packet_time_us) {
+  this->parseRtcpPacket(packet, Direction::kRecv,
+                        ArrivalTimeUs(packet_time_us));
+}
 
 void PeerConnection::RtpTransport::parseRtpPacket(
-    rtc::CopyOnWriteBuffer* packet) {
-  if (parseQueue == nullptr) {
-    auto task_queue_factory = webrtc::CreateDefaultTaskQueueFactory();
-    parseQueue = new rtc::TaskQueue(task_queue_factory->CreateTaskQueue(
-        "parsePacket", webrtc::TaskQueueFactory::Priority::LOW));
+    rtc::CopyOnWriteBuffer* packet,
+    Direction direction,
+    int64_t timeUs) {
+  if (packet->size() < kRtpFixedHeaderSize) {
+    return;
   }
 
-  std::unique_ptr<uint8_t> buff(new uint8_t[packet->size()]);
-  uint32_t len = packet->size();
-  memcpy(buff.get(), packet->data(), len);
+  if (this->rtpDump) {
+    this->rtpDump->write(packet->cdata(), packet->size(), false);
+  }
+  if (this->flightRecorder) {
+    this->flightRecorder->append(packet->cdata(), packet->size(),
+                                 PacketKind::kRtp, direction, timeUs);
+  }
 
-  uint8_t payloadType = buff.get()[1] & 0x7f;
-  switch (payloadType) {
-    case Subtype::FLEXFEC:
-      payloadType = buff.get()[1] & 0x7f;
-      break;
+  uint32_t ssrc =
+      webrtc::ByteReader<uint32_t>::ReadBigEndian(packet->cdata() + 8);
+  this->post(packet, ssrc, PacketKind::kRtp, direction, timeUs);
+}
+
+void PeerConnection::RtpTransport::parseRtcpPacket(
+    rtc::CopyOnWriteBuffer* packet,
+    Direction direction,
+    int64_t timeUs) {
+  if (packet->size() < kRtcpMinSize) {
+    return;
   }
 
-  parseQueue->PostTask([this, buff = std::move(buff), len]() {
-    uint8_t payloadType = buff.get()[1] & 0x7f;
-
-    // parse payload
-    nlohmann::json json;
-    switch (payloadType) {
-      case Subtype::OPUS:  // opus
-      case Subtype::H264:  // h264
-      case Subtype::AV1:
-      case Subtype::FLEXFEC: {
-        json = this->rtpPacket.parse(buff.get(), len);
-        break;
-      } 
-      case Subtype::H264_RTX:  // rtx
-      case Subtype::AV1_RTX: {
-        RtxPacket rtx;
-        json = rtx.parse(buff.get(), len);
-        break;
-      } 
-      case Subtype::TEST: {
-        return;
-      }
-      default: {
-        return;
-      }
+  if (this->rtpDump) {
+    this->rtpDump->write(packet->cdata(), packet->size(), true);
+  }
+  if (this->flightRecorder) {
+    this->flightRecorder->append(packet->cdata(), packet->size(),
+                                 PacketKind::kRtcp, direction, timeUs);
+  }
+
+  // Sender SSRC of the first packet in the compound, so the reports of one
+  // sender stay in order on one worker.
+  uint32_t ssrc =
+      webrtc::ByteReader<uint32_t>::ReadBigEndian(packet->cdata() + 4);
+  this->post(packet, ssrc, PacketKind::kRtcp, direction, timeUs);
+}
+
+void PeerConnection::RtpTransport::post(rtc::CopyOnWriteBuffer* packet,
+                                        uint32_t ssrc,
+                                        PacketKind kind,
+                                        Direction direction,
+                                        int64_t timeUs) {
+  // Keep a reference to the network buffer instead of copying it.
+  PacketSlot* slot = this->packetPool.Acquire();
+  if (slot == nullptr) {
+    if (kind == PacketKind::kRtp) {
+      ++this->droppedBySsrc[ssrc];
     }
-    this->observer->onRtpPakcet(json);
-  });
+    uint64_t exhausted = this->packetPool.exhausted();
+    if ((exhausted & (exhausted - 1)) == 0) {
+      RTC_LOG(LS_WARNING) << "packet pool exhausted, dropped " << exhausted
+                          << " packets";
+    }
+    return;
+  }
+  slot->buffer = *packet;
+  slot->data = slot->buffer.cdata();
+  slot->size = slot->buffer.size();
+  slot->timeUs = timeUs;
+  slot->kind = kind;
+  slot->direction = direction;
+
+  // Drops are reported with the next RTP packet of the same stream.
+  auto dropped = this->droppedBySsrc.end();
+  if (kind == PacketKind::kRtp) {
+    dropped = this->droppedBySsrc.find(ssrc);
+  }
+  if (dropped != this->droppedBySsrc.end()) {
+    slot->dropped = dropped->second;
+    dropped->second = 0;
+  }
+
+  // Shard by SSRC so every stream is parsed in order by one worker.
+  auto& worker = this->parseWorkers[ssrc % this->parseWorkers.size()];
+  if (!worker->Post(slot)) {
+    if (kind == PacketKind::kRtp) {
+      this->droppedBySsrc[ssrc] += slot->dropped + 1;
+    }
+    this->packetPool.Release(slot);
+  }
+}
+
+void PeerConnection::RtpTransport::setParseHighWaterMark(size_t packets) {
+  for (auto& worker : this->parseWorkers) {
+    worker->setHighWaterMark(packets);
+  }
+}
+
+void PeerConnection::RtpTransport::drain() {
+  for (auto& worker : this->parseWorkers) {
+    worker->Drain();
+  }
+}
+
+void PeerConnection::RtpTransport::setPayloadTypes(
+    std::shared_ptr<const PayloadTypeTable> payloadTypes) {
+  for (auto& worker : this->parseWorkers) {
+    worker->setPayloadTypes(payloadTypes);
+  }
 }
 
 }  // namespace chai
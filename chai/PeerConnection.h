@@ -4,29 +4,26 @@
 #include <api/peer_connection_interface.h>  // webrtc::PeerConnectionInterface
 #include <pc/peer_connection.h>
 
+#include <functional>
 #include <future>  // std::promise, std::future
 #include <json.hpp>
+#include <map>
 #include <memory>  // std::unique_ptr
+#include <set>
+#include <unordered_map>
 
+#include "FlightRecorder.h"
+#include "PacketPool.h"
+#include "ParseWorker.h"
+#include "RtpDumpWriter.h"
 #include "RtpPakcet.h"
 //#include "../zx/frame_buffer.h"
 
 namespace chai {
-enum Subtype : uint8_t {
-  OPUS = 111,
-  H264 = 124,
-  H264_RTX = 107,
-  AV1 = 35,
-  AV1_RTX = 36,
-  FLEXFEC = 115,
-  TEST = 127
-};
-
-class PeerConnectionObserver {
+// Receives the parse results of the packets tapped on the PeerConnection.
+class PeerConnectionObserver : public ParseObserver {
  public:
   virtual ~PeerConnectionObserver() = default;
-  virtual void onRtpPakcet(nlohmann::json& json) = 0;
-  virtual void onRtcpPakcet(nlohmann::json& json) = 0;
 };
 
 class PeerConnection {
@@ -72,6 +69,21 @@ class PeerConnection {
   void CreateTrack(const cricket::AudioOptions& audio,
                    const cricket::VideoOptions& video);
 
+  // Parse backlog, in packets per parse worker, above which tapped packets
+  // are only parsed down to the RTP header until the backlog drains.
+  void SetParseHighWaterMark(size_t packets);
+  // Record the tapped RTP/RTCP, both directions, to an rtpdump file.
+  bool StartRtpDump(const std::string& path);
+  void StopRtpDump();
+  // Keep the last |size| bytes of tapped RTP/RTCP in a memory-mapped ring
+  // file, see FlightRecorder.
+  bool StartFlightRecorder(const std::string& path, uint64_t size);
+  void StopFlightRecorder();
+  // Tapped packets the live taps dropped because their packet pool ran dry,
+  // i.e. the parse workers fell behind. RTP drops also show per stream in
+  // RtpRecord::dropped; this counts RTCP too.
+  uint64_t GetTapDrops();
+
  protected:
   class PrivateListener : public webrtc::PeerConnectionObserver {
     /* Virtual methods inherited from PeerConnectionObserver. */
@@ -177,17 +189,65 @@ class PeerConnection {
     void OnRtcpPacketReceived(rtc::CopyOnWriteBuffer* packet,
                               int64_t packet_time_us) override;
 
-    void parseRtpPacket(rtc::CopyOnWriteBuffer* packet);
+    void parseRtpPacket(rtc::CopyOnWriteBuffer* packet,
+                        Direction direction,
+                        int64_t timeUs);
+    void parseRtcpPacket(rtc::CopyOnWriteBuffer* packet,
+                         Direction direction,
+                         int64_t timeUs);
+    void setParseHighWaterMark(size_t packets);
+    // Blocks until the workers have parsed every packet posted so far. Only
+    // once nothing posts any more, i.e. after the tap is unhooked.
+    void drain();
+    void setPayloadTypes(std::shared_ptr<const PayloadTypeTable> payloadTypes);
+    // Network thread only. Both are shared by every transport of the
+    // PeerConnection, which all run on the network thread.
+    void setRtpDump(RtpDumpWriter* rtpDump) { this->rtpDump = rtpDump; }
+    void setFlightRecorder(FlightRecorder* flightRecorder) {
+      this->flightRecorder = flightRecorder;
+    }
+
+    // How many tapped packets were dropped because every pool slot was still
+    // waiting on the parse queue.
+    uint64_t poolExhausted() const { return packetPool.exhausted(); }
 
    private:
-    // frame_buffer_t frameBuffer;
-    RtpPacket rtpPacket;
+    void post(rtc::CopyOnWriteBuffer* packet,
+              uint32_t ssrc,
+              PacketKind kind,
+              Direction direction,
+              int64_t timeUs);
 
-    rtc::TaskQueue* parseQueue{nullptr};
+    // frame_buffer_t frameBuffer;
+    PacketPool packetPool;
+    std::vector<std::unique_ptr<ParseWorker>> parseWorkers;
+    // Network thread only: drops per SSRC not yet reported to a worker.
+    std::unordered_map<uint32_t, uint32_t> droppedBySsrc;
+    RtpDumpWriter* rtpDump{nullptr};
+    FlightRecorder* flightRecorder{nullptr};
     PeerConnectionObserver* observer{nullptr};
   };
 
+  // The tap of one webrtc transport, with its own parse pipeline. With
+  // BUNDLE there is a single transport carrying every mid.
+  struct Tap {
+    std::unique_ptr<RtpTransport> rtpTransport;
+    std::set<std::string> mids;
+  };
+
  private:
+  // Hooks a tap into every transport the transceivers use, including the
+  // ones added by a renegotiation.
+  void attachTaps();
+  // Rebuilds the payload type tables from the current descriptions.
+  void updatePayloadTypes();
+  // Runs |fn| on the network thread for every tap.
+  void forEachTap(std::function<void(RtpTransport*)> fn);
+  // Points the tap hook of each transport at its tap, or clears it, on the
+  // network thread, which reads it for every packet.
+  void setHooks(const std::vector<std::pair<webrtc::RtpTransportInternal*,
+                                            RtpTransport*>>& hooks);
+
   // Signaling and worker threads.
   static std::unique_ptr<rtc::Thread> networkThread;
   static std::unique_ptr<rtc::Thread> signalingThread;
@@ -197,7 +257,10 @@ class PeerConnection {
       peerConnectionFactory;
 
   // PeerConnection instance.
-  std::unique_ptr<RtpTransport> rtpTransport{nullptr};
+  std::map<webrtc::RtpTransportInternal*, Tap> taps;
+  size_t parseHighWaterMark{ParseWorker::kDefaultHighWaterMark};
+  std::unique_ptr<RtpDumpWriter> rtpDump;
+  std::unique_ptr<FlightRecorder> flightRecorder;
   PeerConnectionObserver* observer{nullptr};
   std::unique_ptr<PrivateListener> privateListener{new PrivateListener};
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> pc{nullptr};
@@ -0,0 +1,564 @@
+#define MSC_CLASS "RtcpPacket"
+
+#include "RtcpPacket.h"
+
+#include <modules/rtp_rtcp/source/byte_io.h>
+
+#include <string.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+const uint16_t kCommonHeaderSize{4};
+const uint16_t kReportBlockSize{24};
+const uint16_t kFeedbackHeaderSize{12};  // common header + sender/media SSRC
+
+enum PacketType : uint8_t {
+  kSr = 200,
+  kRr = 201,
+  kSdes = 202,
+  kBye = 203,
+  kApp = 204,
+  kRtpfb = 205,
+  kPsfb = 206,
+  kXr = 207,
+};
+
+const std::map<uint8_t, std::string> packetType2String = {
+    {kSr, "SR"},       {kRr, "RR"},       {kSdes, "SDES"}, {kBye, "BYE"},
+    {kApp, "APP"},     {kRtpfb, "RTPFB"}, {kPsfb, "PSFB"}, {kXr, "XR"},
+};
+
+const std::map<uint8_t, std::string> sdesItem2String = {
+    {1, "cname"}, {2, "name"}, {3, "email"}, {4, "phone"},
+    {5, "loc"},   {6, "tool"}, {7, "note"},  {8, "priv"},
+};
+
+const std::map<uint8_t, std::string> rtpfbFmt2String = {
+    {1, "Generic NACK"},
+    {3, "TMMBR"},
+    {4, "TMMBN"},
+    {15, "transport-cc"},
+};
+
+const std::map<uint8_t, std::string> psfbFmt2String = {
+    {1, "PLI"},
+    {2, "SLI"},
+    {3, "RPSI"},
+    {4, "FIR"},
+    {15, "AFB"},
+};
+
+std::string toString(uint8_t value,
+                     const std::map<uint8_t, std::string>& names) {
+  std::ostringstream oss;
+  auto it = names.find(value);
+  oss << uint16_t(value) << "("
+      << (it != names.end() ? it->second : "unknown") << ")";
+  return oss.str();
+}
+}  // namespace
+
+namespace chai {
+/*
+        0                   1                   2                   3
+        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |V=2|P|  count  |      PT       |             length            |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*/
+nlohmann::json RtcpPacket::parse(const uint8_t* buff, uint16_t length) {
+  nlohmann::json compound = {
+      {"length", length},
+      {"packets", nlohmann::json::array()},
+  };
+
+  uint16_t offset{0};
+  while (offset + kCommonHeaderSize <= length) {
+    const uint8_t* ptr = buff + offset;
+    uint8_t version = ptr[0] >> 6;
+    uint8_t padding = (ptr[0] >> 5) & 0x1;
+    uint8_t count = ptr[0] & 0x1f;
+    uint8_t packetType = ptr[1];
+    uint32_t size =
+        (webrtc::ByteReader<uint16_t>::ReadBigEndian(ptr + 2) + 1u) * 4;
+
+    nlohmann::json packet = {
+        {"version", version},
+        {"padding", padding},
+        {"count", count},
+        {"packet_type", toString(packetType, packetType2String)},
+        {"length", size},
+    };
+    if (version != 2 || offset + size > length) {
+      packet["error"] = "malformed";
+      compound["packets"].push_back(packet);
+      break;
+    }
+
+    uint16_t len = size;
+    if (padding) {
+      // 最后一个字节为填充长度
+      uint8_t paddingLength = ptr[size - 1];
+      packet["padding_length"] = paddingLength;
+      len = paddingLength < size ? size - paddingLength : kCommonHeaderSize;
+    }
+
+    nlohmann::json body;
+    switch (packetType) {
+      case kSr:
+        body = parseSr(ptr, len, count);
+        break;
+      case kRr:
+        body = parseRr(ptr, len, count);
+        break;
+      case kSdes:
+        body = parseSdes(ptr, len, count);
+        break;
+      case kBye:
+        body = parseBye(ptr, len, count);
+        break;
+      case kApp:
+        body = parseApp(ptr, len, count);
+        break;
+      case kRtpfb:
+        body = parseRtpfb(ptr, len, count);
+        break;
+      case kPsfb:
+        body = parsePsfb(ptr, len, count);
+        break;
+      default:
+        break;
+    }
+    if (body.is_object()) {
+      packet.update(body);
+    }
+    compound["packets"].push_back(packet);
+
+    offset += size;
+  }
+
+  return compound;
+}
+
+/*
+        0                   1                   2                   3
+        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+header |V=2|P|    RC   |   PT=SR=200   |             length            |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                         SSRC of sender                        |
+       +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+sender |              NTP timestamp, most significant word             |
+info   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |             NTP timestamp, least significant word             |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                         RTP timestamp                         |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                     sender's packet count                     |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                      sender's octet count                     |
+       +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+       |                 report blocks (RC * 24 bytes)                 |
+*/
+nlohmann::json RtcpPacket::parseSr(const uint8_t* buff,
+                                   uint16_t length,
+                                   uint8_t count) {
+  const uint16_t kSrHeaderSize{28};
+  if (length < kSrHeaderSize) {
+    return {{"error", "truncated"}};
+  }
+  nlohmann::json sr = {
+      {"sender_ssrc", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 4)},
+      {"ntp_sec", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 8)},
+      {"ntp_frac", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 12)},
+      {"rtp_timestamp", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 16)},
+      {"packet_count", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 20)},
+      {"octet_count", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 24)},
+  };
+  sr["report_blocks"] = parseReportBlocks(
+      buff + kSrHeaderSize, length - kSrHeaderSize, count);
+  return sr;
+}
+
+nlohmann::json RtcpPacket::parseRr(const uint8_t* buff,
+                                   uint16_t length,
+                                   uint8_t count) {
+  const uint16_t kRrHeaderSize{8};
+  if (length < kRrHeaderSize) {
+    return {{"error", "truncated"}};
+  }
+  return {
+      {"sender_ssrc", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 4)},
+      {"report_blocks", parseReportBlocks(buff + kRrHeaderSize,
+                                          length - kRrHeaderSize, count)},
+  };
+}
+
+/*
+        0                   1                   2                   3
+        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+       +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+report |                 SSRC_1 (SSRC of first source)                 |
+block  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  1    | fraction lost |       cumulative number of packets lost       |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |           extended highest sequence number received           |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                      interarrival jitter                      |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                         last SR (LSR)                         |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                   delay since last SR (DLSR)                  |
+       +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+*/
+nlohmann::json RtcpPacket::parseReportBlocks(const uint8_t* buff,
+                                             uint16_t length,
+                                             uint8_t count) {
+  nlohmann::json blocks = nlohmann::json::array();
+  for (uint8_t i = 0; i < count && (i + 1) * kReportBlockSize <= length; ++i) {
+    const uint8_t* ptr = buff + i * kReportBlockSize;
+    // 累计丢包数是24位有符号数
+    int32_t cumulativeLost =
+        webrtc::ByteReader<int32_t, 3>::ReadBigEndian(ptr + 5);
+    blocks.push_back({
+        {"ssrc", webrtc::ByteReader<uint32_t>::ReadBigEndian(ptr)},
+        {"fraction_lost", ptr[4]},
+        {"cumulative_lost", cumulativeLost},
+        {"extended_highest_sequence_number",
+         webrtc::ByteReader<uint32_t>::ReadBigEndian(ptr + 8)},
+        {"jitter", webrtc::ByteReader<uint32_t>::ReadBigEndian(ptr + 12)},
+        {"last_sr", webrtc::ByteReader<uint32_t>::ReadBigEndian(ptr + 16)},
+        {"delay_since_last_sr",
+         webrtc::ByteReader<uint32_t>::ReadBigEndian(ptr + 20)},
+    });
+  }
+  return blocks;
+}
+
+/*
+        0                   1                   2                   3
+        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+header |V=2|P|    SC   |  PT=SDES=202  |             length            |
+       +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+chunk  |                          SSRC/CSRC_1                          |
+  1    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                           SDES items                          |
+       |                              ...                              |
+       +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+*/
+nlohmann::json RtcpPacket::parseSdes(const uint8_t* buff,
+                                     uint16_t length,
+                                     uint8_t count) {
+  nlohmann::json chunks = nlohmann::json::array();
+  uint16_t offset{kCommonHeaderSize};
+  for (uint8_t i = 0; i < count && offset + 4 <= length; ++i) {
+    nlohmann::json chunk = {
+        {"ssrc", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + offset)},
+        {"items", nlohmann::json::array()},
+    };
+    offset += 4;
+    while (offset < length && buff[offset] != 0) {
+      if (offset + 2 > length || offset + 2 + buff[offset + 1] > length) {
+        chunk["error"] = "truncated";
+        offset = length;
+        break;
+      }
+      uint8_t type = buff[offset];
+      uint8_t len = buff[offset + 1];
+      chunk["items"].push_back({
+          {"type", toString(type, sdesItem2String)},
+          {"value", std::string(reinterpret_cast<const char*>(buff + offset + 2),
+                                len)},
+      });
+      offset += 2 + len;
+    }
+    // 以0结束，并填充到32位边界
+    offset = (offset + 4) & ~3;
+    chunks.push_back(chunk);
+  }
+  return {{"chunks", chunks}};
+}
+
+nlohmann::json RtcpPacket::parseBye(const uint8_t* buff,
+                                    uint16_t length,
+                                    uint8_t count) {
+  nlohmann::json bye = {{"ssrc", nlohmann::json::array()}};
+  uint16_t offset{kCommonHeaderSize};
+  for (uint8_t i = 0; i < count && offset + 4 <= length; ++i) {
+    bye["ssrc"].push_back(
+        webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + offset));
+    offset += 4;
+  }
+  if (offset < length && offset + 1 + buff[offset] <= length) {
+    bye["reason"] = std::string(
+        reinterpret_cast<const char*>(buff + offset + 1), buff[offset]);
+  }
+  return bye;
+}
+
+/*
+        0                   1                   2                   3
+        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |V=2|P| subtype |   PT=APP=204  |             length            |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                           SSRC/CSRC                           |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                          name (ASCII)                         |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                   application-dependent data                ...
+*/
+nlohmann::json RtcpPacket::parseApp(const uint8_t* buff,
+                                    uint16_t length,
+                                    uint8_t subtype) {
+  const uint16_t kAppHeaderSize{12};
+  if (length < kAppHeaderSize) {
+    return {{"error", "truncated"}};
+  }
+  return {
+      {"subtype", subtype},
+      {"ssrc", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 4)},
+      {"name", std::string(reinterpret_cast<const char*>(buff + 8), 4)},
+      {"data_length", length - kAppHeaderSize},
+  };
+}
+
+/*
+        0                   1                   2                   3
+        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |V=2|P|   FMT   |       PT      |          length               |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                  SSRC of packet sender                        |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                  SSRC of media source                         |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       :            Feedback Control Information (FCI)                 :
+*/
+nlohmann::json RtcpPacket::parseRtpfb(const uint8_t* buff,
+                                      uint16_t length,
+                                      uint8_t fmt) {
+  if (length < kFeedbackHeaderSize) {
+    return {{"error", "truncated"}};
+  }
+  nlohmann::json fb = {
+      {"fmt", toString(fmt, rtpfbFmt2String)},
+      {"sender_ssrc", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 4)},
+      {"media_ssrc", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 8)},
+  };
+  const uint8_t* fci = buff + kFeedbackHeaderSize;
+  uint16_t fciLength = length - kFeedbackHeaderSize;
+  switch (fmt) {
+    case 1:
+      fb["nack"] = parseNack(fci, fciLength);
+      break;
+    case 15:
+      fb["transport_cc"] = parseTransportCc(fci, fciLength);
+      break;
+    default:
+      fb["fci_length"] = fciLength;
+      break;
+  }
+  return fb;
+}
+
+nlohmann::json RtcpPacket::parsePsfb(const uint8_t* buff,
+                                     uint16_t length,
+                                     uint8_t fmt) {
+  if (length < kFeedbackHeaderSize) {
+    return {{"error", "truncated"}};
+  }
+  nlohmann::json fb = {
+      {"fmt", toString(fmt, psfbFmt2String)},
+      {"sender_ssrc", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 4)},
+      {"media_ssrc", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 8)},
+  };
+  const uint8_t* fci = buff + kFeedbackHeaderSize;
+  uint16_t fciLength = length - kFeedbackHeaderSize;
+  switch (fmt) {
+    case 1:  // PLI 没有FCI
+      break;
+    case 4:
+      fb["fir"] = parseFir(fci, fciLength);
+      break;
+    case 15:
+      if (fciLength >= 4 && memcmp(fci, "REMB", 4) == 0) {
+        fb["remb"] = parseRemb(fci, fciLength);
+      } else {
+        fb["fci_length"] = fciLength;
+      }
+      break;
+    default:
+      fb["fci_length"] = fciLength;
+      break;
+  }
+  return fb;
+}
+
+/*
+        0                   1                   2                   3
+        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |            PID                |             BLP               |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*/
+nlohmann::json RtcpPacket::parseNack(const uint8_t* buff, uint16_t length) {
+  nlohmann::json lost = nlohmann::json::array();
+  for (uint16_t offset = 0; offset + 4 <= length; offset += 4) {
+    uint16_t pid = webrtc::ByteReader<uint16_t>::ReadBigEndian(buff + offset);
+    uint16_t blp =
+        webrtc::ByteReader<uint16_t>::ReadBigEndian(buff + offset + 2);
+    lost.push_back(pid);
+    for (uint16_t i = 0; i < 16; ++i) {
+      if (blp & (1 << i)) {
+        lost.push_back(uint16_t(pid + i + 1));
+      }
+    }
+  }
+  return {{"lost", lost}};
+}
+
+/*
+        0                   1                   2                   3
+        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |      base sequence number     |      packet status count      |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                 reference time                | fb pkt. count |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |          packet chunk         |         packet chunk          |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       .                                                               .
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |         packet chunk          |  recv delta   |  recv delta   |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       .                                                               .
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |           recv delta          |  recv delta   | zero padding  |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*/
+nlohmann::json RtcpPacket::parseTransportCc(const uint8_t* buff,
+                                            uint16_t length) {
+  const uint16_t kTransportCcHeaderSize{8};
+  const int64_t kDeltaScaleUs{250};
+  const int64_t kReferenceTimeScaleMs{64};
+  if (length < kTransportCcHeaderSize) {
+    return {{"error", "truncated"}};
+  }
+
+  uint16_t baseSeq = webrtc::ByteReader<uint16_t>::ReadBigEndian(buff);
+  uint16_t statusCount = webrtc::ByteReader<uint16_t>::ReadBigEndian(buff + 2);
+  int32_t referenceTime = webrtc::ByteReader<int32_t, 3>::ReadBigEndian(buff + 4);
+  uint8_t fbPktCount = buff[7];
+  nlohmann::json cc = {
+      {"base_sequence_number", baseSeq},
+      {"packet_status_count", statusCount},
+      {"reference_time_ms", referenceTime * kReferenceTimeScaleMs},
+      {"fb_pkt_count", fbPktCount},
+  };
+
+  // 0: not received, 1: small delta, 2: large or negative delta
+  std::vector<uint8_t> symbols;
+  symbols.reserve(statusCount);
+  uint16_t offset{kTransportCcHeaderSize};
+  while (symbols.size() < statusCount && offset + 2 <= length) {
+    uint16_t chunk = webrtc::ByteReader<uint16_t>::ReadBigEndian(buff + offset);
+    offset += 2;
+    if ((chunk & 0x8000) == 0) {
+      // Run length chunk: |T|S|  run length  |
+      uint8_t symbol = (chunk >> 13) & 0x3;
+      uint16_t run = chunk & 0x1fff;
+      for (uint16_t i = 0; i < run && symbols.size() < statusCount; ++i) {
+        symbols.push_back(symbol);
+      }
+    } else if ((chunk & 0x4000) == 0) {
+      // Status vector chunk, 14 one-bit symbols.
+      for (int i = 13; i >= 0 && symbols.size() < statusCount; --i) {
+        symbols.push_back((chunk >> i) & 0x1);
+      }
+    } else {
+      // Status vector chunk, 7 two-bit symbols.
+      for (int i = 6; i >= 0 && symbols.size() < statusCount; --i) {
+        symbols.push_back((chunk >> (i * 2)) & 0x3);
+      }
+    }
+  }
+
+  nlohmann::json received = nlohmann::json::array();
+  nlohmann::json lost = nlohmann::json::array();
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    uint16_t seq = baseSeq + i;
+    if (symbols[i] == 1 && offset + 1 <= length) {
+      received.push_back({{"seq", seq}, {"delta_us", buff[offset] * kDeltaScaleUs}});
+      offset += 1;
+    } else if (symbols[i] == 2 && offset + 2 <= length) {
+      int16_t delta = webrtc::ByteReader<int16_t>::ReadBigEndian(buff + offset);
+      received.push_back({{"seq", seq}, {"delta_us", delta * kDeltaScaleUs}});
+      offset += 2;
+    } else if (symbols[i] == 0) {
+      lost.push_back(seq);
+    } else {
+      cc["error"] = "truncated";
+      break;
+    }
+  }
+  cc["received"] = received;
+  cc["lost"] = lost;
+  return cc;
+}
+
+/*
+        0                   1                   2                   3
+        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |                              SSRC                             |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       | Seq nr.       |    Reserved                                   |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*/
+nlohmann::json RtcpPacket::parseFir(const uint8_t* buff, uint16_t length) {
+  nlohmann::json entries = nlohmann::json::array();
+  for (uint16_t offset = 0; offset + 8 <= length; offset += 8) {
+    entries.push_back({
+        {"ssrc", webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + offset)},
+        {"seq_nr", buff[offset + 4]},
+    });
+  }
+  return entries;
+}
+
+/*
+        0                   1                   2                   3
+        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |  Unique identifier 'R' 'E' 'M' 'B'                            |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |  Num SSRC     | BR Exp    |  BR Mantissa                      |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |   SSRC feedback                                               |
+       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       |  ...                                                          |
+*/
+nlohmann::json RtcpPacket::parseRemb(const uint8_t* buff, uint16_t length) {
+  if (length < 8) {
+    return {{"error", "truncated"}};
+  }
+  uint8_t numSsrc = buff[4];
+  uint8_t exponent = buff[5] >> 2;
+  uint32_t mantissa =
+      webrtc::ByteReader<uint32_t, 3>::ReadBigEndian(buff + 5) & 0x3ffff;
+  nlohmann::json remb = {
+      {"bitrate_bps", uint64_t(mantissa) << exponent},
+      {"ssrc", nlohmann::json::array()},
+  };
+  for (uint8_t i = 0; i < numSsrc && 8 + (i + 1) * 4 <= length; ++i) {
+    remb["ssrc"].push_back(
+        webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 8 + i * 4));
+  }
+  return remb;
+}
+}  // namespace chai
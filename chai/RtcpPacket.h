@@ -0,0 +1,35 @@
+#ifndef CHAI_RTCP_PACKET_H
+#define CHAI_RTCP_PACKET_H
+
+#include <stdint.h>
+
+#include <json.hpp>
+
+namespace chai {
+// Parser for RTCP compound packets (RFC 3550, RFC 4585, RFC 5104,
+// draft-alvestrand-rmcat-remb, draft-holmer-rmcat-transport-wide-cc).
+// Stateless: one instance can be reused for any number of packets.
+class RtcpPacket {
+ public:
+  nlohmann::json parse(const uint8_t* buff, uint16_t length);
+
+ protected:
+  nlohmann::json parseSr(const uint8_t* buff, uint16_t length, uint8_t count);
+  nlohmann::json parseRr(const uint8_t* buff, uint16_t length, uint8_t count);
+  nlohmann::json parseReportBlocks(const uint8_t* buff,
+                                   uint16_t length,
+                                   uint8_t count);
+  nlohmann::json parseSdes(const uint8_t* buff, uint16_t length, uint8_t count);
+  nlohmann::json parseBye(const uint8_t* buff, uint16_t length, uint8_t count);
+  nlohmann::json parseApp(const uint8_t* buff, uint16_t length, uint8_t subtype);
+  nlohmann::json parseRtpfb(const uint8_t* buff, uint16_t length, uint8_t fmt);
+  nlohmann::json parsePsfb(const uint8_t* buff, uint16_t length, uint8_t fmt);
+
+  nlohmann::json parseNack(const uint8_t* buff, uint16_t length);
+  nlohmann::json parseTransportCc(const uint8_t* buff, uint16_t length);
+  nlohmann::json parseFir(const uint8_t* buff, uint16_t length);
+  nlohmann::json parseRemb(const uint8_t* buff, uint16_t length);
+};
+}  // namespace chai
+
+#endif  // CHAI_RTCP_PACKET_H
@@ -0,0 +1,97 @@
+#include "RtpDumpReader.h"
+
+#include <string.h>
+
+namespace {
+const char kFirstLine[] = "#!rtpplay1.0 ";
+const size_t kFirstLineMax{256};
+const size_t kFileHeaderSize{16};
+const size_t kPacketHeaderSize{8};
+
+uint16_t read16(const uint8_t* ptr) {
+  return (ptr[0] << 8) | ptr[1];
+}
+
+uint32_t read32(const uint8_t* ptr) {
+  return (uint32_t(ptr[0]) << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3];
+}
+}  // namespace
+
+namespace chai {
+bool RtpDumpReader::probe(const uint8_t* data, size_t size) {
+  return size >= sizeof(kFirstLine) - 1 &&
+         memcmp(data, kFirstLine, sizeof(kFirstLine) - 1) == 0;
+}
+
+/*
+  "#!rtpplay1.0 address/port\n"
+  struct RD_hdr_t {
+    uint32 start_sec;
+    uint32 start_usec;
+    uint32 source;  // network byte order
+    uint16 port;
+    uint16 padding;
+  };
+*/
+bool RtpDumpReader::open(const std::string& path) {
+  if (!this->file_.open(path)) {
+    this->error_ = this->file_.error();
+    return false;
+  }
+
+  const uint8_t* data = this->file_.data();
+  size_t size = this->file_.size();
+  if (!probe(data, size)) {
+    this->error_ = "not an rtpdump file";
+    return false;
+  }
+  const uint8_t* end = static_cast<const uint8_t*>(
+      memchr(data, '\n', size < kFirstLineMax ? size : kFirstLineMax));
+  if (end == nullptr) {
+    this->error_ = "not an rtpdump file";
+    return false;
+  }
+  this->source_.assign(reinterpret_cast<const char*>(data) +
+                           sizeof(kFirstLine) - 1,
+                       reinterpret_cast<const char*>(end));
+
+  this->offset_ = end - data + 1;
+  if (this->offset_ + kFileHeaderSize > size) {
+    this->error_ = "truncated rtpdump header";
+    return false;
+  }
+  const uint8_t* header = data + this->offset_;
+  this->startUs_ = int64_t(read32(header)) * 1000000 + read32(header + 4);
+  this->offset_ += kFileHeaderSize;
+  return true;
+}
+
+/*
+  struct RD_packet_t {
+    uint16 length;  // header plus data
+    uint16 plen;    // RTP packet length, 0 for RTCP
+    uint32 offset;  // ms since the start of the recording
+  };
+*/
+bool RtpDumpReader::next(RtpDumpRecord* record) {
+  size_t size = this->file_.size();
+  if (this->offset_ + kPacketHeaderSize > size) {
+    return false;
+  }
+  const uint8_t* ptr = this->file_.data() + this->offset_;
+  uint16_t length = read16(ptr);
+  uint16_t plen = read16(ptr + 2);
+  if (length < kPacketHeaderSize || this->offset_ + length > size) {
+    this->error_ = "corrupt record";
+    return false;
+  }
+
+  record->data = ptr + kPacketHeaderSize;
+  record->length = length - kPacketHeaderSize;
+  record->originalLength = plen ? plen : record->length;
+  record->rtcp = plen == 0;
+  record->timeUs = this->startUs_ + int64_t(read32(ptr + 4)) * 1000;
+  this->offset_ += length;
+  return true;
+}
+}  // namespace chai
@@ -0,0 +1,45 @@
+#ifndef CHAI_RTP_DUMP_READER_H
+#define CHAI_RTP_DUMP_READER_H
+
+#include <stdint.h>
+
+#include <string>
+
+#include "MappedFile.h"
+
+namespace chai {
+// One packet of an rtpdump file. |data| points into the mapped file.
+struct RtpDumpRecord {
+  const uint8_t* data{nullptr};
+  uint32_t length{0};          // bytes stored in the file
+  uint32_t originalLength{0};  // RTP packet length, larger for header dumps
+  bool rtcp{false};
+  int64_t timeUs{0};  // file start time plus the packet offset
+};
+
+// Sequential reader for rtptools "#!rtpplay1.0" files, as written by rtpdump,
+// webrtc's RtpFileWriter and our media servers.
+class RtpDumpReader {
+ public:
+  // Whether |data| starts with the rtpdump text header.
+  static bool probe(const uint8_t* data, size_t size);
+
+  bool open(const std::string& path);
+  // Returns false at the end of the file or on a corrupt record.
+  bool next(RtpDumpRecord* record);
+
+  // Source address and port from the header, as "a.b.c.d/port".
+  const std::string& source() const { return source_; }
+  size_t offset() const { return offset_; }
+  const std::string& error() const { return error_; }
+
+ private:
+  MappedFile file_;
+  size_t offset_{0};
+  int64_t startUs_{0};
+  std::string source_;
+  std::string error_;
+};
+}  // namespace chai
+
+#endif  // CHAI_RTP_DUMP_READER_H
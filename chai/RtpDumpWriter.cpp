@@ -0,0 +1,122 @@
+#define MSC_CLASS "RtpDumpWriter"
+
+#include "RtpDumpWriter.h"
+
+#include <api/task_queue/default_task_queue_factory.h>
+#include <modules/rtp_rtcp/source/byte_io.h>
+#include <rtc_base/event.h>
+#include <rtc_base/logging.h>
+#include <rtc_base/time_utils.h>
+
+namespace {
+const char kFirstLine[] = "#!rtpplay1.0 0.0.0.0/0\n";
+const size_t kFileHeaderSize{16};
+const size_t kPacketHeaderSize{8};
+const int64_t kFlushIntervalMs{1000};
+}  // namespace
+
+namespace chai {
+RtpDumpWriter::~RtpDumpWriter() {
+  this->close();
+}
+
+bool RtpDumpWriter::open(const std::string& path) {
+  this->close();
+
+  this->file_ = fopen(path.c_str(), "wb");
+  if (this->file_ == nullptr) {
+    RTC_LOG(LS_ERROR) << "can't open " << path;
+    return false;
+  }
+
+  // The tap only knows the local side of the transport.
+  int64_t nowUs = rtc::TimeUTCMicros();
+  uint8_t header[kFileHeaderSize] = {0};
+  webrtc::ByteWriter<uint32_t>::WriteBigEndian(header, nowUs / 1000000);
+  webrtc::ByteWriter<uint32_t>::WriteBigEndian(header + 4, nowUs % 1000000);
+  fwrite(kFirstLine, 1, sizeof(kFirstLine) - 1, this->file_);
+  fwrite(header, 1, sizeof(header), this->file_);
+
+  this->startMs_ = rtc::TimeMillis();
+  this->lastFlushMs_ = this->startMs_;
+  this->active_.reserve(kBufferSize);
+  this->spare_.reserve(kBufferSize);
+  this->dropped_.store(0);
+
+  auto taskQueueFactory = webrtc::CreateDefaultTaskQueueFactory();
+  this->queue_.reset(new rtc::TaskQueue(taskQueueFactory->CreateTaskQueue(
+      "rtpdump", webrtc::TaskQueueFactory::Priority::LOW)));
+  return true;
+}
+
+void RtpDumpWriter::close() {
+  if (!this->queue_) {
+    return;
+  }
+
+  // Runs after any flush already posted.
+  rtc::Event done;
+  this->queue_->PostTask([this, &done] {
+    fwrite(this->active_.data(), 1, this->active_.size(), this->file_);
+    fclose(this->file_);
+    done.Set();
+  });
+  done.Wait(rtc::Event::kForever);
+
+  this->queue_.reset();
+  this->file_ = nullptr;
+  this->active_.clear();
+  this->spare_.clear();
+  this->flushing_.store(false);
+
+  if (uint64_t dropped = this->dropped_.load()) {
+    RTC_LOG(LS_WARNING) << "rtpdump dropped " << dropped
+                        << " packets, disk too slow";
+  }
+}
+
+void RtpDumpWriter::write(const uint8_t* data, size_t length, bool rtcp) {
+  if (!this->queue_ || length > 0xffff - kPacketHeaderSize) {
+    return;
+  }
+
+  int64_t nowMs = rtc::TimeMillis();
+  if (this->active_.size() + kPacketHeaderSize + length > kBufferSize ||
+      nowMs - this->lastFlushMs_ >= kFlushIntervalMs) {
+    this->flush();
+  }
+  if (this->active_.size() + kPacketHeaderSize + length > kBufferSize) {
+    this->dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  uint8_t header[kPacketHeaderSize];
+  webrtc::ByteWriter<uint16_t>::WriteBigEndian(header,
+                                               kPacketHeaderSize + length);
+  webrtc::ByteWriter<uint16_t>::WriteBigEndian(header + 2, rtcp ? 0 : length);
+  webrtc::ByteWriter<uint32_t>::WriteBigEndian(header + 4,
+                                               nowMs - this->startMs_);
+  this->active_.insert(this->active_.end(), header, header + kPacketHeaderSize);
+  this->active_.insert(this->active_.end(), data, data + length);
+}
+
+void RtpDumpWriter::flush() {
+  // Still writing the previous batch: keep appending to |active_| until it
+  // is full, then drop.
+  if (this->flushing_.load(std::memory_order_acquire)) {
+    return;
+  }
+  this->lastFlushMs_ = rtc::TimeMillis();
+  if (this->active_.empty()) {
+    return;
+  }
+
+  this->active_.swap(this->spare_);
+  this->flushing_.store(true, std::memory_order_relaxed);
+  this->queue_->PostTask([this] {
+    fwrite(this->spare_.data(), 1, this->spare_.size(), this->file_);
+    this->spare_.clear();
+    this->flushing_.store(false, std::memory_order_release);
+  });
+}
+}  // namespace chai
@@ -0,0 +1,57 @@
+#ifndef CHAI_RTP_DUMP_WRITER_H
+#define CHAI_RTP_DUMP_WRITER_H
+
+#include <rtc_base/task_queue.h>
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace chai {
+// Records packets in rtptools "#!rtpplay1.0" format.
+//
+// write() is called on the network thread and only appends to an in-memory
+// buffer. Once the buffer fills up, or a second has passed, it is swapped
+// with a spare one and written out on the writer's own task queue, so the
+// tap never waits on the disk. If the disk can't keep up and the spare
+// buffer is still being written, packets are dropped and counted.
+class RtpDumpWriter {
+ public:
+  static const size_t kBufferSize{1 << 20};
+
+  RtpDumpWriter() = default;
+  ~RtpDumpWriter();
+
+  bool open(const std::string& path);
+  // Flushes what is buffered and closes the file. Blocks until written; the
+  // writer must no longer be reachable from the network thread.
+  void close();
+
+  // Network thread only.
+  void write(const uint8_t* data, size_t length, bool rtcp);
+
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ protected:
+  void flush();
+
+ private:
+  std::unique_ptr<rtc::TaskQueue> queue_;
+  FILE* file_{nullptr};
+  int64_t startMs_{0};
+  int64_t lastFlushMs_{0};
+
+  // |active_| belongs to the network thread; |spare_| belongs to the queue
+  // while |flushing_| is set.
+  std::vector<uint8_t> active_;
+  std::vector<uint8_t> spare_;
+  std::atomic<bool> flushing_{false};
+  std::atomic<uint64_t> dropped_{0};
+};
+}  // namespace chai
+
+#endif  // CHAI_RTP_DUMP_WRITER_H
@@ -0,0 +1,344 @@
+#include "RtpExtensions.h"
+
+#include <modules/rtp_rtcp/source/byte_io.h>
+
+namespace {
+using chai::ExtensionType;
+using chai::RtpExtensionValues;
+
+using Decode = bool (*)(const uint8_t* data,
+                        uint8_t length,
+                        RtpExtensionValues* values);
+using Render = void (*)(const RtpExtensionValues& values,
+                        const uint8_t* data,
+                        uint8_t length,
+                        nlohmann::json* json);
+
+struct ExtensionDescriptor {
+  ExtensionType type;
+  const char* uri;
+  // Accepted element sizes.
+  uint8_t minLength;
+  uint8_t maxLength;
+  Decode decode;
+  Render render;
+};
+
+/*
+  0                   1                   2
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |  abs send time, 6.18 seconds                  |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*/
+bool decodeAbsSendTime(const uint8_t* data,
+                       uint8_t length,
+                       RtpExtensionValues* values) {
+  values->absSendTime = webrtc::ByteReader<uint32_t, 3>::ReadBigEndian(data);
+  return true;
+}
+
+void renderAbsSendTime(const RtpExtensionValues& values,
+                       const uint8_t* data,
+                       uint8_t length,
+                       nlohmann::json* json) {
+  (*json)["abs_send_time"] = values.absSendTime;
+  (*json)["abs_send_time_ms"] = values.absSendTime * 1000.0 / (1 << 18);
+}
+
+bool decodeTransmissionOffset(const uint8_t* data,
+                              uint8_t length,
+                              RtpExtensionValues* values) {
+  values->transmissionOffset =
+      webrtc::ByteReader<int32_t, 3>::ReadBigEndian(data);
+  return true;
+}
+
+void renderTransmissionOffset(const RtpExtensionValues& values,
+                              const uint8_t* data,
+                              uint8_t length,
+                              nlohmann::json* json) {
+  (*json)["transmission_offset"] = values.transmissionOffset;
+}
+
+/*
+  transport-wide-cc-02 appends an optional feedback request:
+  |T|   sequence count (15 bits)   |
+*/
+bool decodeTransportSequenceNumber(const uint8_t* data,
+                                   uint8_t length,
+                                   RtpExtensionValues* values) {
+  if (length != 2 && length != 4) {
+    return false;
+  }
+  values->transportSequenceNumber =
+      webrtc::ByteReader<uint16_t>::ReadBigEndian(data);
+  values->feedbackRequested = length == 4;
+  if (values->feedbackRequested) {
+    uint16_t request = webrtc::ByteReader<uint16_t>::ReadBigEndian(data + 2);
+    values->feedbackIncludeTimestamps = (request & 0x8000) != 0;
+    values->feedbackSequenceCount = request & 0x7fff;
+  }
+  return true;
+}
+
+void renderTransportSequenceNumber(const RtpExtensionValues& values,
+                                   const uint8_t* data,
+                                   uint8_t length,
+                                   nlohmann::json* json) {
+  (*json)["transport_sequence_number"] = values.transportSequenceNumber;
+  if (values.feedbackRequested) {
+    (*json)["feedback_request"] = {
+        {"include_timestamps", values.feedbackIncludeTimestamps},
+        {"sequence_count", values.feedbackSequenceCount},
+    };
+  }
+}
+
+// |V| level |
+bool decodeAudioLevel(const uint8_t* data,
+                      uint8_t length,
+                      RtpExtensionValues* values) {
+  values->voiceActivity = (data[0] & 0x80) != 0;
+  values->audioLevel = data[0] & 0x7f;
+  return true;
+}
+
+void renderAudioLevel(const RtpExtensionValues& values,
+                      const uint8_t* data,
+                      uint8_t length,
+                      nlohmann::json* json) {
+  (*json)["voice_activity"] = values.voiceActivity;
+  (*json)["audio_level"] = -int(values.audioLevel);
+}
+
+// |  MIN delay (12 bits)  |  MAX delay (12 bits)  |
+bool decodePlayoutDelay(const uint8_t* data,
+                        uint8_t length,
+                        RtpExtensionValues* values) {
+  values->minPlayoutDelay = uint16_t(data[0] << 4 | data[1] >> 4);
+  values->maxPlayoutDelay = uint16_t((data[1] & 0x0f) << 8 | data[2]);
+  return true;
+}
+
+void renderPlayoutDelay(const RtpExtensionValues& values,
+                        const uint8_t* data,
+                        uint8_t length,
+                        nlohmann::json* json) {
+  (*json)["min_delay_ms"] = values.minPlayoutDelay * 10;
+  (*json)["max_delay_ms"] = values.maxPlayoutDelay * 10;
+}
+
+// |0 0 0 0 C F R R|
+bool decodeVideoOrientation(const uint8_t* data,
+                            uint8_t length,
+                            RtpExtensionValues* values) {
+  values->backCamera = (data[0] & 0x08) != 0;
+  values->horizontalFlip = (data[0] & 0x04) != 0;
+  values->rotation = (data[0] & 0x03) * 90;
+  return true;
+}
+
+void renderVideoOrientation(const RtpExtensionValues& values,
+                            const uint8_t* data,
+                            uint8_t length,
+                            nlohmann::json* json) {
+  (*json)["rotation"] = values.rotation;
+  (*json)["camera"] = values.backCamera ? "back" : "front";
+  (*json)["flip"] = values.horizontalFlip;
+}
+
+/*
+  flags, then 16-bit ms deltas from the capture time: encode start, encode
+  finish, packetization finish, pacer exit, and two slots for network
+  elements. Old senders omit the flags byte.
+*/
+bool decodeVideoTiming(const uint8_t* data,
+                       uint8_t length,
+                       RtpExtensionValues* values) {
+  if (length != 12 && length != 13) {
+    return false;
+  }
+  values->timingFlags = 0;
+  if (length == 13) {
+    values->timingFlags = data[0];
+    ++data;
+  }
+  values->encodeStartDelta = webrtc::ByteReader<uint16_t>::ReadBigEndian(data);
+  values->encodeFinishDelta =
+      webrtc::ByteReader<uint16_t>::ReadBigEndian(data + 2);
+  values->packetizationFinishDelta =
+      webrtc::ByteReader<uint16_t>::ReadBigEndian(data + 4);
+  values->pacerExitDelta = webrtc::ByteReader<uint16_t>::ReadBigEndian(data + 6);
+  values->network1Delta = webrtc::ByteReader<uint16_t>::ReadBigEndian(data + 8);
+  values->network2Delta =
+      webrtc::ByteReader<uint16_t>::ReadBigEndian(data + 10);
+  return true;
+}
+
+void renderVideoTiming(const RtpExtensionValues& values,
+                       const uint8_t* data,
+                       uint8_t length,
+                       nlohmann::json* json) {
+  (*json)["flags"] = values.timingFlags;
+  (*json)["encode_start_ms"] = values.encodeStartDelta;
+  (*json)["encode_finish_ms"] = values.encodeFinishDelta;
+  (*json)["packetization_finish_ms"] = values.packetizationFinishDelta;
+  (*json)["pacer_exit_ms"] = values.pacerExitDelta;
+  (*json)["network_ms"] = values.network1Delta;
+  (*json)["network2_ms"] = values.network2Delta;
+}
+
+bool decodeAbsCaptureTime(const uint8_t* data,
+                          uint8_t length,
+                          RtpExtensionValues* values) {
+  if (length != 8 && length != 16) {
+    return false;
+  }
+  values->absoluteCaptureTimestamp =
+      webrtc::ByteReader<uint64_t>::ReadBigEndian(data);
+  values->hasCaptureClockOffset = length == 16;
+  values->estimatedCaptureClockOffset =
+      values->hasCaptureClockOffset
+          ? webrtc::ByteReader<int64_t>::ReadBigEndian(data + 8)
+          : 0;
+  return true;
+}
+
+void renderAbsCaptureTime(const RtpExtensionValues& values,
+                          const uint8_t* data,
+                          uint8_t length,
+                          nlohmann::json* json) {
+  (*json)["absolute_capture_timestamp"] = values.absoluteCaptureTimestamp;
+  if (values.hasCaptureClockOffset) {
+    (*json)["estimated_capture_clock_offset_ms"] =
+        values.estimatedCaptureClockOffset * 1000.0 / (int64_t(1) << 32);
+  }
+}
+
+// |S|E| template id (6) | frame number (16) | extended fields...
+bool decodeDependencyDescriptor(const uint8_t* data,
+                                uint8_t length,
+                                RtpExtensionValues* values) {
+  values->startOfFrame = (data[0] & 0x80) != 0;
+  values->endOfFrame = (data[0] & 0x40) != 0;
+  values->frameDependencyTemplateId = data[0] & 0x3f;
+  values->frameNumber = webrtc::ByteReader<uint16_t>::ReadBigEndian(data + 1);
+  values->extendedDescriptor = length > 3;
+  return true;
+}
+
+void renderDependencyDescriptor(const RtpExtensionValues& values,
+                                const uint8_t* data,
+                                uint8_t length,
+                                nlohmann::json* json) {
+  (*json)["start_of_frame"] = values.startOfFrame;
+  (*json)["end_of_frame"] = values.endOfFrame;
+  (*json)["template_id"] = values.frameDependencyTemplateId;
+  (*json)["frame_number"] = values.frameNumber;
+  (*json)["extended"] = values.extendedDescriptor;
+}
+
+// RFC 7941 SDES items: the value is the text itself.
+bool decodeString(const uint8_t* data,
+                  uint8_t length,
+                  RtpExtensionValues* values) {
+  return true;
+}
+
+void renderString(const RtpExtensionValues& values,
+                  const uint8_t* data,
+                  uint8_t length,
+                  nlohmann::json* json) {
+  (*json)["text"] = std::string(reinterpret_cast<const char*>(data), length);
+}
+
+// Indexed by ExtensionType.
+const ExtensionDescriptor kDescriptors[] = {
+    {ExtensionType::kUnknown, "", 0, 0, nullptr, nullptr},
+    {ExtensionType::kAbsSendTime,
+     "http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time", 3, 3,
+     decodeAbsSendTime, renderAbsSendTime},
+    {ExtensionType::kTransportSequenceNumber,
+     "http://www.ietf.org/id/"
+     "draft-holmer-rmcat-transport-wide-cc-extensions-01",
+     2, 2, decodeTransportSequenceNumber, renderTransportSequenceNumber},
+    {ExtensionType::kTransportSequenceNumberV2,
+     "http://www.webrtc.org/experiments/rtp-hdrext/transport-wide-cc-02", 2, 4,
+     decodeTransportSequenceNumber, renderTransportSequenceNumber},
+    {ExtensionType::kAudioLevel, "urn:ietf:params:rtp-hdrext:ssrc-audio-level",
+     1, 2, decodeAudioLevel, renderAudioLevel},
+    {ExtensionType::kPlayoutDelay,
+     "http://www.webrtc.org/experiments/rtp-hdrext/playout-delay", 3, 3,
+     decodePlayoutDelay, renderPlayoutDelay},
+    {ExtensionType::kVideoOrientation, "urn:3gpp:video-orientation", 1, 1,
+     decodeVideoOrientation, renderVideoOrientation},
+    {ExtensionType::kVideoTiming,
+     "http://www.webrtc.org/experiments/rtp-hdrext/video-timing", 12, 13,
+     decodeVideoTiming, renderVideoTiming},
+    {ExtensionType::kAbsCaptureTime,
+     "http://www.webrtc.org/experiments/rtp-hdrext/abs-capture-time", 8, 16,
+     decodeAbsCaptureTime, renderAbsCaptureTime},
+    {ExtensionType::kDependencyDescriptor,
+     "https://aomediacodec.github.io/av1-rtp-spec/"
+     "#dependency-descriptor-rtp-header-extension",
+     3, 255, decodeDependencyDescriptor, renderDependencyDescriptor},
+    {ExtensionType::kTransmissionOffset, "urn:ietf:params:rtp-hdrext:toffset",
+     3, 3, decodeTransmissionOffset, renderTransmissionOffset},
+    {ExtensionType::kMid, "urn:ietf:params:rtp-hdrext:sdes:mid", 1, 255,
+     decodeString, renderString},
+    {ExtensionType::kRtpStreamId,
+     "urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id", 1, 255, decodeString,
+     renderString},
+    {ExtensionType::kRepairedRtpStreamId,
+     "urn:ietf:params:rtp-hdrext:sdes:repaired-rtp-stream-id", 1, 255,
+     decodeString, renderString},
+};
+static_assert(sizeof(kDescriptors) / sizeof(kDescriptors[0]) ==
+                  size_t(ExtensionType::kCount),
+              "one descriptor per ExtensionType");
+static_assert(size_t(ExtensionType::kCount) <= 32,
+              "RtpExtensionValues::present is a 32-bit mask");
+}  // namespace
+
+namespace chai {
+ExtensionType extensionTypeFromUri(const std::string& uri) {
+  for (const auto& descriptor : kDescriptors) {
+    if (descriptor.decode && uri == descriptor.uri) {
+      return descriptor.type;
+    }
+  }
+  return ExtensionType::kUnknown;
+}
+
+const char* extensionUri(ExtensionType type) {
+  return kDescriptors[size_t(type)].uri;
+}
+
+bool decodeExtension(ExtensionType type,
+                     const uint8_t* data,
+                     uint8_t length,
+                     RtpExtensionValues* values) {
+  const ExtensionDescriptor& descriptor = kDescriptors[size_t(type)];
+  if (!descriptor.decode || length < descriptor.minLength ||
+      length > descriptor.maxLength) {
+    return false;
+  }
+  if (!descriptor.decode(data, length, values)) {
+    return false;
+  }
+  values->present |= 1u << uint8_t(type);
+  return true;
+}
+
+void renderExtension(ExtensionType type,
+                     const RtpExtensionValues& values,
+                     const uint8_t* data,
+                     uint8_t length,
+                     nlohmann::json* json) {
+  const ExtensionDescriptor& descriptor = kDescriptors[size_t(type)];
+  if (descriptor.render) {
+    descriptor.render(values, data, length, json);
+  }
+}
+}  // namespace chai
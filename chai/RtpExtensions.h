@@ -0,0 +1,102 @@
+#ifndef CHAI_RTP_EXTENSIONS_H
+#define CHAI_RTP_EXTENSIONS_H
+
+#include <stdint.h>
+
+#include <array>
+#include <json.hpp>
+#include <string>
+
+namespace chai {
+// RTP header extensions we know, by the URI of their a=extmap line.
+enum class ExtensionType : uint8_t {
+  kUnknown,
+  kAbsSendTime,
+  kTransportSequenceNumber,
+  kTransportSequenceNumberV2,
+  kAudioLevel,
+  kPlayoutDelay,
+  kVideoOrientation,
+  kVideoTiming,
+  kAbsCaptureTime,
+  kDependencyDescriptor,
+  kTransmissionOffset,
+  kMid,
+  kRtpStreamId,
+  kRepairedRtpStreamId,
+  kCount,
+};
+
+// Extension id to type, for one direction of one transport. One-byte
+// elements use ids 1-14, two-byte elements 1-255 (RFC 8285).
+using ExtensionMap = std::array<ExtensionType, 256>;
+
+ExtensionType extensionTypeFromUri(const std::string& uri);
+const char* extensionUri(ExtensionType type);
+
+// Typed values of the extensions of one packet. An extension appears at
+// most once per packet, so there is one field set per type; has() tells
+// which ones the packet carried.
+struct RtpExtensionValues {
+  bool has(ExtensionType type) const {
+    return (this->present & (1u << uint8_t(type))) != 0;
+  }
+
+  uint32_t present{0};
+
+  // abs-send-time: 6.18 fixed point seconds.
+  uint32_t absSendTime{0};
+  // toffset (RFC 5450): RTP timestamp units.
+  int32_t transmissionOffset{0};
+  // transport-wide-cc.
+  uint16_t transportSequenceNumber{0};
+  // transport-wide-cc-02 feedback request, when the sender added one.
+  bool feedbackRequested{false};
+  bool feedbackIncludeTimestamps{false};
+  uint16_t feedbackSequenceCount{0};
+  // ssrc-audio-level (RFC 6464): level in -dBov.
+  bool voiceActivity{false};
+  uint8_t audioLevel{0};
+  // playout-delay: 10 ms units.
+  uint16_t minPlayoutDelay{0};
+  uint16_t maxPlayoutDelay{0};
+  // video-orientation (3GPP TS 26.114 7.4.5): degrees clockwise.
+  uint16_t rotation{0};
+  bool backCamera{false};
+  bool horizontalFlip{false};
+  // video-timing: ms after the capture time.
+  uint8_t timingFlags{0};
+  uint16_t encodeStartDelta{0};
+  uint16_t encodeFinishDelta{0};
+  uint16_t packetizationFinishDelta{0};
+  uint16_t pacerExitDelta{0};
+  uint16_t network1Delta{0};
+  uint16_t network2Delta{0};
+  // abs-capture-time: UQ32.32 NTP time, Q32.32 seconds.
+  uint64_t absoluteCaptureTimestamp{0};
+  bool hasCaptureClockOffset{false};
+  int64_t estimatedCaptureClockOffset{0};
+  // AV1 dependency descriptor, mandatory fields only.
+  bool startOfFrame{false};
+  bool endOfFrame{false};
+  uint8_t frameDependencyTemplateId{0};
+  uint16_t frameNumber{0};
+  bool extendedDescriptor{false};
+};
+
+// Decodes one element into |values|. Returns false if its size doesn't fit
+// the type, leaving |values| untouched.
+bool decodeExtension(ExtensionType type,
+                     const uint8_t* data,
+                     uint8_t length,
+                     RtpExtensionValues* values);
+// Adds the typed fields of |type| to |json|. |data| is the element, for the
+// types whose value is the bytes themselves (mid, rid).
+void renderExtension(ExtensionType type,
+                     const RtpExtensionValues& values,
+                     const uint8_t* data,
+                     uint8_t length,
+                     nlohmann::json* json);
+}  // namespace chai
+
+#endif  // CHAI_RTP_EXTENSIONS_H
@@ -2,14 +2,12 @@
 
 #include "RtpPakcet.h"
 
-#include <api/audio_codecs/opus/audio_decoder_opus.h>
+#include <api/units/timestamp.h>
 #include <modules/rtp_rtcp/source/byte_io.h>
 #include <modules/rtp_rtcp/source/create_video_rtp_depacketizer.h>
-#include <modules/rtp_rtcp/source/video_rtp_depacketizer_av1.h>
 #include <modules/video_coding/frame_object.h>
 #include <api/video/i420_buffer.h>
 #include <third_party/libyuv/include/libyuv/convert.h>
-//#include <third_party/libaom/source/libaom/aom_util/aom_thread.h>
 
 #include <algorithm>
 #include <fstream>
@@ -18,34 +16,15 @@
 #include <sdptransform.hpp>
 
 #include "PayloadAV1.h"
+#include "PayloadH264.h"
+#include "PayloadH265.h"
+#include "PayloadOpus.h"
+#include "PayloadVP8.h"
+#include "PayloadVP9.h"
+#include "VideoRtpDepacketizerH265.h"
 
 using json = nlohmann::json;
 
-namespace {
-const uint16_t kFixedHeaderSize{12};
-const uint16_t kOneByteExtensionProfileId{0xBEDE};
-const uint16_t kTwoByteExtensionProfileId{0x1000};
-
-std::map<uint8_t, std::string> opusConfig2String = {
-    {0, "SILK-only, 8kHz, 10ms"},    {1, "SILK-only, 8kHz, 20ms"},
-    {2, "SILK-only, 8kHz, 40ms"},    {3, "SILK-only, 8kHz, 60ms"},
-    {4, "SILK-only, 12kHz, 10ms"},   {5, "SILK-only, 12kHz, 20ms"},
-    {6, "SILK-only, 12kHz, 40ms"},   {7, "SILK-only, 12kHz, 60ms"},
-    {8, "SILK-only, 16kHz, 10ms"},   {9, "SILK-only, 16kHz, 20ms"},
-    {10, "SILK-only, 16kHz, 40ms"},  {11, "SILK-only, 16kHz, 60ms"},
-    {12, "Hybrid, 24kHz, 10ms"},     {13, "Hybrid, 24kHz, 20ms"},
-    {14, "Hybrid, 48kHz, 10ms"},     {15, "Hybrid, 48kHz, 20ms"},
-    {16, "CELT-only, 8kHz, 2.5ms"},  {17, "CELT-only, 8kHz, 5ms"},
-    {18, "CELT-only, 8kHz, 10ms"},   {19, "CELT-only, 8kHz, 20ms"},
-    {20, "CELT-only, 16kHz, 2.5ms"}, {21, "CELT-only, 16kHz, 5ms"},
-    {22, "CELT-only, 16kHz, 10ms"},  {23, "CELT-only, 16kHz, 20ms"},
-    {24, "CELT-only, 24kHz, 2.5ms"}, {25, "CELT-only, 24kHz, 5ms"},
-    {26, "CELT-only, 24kHz, 10ms"},  {27, "CELT-only, 24kHz, 20ms"},
-    {28, "CELT-only, 48kHz, 2.5ms"}, {29, "CELT-only, 48kHz, 5ms"},
-    {30, "CELT-only, 48kHz, 10ms"},  {31, "CELT-only, 48kHz, 20ms"},
-};
-}  // namespace
-
 namespace chai {
 
 void XorHeaders(const uint8_t* src_data, uint8_t* dst_data, uint16_t length) {
@@ -196,7 +175,7 @@ void PayloadFlexFec::insertFecPacket(webrtc::RtpPacketReceived& fecPacket) {
   }
 }
 
-nlohmann::json PayloadFlexFec::parse(const uint8_t* buff, uint16_t length) {
+nlohmann::json PayloadFlexFec::parse(const uint8_t* buff, size_t length) {
   /*
                   0                   1                   2                   3
                   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0
@@ -478,527 +457,158 @@ void PayloadFlexFec::setMask(char* const mask,
   }
 }
 
-  /*
-   +-----------------------+-----------+-----------+-------------------+
-   | Configuration         | Mode      | Bandwidth | Frame Sizes       |
-   | Number(s)             |           |           |                   |
-   +-----------------------+-----------+-----------+-------------------+
-   | 0...3                 | SILK-only | NB        | 10, 20, 40, 60 ms |
-   |                       |           |           |                   |
-   | 4...7                 | SILK-only | MB        | 10, 20, 40, 60 ms |
-   |                       |           |           |                   |
-   | 8...11                | SILK-only | WB        | 10, 20, 40, 60 ms |
-   |                       |           |           |                   |
-   | 12...13               | Hybrid    | SWB       | 10, 20 ms         |
-   |                       |           |           |                   |
-   | 14...15               | Hybrid    | FB        | 10, 20 ms         |
-   |                       |           |           |                   |
-   | 16...19               | CELT-only | NB        | 2.5, 5, 10, 20 ms |
-   |                       |           |           |                   |
-   | 20...23               | CELT-only | WB        | 2.5, 5, 10, 20 ms |
-   |                       |           |           |                   |
-   | 24...27               | CELT-only | SWB       | 2.5, 5, 10, 20 ms |
-   |                       |           |           |                   |
-   | 28...31               | CELT-only | FB        | 2.5, 5, 10, 20 ms |
-   +-----------------------+-----------+-----------+-------------------+
-                                Table 2: TOC Byte Configuration Parameters
-*/
-/*
-   +----------------------+-----------------+-------------------------+
-   | Abbreviation         | Audio Bandwidth | Sample Rate (Effective) |
-   +----------------------+-----------------+-------------------------+
-   | NB (narrowband)      |           4 kHz |                   8 kHz |
-   |                      |                 |                         |
-   | MB (medium-band)     |           6 kHz |                  12 kHz |
-   |                      |                 |                         |
-   | WB (wideband)        |           8 kHz |                  16 kHz |
-   |                      |                 |                         |
-   | SWB (super-wideband) |          12 kHz |                  24 kHz |
-   |                      |                 |                         |
-   | FB (fullband)        |      20 kHz (*) |                  48 kHz |
-   +----------------------+-----------------+-------------------------+
-*/
-nlohmann::json PayloadOpus::parse(const uint8_t* buff, uint16_t length) {
-  std::ostringstream oss;
-  uint32_t offset{0};
-
-  // OTC
-  uint8_t config = (buff[offset] >> 3) & 0x1f;
-  uint16_t packet_flag = buff[offset] & 0x3;
-  oss << uint16_t(config) << "(" << opusConfig2String[config] << ")";
-  nlohmann::json opus = {
-      {"config", oss.str()},
-      {"payload_length", length},
-      {"packet_flag", packet_flag},
-  };
-  uint16_t channels = (buff[offset] >> 2) & 0x1;
-  oss.str("");
-  oss << channels << "(" << channels + 1 << ")";
-  opus["channels"] = oss.str();
-  switch (packet_flag) {
-    case 0:
-      opus["frame"] = parseC0(buff, length);
-      break;
-    case 1:
-      opus["frame"] = parseC1(buff, length);
-      break;
-    case 2:
-      opus["frame"] = parseC2(buff, length);
-      break;
-    case 3:
-      opus["frame"] = parseC3(buff, length);
-      break;
-  }
-
-  // default
-  auto format = webrtc::AudioDecoderOpus::SdpToConfig(
-      {"opus", 48000, 2, {{"minptime", "10"}, {"useinbandfec", "1"}}});
-  if (true) {
-    format->sample_rate_hz = 16000;
-  }
-
-  return opus;
-}
-nlohmann::json PayloadOpus::parseC0(const uint8_t* buff, uint16_t length) {
-  /*
-            0                   1                   2                   3
-            0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           | config  |s|0|0|                                               |
-           +-+-+-+-+-+-+-+-+                                               |
-           |                    Compressed frame 1 (N-1 bytes)...          :
-           :                                                               |
-           |                                                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  */
-  uint32_t offset{1};
-  nlohmann::json frame;
-  frame["len"] = length - 1;
-
-  return frame;
-}
-nlohmann::json PayloadOpus::parseC1(const uint8_t* buff, uint16_t length) {
-  /*
-            0                   1                   2                   3
-            0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           | config  |s|0|1|                                               |
-           +-+-+-+-+-+-+-+-+                                               :
-           |             Compressed frame 1 ((N-1)/2 bytes)...             |
-           :                               +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           |                               |                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+                               :
-           |             Compressed frame 2 ((N-1)/2 bytes)...             |
-           :                                               +-+-+-+-+-+-+-+-+
-           |                                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  */
-  uint32_t offset{1};
-  nlohmann::json frames = {
-      {"packet_num", 2},
-      {"frame", nlohmann::json::array()},
-  };
-
-  std::list<uint16_t> lens(2, (length - 1) / 2);
-  for (auto len : lens) {
-    nlohmann::json frame;
-    frame["len"] = len;
-
-    // parse opus
-
-    offset += len;
-    frames["frame"].push_back(frame);
-  }
-
-  return frames;
-}
-
-nlohmann::json PayloadOpus::parseC2(const uint8_t* buff, uint16_t length) {
-  /*
-            0                   1                   2                   3
-            0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           | config  |s|1|0| N1 (1-2 bytes):                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+                               :
-           |               Compressed frame 1 (N1 bytes)...                |
-           :                               +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           |                               |                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+                               |
-           |                     Compressed frame 2...                     :
-           :                                                               |
-           |                                                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  */
-  uint32_t offset{1};
-  nlohmann::json frames = {
-      {"packet_num", 2},
-      {"frame", nlohmann::json::array()},
-  };
-
-  std::list<uint16_t> lens;
-  for (uint16_t i = 0; i < 2; ++i) {
-    if (i == 0) {
-      uint16_t len = buff[offset];
-      offset += 1;
-      if (len > 251) {
-        len += buff[offset] * 4;
-        offset += 1;
-      }
-      lens.push_back(len);
-    } else {
-      lens.push_back(length - offset);
-    }
-  }
-  for (auto len : lens) {
-    nlohmann::json frame;
-    frame["len"] = len;
-
-    // parse opus
-
-    offset += len;
-    frames["frame"].push_back(frame);
-  }
-
-  return frames;
-}
-
-nlohmann::json PayloadOpus::parseC3(const uint8_t* buff, uint16_t length) {
-  /*
-                                                            0
-                                                            0 1 2 3 4 5 6 7
-                                                           +-+-+-+-+-+-+-+-+
-                                                           |v|p|     M     |
-                                                           +-+-+-+-+-+-+-+-+
-                                            Figure 5: The frame count byte
-  */
-  uint32_t offset{1};
-  std::ostringstream oss;
-  nlohmann::json frames = {
-      {"frame", nlohmann::json::array()},
-  };
-
-  uint8_t variable_bitrate = (buff[offset] >> 7) & 0x1;
-  uint8_t padding = (buff[offset] >> 6) & 0x1;
-  frames["padding"] = padding;
-  uint8_t packet_num = buff[offset] & 0x3f;
-  frames["packet_num"] = packet_num;
-  offset += 1;
-  uint32_t padding_length{0};  // 填充字节大小不包含填充字节的第一个字节
-  if (padding) {
-    nlohmann::json frame;
-    bool padding_flag = false;
-    do {
-      padding_length += buff[offset];
-      offset += 1;
-      buff[offset] == 255 ? (padding_flag = true) : (padding_flag = false);
-    } while (padding_flag);
-  }
-  oss << padding_length << "(" << padding_length + 1 << ")";
-  frames["padding_length"] = oss.str();
-  if (variable_bitrate == 0) {
-    frames["variable_bitrate"] = "0(CBR)";
-    frames["frame"] =
-        parseC3CBR(buff + offset, length - 3 - padding_length, packet_num);
-  } else {
-    frames["variable_bitrate"] = "1(VBR)";
-    frames["frame"] =
-        parseC3VBR(buff + offset, length - 3 - padding_length, packet_num);
-  }
-  return frames;
-}
-
-nlohmann::json PayloadOpus::parseC3CBR(const uint8_t* buff,
-                                       uint16_t length,
-                                       uint8_t num) {
-  /*
-            0                   1                   2                   3
-            0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           | config  |s|1|1|0|p|     M     |  Padding length (Optional)    :
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           |                                                               |
-           :               Compressed frame 1 (R/M bytes)...               :
-           |                                                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           |                                                               |
-           :               Compressed frame 2 (R/M bytes)...               :
-           |                                                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           |                                                               |
-           :                              ...                              :
-           |                                                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           |                                                               |
-           :               Compressed frame M (R/M bytes)...               :
-           |                                                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           :                  Opus Padding (Optional)...                   |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-                                             Figure 6: A CBR Code 3 Packet
-  */
-  uint32_t offset{0};
-  nlohmann::json frame = nlohmann::json::array();
-
-  std::list<uint16_t> lens(num, length / num);
-  for (auto len : lens) {
-    nlohmann::json frame;
-    frame["len"] = len;
-
-    // parse opus
-
-    offset += len;
-    frame.push_back(frame);
-  }
-  return frame;
-}
-
-nlohmann::json PayloadOpus::parseC3VBR(const uint8_t* buff,
-                                       uint16_t length,
-                                       uint8_t num) {
-  /*
-            0                   1                   2                   3
-            0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           | config  |s|1|1|1|p|     M     | Padding length (Optional)     :
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           : N1 (1-2 bytes): N2 (1-2 bytes):     ...       :     N[M-1]    |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           |                                                               |
-           :               Compressed frame 1 (N1 bytes)...                :
-           |                                                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           |                                                               |
-           :               Compressed frame 2 (N2 bytes)...                :
-           |                                                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           |                                                               |
-           :                              ...                              :
-           |                                                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           |                                                               |
-           :                     Compressed frame M...                     :
-           |                                                               |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-           :                  Opus Padding (Optional)...                   |
-           +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-
-                                             Figure 7: A VBR Code 3 Packet
-  */
-  uint32_t offset{0};
-  nlohmann::json frame = nlohmann::json::array();
-
-  // 解析包的长度
-  std::list<uint16_t> lens;
-  for (uint16_t i = 0; i < num; ++i) {
-    uint16_t len = buff[offset];
-    offset += 1;
-    if (i != num - 1) {
-      if (len > 251) {
-        len += buff[offset] * 4;
-        offset += 1;
-      }
-    } else {
-      len = length - offset;
-    }
-    lens.push_back(len);
-  }
-  // 解析frame
-  for (auto len : lens) {
-    nlohmann::json frame;
-    frame["len"] = len;
-
-    // parse opus
-
-    offset += len;
-    frame.push_back(frame);
-  }
-  return frame;
-}
-
-nlohmann::json RtpPacket::parse(const uint8_t* buff, uint16_t length) {
-  webrtc::RtpPacketReceived rtpPacket;
-  if (!rtpPacket.Parse(buff, length)) {
+bool RtpPacket::parse(const uint8_t* buff,
+                      uint16_t length,
+                      RtpRecord* record) {
+  if (!record->parseHeader(buff, length, !this->headerOnly_)) {
     RTC_LOG(LS_ERROR) << "parse rtp header error";
-    return nlohmann::json();
-  }
-
-  const uint8_t extension = (buff[0] & 0x10) >> 4;
-  nlohmann::json json;
-  json["header"] = parseHeader(rtpPacket);
-  if (extension) {
-    json["extension"] = this->parseExtension(rtpPacket);
-  }
-
-  switch (rtpPacket.PayloadType()) {
-    case 124:
-      if (!video_depacketizer_) {
+    return false;
+  }
+  record->headerOnly = this->headerOnly_;
+  if (this->headerOnly_) {
+    return true;
+  }
+
+  switch (this->codec_) {
+    case Codec::kH264:
+    case Codec::kH265:
+    case Codec::kVp8:
+    case Codec::kVp9:
+    case Codec::kAv1: {
+      if (video_codec_ != this->codec_) {
+        switch (this->codec_) {
+          case Codec::kH264:
+            video_depacketizer_ = webrtc::CreateVideoRtpDepacketizer(
+                webrtc::VideoCodecType::kVideoCodecH264);
+            video_.reset(new PayloadH264);
+            break;
+          case Codec::kH265:
+            video_depacketizer_.reset(new VideoRtpDepacketizerH265);
+            video_.reset(new PayloadH265);
+            break;
+          case Codec::kVp8:
+            video_depacketizer_ = webrtc::CreateVideoRtpDepacketizer(
+                webrtc::VideoCodecType::kVideoCodecVP8);
+            video_.reset(new PayloadVP8);
+            break;
+          case Codec::kVp9:
+            video_depacketizer_ = webrtc::CreateVideoRtpDepacketizer(
+                webrtc::VideoCodecType::kVideoCodecVP9);
+            video_.reset(new PayloadVP9);
+            break;
+          default:
+            video_depacketizer_ = webrtc::CreateVideoRtpDepacketizer(
+                webrtc::VideoCodecType::kVideoCodecAV1);
+            video_.reset(new PayloadAV1);
+            break;
+        }
+        video_codec_ = this->codec_;
       }
-    case 35:
-      if (!video_depacketizer_) {
-        video_depacketizer_ = webrtc::CreateVideoRtpDepacketizer(
-            webrtc::VideoCodecType::kVideoCodecAV1);
-        video_.reset(new PayloadAV1);
+      // Frame assembly needs webrtc's own view of the packet.
+      webrtc::RtpPacketReceived rtpPacket;
+      if (!rtpPacket.Parse(buff, length)) {
+        RTC_LOG(LS_ERROR) << "parse rtp header error";
+        return false;
       }
       // Jitter Buffer
-      json["payload"] = assembleFrame(rtpPacket);
+      nlohmann::json payload = assembleFrame(rtpPacket);
+      if (!payload.is_null()) {
+        record->payload =
+            std::make_shared<const nlohmann::json>(std::move(payload));
+      }
+      // The VP8/VP9 payload descriptors are per packet, and set its colours.
+      if (this->codec_ == Codec::kVp8) {
+        auto vp8 = static_cast<PayloadVP8*>(video_.get());
+        record->hasVp8 = vp8->parseDescriptor(
+            buff + record->header.headerSize, record->header.payloadSize,
+            &record->vp8);
+      } else if (this->codec_ == Codec::kVp9) {
+        auto vp9 = static_cast<PayloadVP9*>(video_.get());
+        record->hasVp9 = vp9->parseDescriptor(
+            buff + record->header.headerSize, record->header.payloadSize,
+            this->arrivalTimeUs_, &record->vp9);
+      }
 
-      json["customize"] = {{"color1", video_->color1_},
-                           {"color2", video_->color2_}};
+      record->color1 = video_->color1_;
+      record->color2 = video_->color2_;
       break;
-    case 107:
-    case 36:
+    }
+    case Codec::kOpus: {
+      if (!audio_) {
+        audio_.reset(new PayloadOpus);
+      }
+      auto opus = static_cast<PayloadOpus*>(audio_.get());
+      record->hasOpus = opus->parsePacket(buff + record->header.headerSize,
+                                          record->header.payloadSize,
+                                          &record->opus);
+      record->color1 = audio_->color1_;
+      record->color2 = audio_->color2_;
+      break;
+    }
+    case Codec::kRtx:
       break;
-    case 115:
+    case Codec::kFlexFec:
       break;
     default:
       break;
   }
-  return json;
+  return true;
 }
 
-//  0                   1                   2                   3
-//  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-// |V=2|P|X|  CC   |M|     PT      |       sequence number         |
-// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-// |                           timestamp                           |
-// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-// |           synchronization source (SSRC) identifier            |
-// +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
-// |            Contributing source (CSRC) identifiers             |
-// |                             ....                              |
-// +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
-// |  header eXtension profile id  |       length in 32bits        |
-// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-// |                          Extensions                           |
-// |                             ....                              |
-// +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
-// |                           Payload                             |
-// |             ....              :  padding...                   |
-// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-// |               padding         | Padding size  |
-// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-nlohmann::json RtpPacket::parseHeader(
+nlohmann::json RtpPacket::assembleFrame(
     const webrtc::RtpPacketReceived& rtpPacket) {
-  const uint8_t extension = (rtpPacket.data()[0] & 0x10) >> 4;
-  const uint8_t padding = rtpPacket.padding_size() ? 1 : 0;
-  const uint8_t csrcCount = rtpPacket.Csrcs().size();
-  nlohmann::json header = {
-      {"version", rtpPacket.data()[0] >> 6},
-      {"padding", padding},
-      {"extension", extension},
-      {"csrc_count", rtpPacket.Csrcs().size()},
-      {"marker", (uint8_t)rtpPacket.Marker()},
-      {"payload_type", rtpPacket.PayloadType()},
-      {"sequence_number", rtpPacket.SequenceNumber()},
-      {"timestamp", rtpPacket.Timestamp()},
-      {"ssrc", rtpPacket.Ssrc()},
-  };
-
-  if (csrcCount) {
-    nlohmann::json csrcs = nlohmann::json::array();
-    for (auto csrc : rtpPacket.Csrcs()) {
-      csrcs.push_back(csrc);
-    }
-    header["csrc"] = csrcs;
-  }
-  if (padding) {
-    // 最后一个字节为对齐的长度
-    header["padding_length"] = rtpPacket.padding_size();
+  auto parsed = video_depacketizer_->Parse(rtpPacket.PayloadBuffer());
+  if (!parsed) {
+    RTC_LOG(LS_WARNING) << "depacketize error, seq "
+                        << rtpPacket.SequenceNumber();
+    return nlohmann::json();
   }
 
-  return header;
-}
-
-/* RTP header extension, RFC 3550.
- 0                   1                   2                   3
- 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-|      defined by profile       |           length              |
-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-|                        header extension                       |
-|                             ....                              |
-*/
-nlohmann::json RtpPacket::parseExtension(
-    const webrtc::RtpPacketReceived& rtpPacket) {
-  uint32_t extensionOffset = kFixedHeaderSize + rtpPacket.Csrcs().size() * 4;
-  const uint8_t* extensionEnd = rtpPacket.data() + rtpPacket.headers_size();
-  const uint8_t* ptr = rtpPacket.data() + extensionOffset +
-                       4;  // 前4个字节为扩展描述以及扩展长度
-  std::ostringstream oss;
-
-  uint16_t profile = webrtc::ByteReader<uint16_t>::ReadBigEndian(
-      rtpPacket.data() + extensionOffset);
-  uint16_t length = webrtc::ByteReader<uint16_t>::ReadBigEndian(
-      rtpPacket.data() + extensionOffset + 2);
-
-  oss << length << "(" << length * 4 << ")";
-  nlohmann::json headerExtension = {
-      {"profile", profile},
-      {"length",
-       oss.str()},  // 不包含profile length的长度，扩展长度为length*4字节
-      {"extension", nlohmann::json::array()},
-  };
-
-  if (profile == kOneByteExtensionProfileId) {
-    oss.str("");
-    oss << "0x" << std::hex << kOneByteExtensionProfileId << "(oneByte)";
-    headerExtension["profile"] = oss.str();
-    while (ptr < extensionEnd) {
-      uint8_t id = (*ptr & 0xF0) >> 4;
-      uint8_t len = (*ptr & 0x0F) + 1;  // 不包含id len的长度
-      nlohmann::json extension = {{"id", id}};
-      // id为15表示停止解析
-      if (id == 15u) {
-        headerExtension["extension"].push_back(extension);
-        break;
-      } else if (id != 0u) {
-        oss.str("");
-        oss << "0x";
-        ptr += 1;
-        for (uint8_t i = 0; i < len; ++i) {
-          oss << std::hex << std::setw(2) << std::setfill('0')
-              << uint16_t(ptr[i]);
-        }
-        extension["length"] = len;
-        extension["value"] = oss.str();
-        headerExtension["extension"].push_back(extension);
+  auto packet = std::make_unique<webrtc::video_coding::PacketBuffer::Packet>(rtpPacket, parsed->video_header);
 
-        ptr += len;
-      }
-      // id=0表示对齐
-      else {
-        extension["length"] = len;
-        headerExtension["extension"].push_back(extension);
+  webrtc::RTPVideoHeader& video_header = packet->video_header;
+  video_header.is_last_packet_in_frame |= rtpPacket.Marker();
+  if (video_codec_ == Codec::kH265) {
+    // The depacketizer only sees the NAL units of one packet; a packet right
+    // after the previous one starts a frame exactly when the timestamp moves.
+    uint16_t seq = rtpPacket.SequenceNumber();
+    if (h265_has_last_ && seq == uint16_t(h265_last_seq_ + 1)) {
+      video_header.is_first_packet_in_frame =
+          rtpPacket.Timestamp() != h265_last_timestamp_;
+    }
+    h265_has_last_ = true;
+    h265_last_seq_ = seq;
+    h265_last_timestamp_ = rtpPacket.Timestamp();
+  }
+  if (video_codec_ == Codec::kH264) {
+    // As RtpVideoStreamReceiver2 does: start codes in front of every NAL
+    // unit, and no IDR without the parameter sets it refers to.
+    auto fixed = h264_tracker_.CopyAndFixBitstream(
+        rtc::MakeArrayView(parsed->video_payload.cdata(),
+                           parsed->video_payload.size()),
+        &video_header);
+    switch (fixed.action) {
+      case webrtc::video_coding::H264SpsPpsTracker::kRequestKeyframe:
+        RTC_LOG(LS_WARNING) << "h264 idr without sps/pps, seq "
+                            << rtpPacket.SequenceNumber();
+        return nlohmann::json();
+      case webrtc::video_coding::H264SpsPpsTracker::kDrop:
+        return nlohmann::json();
+      case webrtc::video_coding::H264SpsPpsTracker::kInsert:
+        packet->video_payload = std::move(fixed.bitstream);
         break;
-      }
     }
-  } else if ((profile & 0xfff0) == kTwoByteExtensionProfileId) {
-    oss.str("");
-    oss << "0x" << std::hex << kTwoByteExtensionProfileId << "(twoByte)";
-    headerExtension["profile"] = oss.str();
+  } else {
+    packet->video_payload = std::move(parsed->video_payload);
   }
 
-  return headerExtension;
-}
-
-nlohmann::json RtpPacket::assembleFrame(
-    const webrtc::RtpPacketReceived& rtpPacket) {
-  webrtc::VideoRtpDepacketizerAv1 av1;
-  auto parsed = av1.Parse(rtpPacket.PayloadBuffer());
-
-  auto packet = std::make_unique<webrtc::video_coding::PacketBuffer::Packet>(rtpPacket, parsed->video_header);
-
-  webrtc::RTPVideoHeader& video_header = packet->video_header;
-  video_header.is_last_packet_in_frame = rtpPacket.Marker();
-  packet->video_payload = rtpPacket.PayloadBuffer();
-
-  packet_infos_.emplace(
-      rtpPacket.SequenceNumber(),
-      webrtc::RtpPacketInfo(
-          rtpPacket.Ssrc(), rtpPacket.Csrcs(), rtpPacket.Timestamp(),
-          absl::nullopt,
-          rtpPacket.GetExtension<webrtc::AbsoluteCaptureTimeExtension>(), 0));
+  // Assigned rather than emplaced: after the sequence number wraps, or for a
+  // retransmission, the entry left by an earlier packet must not win.
+  packet_infos_[rtpPacket.SequenceNumber()] = webrtc::RtpPacketInfo(
+      rtpPacket.Ssrc(), rtpPacket.Csrcs(), rtpPacket.Timestamp(),
+      absl::nullopt,
+      rtpPacket.GetExtension<webrtc::AbsoluteCaptureTimeExtension>(),
+      webrtc::Timestamp::Micros(this->arrivalTimeUs_));
 
   auto result = packet_buffer_.InsertPacket(std::move(packet));
   if (result.packets.size() == 0) {
@@ -1008,6 +618,11 @@ nlohmann::json RtpPacket::assembleFrame(
   // frame buffer
   webrtc::video_coding::PacketBuffer::Packet* first_packet{nullptr};
   int max_nack_count{0};
+  // Whether any packet of the frame is a key frame packet. For H.265 the
+  // first packet is often an AP of parameter sets and the IRAP slices come
+  // in later FUs, so as PacketBuffer does with has_h264_idr the whole frame
+  // is scanned.
+  bool key_frame{false};
   int64_t min_recv_time{0};
   int64_t max_recv_time{0};
   std::vector<rtc::ArrayView<const uint8_t>> payloads;
@@ -1018,6 +633,7 @@ nlohmann::json RtpPacket::assembleFrame(
     if (packet->is_first_packet_in_frame()) {
       first_packet = packet.get();
       max_nack_count = packet->times_nacked;
+      key_frame = false;
       min_recv_time = packet_info.receive_time().ms();
       max_recv_time = packet_info.receive_time().ms();
       payloads.clear();
@@ -1027,10 +643,14 @@ nlohmann::json RtpPacket::assembleFrame(
       min_recv_time = std::min(min_recv_time, packet_info.receive_time().ms());
       max_recv_time = std::max(max_recv_time, packet_info.receive_time().ms());
     }
+    key_frame |= packet->video_header.frame_type ==
+                 webrtc::VideoFrameType::kVideoFrameKey;
     payloads.emplace_back(packet->video_payload);
     packet_infos.push_back(packet_info);
 
     if (packet->is_last_packet_in_frame()) {
+      // The arrival times of the frame are in packet_infos now.
+      this->erasePacketInfos(first_packet->seq_num, packet->seq_num);
       auto bitstream = video_depacketizer_->AssembleFrame(payloads);
       if (!bitstream) {
         // Failed to assemble a frame. Discard and continue.
@@ -1038,6 +658,10 @@ nlohmann::json RtpPacket::assembleFrame(
       }
 
       const webrtc::video_coding::PacketBuffer::Packet& last_packet = *packet;
+      // RtpFrameObject takes the frame type from the first packet.
+      first_packet->video_header.frame_type =
+          key_frame ? webrtc::VideoFrameType::kVideoFrameKey
+                    : webrtc::VideoFrameType::kVideoFrameDelta;
       auto frame = std::make_unique<webrtc::RtpFrameObject>(
           first_packet->seq_num,                             //
           last_packet.seq_num,                               //
@@ -1060,7 +684,12 @@ nlohmann::json RtpPacket::assembleFrame(
       
       auto frames = reference_finder_.ManageFrame(std::move(frame));
       for (auto& f : frames) {
-        return video_->parse(f->data(), f->size());
+        nlohmann::json json = video_->parse(f->data(), f->size());
+        if (json.is_object()) {
+          // Spread between the first and the last packet of the frame.
+          json["assembly_time_ms"] = max_recv_time - min_recv_time;
+        }
+        return json;
       }
     }
   }
@@ -1070,7 +699,19 @@ nlohmann::json RtpPacket::assembleFrame(
   return nlohmann::json();
 }
 
-nlohmann::json RtxPacket::parse(const uint8_t* buff, uint16_t length) {
+void RtpPacket::erasePacketInfos(uint16_t first_seq_num,
+                                 uint16_t last_seq_num) {
+  for (uint16_t seq_num = first_seq_num;; ++seq_num) {
+    packet_infos_.erase(seq_num);
+    if (seq_num == last_seq_num) {
+      break;
+    }
+  }
+}
+
+bool RtxPacket::parse(const uint8_t* buff,
+                      uint16_t length,
+                      RtpRecord* record) {
   /*
           0                   1                   2                   3
           0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
@@ -1083,23 +724,17 @@ nlohmann::json RtxPacket::parse(const uint8_t* buff, uint16_t length) {
      |                                                               |
      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   */
-  webrtc::RtpPacketReceived rtpPacket;
-  if (!rtpPacket.Parse(buff, length)) {
+  if (!record->parseHeader(buff, length, !this->headerOnly_)) {
     RTC_LOG(LS_ERROR) << "parse rtp header error";
-    return nlohmann::json();
-  }
-
-  const uint8_t extension = (buff[0] & 0x10) >> 4;
-  nlohmann::json json;
-  json["header"] = parseHeader(rtpPacket);
-  if (extension) {
-    json["extension"] = this->parseExtension(rtpPacket);
+    return false;
   }
+  record->headerOnly = this->headerOnly_;
 
-  auto& payload = rtpPacket.PayloadBuffer();
-  if (rtpPacket.payload_size()) {
-    json["osn"] = webrtc::ByteReader<uint16_t>::ReadBigEndian(payload.data());
+  if (record->header.payloadSize >= 2) {
+    record->hasOsn = true;
+    record->osn = webrtc::ByteReader<uint16_t>::ReadBigEndian(
+        buff + record->header.headerSize);
   }
-  return json;
+  return true;
 }
 }  // namespace chai
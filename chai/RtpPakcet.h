@@ -5,13 +5,16 @@
 #include <pc/peer_connection.h>
 #include <rtc_base/bit_buffer.h>
 #include <modules/video_coding/packet_buffer.h>
+#include <modules/video_coding/h264_sps_pps_tracker.h>
 #include <modules/rtp_rtcp/source/video_rtp_depacketizer.h>
 #include <common_video/include/video_frame_buffer_pool.h>
-#include <third_party/libaom/source/libaom/av1/decoder/decoder.h>
 #include <modules/video_coding/rtp_frame_reference_finder.h>
 
 #include <json.hpp>
 
+#include "PayloadTypeTable.h"
+#include "RtpRecord.h"
+
 namespace chai {
 #define AUDIO_COLOR "#000000"
 #define WHITE_COLOR "#FFFFFF"
@@ -25,19 +28,20 @@ namespace chai {
 class PayloadBase {
  public:
   virtual ~PayloadBase() = default;
-  virtual nlohmann::json parse(const uint8_t* buff, uint16_t length) = 0;
+  // |length| is that of a whole assembled frame, which can exceed 64 KiB.
+  virtual nlohmann::json parse(const uint8_t* buff, size_t length) = 0;
 
  public:
   int frame_type_{0};
-  std::string color1_{WHITE_COLOR};
-  std::string color2_{WHITE_COLOR};
+  const char* color1_{WHITE_COLOR};
+  const char* color2_{WHITE_COLOR};
 };
 
 class PayloadFlexFec : public PayloadBase {
  public:
   void insertMediaPacket(webrtc::RtpPacketReceived& rtpPacket);
   void insertFecPacket(webrtc::RtpPacketReceived& fecPacket);
-  nlohmann::json parse(const uint8_t* buff, uint16_t length) override;
+  nlohmann::json parse(const uint8_t* buff, size_t length) override;
 
  protected:
   nlohmann::json parseR0F0(const uint8_t* buff, uint16_t length);
@@ -52,45 +56,58 @@ class PayloadFlexFec : public PayloadBase {
 };
 
 
-class PayloadOpus : public PayloadBase {
- public:
-  nlohmann::json parse(const uint8_t* buff, uint16_t length) override;
-
- protected:
-  nlohmann::json parseC0(const uint8_t* buff, uint16_t length);
-  nlohmann::json parseC1(const uint8_t* buff, uint16_t length);
-  nlohmann::json parseC2(const uint8_t* buff, uint16_t length);
-  nlohmann::json parseC3(const uint8_t* buff, uint16_t length);
-  nlohmann::json parseC3CBR(const uint8_t* buff, uint16_t length, uint8_t num);
-  nlohmann::json parseC3VBR(const uint8_t* buff, uint16_t length, uint8_t num);
-};
-
 class RtpPacket {
  public:
   virtual ~RtpPacket() = default;
-  virtual nlohmann::json parse(const uint8_t* buff, uint16_t length);
+  // Fills |record|; returns false if |buff| isn't a valid RTP packet.
+  virtual bool parse(const uint8_t* buff, uint16_t length, RtpRecord* record);
+
+  // Header-only mode is used while the parse backlog is above its high-water
+  // mark: only the fixed RTP header is parsed, no extensions, no frame
+  // assembly and no payload decoding.
+  void setHeaderOnly(bool headerOnly) { headerOnly_ = headerOnly; }
+  bool headerOnly() const { return headerOnly_; }
+  // Codec of the payload type, from the negotiated PayloadTypeTable.
+  void setCodec(Codec codec) { codec_ = codec; }
+  // Arrival (or send) time of the next packet, rtc::TimeMicros() clock.
+  void setArrivalTime(int64_t timeUs) { arrivalTimeUs_ = timeUs; }
 
  protected:
-  nlohmann::json parseHeader(const webrtc::RtpPacketReceived& rtpPacket);
-  nlohmann::json parseExtension(const webrtc::RtpPacketReceived& rtpPacket);
-
   nlohmann::json assembleFrame(const webrtc::RtpPacketReceived& rtpPacket);
 
  private:
+  // Drops the arrival times of an assembled frame, whose sequence numbers
+  // may wrap.
+  void erasePacketInfos(uint16_t first_seq_num, uint16_t last_seq_num);
+
   std::unique_ptr<PayloadBase> video_;
   std::unique_ptr<PayloadBase> audio_;
 
 std::map<int64_t, webrtc::RtpPacketInfo> packet_infos_;
   webrtc::video_coding::PacketBuffer packet_buffer_{512, 2048};
   std::unique_ptr<webrtc::VideoRtpDepacketizer> video_depacketizer_;
+  // Codec video_depacketizer_ and video_ were created for.
+  Codec video_codec_{Codec::kUnknown};
+  // H.264 only: turns depacketized NAL units into Annex B and keeps the
+  // SPS/PPS an IDR needs.
+  webrtc::video_coding::H264SpsPpsTracker h264_tracker_;
+  // H.265 only: the last packet seen, to tell where a frame starts.
+  bool h265_has_last_{false};
+  uint16_t h265_last_seq_{0};
+  uint32_t h265_last_timestamp_{0};
   webrtc::RtpFrameReferenceFinder reference_finder_;
 
   std::unique_ptr<PayloadFlexFec> flexfec_{new PayloadFlexFec};
+
+ protected:
+  bool headerOnly_{false};
+  Codec codec_{Codec::kUnknown};
+  int64_t arrivalTimeUs_{0};
 };
 
 class RtxPacket : public RtpPacket {
  public:
-  nlohmann::json parse(const uint8_t* buff, uint16_t length) override;
+  bool parse(const uint8_t* buff, uint16_t length, RtpRecord* record) override;
 
  protected:
 };
@@ -0,0 +1,282 @@
+#include "RtpRecord.h"
+
+#include <modules/rtp_rtcp/source/byte_io.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const uint16_t kFixedHeaderSize{12};
+const uint16_t kOneByteExtensionProfileId{0xBEDE};
+const uint16_t kTwoByteExtensionProfileId{0x1000};
+
+const char kHexDigits[] = "0123456789abcdef";
+
+std::string toHex(const uint8_t* data, size_t length) {
+  std::string hex = "0x";
+  hex.reserve(2 + length * 2);
+  for (size_t i = 0; i < length; ++i) {
+    hex += kHexDigits[data[i] >> 4];
+    hex += kHexDigits[data[i] & 0x0f];
+  }
+  return hex;
+}
+}  // namespace
+
+namespace chai {
+const size_t RtpRecord::kMaxExtensions;
+const size_t RtpRecord::kMaxExtensionBytes;
+const size_t RtpRecord::kMaxMidSize;
+
+bool RtpRecord::parseHeader(const uint8_t* buff,
+                            size_t length,
+                            bool extensions) {
+  if (length < kFixedHeaderSize || (buff[0] >> 6) != 2) {
+    return false;
+  }
+
+  RtpHeaderView& header = this->header;
+  header.version = buff[0] >> 6;
+  header.padding = (buff[0] & 0x20) != 0;
+  header.extension = (buff[0] & 0x10) != 0;
+  header.csrcCount = buff[0] & 0x0f;
+  header.marker = (buff[1] & 0x80) != 0;
+  header.payloadType = buff[1] & 0x7f;
+  header.sequenceNumber = webrtc::ByteReader<uint16_t>::ReadBigEndian(buff + 2);
+  header.timestamp = webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 4);
+  header.ssrc = webrtc::ByteReader<uint32_t>::ReadBigEndian(buff + 8);
+
+  size_t offset = kFixedHeaderSize + header.csrcCount * 4u;
+  if (offset > length) {
+    return false;
+  }
+  for (uint8_t i = 0; i < header.csrcCount; ++i) {
+    header.csrcs[i] = webrtc::ByteReader<uint32_t>::ReadBigEndian(
+        buff + kFixedHeaderSize + i * 4);
+  }
+
+  this->extensionProfile = 0;
+  this->extensionWords = 0;
+  this->extensionCount = 0;
+  this->extensionTruncated = false;
+  this->extensionValues.present = 0;
+  if (header.extension) {
+    if (offset + 4 > length) {
+      return false;
+    }
+    this->extensionProfile =
+        webrtc::ByteReader<uint16_t>::ReadBigEndian(buff + offset);
+    this->extensionWords =
+        webrtc::ByteReader<uint16_t>::ReadBigEndian(buff + offset + 2);
+    size_t extensionSize = this->extensionWords * 4u;
+    if (offset + 4 + extensionSize > length) {
+      return false;
+    }
+
+    bool oneByte = this->extensionProfile == kOneByteExtensionProfileId;
+    bool twoByte =
+        (this->extensionProfile & 0xfff0) == kTwoByteExtensionProfileId;
+    if (extensions && (oneByte || twoByte)) {
+      const uint8_t* data = buff + offset + 4;
+      size_t copied = std::min(extensionSize, kMaxExtensionBytes);
+      this->extensionTruncated = copied < extensionSize;
+      std::memcpy(this->extensionData, data, copied);
+
+      /*
+        RFC 8285 4.2, one-byte: 4-bit id, 4-bit length - 1, data; id 15
+        stops the parsing.
+        RFC 8285 4.3, two-byte: 8-bit id, 8-bit length, data.
+        In both a zero byte is padding.
+      */
+      size_t pos = 0;
+      while (pos < copied) {
+        if (data[pos] == 0) {
+          ++pos;
+          continue;
+        }
+        uint8_t id;
+        uint8_t len;
+        size_t headerSize;
+        if (oneByte) {
+          id = data[pos] >> 4;
+          len = (data[pos] & 0x0f) + 1;
+          headerSize = 1;
+          if (id == 15) {
+            break;
+          }
+        } else {
+          if (pos + 2 > copied) {
+            this->extensionTruncated = true;
+            break;
+          }
+          id = data[pos];
+          len = data[pos + 1];
+          headerSize = 2;
+        }
+        if (this->extensionCount == kMaxExtensions ||
+            pos + headerSize + len > copied) {
+          this->extensionTruncated = true;
+          break;
+        }
+        RtpExtensionView& element = this->extensions[this->extensionCount++];
+        element.id = id;
+        element.length = len;
+        element.offset = uint16_t(pos + headerSize);
+        element.type = ExtensionType::kUnknown;
+        element.decoded = false;
+        pos += headerSize + len;
+      }
+    }
+    offset += 4 + extensionSize;
+  }
+
+  header.paddingLength = 0;
+  if (header.padding) {
+    if (offset == length) {
+      return false;
+    }
+    header.paddingLength = buff[length - 1];
+    if (header.paddingLength == 0 ||
+        offset + header.paddingLength > length) {
+      return false;
+    }
+  }
+  header.headerSize = uint16_t(offset);
+  header.payloadSize = uint16_t(length - offset - header.paddingLength);
+  return true;
+}
+
+void RtpRecord::decodeExtensions(const ExtensionMap& map) {
+  for (uint8_t i = 0; i < this->extensionCount; ++i) {
+    RtpExtensionView& element = this->extensions[i];
+    element.type = map[element.id];
+    element.decoded =
+        decodeExtension(element.type, this->extensionData + element.offset,
+                        element.length, &this->extensionValues);
+  }
+}
+
+void RtpRecord::setMid(const std::string& mid) {
+  size_t size = std::min(mid.size(), kMaxMidSize);
+  std::memcpy(this->mid, mid.data(), size);
+  this->mid[size] = '\0';
+}
+
+nlohmann::json RtpRecord::toJson() const {
+  nlohmann::json json;
+  json["header"] = this->headerJson();
+  if (this->header.extension && !this->headerOnly) {
+    json["extension"] = this->extensionJson();
+  }
+  if (this->hasOsn) {
+    json["osn"] = this->osn;
+  }
+  if (this->hasDependency) {
+    json["dependency"] = this->dependency.toJson();
+  }
+  if (this->hasVp8) {
+    json["vp8_descriptor"] = this->vp8.toJson();
+  }
+  if (this->hasVp9) {
+    json["vp9_descriptor"] = this->vp9.toJson();
+  }
+  if (this->hasOpus) {
+    json["opus"] = this->opus.toJson();
+  }
+  if (this->payload) {
+    json["payload"] = *this->payload;
+  }
+  if (this->color1) {
+    json["customize"] = {{"color1", this->color1}, {"color2", this->color2}};
+  }
+
+  if (this->codec == Codec::kRtx) {
+    json["apt"] = this->apt;
+  }
+  json["codec"] = codecName(this->codec);
+  json["direction"] = this->direction == Direction::kSend ? "send" : "recv";
+  if (this->mid[0]) {
+    json["mid"] = this->mid;
+  }
+  if (this->timeUs) {
+    json["time_us"] = this->timeUs;
+  }
+  if (this->dropped || this->degraded) {
+    json["overload"] = {
+        {"header_only", this->overloaded},
+        {"dropped", this->dropped},
+        {"degraded", this->degraded},
+    };
+  }
+  return json;
+}
+
+nlohmann::json RtpHeaderView::toJson() const {
+  const RtpHeaderView& header = *this;
+  nlohmann::json json = {
+      {"version", header.version},
+      {"padding", uint8_t(header.padding)},
+      {"extension", uint8_t(header.extension)},
+      {"csrc_count", header.csrcCount},
+      {"marker", uint8_t(header.marker)},
+      {"payload_type", header.payloadType},
+      {"sequence_number", header.sequenceNumber},
+      {"timestamp", header.timestamp},
+      {"ssrc", header.ssrc},
+  };
+  if (header.csrcCount) {
+    nlohmann::json csrcs = nlohmann::json::array();
+    for (uint8_t i = 0; i < header.csrcCount; ++i) {
+      csrcs.push_back(header.csrcs[i]);
+    }
+    json["csrc"] = csrcs;
+  }
+  if (header.padding) {
+    // 最后一个字节为对齐的长度
+    json["padding_length"] = header.paddingLength;
+  }
+  return json;
+}
+
+nlohmann::json RtpRecord::headerJson() const {
+  return this->header.toJson();
+}
+
+nlohmann::json RtpRecord::extensionJson() const {
+  // 不包含profile length的长度，扩展长度为length*4字节
+  nlohmann::json json = {
+      {"profile", this->extensionProfile},
+      {"length", std::to_string(this->extensionWords) + "(" +
+                     std::to_string(this->extensionWords * 4) + ")"},
+      {"extension", nlohmann::json::array()},
+  };
+  if (this->extensionProfile == kOneByteExtensionProfileId) {
+    json["profile"] = "0xbede(oneByte)";
+  } else if ((this->extensionProfile & 0xfff0) == kTwoByteExtensionProfileId) {
+    json["profile"] = "0x1000(twoByte)";
+  }
+
+  for (uint8_t i = 0; i < this->extensionCount; ++i) {
+    const RtpExtensionView& element = this->extensions[i];
+    const uint8_t* data = this->extensionData + element.offset;
+    nlohmann::json extension = {
+        {"id", element.id},
+        {"length", element.length},
+    };
+    if (element.type != ExtensionType::kUnknown) {
+      extension["uri"] = extensionUri(element.type);
+    }
+    if (element.decoded) {
+      renderExtension(element.type, this->extensionValues, data,
+                      element.length, &extension);
+    } else {
+      extension["value"] = toHex(data, element.length);
+    }
+    json["extension"].push_back(extension);
+  }
+  if (this->extensionTruncated) {
+    json["truncated"] = true;
+  }
+  return json;
+}
+}  // namespace chai
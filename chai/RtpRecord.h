@@ -0,0 +1,126 @@
+#ifndef CHAI_RTP_RECORD_H
+#define CHAI_RTP_RECORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <json.hpp>
+#include <memory>
+
+#include "DependencyDescriptor.h"
+#include "OpusPacket.h"
+#include "PacketPool.h"
+#include "PayloadTypeTable.h"
+#include "RtpExtensions.h"
+#include "Vp8Descriptor.h"
+#include "Vp9Descriptor.h"
+
+namespace chai {
+// Fixed RTP header (RFC 3550 5.1), decoded in place.
+struct RtpHeaderView {
+  uint8_t version{0};
+  bool padding{false};
+  bool extension{false};
+  uint8_t csrcCount{0};
+  bool marker{false};
+  uint8_t payloadType{0};
+  uint16_t sequenceNumber{0};
+  uint32_t timestamp{0};
+  uint32_t ssrc{0};
+  uint32_t csrcs[15]{};
+  uint8_t paddingLength{0};
+  // Fixed header, CSRCs and extension block.
+  uint16_t headerSize{0};
+  uint16_t payloadSize{0};
+
+  nlohmann::json toJson() const;
+};
+
+// One header extension element, of either RFC 8285 profile. |offset|
+// indexes RtpRecord::extensionData.
+struct RtpExtensionView {
+  uint8_t id{0};
+  uint8_t length{0};
+  uint16_t offset{0};
+  // From the extmap, once decodeExtensions() ran.
+  ExtensionType type{ExtensionType::kUnknown};
+  // The typed fields of |type| in RtpRecord::extensionValues are set.
+  bool decoded{false};
+};
+
+// Parse result of one RTP packet. Everything the parse path produces per
+// packet lives in fixed-size fields, so filling a record allocates nothing;
+// JSON is only rendered by toJson() when a consumer wants the details.
+// Only packets completing a video frame carry a payload tree, built by the
+// payload parser.
+//
+// The extension bytes are copied, so a record stays valid after its packet
+// slot is released.
+struct RtpRecord {
+  static const size_t kMaxExtensions{16};
+  static const size_t kMaxExtensionBytes{256};
+  static const size_t kMaxMidSize{31};
+
+  // Decodes the fixed header and, with |extensions|, the header extension
+  // elements. Returns false if |buff| isn't a well-formed RTP packet.
+  bool parseHeader(const uint8_t* buff, size_t length, bool extensions);
+  // Types the parsed elements with |map| and decodes the known ones.
+  void decodeExtensions(const ExtensionMap& map);
+  void setMid(const std::string& mid);
+
+  nlohmann::json toJson() const;
+  nlohmann::json headerJson() const;
+  nlohmann::json extensionJson() const;
+
+  RtpHeaderView header;
+
+  // Header extension block; |extensionCount| is 0 if it wasn't parsed.
+  uint16_t extensionProfile{0};
+  uint16_t extensionWords{0};
+  uint8_t extensionCount{0};
+  // Elements or bytes beyond kMaxExtensions/kMaxExtensionBytes were left
+  // out.
+  bool extensionTruncated{false};
+  RtpExtensionView extensions[kMaxExtensions];
+  uint8_t extensionData[kMaxExtensionBytes];
+  RtpExtensionValues extensionValues;
+
+  Codec codec{Codec::kUnknown};
+  Direction direction{Direction::kRecv};
+  char mid[kMaxMidSize + 1]{};
+  int64_t timeUs{0};
+
+  // RTX (RFC 4588): payload type and sequence number of the original.
+  uint8_t apt{0};
+  bool hasOsn{false};
+  uint16_t osn{0};
+
+  // AV1 dependency descriptor, resolved against the stream's template
+  // structure by ParseWorker.
+  bool hasDependency{false};
+  FrameDependency dependency;
+
+  // VP8/VP9 payload descriptors, by the RtpPacket of the stream.
+  bool hasVp8{false};
+  Vp8Descriptor vp8;
+  bool hasVp9{false};
+  Vp9Descriptor vp9;
+  // Opus packet layout, by the RtpPacket of the stream.
+  bool hasOpus{false};
+  OpusPacketInfo opus;
+
+  // Colours of the packet list row, from the payload parser.
+  const char* color1{nullptr};
+  const char* color2{nullptr};
+  // Set on the packet completing a frame.
+  std::shared_ptr<const nlohmann::json> payload;
+
+  // Overload accounting of the stream, see ParseWorker.
+  bool overloaded{false};
+  bool headerOnly{false};
+  uint64_t dropped{0};
+  uint64_t degraded{0};
+};
+}  // namespace chai
+
+#endif  // CHAI_RTP_RECORD_H
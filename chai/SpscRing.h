@@ -0,0 +1,56 @@
+#ifndef CHAI_SPSC_RING_H
+#define CHAI_SPSC_RING_H
+
+#include <atomic>
+#include <stddef.h>
+
+namespace chai {
+// Bounded lock-free single-producer/single-consumer ring. |N| must be a power
+// of two. Push() may only be called from the producer thread and Pop() from
+// the consumer thread; size() is a racy snapshot usable from either side.
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N && (N & (N - 1)) == 0, "N must be a power of two");
+
+ public:
+  bool Push(const T& item) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == N) {
+      return false;
+    }
+    items_[tail & (N - 1)] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Moves up to |max| items into |out| and returns how many were taken.
+  size_t Pop(T* out, size_t max) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    size_t count = tail_.load(std::memory_order_acquire) - head;
+    if (count > max) {
+      count = max;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = items_[(head + i) & (N - 1)];
+    }
+    head_.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  // Keep the two indices on separate cache lines so the producer and the
+  // consumer don't bounce each other's line on every packet.
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) T items_[N];
+};
+}  // namespace chai
+
+#endif  // CHAI_SPSC_RING_H
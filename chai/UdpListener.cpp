@@ -0,0 +1,269 @@
+#define MSC_CLASS "UdpListener"
+
+#include "UdpListener.h"
+
+#include <arpa/inet.h>
+#include <linux/net_tstamp.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace {
+// Enough for the three timespecs of SO_TIMESTAMPING, or SO_TIMESTAMPNS.
+const size_t kControlSize{128};
+// Large enough to ride out a parse hiccup at a few hundred thousand packets
+// per second. Capped by net.core.rmem_max unless we have CAP_NET_ADMIN.
+const int kReceiveBufferSize{16 * 1024 * 1024};
+const int kPollTimeoutMs{100};
+// How long to wait for the workers to release a slot when the pool is dry.
+const auto kPoolWait = std::chrono::milliseconds(1);
+
+int64_t toUs(const timespec& ts) {
+  return int64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void toEndpoint(const sockaddr_storage& address, chai::Endpoint* endpoint) {
+  if (address.ss_family == AF_INET) {
+    const auto* in = reinterpret_cast<const sockaddr_in*>(&address);
+    endpoint->family = 4;
+    std::memcpy(endpoint->address, &in->sin_addr, 4);
+    endpoint->port = ntohs(in->sin_port);
+  } else if (address.ss_family == AF_INET6) {
+    const auto* in6 = reinterpret_cast<const sockaddr_in6*>(&address);
+    // Show v4-mapped senders of a dual-stack socket as IPv4.
+    if (IN6_IS_ADDR_V4MAPPED(&in6->sin6_addr)) {
+      endpoint->family = 4;
+      std::memcpy(endpoint->address, in6->sin6_addr.s6_addr + 12, 4);
+    } else {
+      endpoint->family = 6;
+      std::memcpy(endpoint->address, &in6->sin6_addr, 16);
+    }
+    endpoint->port = ntohs(in6->sin6_port);
+  }
+}
+}  // namespace
+
+namespace chai {
+struct UdpListener::Batch {
+  mmsghdr messages[kBatchSize];
+  iovec iovecs[kBatchSize];
+  sockaddr_storage addresses[kBatchSize];
+  alignas(cmsghdr) uint8_t controls[kBatchSize][kControlSize];
+};
+
+UdpListener::UdpListener(PacketPool* pool)
+    : pool_(pool),
+      // Not value-initialised: only the pages of the slots in use get
+      // touched.
+      storage_(new uint8_t[pool->capacity() * kMaxDatagramSize]),
+      batch_(new Batch) {
+  std::memset(this->batch_.get(), 0, sizeof(Batch));
+  this->spare_.reserve(kBatchSize);
+}
+
+UdpListener::~UdpListener() {
+  for (PacketSlot* slot : this->spare_) {
+    this->pool_->Release(slot);
+  }
+  for (const Socket& socket : this->sockets_) {
+    ::close(socket.fd);
+  }
+}
+
+bool UdpListener::bind(const std::string& address, uint16_t port) {
+  sockaddr_storage local{};
+  socklen_t localSize;
+  auto* in = reinterpret_cast<sockaddr_in*>(&local);
+  auto* in6 = reinterpret_cast<sockaddr_in6*>(&local);
+  if (address.empty()) {
+    // Dual-stack wildcard.
+    in6->sin6_family = AF_INET6;
+    in6->sin6_addr = in6addr_any;
+    in6->sin6_port = htons(port);
+    localSize = sizeof(sockaddr_in6);
+  } else if (inet_pton(AF_INET, address.c_str(), &in->sin_addr) == 1) {
+    in->sin_family = AF_INET;
+    in->sin_port = htons(port);
+    localSize = sizeof(sockaddr_in);
+  } else if (inet_pton(AF_INET6, address.c_str(), &in6->sin6_addr) == 1) {
+    in6->sin6_family = AF_INET6;
+    in6->sin6_port = htons(port);
+    localSize = sizeof(sockaddr_in6);
+  } else {
+    this->error_ = "bad address " + address;
+    return false;
+  }
+
+  int fd = ::socket(local.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                    0);
+  if (fd < 0) {
+    this->error_ = std::string("socket: ") + std::strerror(errno);
+    return false;
+  }
+
+  int off = 0;
+  if (local.ss_family == AF_INET6) {
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+  }
+  int size = kReceiveBufferSize;
+  if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0) {
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+  }
+  int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+  if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) !=
+      0) {
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+  }
+
+  if (::bind(fd, reinterpret_cast<sockaddr*>(&local), localSize) != 0) {
+    this->error_ = "bind " + (address.empty() ? "*" : address) + ":" +
+                   std::to_string(port) + ": " + std::strerror(errno);
+    ::close(fd);
+    return false;
+  }
+
+  Socket socket;
+  socket.fd = fd;
+  toEndpoint(local, &socket.local);
+  this->sockets_.push_back(socket);
+  return true;
+}
+
+void UdpListener::run(const Callback& callback) {
+  std::vector<pollfd> fds;
+  for (const Socket& socket : this->sockets_) {
+    fds.push_back({socket.fd, POLLIN, 0});
+  }
+
+  while (!this->stopped_.load(std::memory_order_relaxed)) {
+    // With no slot to receive into the datagrams stay in the socket buffer,
+    // which keeps the sockets readable: polling them now would spin.
+    if (!this->topUp()) {
+      ++this->poolWaits_;
+      std::this_thread::sleep_for(kPoolWait);
+      continue;
+    }
+    int ready = ::poll(fds.data(), fds.size(), kPollTimeoutMs);
+    if (ready < 0 && errno != EINTR) {
+      this->error_ = std::string("poll: ") + std::strerror(errno);
+      return;
+    }
+    for (size_t i = 0; ready > 0 && i < fds.size(); ++i) {
+      if (fds[i].revents & POLLIN) {
+        // Drain the socket, a full batch at a time, before polling again.
+        while (this->receive(i, callback) == kBatchSize &&
+               !this->stopped_.load(std::memory_order_relaxed)) {
+        }
+      }
+    }
+  }
+}
+
+bool UdpListener::topUp() {
+  // An exhausted pool means the workers are behind; leave the datagrams to
+  // the socket buffer until they catch up.
+  while (this->spare_.size() < kBatchSize) {
+    PacketSlot* slot = this->pool_->Acquire();
+    if (slot == nullptr) {
+      break;
+    }
+    this->spare_.push_back(slot);
+  }
+  return !this->spare_.empty();
+}
+
+size_t UdpListener::receive(size_t index, const Callback& callback) {
+  if (!this->topUp()) {
+    return 0;
+  }
+
+  // Message i goes to the i-th slot from the back of |spare_|, so the slots
+  // left unused stay at its front.
+  Batch& batch = *this->batch_;
+  size_t count = this->spare_.size();
+  for (size_t i = 0; i < count; ++i) {
+    PacketSlot* slot = this->spare_[count - 1 - i];
+    uint8_t* buffer = this->storage_.get() +
+                      this->pool_->index(slot) * kMaxDatagramSize;
+    batch.iovecs[i] = {buffer, kMaxDatagramSize};
+    msghdr& header = batch.messages[i].msg_hdr;
+    header.msg_name = &batch.addresses[i];
+    header.msg_namelen = sizeof(sockaddr_storage);
+    header.msg_iov = &batch.iovecs[i];
+    header.msg_iovlen = 1;
+    header.msg_control = batch.controls[i];
+    header.msg_controllen = kControlSize;
+    header.msg_flags = 0;
+  }
+
+  const Socket& socket = this->sockets_[index];
+  int received = ::recvmmsg(socket.fd, batch.messages, count, MSG_DONTWAIT,
+                            nullptr);
+  if (received <= 0) {
+    return 0;
+  }
+  ++this->batches_;
+  this->received_ += received;
+
+  // Fallback for datagrams the kernel didn't stamp, read at most once per
+  // batch.
+  timespec now{0, 0};
+  for (int i = 0; i < received; ++i) {
+    PacketSlot* slot = this->spare_[count - 1 - i];
+    const mmsghdr& message = batch.messages[i];
+
+    int64_t timeUs{0};
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message.msg_hdr); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&message.msg_hdr), cmsg)) {
+      if (cmsg->cmsg_level != SOL_SOCKET) {
+        continue;
+      }
+      if (cmsg->cmsg_type == SO_TIMESTAMPING) {
+        // ts[0] is the software receive time.
+        const auto* ts = reinterpret_cast<const timespec*>(CMSG_DATA(cmsg));
+        timeUs = toUs(ts[0]);
+      } else if (cmsg->cmsg_type == SO_TIMESTAMPNS) {
+        timeUs = toUs(*reinterpret_cast<const timespec*>(CMSG_DATA(cmsg)));
+      }
+    }
+    if (timeUs == 0) {
+      if (now.tv_sec == 0) {
+        clock_gettime(CLOCK_REALTIME, &now);
+      }
+      timeUs = toUs(now);
+    }
+
+    slot->data = static_cast<const uint8_t*>(batch.iovecs[i].iov_base);
+    slot->size = message.msg_len;
+    slot->timeUs = timeUs;
+    slot->direction = Direction::kRecv;
+
+    // Truncated datagrams can't be parsed.
+    PayloadKind kind = PayloadKind::kOther;
+    if ((message.msg_hdr.msg_flags & MSG_TRUNC) == 0) {
+      kind = NetDemux::classify(slot->data, slot->size);
+    }
+    if (kind == PayloadKind::kOther) {
+      this->pool_->Release(slot);
+      continue;
+    }
+    slot->kind =
+        kind == PayloadKind::kRtcp ? PacketKind::kRtcp : PacketKind::kRtp;
+
+    Flow flow;
+    toEndpoint(batch.addresses[i], &flow.source);
+    flow.destination = socket.local;
+    callback(slot, flow, kind);
+  }
+  this->spare_.resize(count - received);
+  return received;
+}
+}  // namespace chai
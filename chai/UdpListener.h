@@ -0,0 +1,83 @@
+#ifndef CHAI_UDP_LISTENER_H
+#define CHAI_UDP_LISTENER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "NetDemux.h"
+#include "PacketPool.h"
+
+namespace chai {
+// Plain RTP/UDP input, for test senders (ffmpeg, GStreamer) that don't speak
+// WebRTC. Datagrams are received straight into storage kept next to each
+// PacketPool slot, up to kBatchSize per recvmmsg() call, so a packet costs no
+// allocation and no copy on its way to the parse workers. The receive time
+// is the kernel's (SO_TIMESTAMPING), in wall clock microseconds.
+//
+// Linux only.
+class UdpListener {
+ public:
+  static const size_t kBatchSize{64};
+  static const size_t kMaxDatagramSize{2048};
+
+  // Takes ownership of |slot|: post it or release it to the pool.
+  using Callback =
+      std::function<void(PacketSlot* slot, const Flow& flow, PayloadKind kind)>;
+
+  explicit UdpListener(PacketPool* pool);
+  ~UdpListener();
+  UdpListener(const UdpListener&) = delete;
+  UdpListener& operator=(const UdpListener&) = delete;
+
+  // |address| may be empty for every local address. Call once per port.
+  bool bind(const std::string& address, uint16_t port);
+  // Receives on every bound port until stop(). Slots holding anything but
+  // RTP or RTCP (RFC 7983 demux) are released without a callback.
+  void run(const Callback& callback);
+  // Any thread.
+  void stop() { stopped_.store(true, std::memory_order_relaxed); }
+
+  uint64_t received() const { return received_; }
+  // recvmmsg() calls made, to tell how well batching works.
+  uint64_t batches() const { return batches_; }
+  // Times receiving paused because every pool slot was waiting on a worker.
+  uint64_t poolWaits() const { return poolWaits_; }
+  const std::string& error() const { return error_; }
+
+ protected:
+  // Returns the number of datagrams received, 0 when the socket is drained
+  // or there is no slot to receive into.
+  size_t receive(size_t socket, const Callback& callback);
+  // Fills |spare_| from the pool. Returns false if it is still empty.
+  bool topUp();
+
+ private:
+  struct Socket {
+    int fd{-1};
+    Endpoint local;
+  };
+  // recvmmsg() headers, addresses and control buffers, kBatchSize each.
+  struct Batch;
+
+  PacketPool* pool_{nullptr};
+  std::vector<Socket> sockets_;
+  // kMaxDatagramSize bytes per pool slot.
+  std::unique_ptr<uint8_t[]> storage_;
+  // Acquired slots not filled by the last recvmmsg(), kept for the next one.
+  std::vector<PacketSlot*> spare_;
+  std::unique_ptr<Batch> batch_;
+  std::atomic<bool> stopped_{false};
+  uint64_t received_{0};
+  uint64_t batches_{0};
+  uint64_t poolWaits_{0};
+  std::string error_;
+};
+}  // namespace chai
+
+#endif  // CHAI_UDP_LISTENER_H
@@ -0,0 +1,188 @@
+#include "VideoRtpDepacketizerH265.h"
+
+#include <modules/rtp_rtcp/source/byte_io.h>
+
+#include "PayloadH265.h"
+
+namespace {
+const size_t kNalHeaderSize{2};
+const size_t kFuHeaderSize{1};
+const size_t kLengthFieldSize{2};
+// RFC 7798 4.4.4: A, cType, PHSsize, F0, F1, F2, Y.
+const size_t kPaciHeaderSize{2};
+const uint8_t kStartCode[] = {0, 0, 0, 1};
+
+// Bit masks of the FU header.
+enum FuDefs : uint8_t { kSBit = 0x80, kFuTypeMask = 0x3f };
+
+uint8_t naluType(const uint8_t* header) {
+  return (header[0] >> 1) & 0x3f;
+}
+}  // namespace
+
+namespace chai {
+absl::optional<webrtc::VideoRtpDepacketizer::ParsedRtpPayload>
+VideoRtpDepacketizerH265::Parse(rtc::CopyOnWriteBuffer rtp_payload) {
+  if (rtp_payload.size() <= kNalHeaderSize) {
+    return absl::nullopt;
+  }
+  absl::optional<ParsedRtpPayload> parsed(absl::in_place);
+  parsed->video_header.codec = webrtc::kVideoCodecGeneric;
+  parsed->video_header.frame_type = webrtc::VideoFrameType::kVideoFrameDelta;
+  parsed->video_payload.EnsureCapacity(rtp_payload.size() + 16);
+  if (!this->parsePayload(rtp_payload.cdata(),
+                          rtp_payload.cdata() + kNalHeaderSize,
+                          rtp_payload.size() - kNalHeaderSize, &*parsed)) {
+    return absl::nullopt;
+  }
+  return parsed;
+}
+
+bool VideoRtpDepacketizerH265::parsePayload(const uint8_t header[2],
+                                            const uint8_t* data,
+                                            size_t size,
+                                            ParsedRtpPayload* parsed) {
+  switch (naluType(header)) {
+    case kH265Ap:
+      return this->parseAp(data, size, parsed);
+    case kH265Fu:
+      return this->parseFu(header, data, size, parsed);
+    case kH265Paci: {
+      /*
+        RFC 7798 4.4.4:
+         0                   1                   2                   3
+         0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+        +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        |    PayloadHdr (Type=50)       |A|   cType   | PHSsize |F0..2|Y|
+        +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        |        Payload Header Extension Structure (PHES)              |
+        |=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=|
+        |                  PACI payload: NAL unit                       |
+        |                   . . .                                       |
+      */
+      if (size < kPaciHeaderSize) {
+        return false;
+      }
+      uint8_t cType = (data[0] >> 1) & 0x3f;
+      size_t phsSize = ((data[0] & 0x01) << 4) | (data[1] >> 4);
+      if (size < kPaciHeaderSize + phsSize || cType == kH265Paci) {
+        return false;
+      }
+      // The PACI payload has the PayloadHdr, with Type replaced by cType.
+      uint8_t inner[kNalHeaderSize] = {
+          uint8_t((header[0] & 0x81) | (cType << 1)), header[1]};
+      return this->parsePayload(inner, data + kPaciHeaderSize + phsSize,
+                                size - kPaciHeaderSize - phsSize, parsed);
+    }
+    default: {
+      // Single NAL unit packet: put the header back in front of the data.
+      // |header| may be a copy, so onNalu() gets one with the first byte.
+      uint8_t peek[kNalHeaderSize + 1] = {header[0], header[1],
+                                          size ? data[0] : uint8_t(0)};
+      this->onNalu(peek, kNalHeaderSize + (size ? 1 : 0), true, parsed);
+      parsed->video_payload.AppendData(kStartCode, sizeof(kStartCode));
+      parsed->video_payload.AppendData(header, kNalHeaderSize);
+      parsed->video_payload.AppendData(data, size);
+      return true;
+    }
+  }
+}
+
+bool VideoRtpDepacketizerH265::parseAp(const uint8_t* data,
+                                       size_t size,
+                                       ParsedRtpPayload* parsed) {
+  /*
+    RFC 7798 4.4.2: PayloadHdr (Type=48), then NALU size and NALU, repeated.
+  */
+  size_t offset = 0;
+  bool first = true;
+  while (offset < size) {
+    if (offset + kLengthFieldSize > size) {
+      return false;
+    }
+    size_t naluSize =
+        webrtc::ByteReader<uint16_t>::ReadBigEndian(data + offset);
+    offset += kLengthFieldSize;
+    if (naluSize < kNalHeaderSize || offset + naluSize > size) {
+      return false;
+    }
+    this->onNalu(data + offset, naluSize, first, parsed);
+    this->appendNalu(data + offset, naluSize, parsed);
+    offset += naluSize;
+    first = false;
+  }
+  return !first;
+}
+
+bool VideoRtpDepacketizerH265::parseFu(const uint8_t header[2],
+                                       const uint8_t* data,
+                                       size_t size,
+                                       ParsedRtpPayload* parsed) {
+  /*
+    RFC 7798 4.4.3:
+     0                   1                   2                   3
+     0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    |    PayloadHdr (Type=49)       |   FU header   |               |
+    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+               |
+    |                         FU payload                            |
+
+    FU header: S, E, FuType(6).
+  */
+  if (size <= kFuHeaderSize) {
+    return false;
+  }
+  uint8_t fuHeader = data[0];
+  data += kFuHeaderSize;
+  size -= kFuHeaderSize;
+  if (!(fuHeader & kSBit)) {
+    // Continuation: the bytes go straight after the previous fragment.
+    parsed->video_payload.AppendData(data, size);
+    return true;
+  }
+  // First fragment: rebuild the NAL unit header from the PayloadHdr.
+  uint8_t nalHeader[kNalHeaderSize] = {
+      uint8_t((header[0] & 0x81) | ((fuHeader & kFuTypeMask) << 1)),
+      header[1]};
+  // onNalu() looks past the header at first_slice_segment_in_pic_flag.
+  uint8_t peek[kNalHeaderSize + 1] = {nalHeader[0], nalHeader[1], data[0]};
+  this->onNalu(peek, sizeof(peek), true, parsed);
+  parsed->video_payload.AppendData(kStartCode, sizeof(kStartCode));
+  parsed->video_payload.AppendData(nalHeader, kNalHeaderSize);
+  parsed->video_payload.AppendData(data, size);
+  return true;
+}
+
+void VideoRtpDepacketizerH265::appendNalu(const uint8_t* nalu,
+                                          size_t size,
+                                          ParsedRtpPayload* parsed) {
+  parsed->video_payload.AppendData(kStartCode, sizeof(kStartCode));
+  parsed->video_payload.AppendData(nalu, size);
+}
+
+void VideoRtpDepacketizerH265::onNalu(const uint8_t* nalu,
+                                      size_t size,
+                                      bool first,
+                                      ParsedRtpPayload* parsed) {
+  uint8_t type = naluType(nalu);
+  // Parameter sets only precede IRAP pictures in what encoders send, and a
+  // packet of them is often the only one to open a key frame.
+  if (h265IsIrap(type) || type == kH265Vps || type == kH265Sps) {
+    parsed->video_header.frame_type = webrtc::VideoFrameType::kVideoFrameKey;
+  }
+  if (!first) {
+    return;
+  }
+  bool startsAccessUnit;
+  if (type < kH265Vps) {
+    // VCL: first_slice_segment_in_pic_flag, the first bit of the slice
+    // segment header.
+    startsAccessUnit = size > kNalHeaderSize && (nalu[kNalHeaderSize] & 0x80);
+  } else {
+    startsAccessUnit = type == kH265Vps || type == kH265Sps ||
+                       type == kH265Pps || type == kH265Aud ||
+                       type == kH265PrefixSei;
+  }
+  parsed->video_header.is_first_packet_in_frame = startsAccessUnit;
+}
+}  // namespace chai
@@ -0,0 +1,52 @@
+#ifndef CHAI_VIDEO_RTP_DEPACKETIZER_H265_H
+#define CHAI_VIDEO_RTP_DEPACKETIZER_H265_H
+
+#include <modules/rtp_rtcp/source/video_rtp_depacketizer.h>
+
+#include <stdint.h>
+
+namespace chai {
+// RTP payload format for HEVC (RFC 7798), the webrtc checkout we build
+// against has no depacketizer for it. Single NAL unit packets, aggregation
+// packets (AP), fragmentation units (FU) and PACI packets are turned into an
+// Annex B byte stream, a start code in front of every NAL unit, so that the
+// default AssembleFrame() yields a whole access unit.
+//
+// DONL/DOND fields are not expected: webrtc endpoints never signal
+// sprop-max-don-diff.
+//
+// Frames go through the packet buffer as kVideoCodecGeneric. A packet with an
+// IRAP NAL unit, a VPS or an SPS is a key frame packet, and RtpPacket makes a
+// frame a key frame if any of its packets is one. A packet is
+// marked as the first of its frame when it starts with a NAL unit that can
+// only open an access unit (parameter sets, AUD, prefix SEI) or with the
+// first slice segment of a picture; RtpPacket refines that with the RTP
+// timestamps of in-order packets.
+class VideoRtpDepacketizerH265 : public webrtc::VideoRtpDepacketizer {
+ public:
+  absl::optional<ParsedRtpPayload> Parse(
+      rtc::CopyOnWriteBuffer rtp_payload) override;
+
+ protected:
+  // |header| is the two byte NAL unit header (or PayloadHdr) in front of
+  // |data|, which PACI packets rewrite.
+  bool parsePayload(const uint8_t header[2],
+                    const uint8_t* data,
+                    size_t size,
+                    ParsedRtpPayload* parsed);
+  bool parseAp(const uint8_t* data, size_t size, ParsedRtpPayload* parsed);
+  bool parseFu(const uint8_t header[2],
+               const uint8_t* data,
+               size_t size,
+               ParsedRtpPayload* parsed);
+  void appendNalu(const uint8_t* nalu, size_t size, ParsedRtpPayload* parsed);
+  // Frame type and first-packet guess from the NAL unit at the start of a
+  // packet.
+  void onNalu(const uint8_t* nalu,
+              size_t size,
+              bool first,
+              ParsedRtpPayload* parsed);
+};
+}  // namespace chai
+
+#endif  // CHAI_VIDEO_RTP_DEPACKETIZER_H265_H
@@ -0,0 +1,117 @@
+#include "Vp8Descriptor.h"
+
+namespace {
+// Bit masks of the required octet.
+enum RequiredDefs : uint8_t {
+  kXBit = 0x80,
+  kNBit = 0x20,
+  kSBit = 0x10,
+  kPidMask = 0x07,
+};
+// Bit masks of the X octet.
+enum ExtensionDefs : uint8_t {
+  kIBit = 0x80,
+  kLBit = 0x40,
+  kTBit = 0x20,
+  kKBit = 0x10,
+};
+// Bit masks of the T/K octet.
+enum TkDefs : uint8_t {
+  kTidMask = 0xc0,
+  kYBit = 0x20,
+  kKeyIdxMask = 0x1f,
+};
+}  // namespace
+
+namespace chai {
+nlohmann::json Vp8Descriptor::toJson() const {
+  nlohmann::json json = {
+      {"non_reference", this->nonReference},
+      {"start_of_partition", this->startOfPartition},
+      {"partition_id", this->partitionId},
+      {"key_frame", this->keyFrame},
+  };
+  if (this->hasPictureId) {
+    json["picture_id"] = this->pictureId;
+    json["picture_id_bits"] = this->longPictureId ? 15 : 7;
+  }
+  if (this->hasTl0PicIdx) {
+    json["tl0_pic_idx"] = this->tl0PicIdx;
+  }
+  if (this->hasTid) {
+    json["tid"] = this->tid;
+    json["layer_sync"] = this->layerSync;
+  }
+  if (this->hasKeyIdx) {
+    json["key_idx"] = this->keyIdx;
+  }
+  return json;
+}
+
+bool parseVp8Descriptor(const uint8_t* data,
+                        size_t size,
+                        Vp8Descriptor* descriptor) {
+  *descriptor = Vp8Descriptor();
+  if (size == 0) {
+    return false;
+  }
+  size_t offset = 0;
+  uint8_t required = data[offset++];
+  descriptor->nonReference = required & kNBit;
+  descriptor->startOfPartition = required & kSBit;
+  descriptor->partitionId = required & kPidMask;
+  descriptor->startOfFrame =
+      descriptor->startOfPartition && descriptor->partitionId == 0;
+  if (required & kXBit) {
+    if (offset >= size) {
+      return false;
+    }
+    uint8_t extension = data[offset++];
+    if (extension & kIBit) {
+      if (offset >= size) {
+        return false;
+      }
+      descriptor->hasPictureId = true;
+      descriptor->longPictureId = data[offset] & 0x80;
+      descriptor->pictureId = data[offset++] & 0x7f;
+      if (descriptor->longPictureId) {
+        if (offset >= size) {
+          return false;
+        }
+        descriptor->pictureId = (descriptor->pictureId << 8) | data[offset++];
+      }
+    }
+    if (extension & kLBit) {
+      if (offset >= size) {
+        return false;
+      }
+      descriptor->hasTl0PicIdx = true;
+      descriptor->tl0PicIdx = data[offset++];
+    }
+    if (extension & (kTBit | kKBit)) {
+      if (offset >= size) {
+        return false;
+      }
+      uint8_t tk = data[offset++];
+      if (extension & kTBit) {
+        descriptor->hasTid = true;
+        descriptor->tid = (tk & kTidMask) >> 6;
+        descriptor->layerSync = tk & kYBit;
+      }
+      if (extension & kKBit) {
+        descriptor->hasKeyIdx = true;
+        descriptor->keyIdx = tk & kKeyIdxMask;
+      }
+    }
+  }
+  descriptor->size = uint8_t(offset);
+  if (offset >= size) {
+    return false;
+  }
+  if (descriptor->startOfFrame) {
+    // RFC 6386 9.1: the frame tag starts the frame, P is 0 on key frames.
+    descriptor->keyFrame = !(data[offset] & 0x01);
+  }
+  return true;
+}
+}  // namespace chai
@@ -0,0 +1,61 @@
+#ifndef CHAI_VP8_DESCRIPTOR_H
+#define CHAI_VP8_DESCRIPTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <json.hpp>
+
+namespace chai {
+// VP8 payload descriptor, RFC 7741 4.2, at the start of every RTP payload:
+//
+//       0 1 2 3 4 5 6 7
+//      +-+-+-+-+-+-+-+-+
+//      |X|R|N|S|R| PID | (REQUIRED)
+//      +-+-+-+-+-+-+-+-+
+// X:   |I|L|T|K| RSV   | (OPTIONAL)
+//      +-+-+-+-+-+-+-+-+
+// I:   |M| PictureID   | (OPTIONAL)
+//      +-+-+-+-+-+-+-+-+
+//      |   PictureID   |
+//      +-+-+-+-+-+-+-+-+
+// L:   |   TL0PICIDX   | (OPTIONAL)
+//      +-+-+-+-+-+-+-+-+
+// T/K: |TID|Y| KEYIDX  | (OPTIONAL)
+//      +-+-+-+-+-+-+-+-+
+struct Vp8Descriptor {
+  nlohmann::json toJson() const;
+
+  bool nonReference{false};
+  bool startOfPartition{false};
+  uint8_t partitionId{0};
+
+  bool hasPictureId{false};
+  // 15 bits with M set, 7 bits otherwise.
+  bool longPictureId{false};
+  uint16_t pictureId{0};
+  bool hasTl0PicIdx{false};
+  uint8_t tl0PicIdx{0};
+  bool hasTid{false};
+  uint8_t tid{0};
+  bool layerSync{false};
+  bool hasKeyIdx{false};
+  uint8_t keyIdx{0};
+
+  // Descriptor bytes; the VP8 payload follows.
+  uint8_t size{0};
+  // The packet starts a frame (S set, partition 0), and of that frame:
+  // whether it is a key frame, from the frame tag. Set on the later packets
+  // of the frame too, by PayloadVP8.
+  bool startOfFrame{false};
+  bool keyFrame{false};
+};
+
+// Parses the descriptor at the start of |data| into |descriptor|. Returns
+// false if it is truncated or leaves no payload.
+bool parseVp8Descriptor(const uint8_t* data,
+                        size_t size,
+                        Vp8Descriptor* descriptor);
+}  // namespace chai
+
+#endif  // CHAI_VP8_DESCRIPTOR_H
@@ -0,0 +1,234 @@
+#include "Vp9Descriptor.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+using chai::Vp9ScalabilityStructure;
+
+// Bit masks of the required octet.
+enum RequiredDefs : uint8_t {
+  kIBit = 0x80,
+  kPBit = 0x40,
+  kLBit = 0x20,
+  kFBit = 0x10,
+  kBBit = 0x08,
+  kEBit = 0x04,
+  kVBit = 0x02,
+  kZBit = 0x01,
+};
+
+// 4.2.1:
+//      +-+-+-+-+-+-+-+-+
+// V:   | N_S |Y|G|-|-|-|
+//      +-+-+-+-+-+-+-+-+
+// Y:   |     WIDTH     | (16 bits, N_S + 1 times)
+//      |     HEIGHT    | (16 bits)
+//      +-+-+-+-+-+-+-+-+
+// G:   |      N_G      |
+//      +-+-+-+-+-+-+-+-+
+// N_G: | TID |U| R |-|-| (N_G times)
+//      +-+-+-+-+-+-+-+-+
+//      |    P_DIFF     | (R times)
+//      +-+-+-+-+-+-+-+-+
+bool parseStructure(const uint8_t* data,
+                    size_t size,
+                    size_t* offset,
+                    Vp9ScalabilityStructure* ss) {
+  *ss = Vp9ScalabilityStructure();
+  if (*offset >= size) {
+    return false;
+  }
+  uint8_t header = data[(*offset)++];
+  ss->spatialLayers = (header >> 5) + 1;
+  ss->resolutionsPresent = header & 0x10;
+  ss->gofPresent = header & 0x08;
+  if (ss->resolutionsPresent) {
+    if (*offset + 4 * ss->spatialLayers > size) {
+      return false;
+    }
+    for (int i = 0; i < ss->spatialLayers; ++i) {
+      const uint8_t* ptr = data + *offset;
+      ss->width[i] = (ptr[0] << 8) | ptr[1];
+      ss->height[i] = (ptr[2] << 8) | ptr[3];
+      *offset += 4;
+    }
+  }
+  if (ss->gofPresent) {
+    if (*offset >= size) {
+      return false;
+    }
+    ss->gofSize = data[(*offset)++];
+    for (int i = 0; i < ss->gofSize; ++i) {
+      if (*offset >= size) {
+        return false;
+      }
+      uint8_t picture = data[(*offset)++];
+      uint8_t refCount = (picture >> 2) & 0x03;
+      if (*offset + refCount > size) {
+        return false;
+      }
+      if (i < Vp9ScalabilityStructure::kMaxGofPictures) {
+        Vp9ScalabilityStructure::Picture& entry = ss->gof[i];
+        entry.tid = picture >> 5;
+        entry.switchingUp = picture & 0x10;
+        entry.refCount = refCount;
+        for (int r = 0; r < refCount; ++r) {
+          entry.pDiffs[r] = data[*offset + r];
+        }
+      }
+      *offset += refCount;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+namespace chai {
+const int Vp9ScalabilityStructure::kMaxSpatialLayers;
+const int Vp9ScalabilityStructure::kMaxGofPictures;
+const int Vp9ScalabilityStructure::kMaxRefs;
+const int Vp9Descriptor::kMaxRefs;
+
+nlohmann::json Vp9ScalabilityStructure::toJson() const {
+  nlohmann::json json = {{"spatial_layers", this->spatialLayers}};
+  if (this->resolutionsPresent) {
+    nlohmann::json resolutions = nlohmann::json::array();
+    for (int i = 0; i < this->spatialLayers; ++i) {
+      resolutions.push_back({{"width", this->width[i]},
+                             {"height", this->height[i]}});
+    }
+    json["resolutions"] = resolutions;
+  }
+  if (this->gofPresent) {
+    json["gof_size"] = this->gofSize;
+    nlohmann::json gof = nlohmann::json::array();
+    for (int i = 0; i < std::min<int>(this->gofSize, kMaxGofPictures); ++i) {
+      const Picture& picture = this->gof[i];
+      gof.push_back({
+          {"tid", picture.tid},
+          {"switching_up", picture.switchingUp},
+          {"p_diffs", std::vector<uint8_t>(picture.pDiffs,
+                                           picture.pDiffs + picture.refCount)},
+      });
+    }
+    json["gof"] = gof;
+  }
+  return json;
+}
+
+nlohmann::json Vp9Descriptor::toJson() const {
+  nlohmann::json json = {
+      {"inter_picture_predicted", this->interPicturePredicted},
+      {"flexible_mode", this->flexibleMode},
+      {"start_of_frame", this->startOfFrame},
+      {"end_of_frame", this->endOfFrame},
+      {"not_reference_for_upper_spatial", this->notReferenceForUpperSpatial},
+      {"key_frame", this->keyFrame},
+  };
+  if (this->hasPictureId) {
+    json["picture_id"] = this->pictureId;
+    json["picture_id_bits"] = this->longPictureId ? 15 : 7;
+  }
+  if (this->hasLayerIndices) {
+    json["tid"] = this->tid;
+    json["switching_up"] = this->switchingUp;
+    json["sid"] = this->sid;
+    json["inter_layer_dependency"] = this->interLayerDependency;
+  }
+  if (this->hasTl0PicIdx) {
+    json["tl0_pic_idx"] = this->tl0PicIdx;
+  }
+  if (this->pDiffCount) {
+    nlohmann::json references = nlohmann::json::array();
+    for (int i = 0; i < this->pDiffCount; ++i) {
+      // Picture ids wrap at 7 or 15 bits.
+      uint16_t mask = this->longPictureId ? 0x7fff : 0x7f;
+      references.push_back((this->pictureId - this->pDiffs[i]) & mask);
+    }
+    json["references"] = references;
+  }
+  if (this->ssAttached) {
+    json["ss"] = this->ss.toJson();
+  }
+  if (this->width) {
+    json["width"] = this->width;
+    json["height"] = this->height;
+  }
+  json["layer_bitrate"] = this->layerBitrate;
+  return json;
+}
+
+bool parseVp9Descriptor(const uint8_t* data,
+                        size_t size,
+                        Vp9Descriptor* descriptor) {
+  *descriptor = Vp9Descriptor();
+  if (size == 0) {
+    return false;
+  }
+  size_t offset = 0;
+  uint8_t required = data[offset++];
+  descriptor->interPicturePredicted = required & kPBit;
+  descriptor->flexibleMode = required & kFBit;
+  descriptor->startOfFrame = required & kBBit;
+  descriptor->endOfFrame = required & kEBit;
+  descriptor->notReferenceForUpperSpatial = required & kZBit;
+
+  descriptor->hasPictureId = required & kIBit;
+  if (descriptor->hasPictureId) {
+    if (offset >= size) {
+      return false;
+    }
+    descriptor->longPictureId = data[offset] & 0x80;
+    descriptor->pictureId = data[offset++] & 0x7f;
+    if (descriptor->longPictureId) {
+      if (offset >= size) {
+        return false;
+      }
+      descriptor->pictureId = (descriptor->pictureId << 8) | data[offset++];
+    }
+  }
+
+  descriptor->hasLayerIndices = required & kLBit;
+  if (descriptor->hasLayerIndices) {
+    if (offset >= size) {
+      return false;
+    }
+    uint8_t layer = data[offset++];
+    descriptor->tid = layer >> 5;
+    descriptor->switchingUp = layer & 0x10;
+    descriptor->sid = (layer >> 1) & 0x07;
+    descriptor->interLayerDependency = layer & 0x01;
+    if (!descriptor->flexibleMode) {
+      if (offset >= size) {
+        return false;
+      }
+      descriptor->hasTl0PicIdx = true;
+      descriptor->tl0PicIdx = data[offset++];
+    }
+  }
+
+  if (descriptor->flexibleMode && descriptor->interPicturePredicted) {
+    bool more = true;
+    while (more) {
+      if (offset >= size ||
+          descriptor->pDiffCount == Vp9Descriptor::kMaxRefs) {
+        return false;
+      }
+      uint8_t pDiff = data[offset++];
+      descriptor->pDiffs[descriptor->pDiffCount++] = pDiff >> 1;
+      more = pDiff & 0x01;
+    }
+  }
+
+  if (required & kVBit) {
+    if (!parseStructure(data, size, &offset, &descriptor->ss)) {
+      return false;
+    }
+    descriptor->ssAttached = true;
+  }
+
+  descriptor->size = uint16_t(offset);
+  return offset < size;
+}
+}  // namespace chai
@@ -0,0 +1,106 @@
+#ifndef CHAI_VP9_DESCRIPTOR_H
+#define CHAI_VP9_DESCRIPTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <json.hpp>
+
+namespace chai {
+// Scalability structure (SS) of the VP9 payload descriptor, RFC 9628 4.2.1.
+// Sent with key frames and when the layering changes; the packets in between
+// are read against the last one, so it is kept per SSRC.
+struct Vp9ScalabilityStructure {
+  // N_S is 3 bits.
+  static const int kMaxSpatialLayers{8};
+  // N_G is 8 bits; pictures past this many are counted but not kept.
+  static const int kMaxGofPictures{16};
+  static const int kMaxRefs{3};
+
+  struct Picture {
+    uint8_t tid{0};
+    bool switchingUp{false};
+    uint8_t refCount{0};
+    uint8_t pDiffs[kMaxRefs]{};
+  };
+
+  nlohmann::json toJson() const;
+
+  uint8_t spatialLayers{0};
+  bool resolutionsPresent{false};
+  uint16_t width[kMaxSpatialLayers]{};
+  uint16_t height[kMaxSpatialLayers]{};
+  bool gofPresent{false};
+  uint8_t gofSize{0};
+  Picture gof[kMaxGofPictures];
+};
+
+// VP9 payload descriptor, RFC 9628 4.2, at the start of every RTP payload:
+//
+//       0 1 2 3 4 5 6 7
+//      +-+-+-+-+-+-+-+-+
+//      |I|P|L|F|B|E|V|Z| (REQUIRED)
+//      +-+-+-+-+-+-+-+-+
+// I:   |M| PICTURE ID  | (REQUIRED)
+//      +-+-+-+-+-+-+-+-+
+// M:   | EXTENDED PID  | (RECOMMENDED)
+//      +-+-+-+-+-+-+-+-+
+// L:   | TID |U| SID |D| (Conditionally RECOMMENDED)
+//      +-+-+-+-+-+-+-+-+
+//      |   TL0PICIDX   | (non-flexible mode only)
+//      +-+-+-+-+-+-+-+-+
+// P,F: | P_DIFF      |N| (flexible mode only, up to 3 times)
+//      +-+-+-+-+-+-+-+-+
+// V:   | SS            |
+//      | ..            |
+//      +-+-+-+-+-+-+-+-+
+struct Vp9Descriptor {
+  static const int kMaxRefs{Vp9ScalabilityStructure::kMaxRefs};
+
+  nlohmann::json toJson() const;
+
+  bool interPicturePredicted{false};
+  bool flexibleMode{false};
+  bool startOfFrame{false};
+  bool endOfFrame{false};
+  bool notReferenceForUpperSpatial{false};
+
+  bool hasPictureId{false};
+  // 15 bits with M set, 7 bits otherwise.
+  bool longPictureId{false};
+  uint16_t pictureId{0};
+
+  bool hasLayerIndices{false};
+  uint8_t tid{0};
+  bool switchingUp{false};
+  uint8_t sid{0};
+  bool interLayerDependency{false};
+  bool hasTl0PicIdx{false};
+  uint8_t tl0PicIdx{0};
+
+  // Flexible mode: the pictures referenced, as picture id - P_DIFF.
+  uint8_t pDiffCount{0};
+  uint8_t pDiffs[kMaxRefs]{};
+
+  bool ssAttached{false};
+  Vp9ScalabilityStructure ss;
+
+  // Descriptor bytes; the VP9 payload follows.
+  uint16_t size{0};
+
+  // Filled by PayloadVP9 from the stream: the layer's resolution, from the
+  // last SS, and its bitrate over the last window.
+  bool keyFrame{false};
+  uint16_t width{0};
+  uint16_t height{0};
+  uint32_t layerBitrate{0};
+};
+
+// Parses the descriptor at the start of |data| into |descriptor|. Returns
+// false if it is malformed, truncated or leaves no payload.
+bool parseVp9Descriptor(const uint8_t* data,
+                        size_t size,
+                        Vp9Descriptor* descriptor);
+}  // namespace chai
+
+#endif  // CHAI_VP9_DESCRIPTOR_H
@@ -0,0 +1,396 @@
+#include "Bench.h"
+
+#include <modules/rtp_rtcp/source/byte_io.h>
+#include <modules/rtp_rtcp/source/rtp_packet_received.h>
+#include <rtc_base/bit_buffer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <json.hpp>
+#include <sstream>
+
+#include "chai/BitReader.h"
+#include "chai/RtpRecord.h"
+
+namespace {
+// The header and extension trees of the parse path before RtpRecord, kept
+// as they were so --bench compares against what every packet used to pay.
+nlohmann::json legacyHeaderJson(const webrtc::RtpPacketReceived& rtpPacket) {
+  const uint8_t extension = (rtpPacket.data()[0] & 0x10) >> 4;
+  const uint8_t padding = rtpPacket.padding_size() ? 1 : 0;
+  const uint8_t csrcCount = rtpPacket.Csrcs().size();
+  nlohmann::json header = {
+      {"version", rtpPacket.data()[0] >> 6},
+      {"padding", padding},
+      {"extension", extension},
+      {"csrc_count", rtpPacket.Csrcs().size()},
+      {"marker", (uint8_t)rtpPacket.Marker()},
+      {"payload_type", rtpPacket.PayloadType()},
+      {"sequence_number", rtpPacket.SequenceNumber()},
+      {"timestamp", rtpPacket.Timestamp()},
+      {"ssrc", rtpPacket.Ssrc()},
+  };
+  if (csrcCount) {
+    nlohmann::json csrcs = nlohmann::json::array();
+    for (auto csrc : rtpPacket.Csrcs()) {
+      csrcs.push_back(csrc);
+    }
+    header["csrc"] = csrcs;
+  }
+  if (padding) {
+    header["padding_length"] = rtpPacket.padding_size();
+  }
+  return header;
+}
+
+nlohmann::json legacyExtensionJson(
+    const webrtc::RtpPacketReceived& rtpPacket) {
+  const uint16_t kOneByteExtensionProfileId{0xBEDE};
+  const uint16_t kTwoByteExtensionProfileId{0x1000};
+  uint32_t extensionOffset = 12 + rtpPacket.Csrcs().size() * 4;
+  const uint8_t* extensionEnd = rtpPacket.data() + rtpPacket.headers_size();
+  // Past the profile and length.
+  const uint8_t* ptr = rtpPacket.data() + extensionOffset + 4;
+  std::ostringstream oss;
+
+  uint16_t profile = webrtc::ByteReader<uint16_t>::ReadBigEndian(
+      rtpPacket.data() + extensionOffset);
+  uint16_t length = webrtc::ByteReader<uint16_t>::ReadBigEndian(
+      rtpPacket.data() + extensionOffset + 2);
+  oss << length << "(" << length * 4 << ")";
+  nlohmann::json headerExtension = {
+      {"profile", profile},
+      {"length", oss.str()},
+      {"extension", nlohmann::json::array()},
+  };
+  if (profile == kOneByteExtensionProfileId) {
+    oss.str("");
+    oss << "0x" << std::hex << kOneByteExtensionProfileId << "(oneByte)";
+    headerExtension["profile"] = oss.str();
+    while (ptr < extensionEnd) {
+      uint8_t id = (*ptr & 0xF0) >> 4;
+      uint8_t len = (*ptr & 0x0F) + 1;
+      nlohmann::json extension = {{"id", id}};
+      if (id == 15u) {
+        headerExtension["extension"].push_back(extension);
+        break;
+      } else if (id != 0u) {
+        oss.str("");
+        oss << "0x";
+        ptr += 1;
+        for (uint8_t i = 0; i < len; ++i) {
+          oss << std::hex << std::setw(2) << std::setfill('0')
+              << uint16_t(ptr[i]);
+        }
+        extension["length"] = len;
+        extension["value"] = oss.str();
+        headerExtension["extension"].push_back(extension);
+        ptr += len;
+      } else {
+        extension["length"] = len;
+        headerExtension["extension"].push_back(extension);
+        break;
+      }
+    }
+  } else if ((profile & 0xfff0) == kTwoByteExtensionProfileId) {
+    oss.str("");
+    oss << "0x" << std::hex << kTwoByteExtensionProfileId << "(twoByte)";
+    headerExtension["profile"] = oss.str();
+  }
+  return headerExtension;
+}
+}  // namespace
+
+std::vector<std::vector<uint8_t>> syntheticRtpCorpus() {
+  const size_t kPackets{4096};
+  std::vector<std::vector<uint8_t>> corpus;
+  corpus.reserve(kPackets);
+  uint32_t seed{1};
+  auto next = [&seed]() {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+  };
+  uint16_t sequenceNumber{0};
+  for (size_t i = 0; i < kPackets; ++i) {
+    uint32_t roll = next() % 100;
+    bool audio = roll < 25;
+    uint8_t csrcCount = roll % 10 == 0 ? 2 : 0;
+    bool twoByte = roll % 20 == 1;
+    uint8_t padding = !audio && roll % 25 == 2 ? 4 : 0;
+
+    std::vector<uint8_t> ext;
+    if (audio) {
+      // ssrc-audio-level, then abs-send-time.
+      ext = {0x10, 0x80 | uint8_t(next() & 0x7F), 0x32, 0, 0, 0};
+    } else {
+      // abs-send-time, transport-wide-cc, then padding to a word.
+      ext = {0x32, 0, 0, 0, 0x51, 0, 0, 0};
+      ext[1] = uint8_t(next());
+      ext[5] = uint8_t(i >> 8);
+      ext[6] = uint8_t(i);
+    }
+    if (twoByte) {
+      // The same elements with a two-byte header each, and a 16-byte mid.
+      ext = {3, 3, 0, 0, 0, 5, 2, uint8_t(i >> 8), uint8_t(i), 1, 16};
+      for (int j = 0; j < 16; ++j) {
+        ext.push_back(uint8_t('a' + j));
+      }
+    }
+    while (ext.size() % 4) {
+      ext.push_back(0);
+    }
+
+    size_t payloadSize = audio ? 60 + next() % 100 : 200 + next() % 1000;
+    std::vector<uint8_t> packet(12 + csrcCount * 4 + 4 + ext.size() +
+                                payloadSize + padding);
+    uint8_t* p = packet.data();
+    p[0] = 0x80 | (padding ? 0x20 : 0) | 0x10 | csrcCount;
+    p[1] = audio ? 111 : uint8_t((roll % 7 == 0 ? 0x80 : 0) | 96);
+    webrtc::ByteWriter<uint16_t>::WriteBigEndian(p + 2, sequenceNumber++);
+    webrtc::ByteWriter<uint32_t>::WriteBigEndian(p + 4, uint32_t(i * 3000));
+    webrtc::ByteWriter<uint32_t>::WriteBigEndian(p + 8,
+                                                 audio ? 0x1111 : 0x2222);
+    p += 12;
+    for (uint8_t j = 0; j < csrcCount; ++j, p += 4) {
+      webrtc::ByteWriter<uint32_t>::WriteBigEndian(p, 0x3333 + j);
+    }
+    webrtc::ByteWriter<uint16_t>::WriteBigEndian(p, twoByte ? 0x1000 : 0xBEDE);
+    webrtc::ByteWriter<uint16_t>::WriteBigEndian(p + 2,
+                                                 uint16_t(ext.size() / 4));
+    std::copy(ext.begin(), ext.end(), p + 4);
+    if (padding) {
+      packet.back() = padding;
+    }
+    corpus.push_back(std::move(packet));
+  }
+  return corpus;
+}
+
+void benchRtpHeaders(const std::vector<std::vector<uint8_t>>& corpus) {
+  // Enough passes for about a million packets.
+  size_t passes = std::max<size_t>(1, 1000000 / corpus.size());
+  size_t checksum{0};
+  auto time = [&](const char* name, auto&& parse) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t pass = 0; pass < passes; ++pass) {
+      for (const auto& packet : corpus) {
+        checksum += parse(packet);
+      }
+    }
+    double ns = std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - start)
+                    .count() /
+                double(passes * corpus.size());
+    std::cout << nlohmann::json({{"bench", name}, {"ns_per_packet", ns}})
+                     .dump()
+              << '\n';
+    return ns;
+  };
+
+  double webrtcNs = time("webrtc+json", [](const std::vector<uint8_t>& p) {
+    webrtc::RtpPacketReceived rtpPacket;
+    if (!rtpPacket.Parse(p.data(), p.size())) {
+      return size_t(0);
+    }
+    nlohmann::json json;
+    json["header"] = legacyHeaderJson(rtpPacket);
+    if (p[0] & 0x10) {
+      json["extension"] = legacyExtensionJson(rtpPacket);
+    }
+    return json.size();
+  });
+  double eagerNs = time("record+json", [](const std::vector<uint8_t>& p) {
+    chai::RtpRecord record;
+    if (!record.parseHeader(p.data(), p.size(), true)) {
+      return size_t(0);
+    }
+    return record.toJson().size();
+  });
+  double lazyNs = time("record", [](const std::vector<uint8_t>& p) {
+    chai::RtpRecord record;
+    if (!record.parseHeader(p.data(), p.size(), true)) {
+      return size_t(0);
+    }
+    return size_t(record.header.sequenceNumber + record.extensionCount);
+  });
+
+  std::cerr << corpus.size() << " RTP packets x " << passes
+            << " passes: record is " << webrtcNs / lazyNs << "x faster than "
+            << "webrtc+json, " << eagerNs / lazyNs
+            << "x faster than record+json (checksum " << checksum << ")\n";
+}
+
+void benchBitReader() {
+  const size_t kFields{1 << 16};
+  const size_t kPasses{64};
+  // 0 for ue(v), else the width of u(n).
+  std::vector<int> widths(kFields);
+  std::vector<uint8_t> stream(kFields * 4);
+  rtc::BitBufferWriter writer(stream.data(), stream.size());
+  uint32_t seed{1};
+  for (auto& width : widths) {
+    seed = seed * 1103515245 + 12345;
+    width = (seed >> 16) % 9;
+    uint32_t value = (seed >> 8) & ((1u << (width ? width : 6)) - 1);
+    if (width) {
+      writer.WriteBits(value, width);
+    } else {
+      writer.WriteExponentialGolomb(value);
+    }
+  }
+  size_t bytes, bits;
+  writer.GetCurrentOffset(&bytes, &bits);
+  stream.resize(bytes + 1);
+
+  std::vector<uint8_t> escaped;
+  int zeros{0};
+  for (uint8_t byte : stream) {
+    if (zeros >= 2 && byte <= 3) {
+      escaped.push_back(3);
+      zeros = 0;
+    }
+    escaped.push_back(byte);
+    zeros = byte == 0 ? zeros + 1 : 0;
+  }
+
+  uint64_t checksum{0};
+  auto time = [&](const char* name, auto&& pass) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kPasses; ++i) {
+      checksum += pass();
+    }
+    double ns = std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - start)
+                    .count() /
+                double(kPasses * kFields);
+    std::cout << nlohmann::json({{"bench", name}, {"ns_per_field", ns}})
+                     .dump()
+              << '\n';
+    return ns;
+  };
+
+  double bitBufferNs = time("rtc::BitBuffer", [&]() {
+    rtc::BitBuffer buffer(stream.data(), stream.size());
+    uint64_t sum{0};
+    for (int width : widths) {
+      uint32_t value{0};
+      if (width) {
+        buffer.ReadBits(&value, width);
+      } else {
+        buffer.ReadExponentialGolomb(&value);
+      }
+      sum += value;
+    }
+    return sum;
+  });
+  double bitReaderNs = time("chai::BitReader", [&]() {
+    chai::BitReader reader(stream.data(), stream.size());
+    uint64_t sum{0};
+    for (int width : widths) {
+      sum += width ? reader.readBits(width) : reader.readUe();
+    }
+    return sum;
+  });
+  time("chai::BitReader rbsp", [&]() {
+    chai::BitReader reader(escaped.data(), escaped.size(), true);
+    uint64_t sum{0};
+    for (int width : widths) {
+      sum += width ? reader.readBits(width) : reader.readUe();
+    }
+    return sum;
+  });
+
+  std::cerr << kFields << " fields x " << kPasses
+            << " passes: BitReader is " << bitBufferNs / bitReaderNs
+            << "x faster than BitBuffer (checksum " << checksum << ")\n";
+}
+
+// The header and extension trees of the parse path before RtpRecord, kept
+// as they were so --bench compares against what every packet used to pay.
+nlohmann::json legacyHeaderJson(const webrtc::RtpPacketReceived& rtpPacket) {
+  const uint8_t extension = (rtpPacket.data()[0] & 0x10) >> 4;
+  const uint8_t padding = rtpPacket.padding_size() ? 1 : 0;
+  const uint8_t csrcCount = rtpPacket.Csrcs().size();
+  nlohmann::json header = {
+      {"version", rtpPacket.data()[0] >> 6},
+      {"padding", padding},
+      {"extension", extension},
+      {"csrc_count", rtpPacket.Csrcs().size()},
+      {"marker", (uint8_t)rtpPacket.Marker()},
+      {"payload_type", rtpPacket.PayloadType()},
+      {"sequence_number", rtpPacket.SequenceNumber()},
+      {"timestamp", rtpPacket.Timestamp()},
+      {"ssrc", rtpPacket.Ssrc()},
+  };
+  if (csrcCount) {
+    nlohmann::json csrcs = nlohmann::json::array();
+    for (auto csrc : rtpPacket.Csrcs()) {
+      csrcs.push_back(csrc);
+    }
+    header["csrc"] = csrcs;
+  }
+  if (padding) {
+    header["padding_length"] = rtpPacket.padding_size();
+  }
+  return header;
+}
+
+nlohmann::json legacyExtensionJson(
+    const webrtc::RtpPacketReceived& rtpPacket) {
+  const uint16_t kOneByteExtensionProfileId{0xBEDE};
+  const uint16_t kTwoByteExtensionProfileId{0x1000};
+  uint32_t extensionOffset = 12 + rtpPacket.Csrcs().size() * 4;
+  const uint8_t* extensionEnd = rtpPacket.data() + rtpPacket.headers_size();
+  // Past the profile and length.
+  const uint8_t* ptr = rtpPacket.data() + extensionOffset + 4;
+  std::ostringstream oss;
+
+  uint16_t profile = webrtc::ByteReader<uint16_t>::ReadBigEndian(
+      rtpPacket.data() + extensionOffset);
+  uint16_t length = webrtc::ByteReader<uint16_t>::ReadBigEndian(
+      rtpPacket.data() + extensionOffset + 2);
+  oss << length << "(" << length * 4 << ")";
+  nlohmann::json headerExtension = {
+      {"profile", profile},
+      {"length", oss.str()},
+      {"extension", nlohmann::json::array()},
+  };
+  if (profile == kOneByteExtensionProfileId) {
+    oss.str("");
+    oss << "0x" << std::hex << kOneByteExtensionProfileId << "(oneByte)";
+    headerExtension["profile"] = oss.str();
+    while (ptr < extensionEnd) {
+      uint8_t id = (*ptr & 0xF0) >> 4;
+      uint8_t len = (*ptr & 0x0F) + 1;
+      nlohmann::json extension = {{"id", id}};
+      if (id == 15u) {
+        headerExtension["extension"].push_back(extension);
+        break;
+      } else if (id != 0u) {
+        oss.str("");
+        oss << "0x";
+        ptr += 1;
+        for (uint8_t i = 0; i < len; ++i) {
+          oss << std::hex << std::setw(2) << std::setfill('0')
+              << uint16_t(ptr[i]);
+        }
+        extension["length"] = len;
+        extension["value"] = oss.str();
+        headerExtension["extension"].push_back(extension);
+        ptr += len;
+      } else {
+        extension["length"] = len;
+        headerExtension["extension"].push_back(extension);
+        break;
+      }
+    }
+  } else if ((profile & 0xfff0) == kTwoByteExtensionProfileId) {
+    oss.str("");
+    oss << "0x" << std::hex << kTwoByteExtensionProfileId << "(twoByte)";
+    headerExtension["profile"] = oss.str();
+  }
+  return headerExtension;
+}
+
@@ -0,0 +1,28 @@
+// Microbenchmarks of the parse path, run by rtceye-cli --bench. Timings go
+// to stdout as one JSON object per line, the comparison to stderr.
+
+#ifndef RTCEYE_CLI_BENCH_H
+#define RTCEYE_CLI_BENCH_H
+
+#include <stdint.h>
+
+#include <vector>
+
+// RTP packets in the mix a WebRTC call sends: mostly video with a few
+// one-byte header extensions, audio with the audio level, some CSRCs, some
+// two-byte extensions and padding. Deterministic, so runs compare.
+std::vector<std::vector<uint8_t>> syntheticRtpCorpus();
+
+// Per-packet cost of the RTP header and extension stage: webrtc's parser
+// plus the legacy JSON trees (what every packet used to pay), the typed
+// record plus a JSON tree, and the typed record alone (what a consumer that
+// renders on demand pays).
+void benchRtpHeaders(const std::vector<std::vector<uint8_t>>& corpus);
+
+// Field reads of rtc::BitBuffer against chai::BitReader on the same
+// synthetic stream of short ue(v) and u(n) fields, as found in parameter sets
+// and slice headers. The RBSP pass reads the stream with emulation
+// prevention bytes inserted, removing them on the fly.
+void benchBitReader();
+
+#endif  // RTCEYE_CLI_BENCH_H
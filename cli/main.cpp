@@ -0,0 +1,807 @@
+// Headless analyzer: streams a pcap/pcapng, rtpdump or flight recorder
+// capture, live RTP/UDP or a live interface capture, through the same parsers
+// the GUI runs behind the PeerConnection tap, and writes one JSON object per
+// line: every parsed RTP/RTCP packet, then one summary per stream.
+
+#include <modules/rtp_rtcp/source/byte_io.h>
+#include <signal.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "chai/FlightRecorder.h"
+#include "chai/NetDemux.h"
+#include "chai/PacketCapture.h"
+#include "chai/PacketPool.h"
+#include "chai/ParseWorker.h"
+#include "chai/PayloadTypeTable.h"
+#include "chai/PcapReader.h"
+#include "chai/RtpDumpReader.h"
+#include "chai/RtpRecord.h"
+#include "chai/UdpListener.h"
+
+namespace {
+const size_t kMaxWorkers{16};
+const auto kBackoff = std::chrono::microseconds(50);
+const int kCapturePollMs{100};
+
+struct Options {
+  std::string input;
+  std::string output;
+  bool summaryOnly{false};
+  bool headerOnly{false};
+  size_t workers{0};
+  uint16_t port{0};
+  std::string sdp;
+  // Flight recorder input only.
+  uint32_t lastMinutes{0};
+  std::string extract;
+  // [address:]port to receive RTP/UDP on, instead of reading a capture.
+  std::vector<std::string> listen;
+  // Interface to capture on, instead of reading a capture.
+  std::string capture;
+  std::string filter;
+  // Time the RTP parse stages on the capture instead of analyzing it.
+  bool bench{false};
+};
+
+std::atomic<bool> interrupted{false};
+// Set while listening, for the SIGINT handler.
+std::atomic<chai::UdpListener*> activeListener{nullptr};
+
+void onInterrupt(int) {
+  interrupted = true;
+  chai::UdpListener* listener = activeListener.load();
+  if (listener) {
+    listener->stop();
+  }
+}
+
+// Parse threads call in concurrently; lines are written whole.
+class JsonWriter : public chai::ParseObserver {
+ public:
+  JsonWriter(std::ostream& out, bool enabled) : out_(out), enabled_(enabled) {}
+
+  void onRtpRecord(const chai::RtpRecord& record) override {
+    if (this->enabled_) {
+      this->write(record.toJson());
+    }
+  }
+  void onRtpPakcet(nlohmann::json& json) override { this->write(json); }
+  void onRtcpPakcet(nlohmann::json& json) override { this->write(json); }
+
+  void write(const nlohmann::json& json) {
+    if (!this->enabled_) {
+      return;
+    }
+    std::string line = json.dump();
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->out_ << line << '\n';
+  }
+
+ private:
+  std::ostream& out_;
+  bool enabled_{true};
+  std::mutex mutex_;
+};
+
+// RFC 3550 appendix A.3 style per-stream accounting, done on the reader
+// thread from the fixed header only.
+struct StreamStats {
+  uint8_t payloadType{0};
+  uint64_t packets{0};
+  uint64_t bytes{0};
+  int64_t firstUs{0};
+  int64_t lastUs{0};
+  uint32_t baseSeq{0};
+  uint32_t maxSeq{0};  // extended
+  uint64_t reordered{0};
+
+  void update(const uint8_t* buff, uint32_t length, int64_t timeUs) {
+    uint16_t seq = webrtc::ByteReader<uint16_t>::ReadBigEndian(buff + 2);
+    if (this->packets == 0) {
+      this->payloadType = buff[1] & 0x7f;
+      this->firstUs = timeUs;
+      this->baseSeq = seq;
+      this->maxSeq = seq;
+    } else {
+      uint16_t delta = seq - uint16_t(this->maxSeq);
+      if (delta < 0x8000) {
+        this->maxSeq += delta;
+      } else {
+        ++this->reordered;
+      }
+    }
+    ++this->packets;
+    this->bytes += length;
+    this->lastUs = timeUs;
+  }
+
+  nlohmann::json toJson(const chai::Flow& flow, uint32_t ssrc) const {
+    int64_t expected = int64_t(this->maxSeq) - this->baseSeq + 1;
+    int64_t durationUs = this->lastUs - this->firstUs;
+    return {
+        {"stream",
+         {
+             {"flow", flow.toString()},
+             {"ssrc", ssrc},
+             {"payload_type", this->payloadType},
+             {"packets", this->packets},
+             {"bytes", this->bytes},
+             {"first_us", this->firstUs},
+             {"last_us", this->lastUs},
+             {"bitrate_bps",
+              durationUs > 0 ? this->bytes * 8 * 1000000 / durationUs : 0},
+             {"expected", expected},
+             {"lost", expected - int64_t(this->packets)},
+             {"reordered", this->reordered},
+         }},
+    };
+  }
+};
+
+void usage(const char* argv0) {
+  std::cerr
+      << "usage: " << argv0 << " [options] <capture>\n"
+      << "       " << argv0 << " [options] --listen [ADDR:]PORT ...\n"
+      << "       " << argv0 << " [options] --capture IFACE [--filter FILE]\n"
+      << "       " << argv0 << " --bench [<capture>]\n"
+      << "  <capture> is a pcap, pcapng, rtpdump or flight recorder file\n"
+      << "  --listen [ADDR:]PORT  receive RTP/RTCP on this UDP port until "
+         "interrupted; may be repeated\n"
+      << "  --capture IFACE    capture on this interface until interrupted "
+         "(needs CAP_NET_RAW)\n"
+      << "  --filter FILE      BPF program for --capture, as printed by "
+         "tcpdump -ddd\n"
+      << "  -o, --output FILE  write results to FILE instead of stdout\n"
+      << "  --summary-only     only write the per-stream summaries\n"
+      << "  --headers-only     parse RTP headers only, skip payloads\n"
+      << "  --workers N        parse threads (default: cores - 1)\n"
+      << "  --port N           only UDP flows with this source or "
+         "destination port\n"
+      << "  --sdp FILE         payload types from this SDP instead of the "
+         "built-in defaults\n"
+      << "  --bench            time RTP header parsing with and without JSON "
+         "rendering on the capture's packets, or on synthetic ones without a "
+         "capture, and the bit readers\n"
+      << "flight recorder input:\n"
+      << "  --last-minutes N   only the last N minutes of the recording\n"
+      << "  --extract FILE     write the packets to an rtpdump FILE instead "
+         "of parsing them\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if ((arg == "-o" || arg == "--output") && hasValue) {
+      options->output = argv[++i];
+    } else if (arg == "--summary-only") {
+      options->summaryOnly = true;
+    } else if (arg == "--headers-only") {
+      options->headerOnly = true;
+    } else if (arg == "--bench") {
+      options->bench = true;
+    } else if (arg == "--workers" && hasValue) {
+      options->workers = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--port" && hasValue) {
+      options->port = uint16_t(std::strtoul(argv[++i], nullptr, 10));
+    } else if (arg == "--sdp" && hasValue) {
+      options->sdp = argv[++i];
+    } else if (arg == "--last-minutes" && hasValue) {
+      options->lastMinutes = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--extract" && hasValue) {
+      options->extract = argv[++i];
+    } else if (arg == "--listen" && hasValue) {
+      options->listen.push_back(argv[++i]);
+    } else if (arg == "--capture" && hasValue) {
+      options->capture = argv[++i];
+    } else if (arg == "--filter" && hasValue) {
+      options->filter = argv[++i];
+    } else if (!arg.empty() && arg[0] != '-' && options->input.empty()) {
+      options->input = arg;
+    } else {
+      return false;
+    }
+  }
+  size_t inputs = !options->input.empty() + !options->listen.empty() +
+                  !options->capture.empty();
+  if (options->bench) {
+    // The bench replays a capture file, or makes up packets without one.
+    if (!options->listen.empty() || !options->capture.empty()) {
+      std::cerr << "--bench takes a capture file, not --listen or --capture\n";
+      return false;
+    }
+    return true;
+  }
+  // Exactly one input.
+  return inputs == 1;
+}
+// Owns the parse workers and feeds them packets from the capture readers.
+class Analyzer {
+ public:
+  Analyzer(const Options& options,
+           chai::ParseObserver* observer,
+           std::shared_ptr<const chai::PayloadTypeTable> payloadTypes)
+      : options_(options) {
+    size_t workers = options.workers;
+    if (workers == 0) {
+      workers = std::thread::hardware_concurrency();
+      workers = workers > 1 ? workers - 1 : 1;
+    }
+    workers = std::min(workers, kMaxWorkers);
+
+    this->pool_.reset(
+        new chai::PacketPool(chai::ParseWorker::kRingSize * workers));
+    for (size_t i = 0; i < workers; ++i) {
+      this->workers_.emplace_back(
+          new chai::ParseWorker(this->pool_.get(), observer));
+      // The reader waits for the workers instead of dropping, so a full ring
+      // is not an overload here.
+      this->workers_.back()->setHighWaterMark(chai::ParseWorker::kRingSize);
+      this->workers_.back()->setHeaderOnly(options.headerOnly);
+      this->workers_.back()->setPayloadTypes(payloadTypes);
+    }
+  }
+
+  bool readPcap(const std::string& path) {
+    chai::PcapReader reader;
+    if (!reader.open(path)) {
+      std::cerr << path << ": " << reader.error() << "\n";
+      return false;
+    }
+
+    chai::PcapRecord record;
+    chai::UdpDatagram datagram;
+    while (reader.next(&record)) {
+      ++this->frames_;
+      if (!chai::NetDemux::parse(record.linkType, record.data, record.length,
+                                 &datagram)) {
+        continue;
+      }
+      this->feed(datagram.flow, datagram.payload, datagram.length,
+                 record.timeUs,
+                 chai::NetDemux::classify(datagram.payload, datagram.length));
+    }
+    this->drain();
+    if (!reader.error().empty()) {
+      std::cerr << path << ": " << reader.error() << " at offset "
+                << reader.offset() << ", stopping\n";
+    }
+    return true;
+  }
+
+  bool readRtpDump(const std::string& path) {
+    chai::RtpDumpReader reader;
+    if (!reader.open(path)) {
+      std::cerr << path << ": " << reader.error() << "\n";
+      return false;
+    }
+
+    // rtpdump only records where the packets came from.
+    chai::Flow flow;
+    unsigned a, b, c, d, port;
+    if (sscanf(reader.source().c_str(), "%u.%u.%u.%u/%u", &a, &b, &c, &d,
+               &port) == 5) {
+      flow.source.family = 4;
+      flow.source.address[0] = uint8_t(a);
+      flow.source.address[1] = uint8_t(b);
+      flow.source.address[2] = uint8_t(c);
+      flow.source.address[3] = uint8_t(d);
+      flow.source.port = uint16_t(port);
+    }
+
+    chai::RtpDumpRecord record;
+    while (reader.next(&record)) {
+      ++this->frames_;
+      chai::PayloadKind kind =
+          chai::NetDemux::classify(record.data, record.length, record.rtcp);
+      this->feed(flow, record.data, record.length, record.timeUs, kind);
+    }
+    this->drain();
+    if (!reader.error().empty()) {
+      std::cerr << path << ": " << reader.error() << " at offset "
+                << reader.offset() << ", stopping\n";
+    }
+    return true;
+  }
+
+  bool readFlightRecorder(const std::string& path) {
+    chai::FlightRecorderReader reader;
+    if (!reader.open(path)) {
+      std::cerr << path << ": " << reader.error() << "\n";
+      return false;
+    }
+
+    // The recorder keeps the direction but not the addresses.
+    chai::Flow flow;
+    reader.forEach(sinceUs(reader, this->options_),
+                   [this, &flow](const chai::FlightRecord& record) {
+                     ++this->frames_;
+                     chai::PayloadKind kind = chai::NetDemux::classify(
+                         record.data, record.length,
+                         record.kind == chai::PacketKind::kRtcp);
+                     this->feed(flow, record.data, record.length,
+                                record.timeUs, kind);
+                   });
+    this->drain();
+    return true;
+  }
+
+  bool listen() {
+    chai::UdpListener listener(this->pool_.get());
+    for (const auto& listen : this->options_.listen) {
+      std::string address;
+      std::string port = listen;
+      size_t colon = listen.rfind(':');
+      if (colon != std::string::npos) {
+        address = listen.substr(0, colon);
+        port = listen.substr(colon + 1);
+        // [::1]:5004
+        if (address.size() > 1 && address.front() == '[' &&
+            address.back() == ']') {
+          address = address.substr(1, address.size() - 2);
+        }
+      }
+      if (!listener.bind(address,
+                         uint16_t(std::strtoul(port.c_str(), nullptr, 10)))) {
+        std::cerr << listener.error() << "\n";
+        return false;
+      }
+    }
+
+    activeListener = &listener;
+    signal(SIGINT, onInterrupt);
+    signal(SIGTERM, onInterrupt);
+    std::cerr << "listening, interrupt to stop\n";
+    listener.run([this](chai::PacketSlot* slot, const chai::Flow& flow,
+                        chai::PayloadKind kind) {
+      ++this->frames_;
+      uint32_t ssrc;
+      if (!this->account(flow, slot->data, slot->size, slot->timeUs, kind,
+                         &ssrc)) {
+        this->pool_->Release(slot);
+        return;
+      }
+      this->post(slot, ssrc);
+    });
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    activeListener = nullptr;
+    this->drain();
+
+    if (!listener.error().empty()) {
+      std::cerr << listener.error() << "\n";
+    }
+    std::cerr << listener.received() << " datagrams in "
+              << listener.batches() << " batches, " << listener.poolWaits()
+              << " waits for the parse workers\n";
+    return true;
+  }
+
+  bool capture() {
+    chai::PacketCapture capture;
+    if (!capture.open(this->options_.capture, this->options_.filter)) {
+      std::cerr << this->options_.capture << ": " << capture.error() << "\n";
+      return false;
+    }
+
+    signal(SIGINT, onInterrupt);
+    signal(SIGTERM, onInterrupt);
+    std::cerr << "capturing on " << this->options_.capture
+              << ", interrupt to stop\n";
+
+    // Blocks whose frames posted slots may still point into, with the
+    // posted() count of every worker once the block was fed.
+    struct HeldBlock {
+      chai::CaptureBlock block;
+      std::vector<uint64_t> posted;
+    };
+    std::deque<HeldBlock> held;
+    auto release = [this, &capture, &held](bool wait) {
+      while (!held.empty()) {
+        const HeldBlock& front = held.front();
+        bool done{true};
+        for (size_t i = 0; done && i < this->workers_.size(); ++i) {
+          done = this->workers_[i]->completed() >= front.posted[i];
+        }
+        if (!done) {
+          if (!wait) {
+            return;
+          }
+          std::this_thread::sleep_for(kBackoff);
+          continue;
+        }
+        capture.release(front.block);
+        held.pop_front();
+        wait = false;
+      }
+    };
+
+    chai::CaptureBlock block;
+    chai::PcapRecord record;
+    chai::UdpDatagram datagram;
+    while (!interrupted) {
+      // With every block held the kernel has nowhere to write.
+      release(held.size() == chai::PacketCapture::kBlockCount);
+      if (!capture.next(kCapturePollMs, &block)) {
+        if (!capture.error().empty()) {
+          break;
+        }
+        continue;
+      }
+      while (capture.nextFrame(&block, &record)) {
+        ++this->frames_;
+        if (!chai::NetDemux::parse(record.linkType, record.data,
+                                   record.length, &datagram)) {
+          continue;
+        }
+        this->feed(datagram.flow, datagram.payload, datagram.length,
+                   record.timeUs,
+                   chai::NetDemux::classify(datagram.payload,
+                                            datagram.length));
+      }
+      HeldBlock heldBlock{block, {}};
+      for (const auto& worker : this->workers_) {
+        heldBlock.posted.push_back(worker->posted());
+      }
+      held.push_back(std::move(heldBlock));
+    }
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    this->drain();
+    release(false);
+
+    if (!capture.error().empty()) {
+      std::cerr << this->options_.capture << ": " << capture.error() << "\n";
+    }
+    std::cerr << capture.drops() << " frames dropped by the kernel\n";
+    return true;
+  }
+
+  static int64_t sinceUs(const chai::FlightRecorderReader& reader,
+                         const Options& options) {
+    if (options.lastMinutes == 0) {
+      return INT64_MIN;
+    }
+    return reader.lastTimeUs() - int64_t(options.lastMinutes) * 60 * 1000000;
+  }
+
+  void writeSummary(std::ostream& out) const {
+    for (const auto& stream : this->streams_) {
+      out << stream.second.toJson(stream.first.first, stream.first.second)
+                 .dump()
+          << '\n';
+    }
+    for (const auto& rtcp : this->rtcpByFlow_) {
+      out << nlohmann::json({{"rtcp_flow",
+                              {{"flow", rtcp.first.toString()},
+                               {"packets", rtcp.second}}}})
+                 .dump()
+          << '\n';
+    }
+  }
+
+  uint64_t frames() const { return this->frames_; }
+  uint64_t media() const { return this->media_; }
+  size_t streams() const { return this->streams_.size(); }
+
+ private:
+  void feed(const chai::Flow& flow,
+            const uint8_t* payload,
+            uint32_t length,
+            int64_t timeUs,
+            chai::PayloadKind kind) {
+    uint32_t ssrc;
+    if (!this->account(flow, payload, length, timeUs, kind, &ssrc)) {
+      return;
+    }
+
+    // Slots point straight into the mapped file or the capture ring, which
+    // outlive the slots.
+    chai::PacketSlot* slot;
+    while ((slot = this->pool_->Acquire()) == nullptr) {
+      std::this_thread::sleep_for(kBackoff);
+    }
+    slot->data = payload;
+    slot->size = length;
+    slot->timeUs = timeUs;
+    slot->kind = kind == chai::PayloadKind::kRtp ? chai::PacketKind::kRtp
+                                                 : chai::PacketKind::kRtcp;
+    this->post(slot, ssrc);
+  }
+
+  // Applies the port filter and updates the stream statistics. Returns false
+  // for packets that shouldn't be parsed.
+  bool account(const chai::Flow& flow,
+               const uint8_t* payload,
+               uint32_t length,
+               int64_t timeUs,
+               chai::PayloadKind kind,
+               uint32_t* ssrc) {
+    if (this->options_.port && flow.source.port != this->options_.port &&
+        flow.destination.port != this->options_.port) {
+      return false;
+    }
+
+    if (kind == chai::PayloadKind::kRtp) {
+      *ssrc = webrtc::ByteReader<uint32_t>::ReadBigEndian(payload + 8);
+      this->streams_[{flow, *ssrc}].update(payload, length, timeUs);
+    } else if (kind == chai::PayloadKind::kRtcp) {
+      *ssrc = webrtc::ByteReader<uint32_t>::ReadBigEndian(payload + 4);
+      ++this->rtcpByFlow_[flow];
+    } else {
+      return false;
+    }
+    ++this->media_;
+    return true;
+  }
+
+  void post(chai::PacketSlot* slot, uint32_t ssrc) {
+    auto& worker = this->workers_[ssrc % this->workers_.size()];
+    while (!worker->Post(slot)) {
+      std::this_thread::sleep_for(kBackoff);
+    }
+  }
+
+  void drain() {
+    for (auto& worker : this->workers_) {
+      worker->Drain();
+    }
+  }
+
+  const Options& options_;
+  std::unique_ptr<chai::PacketPool> pool_;
+  std::vector<std::unique_ptr<chai::ParseWorker>> workers_;
+  std::map<std::pair<chai::Flow, uint32_t>, StreamStats> streams_;
+  std::map<chai::Flow, uint64_t> rtcpByFlow_;
+  uint64_t frames_{0};
+  uint64_t media_{0};
+};
+
+enum class Format { kPcap, kRtpDump, kFlightRecorder, kListen, kCapture };
+
+Format probe(const std::string& path) {
+  chai::MappedFile file;
+  if (!file.open(path)) {
+    return Format::kPcap;  // let the pcap reader report the error
+  }
+  if (chai::RtpDumpReader::probe(file.data(), file.size())) {
+    return Format::kRtpDump;
+  }
+  if (chai::FlightRecorderReader::probe(file.data(), file.size())) {
+    return Format::kFlightRecorder;
+  }
+  return Format::kPcap;
+}
+
+// Copies a window of a flight recorder into an rtpdump file, keeping the
+// recorded times relative to the first packet.
+bool extractRtpDump(const Options& options) {
+  chai::FlightRecorderReader reader;
+  if (!reader.open(options.input)) {
+    std::cerr << options.input << ": " << reader.error() << "\n";
+    return false;
+  }
+  FILE* file = fopen(options.extract.c_str(), "wb");
+  if (file == nullptr) {
+    std::cerr << "can't write " << options.extract << "\n";
+    return false;
+  }
+
+  // The file header carries the wall clock time of the first packet, so it
+  // is written once that is known.
+  const char firstLine[] = "#!rtpplay1.0 0.0.0.0/0\n";
+  fwrite(firstLine, 1, sizeof(firstLine) - 1, file);
+  uint8_t header[16] = {0};
+  fwrite(header, 1, sizeof(header), file);
+
+  int64_t startUs{0};
+  uint64_t count = reader.forEach(
+      Analyzer::sinceUs(reader, options),
+      [file, &reader, &startUs, &header](const chai::FlightRecord& record) {
+        if (startUs == 0) {
+          startUs = record.timeUs;
+          int64_t wallClockUs = reader.wallClockUs(startUs);
+          webrtc::ByteWriter<uint32_t>::WriteBigEndian(
+              header, uint32_t(wallClockUs / 1000000));
+          webrtc::ByteWriter<uint32_t>::WriteBigEndian(
+              header + 4, uint32_t(wallClockUs % 1000000));
+        }
+        bool rtcp = record.kind == chai::PacketKind::kRtcp;
+        uint8_t packet[8];
+        webrtc::ByteWriter<uint16_t>::WriteBigEndian(packet,
+                                                     8 + record.length);
+        webrtc::ByteWriter<uint16_t>::WriteBigEndian(
+            packet + 2, rtcp ? 0 : record.length);
+        webrtc::ByteWriter<uint32_t>::WriteBigEndian(
+            packet + 4, uint32_t((record.timeUs - startUs) / 1000));
+        fwrite(packet, 1, sizeof(packet), file);
+        fwrite(record.data, 1, record.length, file);
+      });
+  fseek(file, sizeof(firstLine) - 1, SEEK_SET);
+  fwrite(header, 1, sizeof(header), file);
+  fclose(file);
+  std::cerr << count << " packets written to " << options.extract << "\n";
+  return true;
+}
+
+// RTP packets of a capture file, copied out so the timed loops only touch
+// packet bytes.
+bool readCorpus(const std::string& path,
+                Format format,
+                std::vector<std::vector<uint8_t>>* corpus) {
+  auto add = [corpus](const uint8_t* data, uint32_t length) {
+    if (chai::NetDemux::classify(data, length) == chai::PayloadKind::kRtp) {
+      corpus->emplace_back(data, data + length);
+    }
+  };
+
+  switch (format) {
+    case Format::kPcap: {
+      chai::PcapReader reader;
+      if (!reader.open(path)) {
+        std::cerr << path << ": " << reader.error() << "\n";
+        return false;
+      }
+      chai::PcapRecord record;
+      chai::UdpDatagram datagram;
+      while (reader.next(&record)) {
+        if (chai::NetDemux::parse(record.linkType, record.data, record.length,
+                                  &datagram)) {
+          add(datagram.payload, datagram.length);
+        }
+      }
+      return true;
+    }
+    case Format::kRtpDump: {
+      chai::RtpDumpReader reader;
+      if (!reader.open(path)) {
+        std::cerr << path << ": " << reader.error() << "\n";
+        return false;
+      }
+      chai::RtpDumpRecord record;
+      while (reader.next(&record)) {
+        if (!record.rtcp) {
+          add(record.data, record.length);
+        }
+      }
+      return true;
+    }
+    case Format::kFlightRecorder: {
+      chai::FlightRecorderReader reader;
+      if (!reader.open(path)) {
+        std::cerr << path << ": " << reader.error() << "\n";
+        return false;
+      }
+      reader.forEach(INT64_MIN, [&add](const chai::FlightRecord& record) {
+        if (record.kind == chai::PacketKind::kRtp) {
+          add(record.data, record.length);
+        }
+      });
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// Timings of the parse path on the RTP packets of a capture, or of
+// synthetic ones without a capture, see Bench.h.
+bool runBench(const Options& options) {
+  std::vector<std::vector<uint8_t>> corpus;
+  if (options.input.empty()) {
+    corpus = syntheticRtpCorpus();
+  } else if (!readCorpus(options.input, probe(options.input), &corpus)) {
+    return false;
+  }
+  if (corpus.empty()) {
+    std::cerr << "no RTP packets in " << options.input << "\n";
+    return false;
+  }
+
+  benchRtpHeaders(corpus);
+  benchBitReader();
+  return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  if (!parseOptions(argc, argv, &options)) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (options.bench) {
+    return runBench(options) ? 0 : 1;
+  }
+
+  Format format = Format::kListen;
+  if (!options.capture.empty()) {
+    format = Format::kCapture;
+  } else if (options.listen.empty()) {
+    format = probe(options.input);
+  }
+  if (!options.extract.empty()) {
+    if (format != Format::kFlightRecorder) {
+      std::cerr << "--extract needs a flight recorder file\n";
+      return 2;
+    }
+    return extractRtpDump(options) ? 0 : 1;
+  }
+
+  std::ofstream file;
+  if (!options.output.empty()) {
+    file.open(options.output, std::ios::binary);
+    if (!file) {
+      std::cerr << "can't write " << options.output << "\n";
+      return 1;
+    }
+  }
+  std::ostream& out = options.output.empty() ? std::cout : file;
+  std::ios::sync_with_stdio(false);
+
+  std::shared_ptr<const chai::PayloadTypeTable> payloadTypes;
+  if (!options.sdp.empty()) {
+    std::ifstream sdpFile(options.sdp, std::ios::binary);
+    std::string sdp((std::istreambuf_iterator<char>(sdpFile)),
+                    std::istreambuf_iterator<char>());
+    // Captures don't say which side they were taken on; assume both sides
+    // use the same payload types.
+    payloadTypes = chai::PayloadTypeTable::fromSdp(sdp, sdp);
+    if (!payloadTypes) {
+      std::cerr << "can't read payload types from " << options.sdp << "\n";
+      return 1;
+    }
+  }
+
+  JsonWriter writer(out, !options.summaryOnly);
+  Analyzer analyzer(options, &writer, payloadTypes);
+  auto start = std::chrono::steady_clock::now();
+
+  bool ok{false};
+  switch (format) {
+    case Format::kPcap:
+      ok = analyzer.readPcap(options.input);
+      break;
+    case Format::kRtpDump:
+      ok = analyzer.readRtpDump(options.input);
+      break;
+    case Format::kFlightRecorder:
+      ok = analyzer.readFlightRecorder(options.input);
+      break;
+    case Format::kListen:
+      ok = analyzer.listen();
+      break;
+    case Format::kCapture:
+      ok = analyzer.capture();
+      break;
+  }
+  if (!ok) {
+    return 1;
+  }
+  analyzer.writeSummary(out);
+  out.flush();
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  std::cerr << analyzer.frames() << " records, " << analyzer.media()
+            << " RTP/RTCP packets, " << analyzer.streams() << " streams in "
+            << seconds << " s\n";
+  return 0;
+}
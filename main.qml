@@ -129,9 +129,7 @@ Window {
                         height: video.height
 
                         onMessage: {
-                            if (type == "rtp") {
-                                packet.addRtp(msg);
-                            } else if (type == "rtcp") {
+                            if (type == "rtcp") {
                                 console.info("rtcp, %s", msg);
                             }
                         }
@@ -140,6 +138,7 @@ Window {
 
                 Packet {
                     id: packet
+                    frameSource: videoFrame
                     width: parent.width
                     height: parent.height - video.height
                     childWidth: parent.width - video.width - publish.width
@@ -207,6 +206,59 @@ Window {
                         });
                     }
                 }
+
+                // Files are named after the tab and written to the working
+                // directory.
+                Button {
+                    id: rtpDump
+                    anchors.left: video.right
+                    anchors.top: publish.bottom
+                    checkable: true
+                    text: checked ? "stop rtpdump" : "rtpdump"
+                    onToggled: {
+                        if (!checked) {
+                            videoFrame.stopRtpDump();
+                        } else if (!videoFrame.startRtpDump(tabs.getTab(tabs.currentIndex).title + ".rtpdump")) {
+                            console.error("rtpdump failed");
+                            checked = false;
+                        }
+                    }
+                }
+
+                Button {
+                    id: flightRecorder
+                    anchors.left: video.right
+                    anchors.top: rtpDump.bottom
+                    checkable: true
+                    text: checked ? "stop recorder" : "recorder"
+                    onToggled: {
+                        if (!checked) {
+                            videoFrame.stopFlightRecorder();
+                        } else if (!videoFrame.startFlightRecorder(tabs.getTab(tabs.currentIndex).title + ".flight", 256)) {
+                            console.error("flight recorder failed");
+                            checked = false;
+                        }
+                    }
+                }
+
+                // Packets the taps had to drop because parsing fell behind.
+                Text {
+                    id: tapDrops
+                    anchors.left: video.right
+                    anchors.top: flightRecorder.bottom
+                    property real drops: 0
+                    visible: drops > 0
+                    color: "red"
+                    text: qsTr("dropped %1 packets").arg(drops)
+                }
+
+                Timer {
+                    interval: 1000
+                    running: true
+                    repeat: true
+                    onTriggered: tapDrops.drops = videoFrame.tapDrops()
+                }
+
                 onMidChanged: {
                     if (mid) {
                         publish.visible = false;
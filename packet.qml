@@ -10,32 +10,25 @@ Rectangle {
     property int spacing: 16
     property int childWidth: 20
     property int childHeight: 20
-
-    function addRtp(msg) {
-        const message = JSON.parse(msg);
-        modPacket.append({info: JSON.stringify(message.header), details: msg, color1: message.customize.color1, color2: message.customize.color2});
-    }
-
+    // Lists frameSource.packets, see QmlPacketModel.
+    property var frameSource: null
 
     function clear() {
-        modPacket.clear();
+        if (control.frameSource)
+            control.frameSource.packets.clear();
     }
 
     ListView {
         id: view
         anchors.fill: parent
-        cacheBuffer: 10000
         clip: true
-        model: ListModel {
-            id: modPacket
-        }
+        model: control.frameSource ? control.frameSource.packets : null
 
         delegate: Component {
             Rectangle {
                 id: packet
                 width: control.width
                 height: control.spacing
-                property string baseText: details
                 property color startColor: color1
                 property color endColor: color2
                 gradient: Gradient {
@@ -63,7 +56,8 @@ Rectangle {
 
                     onDoubleClicked: {
                         pop.open();
-                        edit.text = JSON.stringify(JSON.parse(baseText), null, 2);
+                        const details = control.frameSource.packets.details(index);
+                        edit.text = details ? JSON.stringify(JSON.parse(details), null, 2) : qsTr("packet no longer available");
                     }
                 }
                 onActiveFocusChanged: {
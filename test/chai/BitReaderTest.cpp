@@ -0,0 +1,280 @@
+#include "BitReader.h"
+
+#include <vector>
+
+#include "Test.h"
+
+namespace {
+// Bit at a time, as the parsers read before BitReader.
+class SlowReader {
+ public:
+  explicit SlowReader(const std::vector<uint8_t>& data) : data_(data) {}
+
+  bool ok() const { return this->ok_; }
+  uint32_t readBits(int n) {
+    uint32_t value = 0;
+    for (int i = 0; i < n; ++i) {
+      if (this->pos_ >= this->data_.size() * 8) {
+        this->ok_ = false;
+        return 0;
+      }
+      uint8_t byte = this->data_[this->pos_ / 8];
+      value = (value << 1) | ((byte >> (7 - this->pos_ % 8)) & 1);
+      ++this->pos_;
+    }
+    return value;
+  }
+  uint32_t readUe() {
+    int zeros = 0;
+    while (this->ok_ && this->readBits(1) == 0) {
+      ++zeros;
+    }
+    return ((1u << zeros) | this->readBits(zeros)) - 1;
+  }
+
+ private:
+  const std::vector<uint8_t>& data_;
+  size_t pos_{0};
+  bool ok_{true};
+};
+
+class BitWriter {
+ public:
+  void writeBits(uint32_t value, int n) {
+    for (int i = n - 1; i >= 0; --i) {
+      if (this->bits_ % 8 == 0) {
+        this->data_.push_back(0);
+      }
+      this->data_.back() |= ((value >> i) & 1) << (7 - this->bits_ % 8);
+      ++this->bits_;
+    }
+  }
+  void writeUe(uint32_t value) {
+    uint64_t coded = uint64_t(value) + 1;
+    int bits = 0;
+    while ((coded >> bits) > 1) {
+      ++bits;
+    }
+    this->writeBits(0, bits);
+    this->writeBits(uint32_t(coded), bits + 1);
+  }
+  const std::vector<uint8_t>& data() const { return this->data_; }
+
+ private:
+  std::vector<uint8_t> data_;
+  size_t bits_{0};
+};
+
+// Inserts emulation prevention bytes, as an encoder does.
+std::vector<uint8_t> escape(const std::vector<uint8_t>& rbsp) {
+  std::vector<uint8_t> escaped;
+  int zeros = 0;
+  for (uint8_t byte : rbsp) {
+    if (zeros >= 2 && byte <= 3) {
+      escaped.push_back(3);
+      zeros = 0;
+    }
+    escaped.push_back(byte);
+    zeros = byte == 0 ? zeros + 1 : 0;
+  }
+  return escaped;
+}
+
+struct Field {
+  // 0 for ue(v).
+  int width;
+  uint32_t value;
+};
+
+std::vector<Field> randomFields(size_t count, uint32_t seed) {
+  std::vector<Field> fields(count);
+  for (auto& field : fields) {
+    seed = seed * 1103515245 + 12345;
+    field.width = (seed >> 16) % 33;
+    uint32_t random = seed ^ (seed << 13);
+    if (field.width == 0) {
+      // Mostly short codes, a few up to 2^31.
+      field.value = (seed >> 24) < 8 ? random >> 1 : random & 0x3f;
+    } else if (field.width < 32) {
+      field.value = random & ((1u << field.width) - 1);
+    } else {
+      field.value = random;
+    }
+  }
+  return fields;
+}
+
+std::vector<uint8_t> write(const std::vector<Field>& fields) {
+  BitWriter writer;
+  for (const auto& field : fields) {
+    if (field.width) {
+      writer.writeBits(field.value, field.width);
+    } else {
+      writer.writeUe(field.value);
+    }
+  }
+  return writer.data();
+}
+}  // namespace
+
+TEST(BitReaderMatchesBitAtATime) {
+  for (uint32_t seed = 1; seed <= 20; ++seed) {
+    auto fields = randomFields(500, seed);
+    auto data = write(fields);
+    chai::BitReader reader(data.data(), data.size());
+    SlowReader slow(data);
+    for (const auto& field : fields) {
+      uint32_t value = field.width ? reader.readBits(field.width)
+                                   : reader.readUe();
+      CHECK_EQ(value, field.width ? slow.readBits(field.width)
+                                  : slow.readUe());
+      CHECK_EQ(value, field.value);
+    }
+    CHECK(reader.ok());
+  }
+}
+
+TEST(BitReaderRbspDropsEmulationPrevention) {
+  for (uint32_t seed = 1; seed <= 20; ++seed) {
+    auto fields = randomFields(500, seed);
+    // Runs of zero bits, so the escaped stream has plenty of 00 00 03.
+    for (size_t i = 0; i < fields.size(); i += 3) {
+      fields[i].value = 0;
+      fields[i].width = fields[i].width ? fields[i].width : 24;
+    }
+    auto rbsp = write(fields);
+    auto escaped = escape(rbsp);
+    CHECK(escaped.size() > rbsp.size());
+    chai::BitReader reader(escaped.data(), escaped.size(), true);
+    for (const auto& field : fields) {
+      uint32_t value = field.width ? reader.readBits(field.width)
+                                   : reader.readUe();
+      CHECK_EQ(value, field.value);
+    }
+    CHECK(reader.ok());
+    // Offsets count RBSP bits, not the escaped ones.
+    CHECK(reader.bitOffset() <= rbsp.size() * 8);
+  }
+}
+
+TEST(BitReaderRbspKeepsEscapeAcrossRefills) {
+  // 00 00 03 straddling the eight-byte refill boundary.
+  std::vector<uint8_t> data = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                               0x00, 0x00, 0x03, 0x01, 0xff, 0xff};
+  for (int skip = 0; skip <= 40; skip += 8) {
+    chai::BitReader reader(data.data(), data.size(), true);
+    reader.skipBits(skip);
+    reader.skipBits(48 - skip);
+    CHECK_EQ(reader.readBits(16), 0u);
+    CHECK_EQ(reader.readBits(8), 0x01u);
+    CHECK_EQ(reader.readBits(16), 0xffffu);
+    CHECK(reader.ok());
+  }
+  // Without rbsp the 03 is data.
+  chai::BitReader plain(data.data(), data.size());
+  plain.skipBits(64);
+  CHECK_EQ(plain.readBits(8), 0x03u);
+}
+
+TEST(BitReaderSignedExpGolomb) {
+  BitWriter writer;
+  for (uint32_t ue : {0u, 1u, 2u, 3u, 4u, 101u, 102u}) {
+    writer.writeUe(ue);
+  }
+  auto data = writer.data();
+  chai::BitReader reader(data.data(), data.size());
+  CHECK_EQ(reader.readSe(), 0);
+  CHECK_EQ(reader.readSe(), 1);
+  CHECK_EQ(reader.readSe(), -1);
+  CHECK_EQ(reader.readSe(), 2);
+  CHECK_EQ(reader.readSe(), -2);
+  CHECK_EQ(reader.readSe(), 51);
+  CHECK_EQ(reader.readSe(), -51);
+  CHECK(reader.ok());
+}
+
+TEST(BitReaderLongUeAtTheEnd) {
+  // 2^31 - 1 needs 31 leading zeros: longer than what the CLZ path takes
+  // out of the cache, and the last field of the buffer.
+  BitWriter writer;
+  writer.writeBits(1, 3);
+  writer.writeUe(0x7fffffff);
+  auto data = writer.data();
+  chai::BitReader reader(data.data(), data.size());
+  CHECK_EQ(reader.readBits(3), 1u);
+  CHECK_EQ(reader.readUe(), 0x7fffffffu);
+  CHECK(reader.ok());
+}
+
+TEST(BitReaderOverrunClearsOk) {
+  const uint8_t data[] = {0xab, 0xcd};
+  chai::BitReader reader(data, sizeof(data));
+  CHECK_EQ(reader.readBits(12), 0xabcu);
+  CHECK(reader.ok());
+  CHECK_EQ(reader.readBits(8), 0u);
+  CHECK(!reader.ok());
+  // Stays failed, and keeps returning zeros.
+  CHECK_EQ(reader.readBits(1), 0u);
+  CHECK_EQ(reader.readUe(), 0u);
+  CHECK(!reader.ok());
+}
+
+TEST(BitReaderRejectsBadWidths) {
+  const uint8_t data[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+  chai::BitReader wide(data, sizeof(data));
+  CHECK_EQ(wide.readBits(33), 0u);
+  CHECK(!wide.ok());
+  chai::BitReader negative(data, sizeof(data));
+  CHECK_EQ(negative.readBits(-1), 0u);
+  CHECK(!negative.ok());
+  chai::BitReader zero(data, sizeof(data));
+  CHECK_EQ(zero.readBits(0), 0u);
+  CHECK(zero.ok());
+}
+
+TEST(BitReaderUeOfZerosFails) {
+  // No terminating one bit: a corrupt stream, not a huge value.
+  const uint8_t data[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  chai::BitReader reader(data, sizeof(data));
+  CHECK_EQ(reader.readUe(), 0u);
+  CHECK(!reader.ok());
+}
+
+TEST(BitReaderByteAlign) {
+  const uint8_t data[] = {0xff, 0x5a};
+  chai::BitReader reader(data, sizeof(data));
+  reader.readBits(3);
+  CHECK(!reader.byteAligned());
+  reader.byteAlign();
+  CHECK(reader.byteAligned());
+  CHECK_EQ(reader.bitOffset(), size_t(8));
+  CHECK_EQ(reader.readBits(8), 0x5au);
+  reader.byteAlign();
+  CHECK(reader.ok());
+}
+
+TEST(BitReaderAv1Fields) {
+  // leb128 300 = ac 02, le(2) 0x1234, su(4) -3 = 1101, ns(5): values below
+  // m = 3 take 2 bits, the others 3.
+  BitWriter writer;
+  writer.writeBits(0xac, 8);
+  writer.writeBits(0x02, 8);
+  writer.writeBits(0x34, 8);
+  writer.writeBits(0x12, 8);
+  writer.writeBits(0xd, 4);
+  writer.writeBits(2, 2);  // ns(5) = 2
+  writer.writeBits(7, 3);  // ns(5) = (3 << 1) - 3 + 1 = 4
+  // uvlc 5: two zeros, a one, then 5 - 3 = 10.
+  writer.writeBits(1, 3);
+  writer.writeBits(2, 2);
+  writer.writeBits(0, 2);
+  auto data = writer.data();
+  chai::BitReader reader(data.data(), data.size());
+  CHECK_EQ(reader.readLeb128(), uint64_t(300));
+  CHECK_EQ(reader.readLe(2), 0x1234u);
+  CHECK_EQ(reader.readSu(4), -3);
+  CHECK_EQ(reader.readNs(5), 2u);
+  CHECK_EQ(reader.readNs(5), 4u);
+  CHECK_EQ(reader.readUvlc(), 5u);
+  CHECK(reader.ok());
+}
@@ -0,0 +1,409 @@
+#include "DependencyDescriptor.h"
+
+#include <utility>
+#include <vector>
+
+#include "Test.h"
+
+namespace {
+class BitWriter {
+ public:
+  void writeBits(uint32_t value, int n) {
+    for (int i = n - 1; i >= 0; --i) {
+      if (this->bits_ % 8 == 0) {
+        this->data_.push_back(0);
+      }
+      this->data_.back() |= ((value >> i) & 1) << (7 - this->bits_ % 8);
+      ++this->bits_;
+    }
+  }
+  // AV1 ns(n), the inverse of BitReader::readNs.
+  void writeNs(uint32_t value, uint32_t n) {
+    if (n <= 1) {
+      return;
+    }
+    int w = 0;
+    while ((n >> w) != 0) {
+      ++w;
+    }
+    uint32_t m = (1u << w) - n;
+    if (value < m) {
+      this->writeBits(value, w - 1);
+    } else {
+      this->writeBits((value + m) >> 1, w - 1);
+      this->writeBits((value + m) & 1, 1);
+    }
+  }
+  size_t bits() const { return this->bits_; }
+  const std::vector<uint8_t>& data() const { return this->data_; }
+
+ private:
+  std::vector<uint8_t> data_;
+  size_t bits_{0};
+};
+
+struct TemplateSpec {
+  // How the next template's layer differs, 3 after the last one.
+  int nextLayerIdc;
+  std::vector<int> dtis;
+  std::vector<int> fdiffs;
+  std::vector<int> chainFdiffs;
+};
+
+struct StructureSpec {
+  int templateIdOffset;
+  int decodeTargetCount;
+  std::vector<TemplateSpec> templates;
+  int chainCount;
+  std::vector<int> protectedBy;
+  std::vector<std::pair<int, int>> resolutions;
+};
+
+// One spatial layer, two temporal ones, the way libwebrtc sends L1T2: a key
+// frame, T0 frames referencing the previous T0 two frames back and T1
+// frames referencing the T0 right before them. Decode target 0 is T0 only,
+// 1 is both; one chain through the T0 frames protects both.
+StructureSpec l1t2(int templateIdOffset) {
+  return {templateIdOffset,
+          2,
+          {{0, {2, 2}, {}, {0}}, {1, {2, 2}, {2}, {2}}, {3, {0, 1}, {1}, {1}}},
+          1,
+          {0, 0},
+          {{640, 360}}};
+}
+
+void writeStructure(BitWriter& writer, const StructureSpec& spec) {
+  writer.writeBits(spec.templateIdOffset, 6);
+  writer.writeBits(spec.decodeTargetCount - 1, 5);
+  for (const auto& tmpl : spec.templates) {
+    writer.writeBits(tmpl.nextLayerIdc, 2);
+  }
+  for (const auto& tmpl : spec.templates) {
+    for (int dti : tmpl.dtis) {
+      writer.writeBits(dti, 2);
+    }
+  }
+  for (const auto& tmpl : spec.templates) {
+    for (int fdiff : tmpl.fdiffs) {
+      writer.writeBits(1, 1);
+      writer.writeBits(fdiff - 1, 4);
+    }
+    writer.writeBits(0, 1);
+  }
+  writer.writeNs(spec.chainCount, spec.decodeTargetCount + 1);
+  if (spec.chainCount) {
+    for (int chain : spec.protectedBy) {
+      writer.writeNs(chain, spec.chainCount);
+    }
+    for (const auto& tmpl : spec.templates) {
+      for (int fdiff : tmpl.chainFdiffs) {
+        writer.writeBits(fdiff, 4);
+      }
+    }
+  }
+  writer.writeBits(!spec.resolutions.empty(), 1);
+  for (const auto& resolution : spec.resolutions) {
+    writer.writeBits(resolution.first - 1, 16);
+    writer.writeBits(resolution.second - 1, 16);
+  }
+}
+
+void writeMandatory(BitWriter& writer,
+                    bool start,
+                    bool end,
+                    int templateId,
+                    uint16_t frameNumber) {
+  writer.writeBits(start, 1);
+  writer.writeBits(end, 1);
+  writer.writeBits(templateId, 6);
+  writer.writeBits(frameNumber, 16);
+}
+
+// A single packet key frame carrying |spec|, on its first template.
+std::vector<uint8_t> keyFrame(const StructureSpec& spec, uint16_t frameNumber) {
+  BitWriter writer;
+  writeMandatory(writer, true, true, spec.templateIdOffset, frameNumber);
+  // structure attached, no active targets, nothing custom.
+  writer.writeBits(0x10, 5);
+  writeStructure(writer, spec);
+  return writer.data();
+}
+
+// Mandatory fields only, three bytes.
+std::vector<uint8_t> delta(bool start,
+                           bool end,
+                           int templateId,
+                           uint16_t frameNumber) {
+  BitWriter writer;
+  writeMandatory(writer, start, end, templateId, frameNumber);
+  return writer.data();
+}
+
+bool parse(const std::vector<uint8_t>& data,
+           chai::FrameDependencyStructure* structure,
+           bool* hasStructure,
+           chai::FrameDependency* frame) {
+  return chai::parseDependencyDescriptor(data.data(), data.size(), structure,
+                                         hasStructure, frame);
+}
+
+bool onPacket(chai::FrameDependencyGraph& graph,
+              const std::vector<uint8_t>& data,
+              uint16_t sequenceNumber,
+              chai::FrameDependency* frame) {
+  *frame = chai::FrameDependency();
+  return graph.onPacket(data.data(), data.size(), sequenceNumber, frame);
+}
+}  // namespace
+
+TEST(DependencyDescriptorAttachedStructure) {
+  chai::FrameDependencyStructure structure;
+  bool hasStructure = false;
+  chai::FrameDependency frame;
+  CHECK(parse(keyFrame(l1t2(10), 100), &structure, &hasStructure, &frame));
+  CHECK(hasStructure);
+  CHECK_EQ(structure.templateIdOffset, uint8_t(10));
+  CHECK_EQ(structure.decodeTargetCount, uint8_t(2));
+  CHECK_EQ(structure.templateCount, uint8_t(3));
+  CHECK_EQ(structure.chainCount, uint8_t(1));
+  CHECK_EQ(structure.maxSpatialId, uint8_t(0));
+  CHECK_EQ(structure.maxTemporalId, uint8_t(1));
+  CHECK_EQ(structure.templates[2].temporalId, uint8_t(1));
+  CHECK_EQ(structure.templates[1].fdiffCount, uint8_t(1));
+  CHECK_EQ(structure.templates[1].fdiffs[0], uint8_t(2));
+  CHECK_EQ(structure.templates[1].chainFdiffs[0], uint8_t(2));
+  CHECK(structure.resolutionsPresent);
+  CHECK_EQ(structure.activeDecodeTargets, 3u);
+
+  CHECK(frame.valid);
+  CHECK(frame.structureAttached);
+  CHECK(frame.startOfFrame);
+  CHECK(frame.endOfFrame);
+  CHECK_EQ(frame.frameNumber, uint16_t(100));
+  CHECK_EQ(frame.temporalId, uint8_t(0));
+  CHECK_EQ(frame.fdiffCount, uint8_t(0));
+  CHECK_EQ(frame.chainFdiffs[0], uint8_t(0));
+  CHECK_EQ(frame.renderWidth, uint16_t(640));
+  CHECK_EQ(frame.renderHeight, uint16_t(360));
+  CHECK(frame.toJson()["dtis"] == "SS");
+}
+
+TEST(DependencyDescriptorResolvesTemplates) {
+  chai::FrameDependencyStructure structure;
+  bool hasStructure = false;
+  chai::FrameDependency frame;
+  // Template ids start at the offset and wrap at 64: 62, 63, then 0.
+  CHECK(parse(keyFrame(l1t2(62), 1), &structure, &hasStructure, &frame));
+
+  frame = chai::FrameDependency();
+  CHECK(parse(delta(true, false, 63, 2), &structure, &hasStructure, &frame));
+  CHECK(!frame.structureAttached);
+  CHECK(!frame.endOfFrame);
+  CHECK_EQ(frame.temporalId, uint8_t(0));
+  CHECK_EQ(frame.fdiffCount, uint8_t(1));
+  CHECK_EQ(frame.fdiffs[0], uint16_t(2));
+
+  frame = chai::FrameDependency();
+  CHECK(parse(delta(true, true, 0, 3), &structure, &hasStructure, &frame));
+  CHECK_EQ(frame.temporalId, uint8_t(1));
+  CHECK_EQ(frame.dtis[0], uint8_t(chai::kDtiNotPresent));
+  CHECK_EQ(frame.dtis[1], uint8_t(chai::kDtiDiscardable));
+  CHECK_EQ(frame.fdiffs[0], uint16_t(1));
+  CHECK_EQ(frame.chainFdiffs[0], uint8_t(1));
+  CHECK(frame.toJson()["dtis"] == "-D");
+
+  // Past the last template, or below the offset.
+  CHECK(!parse(delta(true, true, 1, 4), &structure, &hasStructure, &frame));
+  CHECK(!parse(delta(true, true, 61, 4), &structure, &hasStructure, &frame));
+  CHECK(!frame.valid);
+}
+
+TEST(DependencyDescriptorNeedsStructure) {
+  chai::FrameDependencyStructure structure;
+  bool hasStructure = false;
+  chai::FrameDependency frame;
+  CHECK(!parse(delta(true, false, 5, 0x1234), &structure, &hasStructure,
+               &frame));
+  CHECK(!hasStructure);
+  // The mandatory fields are read anyway.
+  CHECK(frame.startOfFrame);
+  CHECK_EQ(frame.templateId, uint8_t(5));
+  CHECK_EQ(frame.frameNumber, uint16_t(0x1234));
+  CHECK(frame.toJson()["error"] == "unresolved");
+  CHECK(!parse({0x80, 0x00}, &structure, &hasStructure, &frame));
+}
+
+TEST(DependencyDescriptorCustomFields) {
+  chai::FrameDependencyStructure structure;
+  bool hasStructure = false;
+  chai::FrameDependency frame;
+  CHECK(parse(keyFrame(l1t2(0), 1), &structure, &hasStructure, &frame));
+
+  BitWriter writer;
+  writeMandatory(writer, true, true, 1, 2);
+  // Active targets, custom dtis, fdiffs and chains.
+  writer.writeBits(0x0f, 5);
+  writer.writeBits(1, 2);  // only decode target 0
+  writer.writeBits(3, 2);
+  writer.writeBits(1, 2);
+  // fdiffs 3, 20 and 4096, in 4, 8 and 12 bits.
+  writer.writeBits(1, 2);
+  writer.writeBits(2, 4);
+  writer.writeBits(2, 2);
+  writer.writeBits(19, 8);
+  writer.writeBits(3, 2);
+  writer.writeBits(4095, 12);
+  writer.writeBits(0, 2);
+  writer.writeBits(7, 8);
+  frame = chai::FrameDependency();
+  CHECK(parse(writer.data(), &structure, &hasStructure, &frame));
+  CHECK_EQ(frame.activeDecodeTargets, 1u);
+  CHECK_EQ(frame.dtis[0], uint8_t(chai::kDtiRequired));
+  CHECK_EQ(frame.dtis[1], uint8_t(chai::kDtiDiscardable));
+  CHECK_EQ(frame.fdiffCount, uint8_t(3));
+  CHECK_EQ(frame.fdiffs[0], uint16_t(3));
+  CHECK_EQ(frame.fdiffs[1], uint16_t(20));
+  CHECK_EQ(frame.fdiffs[2], uint16_t(4096));
+  CHECK_EQ(frame.chainFdiffs[0], uint8_t(7));
+
+  // The active targets stick to the structure until the next one.
+  frame = chai::FrameDependency();
+  CHECK(parse(delta(true, true, 1, 3), &structure, &hasStructure, &frame));
+  CHECK_EQ(frame.activeDecodeTargets, 1u);
+  CHECK_EQ(frame.fdiffCount, uint8_t(1));
+  CHECK(parse(keyFrame(l1t2(0), 4), &structure, &hasStructure, &frame));
+  CHECK_EQ(frame.activeDecodeTargets, 3u);
+
+  // More custom fdiffs than a frame keeps.
+  BitWriter many;
+  writeMandatory(many, true, true, 1, 5);
+  many.writeBits(0x02, 5);
+  for (int i = 0; i < chai::FrameDependency::kMaxFdiffs + 1; ++i) {
+    many.writeBits(1, 2);
+    many.writeBits(0, 4);
+  }
+  many.writeBits(0, 2);
+  CHECK(!parse(many.data(), &structure, &hasStructure, &frame));
+}
+
+TEST(DependencyDescriptorRejectsTruncation) {
+  const auto full = keyFrame(l1t2(0), 1);
+  for (size_t size = 0; size < full.size(); ++size) {
+    std::vector<uint8_t> data(full.begin(), full.begin() + size);
+    chai::FrameDependencyStructure structure;
+    bool hasStructure = false;
+    chai::FrameDependency frame;
+    CHECK(!parse(data, &structure, &hasStructure, &frame));
+    CHECK(!hasStructure);
+  }
+
+  // A broken structure leaves the one we had alone.
+  chai::FrameDependencyStructure structure;
+  bool hasStructure = false;
+  chai::FrameDependency frame;
+  CHECK(parse(keyFrame(l1t2(20), 1), &structure, &hasStructure, &frame));
+  std::vector<uint8_t> cut(full.begin(), full.begin() + 6);
+  CHECK(!parse(cut, &structure, &hasStructure, &frame));
+  CHECK(hasStructure);
+  CHECK_EQ(structure.templateIdOffset, uint8_t(20));
+  CHECK_EQ(structure.templateCount, uint8_t(3));
+}
+
+TEST(DependencyDescriptorStructureLimits) {
+  chai::FrameDependencyStructure structure;
+  bool hasStructure = false;
+  chai::FrameDependency frame;
+  StructureSpec spec = {0, 1, {}, 0, {}, {}};
+
+  // 64 templates fit, 65 don't.
+  spec.templates.assign(64, TemplateSpec{0, {2}, {}, {}});
+  spec.templates.back().nextLayerIdc = 3;
+  CHECK(parse(keyFrame(spec, 1), &structure, &hasStructure, &frame));
+  CHECK_EQ(structure.templateCount, uint8_t(64));
+  spec.templates.back().nextLayerIdc = 0;
+  spec.templates.push_back({3, {2}, {}, {}});
+  CHECK(!parse(keyFrame(spec, 1), &structure, &hasStructure, &frame));
+
+  // Four spatial layers fit, five don't.
+  spec.templates.assign(4, TemplateSpec{2, {2}, {}, {}});
+  spec.templates.back().nextLayerIdc = 3;
+  spec.resolutions.assign(4, {320, 180});
+  CHECK(parse(keyFrame(spec, 1), &structure, &hasStructure, &frame));
+  CHECK_EQ(structure.maxSpatialId, uint8_t(3));
+  spec.templates.back().nextLayerIdc = 2;
+  spec.templates.push_back({3, {2}, {}, {}});
+  spec.resolutions.push_back({320, 180});
+  CHECK(!parse(keyFrame(spec, 1), &structure, &hasStructure, &frame));
+
+  // 16 fdiffs per template fit, 17 don't.
+  spec.templates.assign(1, TemplateSpec{3, {2}, {}, {}});
+  spec.resolutions.clear();
+  spec.templates[0].fdiffs.assign(16, 1);
+  CHECK(parse(keyFrame(spec, 1), &structure, &hasStructure, &frame));
+  CHECK_EQ(frame.fdiffCount, uint8_t(16));
+  spec.templates[0].fdiffs.push_back(1);
+  CHECK(!parse(keyFrame(spec, 1), &structure, &hasStructure, &frame));
+}
+
+TEST(FrameDependencyGraphTracksDecodability) {
+  chai::FrameDependencyGraph graph;
+  chai::FrameDependency frame;
+  const int t0 = 1;
+  const int t1 = 2;
+  CHECK(onPacket(graph, keyFrame(l1t2(0), 100), 1000, &frame));
+  CHECK(frame.complete);
+  CHECK(frame.decodable);
+  CHECK_EQ(frame.decodableTargets, 3u);
+  CHECK_EQ(frame.frameId, int64_t(100));
+
+  // Two packets; complete on the second.
+  CHECK(onPacket(graph, delta(true, false, t1, 101), 1001, &frame));
+  CHECK(!frame.complete);
+  CHECK(onPacket(graph, delta(false, true, t1, 101), 1002, &frame));
+  CHECK(frame.complete);
+  CHECK(frame.decodable);
+
+  CHECK(onPacket(graph, delta(true, true, t0, 102), 1003, &frame));
+  CHECK(frame.decodable);
+  // 103, a T1, is lost: nothing depends on it.
+  CHECK(onPacket(graph, delta(true, true, t0, 104), 1005, &frame));
+  CHECK(frame.decodable);
+  CHECK_EQ(frame.decodableTargets, 3u);
+  CHECK(onPacket(graph, delta(true, true, t1, 105), 1006, &frame));
+  CHECK(frame.decodable);
+
+  // 106, a T0, is lost: the T1 on it and the chain after it break.
+  CHECK(onPacket(graph, delta(true, true, t1, 107), 1008, &frame));
+  CHECK(frame.complete);
+  CHECK(!frame.decodable);
+  CHECK_EQ(frame.decodableTargets, 0u);
+  CHECK(frame.toJson()["decodable"] == false);
+  CHECK(onPacket(graph, delta(true, true, t0, 108), 1009, &frame));
+  CHECK(!frame.decodable);
+  CHECK_EQ(frame.decodableTargets, 0u);
+
+  // Until the next key frame.
+  CHECK(onPacket(graph, keyFrame(l1t2(0), 109), 1010, &frame));
+  CHECK(frame.decodable);
+  CHECK_EQ(frame.decodableTargets, 3u);
+}
+
+TEST(FrameDependencyGraphWaitsForEveryPacket) {
+  chai::FrameDependencyGraph graph;
+  chai::FrameDependency frame;
+  // Frame numbers wrap into increasing frame ids.
+  CHECK(onPacket(graph, keyFrame(l1t2(0), 0xffff), 10, &frame));
+  CHECK_EQ(frame.frameId, int64_t(0xffff));
+  CHECK(onPacket(graph, delta(true, false, 1, 1), 11, &frame));
+  CHECK_EQ(frame.frameId, int64_t(0x10001));
+  // The middle packet comes last.
+  CHECK(onPacket(graph, delta(false, true, 1, 1), 13, &frame));
+  CHECK(!frame.complete);
+  CHECK(onPacket(graph, delta(false, false, 1, 1), 12, &frame));
+  CHECK(frame.complete);
+  CHECK(frame.decodable);
+
+  // Unresolved descriptors are not frames.
+  chai::FrameDependencyGraph empty;
+  CHECK(!onPacket(empty, delta(true, true, 1, 1), 1, &frame));
+}
@@ -0,0 +1,203 @@
+#include "OpusPacket.h"
+
+#include <vector>
+
+#include "Test.h"
+
+namespace {
+uint8_t toc(int config, bool stereo, int code) {
+  return uint8_t(config << 3 | (stereo ? 0x04 : 0) | code);
+}
+
+// |toc| followed by |size| bytes of |fill|.
+std::vector<uint8_t> packet(uint8_t toc, size_t size, uint8_t fill = 0x11) {
+  std::vector<uint8_t> data(1 + size, fill);
+  data[0] = toc;
+  return data;
+}
+
+bool parse(const std::vector<uint8_t>& data, chai::OpusPacketInfo* info) {
+  return chai::parseOpusPacket(data.data(), data.size(), info);
+}
+}  // namespace
+
+TEST(OpusTocConfigs) {
+  chai::OpusPacketInfo info;
+  CHECK(parse(packet(toc(1, false, 0), 40), &info));
+  CHECK(info.mode == chai::OpusMode::kSilk);
+  CHECK(info.bandwidth == chai::OpusBandwidth::kNarrowband);
+  CHECK_EQ(info.frameSamples, uint16_t(960));
+  CHECK(!info.stereo);
+
+  CHECK(parse(packet(toc(15, true, 0), 40), &info));
+  CHECK(info.mode == chai::OpusMode::kHybrid);
+  CHECK(info.bandwidth == chai::OpusBandwidth::kFullband);
+  CHECK_EQ(info.frameSamples, uint16_t(960));
+  CHECK(info.stereo);
+
+  CHECK(parse(packet(toc(16, false, 0), 40), &info));
+  CHECK(info.mode == chai::OpusMode::kCelt);
+  CHECK(info.bandwidth == chai::OpusBandwidth::kNarrowband);
+  CHECK_EQ(info.frameSamples, uint16_t(120));
+  CHECK(!info.hasSilk);
+
+  CHECK(parse(packet(toc(31, false, 0), 40), &info));
+  CHECK(info.bandwidth == chai::OpusBandwidth::kFullband);
+  CHECK_EQ(info.durationSamples(), 960u);
+}
+
+TEST(OpusRejectsEmptyPacket) {
+  chai::OpusPacketInfo info;
+  CHECK(!chai::parseOpusPacket(nullptr, 0, &info));
+}
+
+TEST(OpusCode0) {
+  chai::OpusPacketInfo info;
+  CHECK(parse(packet(toc(9, false, 0), 1275), &info));
+  CHECK_EQ(info.frameCount, uint8_t(1));
+  CHECK_EQ(info.frameSizes[0], uint16_t(1275));
+  CHECK(!info.dtx);
+  // R2: no frame is longer than 1275 bytes.
+  CHECK(!parse(packet(toc(9, false, 0), 1276), &info));
+  // A TOC alone, or with a single byte, is DTX.
+  CHECK(parse(packet(toc(9, false, 0), 0), &info));
+  CHECK(info.dtx);
+  CHECK(parse(packet(toc(9, false, 0), 1), &info));
+  CHECK(info.dtx);
+}
+
+TEST(OpusCode1) {
+  chai::OpusPacketInfo info;
+  CHECK(parse(packet(toc(19, false, 1), 100), &info));
+  CHECK_EQ(info.frameCount, uint8_t(2));
+  CHECK_EQ(info.frameSizes[0], uint16_t(50));
+  CHECK_EQ(info.frameSizes[1], uint16_t(50));
+  CHECK_EQ(info.durationSamples(), 1920u);
+  // R3: an odd number of bytes can't be two equal frames.
+  CHECK(!parse(packet(toc(19, false, 1), 101), &info));
+}
+
+TEST(OpusCode2) {
+  chai::OpusPacketInfo info;
+  // One-byte N1.
+  auto data = packet(toc(19, false, 2), 1);
+  data[1] = 10;
+  data.resize(1 + 1 + 10 + 25, 0x11);
+  CHECK(parse(data, &info));
+  CHECK_EQ(info.frameSizes[0], uint16_t(10));
+  CHECK_EQ(info.frameSizes[1], uint16_t(25));
+
+  // Two-byte N1: 252 + 4 * 2 = 260.
+  data = packet(toc(19, false, 2), 2);
+  data[1] = 252;
+  data[2] = 2;
+  data.resize(1 + 2 + 260 + 5, 0x11);
+  CHECK(parse(data, &info));
+  CHECK_EQ(info.frameSizes[0], uint16_t(260));
+  CHECK_EQ(info.frameSizes[1], uint16_t(5));
+
+  // R4: N1 beyond the packet, or its second byte missing.
+  data = packet(toc(19, false, 2), 5);
+  data[1] = 10;
+  CHECK(!parse(data, &info));
+  data = packet(toc(19, false, 2), 1);
+  data[1] = 253;
+  CHECK(!parse(data, &info));
+  CHECK(!parse(packet(toc(19, false, 2), 0), &info));
+}
+
+TEST(OpusCode3Cbr) {
+  chai::OpusPacketInfo info;
+  auto data = packet(toc(19, false, 3), 1 + 3 * 40);
+  data[1] = 3;
+  CHECK(parse(data, &info));
+  CHECK(!info.vbr);
+  CHECK_EQ(info.frameCount, uint8_t(3));
+  for (int i = 0; i < 3; ++i) {
+    CHECK_EQ(info.frameSizes[i], uint16_t(40));
+  }
+  CHECK_EQ(info.durationSamples(), 2880u);
+
+  // Not a multiple of the frame count.
+  data.push_back(0);
+  CHECK(!parse(data, &info));
+  // R5: no frames, or more than 120 ms of them.
+  data = packet(toc(19, false, 3), 1);
+  data[1] = 0;
+  CHECK(!parse(data, &info));
+  data = packet(toc(3, false, 3), 1 + 3 * 10);
+  data[1] = 3;  // 3 x 60 ms
+  CHECK(!parse(data, &info));
+  data[1] = 2;
+  data.pop_back();
+  data.pop_back();
+  CHECK(parse(data, &info));
+  // Missing frame count byte.
+  CHECK(!parse(packet(toc(19, false, 3), 0), &info));
+}
+
+TEST(OpusCode3VbrWithPadding) {
+  chai::OpusPacketInfo info;
+  // VBR, padded, 3 frames; padding 255 then 10: 254 + 10 bytes.
+  std::vector<uint8_t> data = {toc(19, false, 3), 0xc3, 255, 10, 20, 30};
+  data.resize(data.size() + 20 + 30 + 7 + 264, 0x11);
+  CHECK(parse(data, &info));
+  CHECK(info.vbr);
+  CHECK_EQ(info.paddingLength, uint16_t(264));
+  CHECK_EQ(info.frameSizes[0], uint16_t(20));
+  CHECK_EQ(info.frameSizes[1], uint16_t(30));
+  CHECK_EQ(info.frameSizes[2], uint16_t(7));
+
+  // R7: more padding than packet.
+  data.resize(6 + 20 + 30 + 200);
+  CHECK(!parse(data, &info));
+  // Padding length bytes running off the end.
+  data = {toc(19, false, 3), 0x41, 255, 255};
+  CHECK(!parse(data, &info));
+  // Frame lengths adding up to more than the packet.
+  data = {toc(19, false, 3), 0x83, 200, 200, 0x11, 0x11};
+  CHECK(!parse(data, &info));
+}
+
+TEST(OpusSilkVadAndLbrr) {
+  chai::OpusPacketInfo info;
+  // 20 ms mono: VAD then LBRR as the first two bits.
+  auto data = packet(toc(1, false, 0), 20, 0x00);
+  data[1] = 0x80;
+  CHECK(parse(data, &info));
+  CHECK(info.hasSilk);
+  CHECK(info.voiceActivity);
+  CHECK(!info.lbrr);
+  data[1] = 0x40;
+  CHECK(parse(data, &info));
+  CHECK(!info.voiceActivity);
+  CHECK(info.lbrr);
+
+  // 60 ms: three VAD bits, then LBRR.
+  data = packet(toc(3, false, 0), 20, 0x00);
+  data[1] = 0x20;
+  CHECK(parse(data, &info));
+  CHECK(info.voiceActivity);
+  CHECK(!info.lbrr);
+  data[1] = 0x10;
+  CHECK(parse(data, &info));
+  CHECK(!info.voiceActivity);
+  CHECK(info.lbrr);
+
+  // 20 ms stereo: the side channel flags follow the mid ones.
+  data = packet(toc(1, true, 0), 20, 0x00);
+  data[1] = 0x20;
+  CHECK(parse(data, &info));
+  CHECK(info.voiceActivity);
+  CHECK(!info.lbrr);
+  data[1] = 0x10;
+  CHECK(parse(data, &info));
+  CHECK(!info.voiceActivity);
+  CHECK(info.lbrr);
+
+  // CELT-only packets have no SILK layer to read flags from.
+  data = packet(toc(31, false, 0), 20, 0xff);
+  CHECK(parse(data, &info));
+  CHECK(!info.hasSilk);
+  CHECK(!info.voiceActivity);
+}
@@ -0,0 +1,108 @@
+#include "PacketPool.h"
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "SpscRing.h"
+#include "Test.h"
+
+TEST(PacketPoolHandsOutEverySlotOnce) {
+  chai::PacketPool pool(4);
+  CHECK_EQ(pool.capacity(), size_t(4));
+  std::set<size_t> indices;
+  std::vector<chai::PacketSlot*> slots;
+  for (int i = 0; i < 4; ++i) {
+    chai::PacketSlot* slot = pool.Acquire();
+    CHECK(slot != nullptr);
+    if (slot) {
+      CHECK(slot->next == nullptr);
+      indices.insert(pool.index(slot));
+      slots.push_back(slot);
+    }
+  }
+  CHECK_EQ(indices.size(), size_t(4));
+  CHECK(*indices.rbegin() < 4);
+
+  // Exhausted: every failed Acquire() is counted.
+  CHECK(pool.Acquire() == nullptr);
+  CHECK(pool.Acquire() == nullptr);
+  CHECK_EQ(pool.exhausted(), uint64_t(2));
+
+  pool.Release(slots.back());
+  CHECK(pool.Acquire() == slots.back());
+  CHECK_EQ(pool.exhausted(), uint64_t(2));
+}
+
+TEST(PacketPoolReleaseResetsSlots) {
+  chai::PacketPool pool(1);
+  chai::PacketSlot* slot = pool.Acquire();
+  const uint8_t data[] = {1, 2, 3};
+  slot->buffer = rtc::CopyOnWriteBuffer(data, sizeof(data));
+  slot->data = data;
+  slot->size = sizeof(data);
+  slot->timeUs = 42;
+  slot->kind = chai::PacketKind::kRtcp;
+  slot->direction = chai::Direction::kSend;
+  slot->dropped = 7;
+  pool.Release(slot);
+
+  slot = pool.Acquire();
+  CHECK(slot != nullptr);
+  if (slot) {
+    CHECK_EQ(slot->buffer.size(), size_t(0));
+    CHECK(slot->data == nullptr);
+    CHECK_EQ(slot->size, size_t(0));
+    CHECK_EQ(slot->timeUs, int64_t(0));
+    CHECK(slot->kind == chai::PacketKind::kRtp);
+    CHECK(slot->direction == chai::Direction::kRecv);
+    CHECK_EQ(slot->dropped, 0u);
+  }
+}
+
+TEST(PacketPoolReleasedFromOtherThreads) {
+  // The producer acquires and queues slots, two consumers release them, as
+  // the tap and the parse threads do.
+  static const int kPackets{100000};
+  chai::PacketPool pool(32);
+  chai::SpscRing<chai::PacketSlot*, 16> rings[2];
+  std::thread consumers[2];
+  for (int i = 0; i < 2; ++i) {
+    consumers[i] = std::thread([&pool, &ring = rings[i]] {
+      chai::PacketSlot* slots[8];
+      int released = 0;
+      while (released < kPackets / 2) {
+        size_t count = ring.Pop(slots, 8);
+        for (size_t j = 0; j < count; ++j) {
+          pool.Release(slots[j]);
+        }
+        released += int(count);
+        if (count == 0) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int i = 0; i < kPackets;) {
+    chai::PacketSlot* slot = pool.Acquire();
+    if (!slot) {
+      std::this_thread::yield();
+      continue;
+    }
+    slot->size = size_t(i);
+    while (!rings[i % 2].Push(slot)) {
+      std::this_thread::yield();
+    }
+    ++i;
+  }
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+
+  // Every slot came back, none twice.
+  std::set<chai::PacketSlot*> slots;
+  while (chai::PacketSlot* slot = pool.Acquire()) {
+    slots.insert(slot);
+  }
+  CHECK_EQ(slots.size(), pool.capacity());
+}
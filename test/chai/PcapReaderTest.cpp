@@ -0,0 +1,323 @@
+#include "PcapReader.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "Test.h"
+
+namespace {
+const uint16_t kLinkTypeEthernet{1};
+const uint16_t kLinkTypeRaw{101};
+
+// Builds capture files in either byte order.
+class Writer {
+ public:
+  explicit Writer(bool bigEndian = false) : bigEndian_(bigEndian) {}
+
+  Writer& put8(uint8_t value) {
+    this->data_.push_back(value);
+    return *this;
+  }
+  Writer& put16(uint16_t value) {
+    return this->putBytes(value, 2);
+  }
+  Writer& put32(uint32_t value) {
+    return this->putBytes(value, 4);
+  }
+  Writer& put(const std::vector<uint8_t>& bytes) {
+    this->data_.insert(this->data_.end(), bytes.begin(), bytes.end());
+    return *this;
+  }
+  Writer& pad() {
+    while (this->data_.size() % 4) {
+      this->data_.push_back(0);
+    }
+    return *this;
+  }
+
+  // pcap file header.
+  Writer& pcapHeader(uint32_t magic, uint32_t linkType) {
+    return this->put32(magic).put16(2).put16(4).put32(0).put32(0).put32(
+        65535).put32(linkType);
+  }
+  Writer& pcapRecord(uint32_t seconds,
+                     uint32_t fraction,
+                     const std::vector<uint8_t>& data) {
+    return this->put32(seconds)
+        .put32(fraction)
+        .put32(uint32_t(data.size()))
+        .put32(uint32_t(data.size()) + 4)
+        .put(data);
+  }
+
+  // pcapng blocks: |body| is written by the caller between begin() and
+  // end(), which fill in the block total length.
+  Writer& begin(uint32_t type) {
+    this->blockStart_ = this->data_.size();
+    return this->put32(type).put32(0);
+  }
+  Writer& end() {
+    this->pad();
+    uint32_t length = uint32_t(this->data_.size() - this->blockStart_ + 4);
+    this->put32(length);
+    Writer patch(this->bigEndian_);
+    patch.put32(length);
+    std::copy(patch.data_.begin(), patch.data_.end(),
+              this->data_.begin() + this->blockStart_ + 4);
+    return *this;
+  }
+  Writer& sectionHeader() {
+    return this->begin(0x0a0d0d0a)
+        .put32(0x1a2b3c4d)
+        .put16(1)
+        .put16(0)
+        .put32(0xffffffff)
+        .put32(0xffffffff)
+        .end();
+  }
+  // if_tsresol |resolution| unless 0.
+  Writer& interface(uint16_t linkType, uint8_t resolution = 0) {
+    this->begin(0x00000001).put16(linkType).put16(0).put32(0);
+    if (resolution) {
+      this->put16(9).put16(1).put8(resolution).pad();
+      this->put16(0).put16(0);
+    }
+    return this->end();
+  }
+  Writer& enhancedPacket(uint32_t id,
+                         uint64_t timestamp,
+                         const std::vector<uint8_t>& data) {
+    return this->begin(0x00000006)
+        .put32(id)
+        .put32(uint32_t(timestamp >> 32))
+        .put32(uint32_t(timestamp))
+        .put32(uint32_t(data.size()))
+        .put32(uint32_t(data.size()))
+        .put(data)
+        .end();
+  }
+
+  const std::vector<uint8_t>& data() const { return this->data_; }
+
+ private:
+  Writer& putBytes(uint32_t value, int size) {
+    for (int i = 0; i < size; ++i) {
+      int shift = this->bigEndian_ ? (size - 1 - i) * 8 : i * 8;
+      this->data_.push_back(uint8_t(value >> shift));
+    }
+    return *this;
+  }
+
+  bool bigEndian_;
+  std::vector<uint8_t> data_;
+  size_t blockStart_{0};
+};
+
+std::vector<uint8_t> bytesOf(const chai::PcapRecord& record) {
+  return std::vector<uint8_t>(record.data, record.data + record.length);
+}
+}  // namespace
+
+TEST(PcapMicroseconds) {
+  Writer writer;
+  // FCS bits above the link type are dropped.
+  writer.pcapHeader(0xa1b2c3d4, 0x10000000 | kLinkTypeEthernet)
+      .pcapRecord(2, 500, {1, 2, 3})
+      .pcapRecord(3, 0, {});
+  test::TempFile file("PcapMicroseconds", writer.data());
+  chai::PcapReader reader;
+  CHECK(reader.open(file.path()));
+  chai::PcapRecord record;
+  CHECK(reader.next(&record));
+  CHECK(bytesOf(record) == std::vector<uint8_t>({1, 2, 3}));
+  CHECK_EQ(record.originalLength, 7u);
+  CHECK_EQ(record.timeUs, int64_t(2000500));
+  CHECK_EQ(record.linkType, kLinkTypeEthernet);
+  CHECK(reader.next(&record));
+  CHECK_EQ(record.length, 0u);
+  CHECK(!reader.next(&record));
+  CHECK(reader.error().empty());
+  CHECK_EQ(reader.offset(), reader.size());
+}
+
+TEST(PcapNanosecondsBigEndian) {
+  Writer writer(true);
+  writer.pcapHeader(0xa1b23c4d, kLinkTypeRaw).pcapRecord(1, 999999999, {9});
+  test::TempFile file("PcapNanosecondsBigEndian", writer.data());
+  chai::PcapReader reader;
+  CHECK(reader.open(file.path()));
+  chai::PcapRecord record;
+  CHECK(reader.next(&record));
+  CHECK(bytesOf(record) == std::vector<uint8_t>({9}));
+  CHECK_EQ(record.timeUs, int64_t(1999999));
+  CHECK_EQ(record.linkType, kLinkTypeRaw);
+}
+
+TEST(PcapTruncatedRecord) {
+  Writer writer;
+  writer.pcapHeader(0xa1b2c3d4, kLinkTypeEthernet).pcapRecord(1, 0, {1, 2});
+  auto data = writer.data();
+  data.pop_back();
+  test::TempFile file("PcapTruncatedRecord", data);
+  chai::PcapReader reader;
+  CHECK(reader.open(file.path()));
+  chai::PcapRecord record;
+  CHECK(!reader.next(&record));
+  CHECK_EQ(reader.error(), std::string("truncated record"));
+
+  // A record length of 4 GB doesn't wrap past the check.
+  Writer huge;
+  huge.pcapHeader(0xa1b2c3d4, kLinkTypeEthernet)
+      .put32(1)
+      .put32(0)
+      .put32(0xffffffff)
+      .put32(0xffffffff)
+      .put({1, 2, 3, 4});
+  test::TempFile hugeFile("PcapTruncatedRecord2", huge.data());
+  CHECK(reader.open(hugeFile.path()));
+  CHECK(!reader.next(&record));
+}
+
+TEST(PcapRejectsOtherFiles) {
+  chai::PcapReader reader;
+  CHECK(!reader.open("PcapRejectsOtherFiles.missing"));
+  CHECK(!reader.error().empty());
+
+  test::TempFile empty("PcapRejectsOtherFiles", {});
+  CHECK(!reader.open(empty.path()));
+
+  Writer shortHeader;
+  shortHeader.put32(0xa1b2c3d4).put32(0);
+  test::TempFile shortFile("PcapRejectsOtherFiles2", shortHeader.data());
+  CHECK(!reader.open(shortFile.path()));
+  CHECK_EQ(reader.error(), std::string("not a pcap/pcapng file"));
+
+  Writer text;
+  text.put(std::vector<uint8_t>(32, 'a'));
+  test::TempFile textFile("PcapRejectsOtherFiles3", text.data());
+  CHECK(!reader.open(textFile.path()));
+}
+
+TEST(PcapngBlocks) {
+  for (bool bigEndian : {false, true}) {
+    Writer writer(bigEndian);
+    writer.sectionHeader()
+        .interface(kLinkTypeEthernet, 9)  // nanoseconds
+        .interface(kLinkTypeRaw)
+        // Name resolution, skipped.
+        .begin(0x00000004)
+        .put32(0)
+        .end()
+        .enhancedPacket(0, 5123456789ull, {1, 2, 3})
+        .enhancedPacket(1, 7000001, {4, 5})
+        // Simple packet, 3 bytes, on interface 0.
+        .begin(0x00000003)
+        .put32(3)
+        .put({6, 7, 8})
+        .end();
+    test::TempFile file("PcapngBlocks", writer.data());
+    chai::PcapReader reader;
+    CHECK(reader.open(file.path()));
+    chai::PcapRecord record;
+    CHECK(reader.next(&record));
+    CHECK(bytesOf(record) == std::vector<uint8_t>({1, 2, 3}));
+    CHECK_EQ(record.timeUs, int64_t(5123456));
+    CHECK_EQ(record.linkType, kLinkTypeEthernet);
+    CHECK(reader.next(&record));
+    CHECK(bytesOf(record) == std::vector<uint8_t>({4, 5}));
+    CHECK_EQ(record.timeUs, int64_t(7000001));
+    CHECK_EQ(record.linkType, kLinkTypeRaw);
+    CHECK(reader.next(&record));
+    CHECK(bytesOf(record) == std::vector<uint8_t>({6, 7, 8}));
+    CHECK_EQ(record.originalLength, 3u);
+    CHECK_EQ(record.linkType, kLinkTypeEthernet);
+    CHECK(!reader.next(&record));
+    CHECK(reader.error().empty());
+  }
+}
+
+TEST(PcapngSectionsScopeInterfaces) {
+  // Interface 1 of the first section is gone in the second, whose byte
+  // order differs.
+  Writer first;
+  first.sectionHeader()
+      .interface(kLinkTypeEthernet)
+      .interface(kLinkTypeRaw)
+      .enhancedPacket(1, 1, {1});
+  Writer second(true);
+  second.sectionHeader()
+      .interface(kLinkTypeRaw)
+      .enhancedPacket(1, 2, {2})
+      .enhancedPacket(0, 3, {3});
+  auto data = first.data();
+  data.insert(data.end(), second.data().begin(), second.data().end());
+  test::TempFile file("PcapngSectionsScopeInterfaces", data);
+  chai::PcapReader reader;
+  CHECK(reader.open(file.path()));
+  chai::PcapRecord record;
+  CHECK(reader.next(&record));
+  CHECK(bytesOf(record) == std::vector<uint8_t>({1}));
+  CHECK(reader.next(&record));
+  CHECK(bytesOf(record) == std::vector<uint8_t>({3}));
+  CHECK_EQ(record.linkType, kLinkTypeRaw);
+  CHECK(!reader.next(&record));
+}
+
+TEST(PcapngSkipsBadPackets) {
+  Writer writer;
+  writer.sectionHeader()
+      // Simple packet before any interface.
+      .begin(0x00000003)
+      .put32(1)
+      .put({1})
+      .end()
+      .interface(kLinkTypeEthernet)
+      // Captured length past the block.
+      .begin(0x00000006)
+      .put32(0)
+      .put32(0)
+      .put32(0)
+      .put32(100)
+      .put32(100)
+      .put({2, 2, 2, 2})
+      .end()
+      // Too short for the packet fields.
+      .begin(0x00000006)
+      .put32(0)
+      .end()
+      .enhancedPacket(0, 0, {3});
+  test::TempFile file("PcapngSkipsBadPackets", writer.data());
+  chai::PcapReader reader;
+  CHECK(reader.open(file.path()));
+  chai::PcapRecord record;
+  CHECK(reader.next(&record));
+  CHECK(bytesOf(record) == std::vector<uint8_t>({3}));
+  CHECK(!reader.next(&record));
+  CHECK(reader.error().empty());
+}
+
+TEST(PcapngRejectsCorruptBlocks) {
+  Writer good;
+  good.sectionHeader().interface(kLinkTypeEthernet);
+  // Block lengths below the overhead, not a multiple of 4, or past the end.
+  for (uint32_t length : {8u, 14u, 1000u}) {
+    Writer writer = good;
+    writer.put32(0x00000006).put32(length).put32(0).put32(length);
+    test::TempFile file("PcapngRejectsCorruptBlocks", writer.data());
+    chai::PcapReader reader;
+    CHECK(reader.open(file.path()));
+    chai::PcapRecord record;
+    CHECK(!reader.next(&record));
+    CHECK_EQ(reader.error(), std::string("corrupt pcapng block"));
+  }
+
+  // A section header without the byte-order magic.
+  Writer badMagic;
+  badMagic.begin(0x0a0d0d0a).put32(0x12345678).put32(0).put32(0).put32(0).end();
+  test::TempFile file("PcapngRejectsCorruptBlocks", badMagic.data());
+  chai::PcapReader reader;
+  CHECK(reader.open(file.path()));
+  chai::PcapRecord record;
+  CHECK(!reader.next(&record));
+  CHECK_EQ(reader.error(), std::string("corrupt pcapng section header"));
+}
@@ -0,0 +1,160 @@
+#include "RtpDumpReader.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "RtpDumpWriter.h"
+#include "Test.h"
+
+namespace {
+// "#!rtpplay1.0 |source|\n" and a file header starting at 100.5 s.
+std::vector<uint8_t> fileHeader(const std::string& source) {
+  std::string line = "#!rtpplay1.0 " + source + "\n";
+  std::vector<uint8_t> data(line.begin(), line.end());
+  const uint8_t header[] = {0, 0, 0, 100, 0, 0x07, 0xa1, 0x20,
+                            10, 0, 0, 1, 0x13, 0x8c, 0, 0};
+  data.insert(data.end(), header, header + sizeof(header));
+  return data;
+}
+
+void appendRecord(std::vector<uint8_t>* data,
+                  uint16_t length,
+                  uint16_t plen,
+                  uint32_t offsetMs,
+                  const std::vector<uint8_t>& payload) {
+  const uint8_t header[] = {uint8_t(length >> 8),     uint8_t(length),
+                            uint8_t(plen >> 8),       uint8_t(plen),
+                            uint8_t(offsetMs >> 24),  uint8_t(offsetMs >> 16),
+                            uint8_t(offsetMs >> 8),   uint8_t(offsetMs)};
+  data->insert(data->end(), header, header + sizeof(header));
+  data->insert(data->end(), payload.begin(), payload.end());
+}
+
+std::vector<uint8_t> bytesOf(const chai::RtpDumpRecord& record) {
+  return std::vector<uint8_t>(record.data, record.data + record.length);
+}
+}  // namespace
+
+TEST(RtpDumpReadsRecords) {
+  auto data = fileHeader("10.0.0.1/5004");
+  appendRecord(&data, 8 + 4, 4, 0, {0x80, 0x60, 0, 1});
+  // A header-only dump: the RTP packet was longer than what was kept.
+  appendRecord(&data, 8 + 2, 1200, 20, {0x80, 0x60});
+  appendRecord(&data, 8 + 3, 0, 1500, {0x81, 0xc8, 0});
+  test::TempFile file("RtpDumpReadsRecords", data);
+
+  chai::RtpDumpReader reader;
+  CHECK(reader.open(file.path()));
+  CHECK_EQ(reader.source(), std::string("10.0.0.1/5004"));
+  chai::RtpDumpRecord record;
+  CHECK(reader.next(&record));
+  CHECK(bytesOf(record) == std::vector<uint8_t>({0x80, 0x60, 0, 1}));
+  CHECK_EQ(record.originalLength, 4u);
+  CHECK(!record.rtcp);
+  CHECK_EQ(record.timeUs, int64_t(100500000));
+  CHECK(reader.next(&record));
+  CHECK_EQ(record.length, 2u);
+  CHECK_EQ(record.originalLength, 1200u);
+  CHECK_EQ(record.timeUs, int64_t(100520000));
+  CHECK(reader.next(&record));
+  CHECK(record.rtcp);
+  CHECK_EQ(record.originalLength, 3u);
+  CHECK_EQ(record.timeUs, int64_t(102000000));
+  CHECK(!reader.next(&record));
+  CHECK(reader.error().empty());
+  CHECK_EQ(reader.offset(), data.size());
+}
+
+TEST(RtpDumpProbe) {
+  const char dump[] = "#!rtpplay1.0 0.0.0.0/0\n";
+  CHECK(chai::RtpDumpReader::probe(reinterpret_cast<const uint8_t*>(dump),
+                                   strlen(dump)));
+  // Without the space after the version, or cut short.
+  const char other[] = "#!rtpplay1.00";
+  CHECK(!chai::RtpDumpReader::probe(reinterpret_cast<const uint8_t*>(other),
+                                    strlen(other)));
+  CHECK(!chai::RtpDumpReader::probe(reinterpret_cast<const uint8_t*>(dump),
+                                    5));
+}
+
+TEST(RtpDumpRejectsBadHeaders) {
+  chai::RtpDumpReader reader;
+  const std::string pcap = "\xd4\xc3\xb2\xa1 and more than the first line";
+  test::TempFile notDump("RtpDumpRejectsBadHeaders",
+                         std::vector<uint8_t>(pcap.begin(), pcap.end()));
+  CHECK(!reader.open(notDump.path()));
+  CHECK_EQ(reader.error(), std::string("not an rtpdump file"));
+
+  // No end of the first line within 256 bytes.
+  std::string line = "#!rtpplay1.0 " + std::string(300, '1');
+  test::TempFile longLine("RtpDumpRejectsBadHeaders2",
+                          std::vector<uint8_t>(line.begin(), line.end()));
+  CHECK(!reader.open(longLine.path()));
+  CHECK_EQ(reader.error(), std::string("not an rtpdump file"));
+
+  auto data = fileHeader("0.0.0.0/0");
+  data.pop_back();
+  test::TempFile shortHeader("RtpDumpRejectsBadHeaders3", data);
+  CHECK(!reader.open(shortHeader.path()));
+  CHECK_EQ(reader.error(), std::string("truncated rtpdump header"));
+}
+
+TEST(RtpDumpRejectsCorruptRecords) {
+  // Record lengths below the record header, and past the end.
+  for (uint16_t length : {uint16_t(0), uint16_t(7), uint16_t(8 + 5)}) {
+    auto data = fileHeader("0.0.0.0/0");
+    appendRecord(&data, length, 4, 0, {1, 2, 3, 4});
+    test::TempFile file("RtpDumpRejectsCorruptRecords", data);
+    chai::RtpDumpReader reader;
+    CHECK(reader.open(file.path()));
+    chai::RtpDumpRecord record;
+    CHECK(!reader.next(&record));
+    CHECK_EQ(reader.error(), std::string("corrupt record"));
+  }
+
+  // A cut record header is the end of the file.
+  auto data = fileHeader("0.0.0.0/0");
+  appendRecord(&data, 8, 0, 0, {});
+  data.pop_back();
+  test::TempFile file("RtpDumpRejectsCorruptRecords", data);
+  chai::RtpDumpReader reader;
+  CHECK(reader.open(file.path()));
+  chai::RtpDumpRecord record;
+  CHECK(!reader.next(&record));
+}
+
+TEST(RtpDumpWriterRoundTrip) {
+  test::TempFile file("RtpDumpWriterRoundTrip");
+  std::vector<uint8_t> rtp(1200);
+  for (size_t i = 0; i < rtp.size(); ++i) {
+    rtp[i] = uint8_t(i);
+  }
+  const std::vector<uint8_t> rtcp = {0x81, 0xc9, 0, 7};
+  {
+    chai::RtpDumpWriter writer;
+    CHECK(writer.open(file.path()));
+    writer.write(rtp.data(), rtp.size(), false);
+    writer.write(rtcp.data(), rtcp.size(), true);
+    // Doesn't fit the 16-bit record length.
+    std::vector<uint8_t> huge(0xffff);
+    writer.write(huge.data(), huge.size(), false);
+    writer.close();
+    CHECK_EQ(writer.dropped(), uint64_t(0));
+  }
+
+  chai::RtpDumpReader reader;
+  CHECK(reader.open(file.path()));
+  chai::RtpDumpRecord record;
+  CHECK(reader.next(&record));
+  CHECK(bytesOf(record) == rtp);
+  CHECK(!record.rtcp);
+  int64_t first = record.timeUs;
+  CHECK(reader.next(&record));
+  CHECK(bytesOf(record) == rtcp);
+  CHECK(record.rtcp);
+  CHECK(record.timeUs >= first);
+  CHECK(!reader.next(&record));
+  CHECK(reader.error().empty());
+}
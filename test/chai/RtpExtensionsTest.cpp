@@ -0,0 +1,246 @@
+#include "RtpExtensions.h"
+
+#include <vector>
+
+#include "RtpRecord.h"
+#include "Test.h"
+
+namespace {
+using chai::ExtensionType;
+
+// RTP packet with |profile| and the extension block |elements|, padded to
+// whole words, and a 4-byte payload.
+std::vector<uint8_t> packetWith(uint16_t profile,
+                                std::vector<uint8_t> elements) {
+  while (elements.size() % 4) {
+    elements.push_back(0);
+  }
+  std::vector<uint8_t> packet = {0x90, 96,   0x12, 0x34, 0, 0, 0, 1,
+                                 0,    0,    0,    2,    uint8_t(profile >> 8),
+                                 uint8_t(profile),
+                                 uint8_t(elements.size() / 4 >> 8),
+                                 uint8_t(elements.size() / 4)};
+  packet.insert(packet.end(), elements.begin(), elements.end());
+  packet.insert(packet.end(), {1, 2, 3, 4});
+  return packet;
+}
+
+bool decode(ExtensionType type,
+            const std::vector<uint8_t>& data,
+            chai::RtpExtensionValues* values) {
+  return chai::decodeExtension(type, data.data(), uint8_t(data.size()),
+                               values);
+}
+}  // namespace
+
+TEST(ExtensionUrisRoundTrip) {
+  for (int i = 1; i < int(ExtensionType::kCount); ++i) {
+    ExtensionType type = ExtensionType(i);
+    CHECK_EQ(int(chai::extensionTypeFromUri(chai::extensionUri(type))), i);
+  }
+  CHECK(chai::extensionTypeFromUri("urn:example:unknown") ==
+        ExtensionType::kUnknown);
+  CHECK(chai::extensionTypeFromUri("") == ExtensionType::kUnknown);
+}
+
+TEST(ExtensionDecodesKnownTypes) {
+  chai::RtpExtensionValues values;
+  CHECK(decode(ExtensionType::kAbsSendTime, {0x12, 0x34, 0x56}, &values));
+  CHECK_EQ(values.absSendTime, 0x123456u);
+  CHECK(decode(ExtensionType::kTransmissionOffset, {0xff, 0xff, 0xfe},
+               &values));
+  CHECK_EQ(values.transmissionOffset, -2);
+  CHECK(decode(ExtensionType::kAudioLevel, {0x80 | 42}, &values));
+  CHECK(values.voiceActivity);
+  CHECK_EQ(values.audioLevel, uint8_t(42));
+  CHECK(decode(ExtensionType::kPlayoutDelay, {0x01, 0x23, 0x45}, &values));
+  CHECK_EQ(values.minPlayoutDelay, uint16_t(0x012));
+  CHECK_EQ(values.maxPlayoutDelay, uint16_t(0x345));
+  CHECK(decode(ExtensionType::kVideoOrientation, {0x0b}, &values));
+  CHECK(values.backCamera);
+  CHECK(!values.horizontalFlip);
+  CHECK_EQ(values.rotation, uint16_t(270));
+  CHECK(decode(ExtensionType::kDependencyDescriptor, {0xc5, 0x01, 0x02},
+               &values));
+  CHECK(values.startOfFrame);
+  CHECK(values.endOfFrame);
+  CHECK_EQ(values.frameDependencyTemplateId, uint8_t(5));
+  CHECK_EQ(values.frameNumber, uint16_t(0x0102));
+  CHECK(!values.extendedDescriptor);
+
+  CHECK(values.has(ExtensionType::kAbsSendTime));
+  CHECK(values.has(ExtensionType::kDependencyDescriptor));
+  CHECK(!values.has(ExtensionType::kTransportSequenceNumber));
+}
+
+TEST(ExtensionTransportWideCc) {
+  chai::RtpExtensionValues values;
+  CHECK(decode(ExtensionType::kTransportSequenceNumber, {0xab, 0xcd},
+               &values));
+  CHECK_EQ(values.transportSequenceNumber, uint16_t(0xabcd));
+  CHECK(!values.feedbackRequested);
+  // The feedback request is only in transport-wide-cc-02.
+  CHECK(!decode(ExtensionType::kTransportSequenceNumber,
+                {0xab, 0xcd, 0x80, 0x05}, &values));
+  CHECK(decode(ExtensionType::kTransportSequenceNumberV2,
+               {0xab, 0xcd, 0x80, 0x05}, &values));
+  CHECK(values.feedbackRequested);
+  CHECK(values.feedbackIncludeTimestamps);
+  CHECK_EQ(values.feedbackSequenceCount, uint16_t(5));
+  CHECK(!decode(ExtensionType::kTransportSequenceNumberV2, {0xab, 0xcd, 0x80},
+                &values));
+}
+
+TEST(ExtensionTimingAndCaptureTime) {
+  chai::RtpExtensionValues values;
+  // Without the flags byte, as old senders write it.
+  std::vector<uint8_t> timing = {0, 1, 0, 2, 0, 3, 0, 4, 0, 5, 0, 6};
+  CHECK(decode(ExtensionType::kVideoTiming, timing, &values));
+  CHECK_EQ(values.timingFlags, uint8_t(0));
+  CHECK_EQ(values.encodeStartDelta, uint16_t(1));
+  CHECK_EQ(values.network2Delta, uint16_t(6));
+  timing.insert(timing.begin(), 0x01);
+  CHECK(decode(ExtensionType::kVideoTiming, timing, &values));
+  CHECK_EQ(values.timingFlags, uint8_t(1));
+  CHECK_EQ(values.pacerExitDelta, uint16_t(4));
+
+  std::vector<uint8_t> captureTime = {0, 0, 0, 1, 0x80, 0, 0, 0};
+  CHECK(decode(ExtensionType::kAbsCaptureTime, captureTime, &values));
+  CHECK_EQ(values.absoluteCaptureTimestamp, uint64_t(0x180000000));
+  CHECK(!values.hasCaptureClockOffset);
+  captureTime.insert(captureTime.end(),
+                     {0xff, 0xff, 0xff, 0xff, 0, 0, 0, 0});
+  CHECK(decode(ExtensionType::kAbsCaptureTime, captureTime, &values));
+  CHECK(values.hasCaptureClockOffset);
+  CHECK_EQ(values.estimatedCaptureClockOffset, -(int64_t(1) << 32));
+  captureTime.pop_back();
+  CHECK(!decode(ExtensionType::kAbsCaptureTime, captureTime, &values));
+}
+
+TEST(ExtensionRejectsBadSizes) {
+  chai::RtpExtensionValues values;
+  values.absSendTime = 7;
+  CHECK(!decode(ExtensionType::kAbsSendTime, {1, 2}, &values));
+  CHECK(!decode(ExtensionType::kAbsSendTime, {1, 2, 3, 4}, &values));
+  // Left untouched.
+  CHECK_EQ(values.absSendTime, 7u);
+  CHECK(!values.has(ExtensionType::kAbsSendTime));
+  CHECK(!decode(ExtensionType::kPlayoutDelay, {1, 2}, &values));
+  CHECK(!decode(ExtensionType::kDependencyDescriptor, {1, 2}, &values));
+  CHECK(!decode(ExtensionType::kVideoTiming, std::vector<uint8_t>(11),
+                &values));
+  CHECK(!decode(ExtensionType::kUnknown, {1}, &values));
+}
+
+TEST(ExtensionOneByteElements) {
+  // abs-send-time (id 3), padding, audio level (id 1), mid "v1" (id 9).
+  auto packet = packetWith(0xBEDE, {0x32, 1, 2, 3, 0, 0, 0x10, 0x85, 0x91,
+                                    'v', '1'});
+  chai::RtpRecord record;
+  CHECK(record.parseHeader(packet.data(), packet.size(), true));
+  CHECK_EQ(record.extensionCount, uint8_t(3));
+  CHECK(!record.extensionTruncated);
+  CHECK_EQ(record.extensions[0].id, uint8_t(3));
+  CHECK_EQ(record.extensions[0].length, uint8_t(3));
+  CHECK_EQ(record.extensions[1].id, uint8_t(1));
+  CHECK_EQ(record.extensions[2].id, uint8_t(9));
+  CHECK_EQ(record.extensions[2].length, uint8_t(2));
+  CHECK_EQ(record.header.payloadSize, uint16_t(4));
+
+  chai::ExtensionMap map{};
+  map[1] = ExtensionType::kAudioLevel;
+  map[3] = ExtensionType::kAbsSendTime;
+  map[9] = ExtensionType::kMid;
+  record.decodeExtensions(map);
+  CHECK(record.extensions[0].decoded);
+  CHECK_EQ(record.extensionValues.absSendTime, 0x010203u);
+  CHECK_EQ(record.extensionValues.audioLevel, uint8_t(5));
+  CHECK(record.extensions[2].decoded);
+  auto json = record.extensionJson();
+  CHECK(json.dump().find("\"v1\"") != std::string::npos);
+}
+
+TEST(ExtensionOneByteStopsAtId15) {
+  auto packet = packetWith(0xBEDE, {0x10, 0x01, 0xf0, 0x20, 0x01});
+  chai::RtpRecord record;
+  CHECK(record.parseHeader(packet.data(), packet.size(), true));
+  CHECK_EQ(record.extensionCount, uint8_t(1));
+}
+
+TEST(ExtensionTwoByteElements) {
+  // transport-wide-cc (id 20), an empty element (id 30), a 17-byte mid
+  // (id 200): lengths the one-byte form can't express.
+  std::vector<uint8_t> elements = {20, 2, 0xab, 0xcd, 0, 30, 0, 200, 17};
+  for (int i = 0; i < 17; ++i) {
+    elements.push_back(uint8_t('a' + i));
+  }
+  auto packet = packetWith(0x1000, elements);
+  chai::RtpRecord record;
+  CHECK(record.parseHeader(packet.data(), packet.size(), true));
+  CHECK_EQ(record.extensionCount, uint8_t(3));
+  CHECK_EQ(record.extensions[0].id, uint8_t(20));
+  CHECK_EQ(record.extensions[1].id, uint8_t(30));
+  CHECK_EQ(record.extensions[1].length, uint8_t(0));
+  CHECK_EQ(record.extensions[2].id, uint8_t(200));
+  CHECK_EQ(record.extensions[2].length, uint8_t(17));
+
+  chai::ExtensionMap map{};
+  map[20] = ExtensionType::kTransportSequenceNumber;
+  map[200] = ExtensionType::kMid;
+  record.decodeExtensions(map);
+  CHECK_EQ(record.extensionValues.transportSequenceNumber, uint16_t(0xabcd));
+  CHECK(!record.extensions[1].decoded);
+  CHECK(record.extensions[2].decoded);
+
+  // The low nibble of the profile is appbits.
+  packet = packetWith(0x100f, {20, 2, 0xab, 0xcd});
+  CHECK(record.parseHeader(packet.data(), packet.size(), true));
+  CHECK_EQ(record.extensionCount, uint8_t(1));
+}
+
+TEST(ExtensionElementsPastTheBlock) {
+  // An element claiming more bytes than the block holds.
+  auto packet = packetWith(0xBEDE, {0x10, 0x01, 0x2f, 0x01});
+  chai::RtpRecord record;
+  CHECK(record.parseHeader(packet.data(), packet.size(), true));
+  CHECK_EQ(record.extensionCount, uint8_t(1));
+  CHECK(record.extensionTruncated);
+
+  packet = packetWith(0x1000, {20, 200, 1, 2});
+  CHECK(record.parseHeader(packet.data(), packet.size(), true));
+  CHECK_EQ(record.extensionCount, uint8_t(0));
+  CHECK(record.extensionTruncated);
+}
+
+TEST(ExtensionLimits) {
+  // More elements than kMaxExtensions, and more bytes than
+  // kMaxExtensionBytes.
+  std::vector<uint8_t> elements;
+  for (int i = 0; i < 20; ++i) {
+    elements.insert(elements.end(), {0x10, uint8_t(i)});
+  }
+  auto packet = packetWith(0xBEDE, elements);
+  chai::RtpRecord record;
+  CHECK(record.parseHeader(packet.data(), packet.size(), true));
+  CHECK_EQ(record.extensionCount, uint8_t(chai::RtpRecord::kMaxExtensions));
+  CHECK(record.extensionTruncated);
+
+  elements.clear();
+  for (int i = 0; i < 3; ++i) {
+    elements.insert(elements.end(), {uint8_t(10 + i), 100});
+    elements.resize(elements.size() + 100, uint8_t(i));
+  }
+  packet = packetWith(0x1000, elements);
+  CHECK(record.parseHeader(packet.data(), packet.size(), true));
+  CHECK_EQ(record.extensionCount, uint8_t(2));
+  CHECK(record.extensionTruncated);
+  CHECK_EQ(record.header.payloadSize, uint16_t(4));
+}
+
+TEST(ExtensionBlockLongerThanPacket) {
+  auto packet = packetWith(0xBEDE, {0x10, 0x01});
+  // Claim one more word than there is.
+  packet[15] = uint8_t(packet.size() / 4);
+  chai::RtpRecord record;
+  CHECK(!record.parseHeader(packet.data(), packet.size(), true));
+}
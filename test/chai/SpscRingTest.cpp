@@ -0,0 +1,85 @@
+#include "SpscRing.h"
+
+#include <stdint.h>
+
+#include <thread>
+#include <vector>
+
+#include "Test.h"
+
+TEST(SpscRingFillsToCapacity) {
+  chai::SpscRing<int, 8> ring;
+  CHECK(ring.empty());
+  CHECK_EQ(ring.capacity(), size_t(8));
+  for (int i = 0; i < 8; ++i) {
+    CHECK(ring.Push(i));
+  }
+  CHECK(!ring.Push(8));
+  CHECK_EQ(ring.size(), size_t(8));
+
+  int out[8] = {};
+  CHECK_EQ(ring.Pop(out, 3), size_t(3));
+  CHECK_EQ(out[0], 0);
+  CHECK_EQ(out[2], 2);
+  // Room for three more.
+  CHECK(ring.Push(8));
+  CHECK(ring.Push(9));
+  CHECK(ring.Push(10));
+  CHECK(!ring.Push(11));
+  CHECK_EQ(ring.Pop(out, 8), size_t(8));
+  for (int i = 0; i < 8; ++i) {
+    CHECK_EQ(out[i], i + 3);
+  }
+  CHECK(ring.empty());
+  CHECK_EQ(ring.Pop(out, 8), size_t(0));
+}
+
+TEST(SpscRingKeepsOrderAcrossWraps) {
+  chai::SpscRing<uint32_t, 16> ring;
+  uint32_t next = 0;
+  uint32_t expected = 0;
+  uint32_t out[16];
+  // Uneven pushes and pops, so the indices wrap at every offset.
+  for (int round = 0; round < 1000; ++round) {
+    for (int i = 0; i < round % 7 + 1; ++i) {
+      if (ring.Push(next)) {
+        ++next;
+      }
+    }
+    size_t count = ring.Pop(out, size_t(round % 5 + 1));
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_EQ(out[i], expected++);
+    }
+  }
+  CHECK_EQ(ring.size(), size_t(next - expected));
+}
+
+TEST(SpscRingAcrossThreads) {
+  static const uint32_t kItems{200000};
+  chai::SpscRing<uint32_t, 64> ring;
+  std::thread producer([&ring] {
+    for (uint32_t i = 0; i < kItems;) {
+      if (ring.Push(i)) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint32_t expected = 0;
+  bool inOrder = true;
+  std::vector<uint32_t> out(32);
+  while (expected < kItems) {
+    size_t count = ring.Pop(out.data(), out.size());
+    if (count == 0) {
+      std::this_thread::yield();
+    }
+    for (size_t i = 0; i < count; ++i) {
+      inOrder = inOrder && out[i] == expected;
+      ++expected;
+    }
+  }
+  producer.join();
+  CHECK(inOrder);
+  CHECK(ring.empty());
+}
@@ -0,0 +1,89 @@
+// Unit tests of the chai parsers, run by rtceye-tests (see cli/CMakeLists.txt).
+// TEST(name) registers a test; CHECK and CHECK_EQ report a failure and let
+// the test carry on, so one run lists every broken field.
+
+#ifndef RTCEYE_TEST_CHAI_TEST_H
+#define RTCEYE_TEST_CHAI_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace test {
+struct Registration {
+  Registration(const char* name, void (*run)());
+};
+
+void fail(const char* file, int line, const std::string& message);
+
+// Bytes print as numbers.
+template <typename T>
+const T& printable(const T& value) {
+  return value;
+}
+inline int printable(uint8_t value) {
+  return value;
+}
+inline int printable(int8_t value) {
+  return value;
+}
+inline int printable(bool value) {
+  return value;
+}
+
+// A file in the working directory for the readers to open, removed when it
+// goes out of scope.
+class TempFile {
+ public:
+  explicit TempFile(const std::string& name) : path_(name + ".tmp") {
+    remove(this->path_.c_str());
+  }
+  TempFile(const std::string& name, const std::vector<uint8_t>& data)
+      : TempFile(name) {
+    FILE* file = fopen(this->path_.c_str(), "wb");
+    if (file) {
+      if (!data.empty()) {
+        fwrite(data.data(), 1, data.size(), file);
+      }
+      fclose(file);
+    }
+  }
+  ~TempFile() { remove(this->path_.c_str()); }
+  TempFile(const TempFile&) = delete;
+  TempFile& operator=(const TempFile&) = delete;
+
+  const std::string& path() const { return this->path_; }
+
+ private:
+  std::string path_;
+};
+}  // namespace test
+
+#define TEST(name)                                                 \
+  static void name();                                              \
+  static const test::Registration name##Registration(#name, name); \
+  static void name()
+
+#define CHECK(expr)                           \
+  do {                                        \
+    if (!(expr)) {                            \
+      test::fail(__FILE__, __LINE__, #expr);  \
+    }                                         \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                        \
+  do {                                                                    \
+    const auto& actual_ = (actual);                                       \
+    const auto& expected_ = (expected);                                   \
+    if (!(actual_ == expected_)) {                                        \
+      std::ostringstream oss_;                                            \
+      oss_ << #actual " is " << test::printable(actual_) << ", expected " \
+           << test::printable(expected_);                                 \
+      test::fail(__FILE__, __LINE__, oss_.str());                         \
+    }                                                                     \
+  } while (0)
+
+#endif  // RTCEYE_TEST_CHAI_TEST_H
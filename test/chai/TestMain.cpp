@@ -0,0 +1,56 @@
+#include <string.h>
+
+#include <iostream>
+#include <vector>
+
+#include "Test.h"
+
+namespace {
+struct Entry {
+  const char* name;
+  void (*run)();
+};
+
+std::vector<Entry>& registry() {
+  static std::vector<Entry> entries;
+  return entries;
+}
+
+int failures{0};
+}  // namespace
+
+namespace test {
+Registration::Registration(const char* name, void (*run)()) {
+  registry().push_back({name, run});
+}
+
+void fail(const char* file, int line, const std::string& message) {
+  std::cerr << file << ":" << line << ": " << message << "\n";
+  ++failures;
+}
+}  // namespace test
+
+// rtceye-tests [PREFIX...]: runs the tests whose name starts with one of the
+// prefixes, or all of them.
+int main(int argc, char* argv[]) {
+  int run{0};
+  int failed{0};
+  for (const auto& entry : registry()) {
+    bool selected = argc == 1;
+    for (int i = 1; i < argc && !selected; ++i) {
+      selected = strncmp(entry.name, argv[i], strlen(argv[i])) == 0;
+    }
+    if (!selected) {
+      continue;
+    }
+    int before = failures;
+    entry.run();
+    ++run;
+    if (failures != before) {
+      std::cerr << "FAILED " << entry.name << "\n";
+      ++failed;
+    }
+  }
+  std::cerr << run - failed << "/" << run << " tests passed\n";
+  return failed == 0 && run > 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+#include "VideoRtpDepacketizerH265.h"
+
+#include <vector>
+
+#include "PayloadH265.h"
+#include "Test.h"
+
+namespace {
+using Parsed = webrtc::VideoRtpDepacketizer::ParsedRtpPayload;
+
+// Two byte NAL unit header: F clear, layer id 0, TID 1.
+uint8_t type(uint8_t naluType) {
+  return uint8_t(naluType << 1);
+}
+
+absl::optional<Parsed> parse(const std::vector<uint8_t>& payload) {
+  chai::VideoRtpDepacketizerH265 depacketizer;
+  return depacketizer.Parse(
+      rtc::CopyOnWriteBuffer(payload.data(), payload.size()));
+}
+
+std::vector<uint8_t> bytes(const Parsed& parsed) {
+  const auto& payload = parsed.video_payload;
+  return std::vector<uint8_t>(payload.cdata(),
+                              payload.cdata() + payload.size());
+}
+
+bool isKey(const Parsed& parsed) {
+  return parsed.video_header.frame_type ==
+         webrtc::VideoFrameType::kVideoFrameKey;
+}
+}  // namespace
+
+TEST(H265SingleNalUnit) {
+  // IDR slice, first_slice_segment_in_pic_flag set.
+  auto parsed = parse({type(chai::kH265IdrWRadl), 1, 0x80, 0xaa});
+  CHECK(parsed);
+  CHECK(isKey(*parsed));
+  CHECK(parsed->video_header.is_first_packet_in_frame);
+  CHECK(bytes(*parsed) == std::vector<uint8_t>(
+                              {0, 0, 0, 1, type(chai::kH265IdrWRadl), 1,
+                               0x80, 0xaa}));
+
+  // Later slice of a TRAIL_R picture.
+  parsed = parse({type(chai::kH265TrailR), 1, 0x40, 0xaa});
+  CHECK(parsed);
+  CHECK(!isKey(*parsed));
+  CHECK(!parsed->video_header.is_first_packet_in_frame);
+
+  // A header with nothing behind it, or less, isn't a packet.
+  CHECK(!parse({type(chai::kH265TrailR), 1}));
+  CHECK(!parse({type(chai::kH265TrailR)}));
+  CHECK(!parse({}));
+}
+
+TEST(H265AggregationPacket) {
+  // VPS, SPS and PPS, three bytes each.
+  auto parsed = parse({type(chai::kH265Ap), 1,
+                       0, 3, type(chai::kH265Vps), 1, 0xaa,
+                       0, 3, type(chai::kH265Sps), 1, 0xbb,
+                       0, 3, type(chai::kH265Pps), 1, 0xcc});
+  CHECK(parsed);
+  CHECK(isKey(*parsed));
+  CHECK(parsed->video_header.is_first_packet_in_frame);
+  CHECK(bytes(*parsed) ==
+        std::vector<uint8_t>({0, 0, 0, 1, type(chai::kH265Vps), 1, 0xaa,
+                              0, 0, 0, 1, type(chai::kH265Sps), 1, 0xbb,
+                              0, 0, 0, 1, type(chai::kH265Pps), 1, 0xcc}));
+
+  // Only the first NAL unit says whether the packet opens a frame.
+  parsed = parse({type(chai::kH265Ap), 1,
+                  0, 3, type(chai::kH265TrailR), 1, 0x00,
+                  0, 2, type(chai::kH265Sps), 1});
+  CHECK(parsed);
+  CHECK(isKey(*parsed));
+  CHECK(!parsed->video_header.is_first_packet_in_frame);
+}
+
+TEST(H265AggregationPacketRejectsBadLengths) {
+  const uint8_t ap = type(chai::kH265Ap);
+  // Past the end.
+  CHECK(!parse({ap, 1, 0, 4, type(chai::kH265Vps), 1, 0xaa}));
+  // Shorter than a NAL unit header.
+  CHECK(!parse({ap, 1, 0, 1, type(chai::kH265Vps), 0, 3, 0, 1, 0xaa}));
+  // A dangling byte of a length field.
+  CHECK(!parse({ap, 1, 0, 3, type(chai::kH265Vps), 1, 0xaa, 0}));
+  // No NAL units at all.
+  CHECK(!parse({ap, 1, 0}));
+  // A length of 0xffff.
+  CHECK(!parse({ap, 1, 0xff, 0xff, type(chai::kH265Vps), 1, 0xaa}));
+}
+
+TEST(H265FragmentationUnits) {
+  // PayloadHdr with F and the high layer id bit set, which the rebuilt
+  // NAL unit header keeps; FU header S with an IDR type.
+  const uint8_t fu = uint8_t(0x81 | type(chai::kH265Fu));
+  auto parsed = parse({fu, 0x09, 0x80 | chai::kH265IdrWRadl, 0x80, 1, 2});
+  CHECK(parsed);
+  CHECK(isKey(*parsed));
+  CHECK(parsed->video_header.is_first_packet_in_frame);
+  CHECK(bytes(*parsed) ==
+        std::vector<uint8_t>({0, 0, 0, 1,
+                              uint8_t(0x81 | type(chai::kH265IdrWRadl)), 0x09,
+                              0x80, 1, 2}));
+
+  // Middle and end fragments carry bytes only, and say nothing about the
+  // frame.
+  parsed = parse({fu, 0x09, chai::kH265IdrWRadl, 3, 4});
+  CHECK(parsed);
+  CHECK(!isKey(*parsed));
+  CHECK(!parsed->video_header.is_first_packet_in_frame);
+  CHECK(bytes(*parsed) == std::vector<uint8_t>({3, 4}));
+  parsed = parse({fu, 0x09, 0x40 | chai::kH265IdrWRadl, 5});
+  CHECK(parsed);
+  CHECK(bytes(*parsed) == std::vector<uint8_t>({5}));
+
+  // An FU header without payload.
+  CHECK(!parse({fu, 0x09, 0x80 | chai::kH265IdrWRadl}));
+}
+
+TEST(H265Paci) {
+  // PACI around a single NAL unit: cType IDR, PHSsize 2, then the PHES.
+  const uint8_t paci = type(chai::kH265Paci);
+  const uint8_t cType = uint8_t(chai::kH265IdrWRadl << 1);
+  auto parsed = parse({paci, 1, cType, 0x20, 0xee, 0xee, 0x80, 0xaa});
+  CHECK(parsed);
+  CHECK(isKey(*parsed));
+  CHECK(parsed->video_header.is_first_packet_in_frame);
+  CHECK(bytes(*parsed) == std::vector<uint8_t>(
+                              {0, 0, 0, 1, type(chai::kH265IdrWRadl), 1,
+                               0x80, 0xaa}));
+
+  // Around the first fragment of an FU.
+  const uint8_t fuType = uint8_t(chai::kH265Fu << 1);
+  parsed = parse({paci, 1, fuType, 0x00, 0x80 | chai::kH265Cra, 0x80, 7});
+  CHECK(parsed);
+  CHECK(isKey(*parsed));
+  CHECK(bytes(*parsed) == std::vector<uint8_t>(
+                              {0, 0, 0, 1, type(chai::kH265Cra), 1, 0x80, 7}));
+
+  // PHSsize over the high bit of the first byte: 16 + 1 bytes of PHES.
+  std::vector<uint8_t> data = {paci, 1, uint8_t(cType | 1), 0x10};
+  data.resize(data.size() + 17, 0xee);
+  data.push_back(0x80);
+  parsed = parse(data);
+  CHECK(parsed);
+  CHECK(bytes(*parsed) == std::vector<uint8_t>(
+                              {0, 0, 0, 1, type(chai::kH265IdrWRadl), 1,
+                               0x80}));
+
+  // PHES past the end, a cut PACI header, and PACI within PACI.
+  CHECK(!parse({paci, 1, cType, 0x30, 0xee, 0xee}));
+  CHECK(!parse({paci, 1, cType}));
+  CHECK(!parse({paci, 1, paci, 0x00, 0x80}));
+}
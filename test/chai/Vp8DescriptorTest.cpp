@@ -0,0 +1,70 @@
+#include "Vp8Descriptor.h"
+
+#include <vector>
+
+#include "Test.h"
+
+namespace {
+bool parse(const std::vector<uint8_t>& data, chai::Vp8Descriptor* descriptor) {
+  return chai::parseVp8Descriptor(data.data(), data.size(), descriptor);
+}
+}  // namespace
+
+TEST(Vp8MinimalDescriptor) {
+  chai::Vp8Descriptor descriptor;
+  // S, partition 0, then a key frame tag (P clear).
+  CHECK(parse({0x10, 0x00}, &descriptor));
+  CHECK_EQ(descriptor.size, uint8_t(1));
+  CHECK(descriptor.startOfPartition);
+  CHECK(descriptor.startOfFrame);
+  CHECK(descriptor.keyFrame);
+  CHECK(!descriptor.nonReference);
+  CHECK(!descriptor.hasPictureId);
+
+  // Inter frame tag.
+  CHECK(parse({0x10, 0x01}, &descriptor));
+  CHECK(!descriptor.keyFrame);
+  // Later partitions don't start a frame, so carry no frame tag.
+  CHECK(parse({0x33, 0x00}, &descriptor));
+  CHECK(descriptor.nonReference);
+  CHECK_EQ(descriptor.partitionId, uint8_t(3));
+  CHECK(!descriptor.startOfFrame);
+  CHECK(!descriptor.keyFrame);
+}
+
+TEST(Vp8AllExtensions) {
+  chai::Vp8Descriptor descriptor;
+  // X; I L T K; 15-bit picture id 0x1234; TL0PICIDX 7; TID 2, Y, KEYIDX 5.
+  CHECK(parse({0x90, 0xf0, 0x92, 0x34, 0x07, 0xa5, 0x00}, &descriptor));
+  CHECK_EQ(descriptor.size, uint8_t(6));
+  CHECK(descriptor.hasPictureId);
+  CHECK(descriptor.longPictureId);
+  CHECK_EQ(descriptor.pictureId, uint16_t(0x1234));
+  CHECK(descriptor.hasTl0PicIdx);
+  CHECK_EQ(descriptor.tl0PicIdx, uint8_t(7));
+  CHECK(descriptor.hasTid);
+  CHECK_EQ(descriptor.tid, uint8_t(2));
+  CHECK(descriptor.layerSync);
+  CHECK(descriptor.hasKeyIdx);
+  CHECK_EQ(descriptor.keyIdx, uint8_t(5));
+
+  // 7-bit picture id, K without T.
+  CHECK(parse({0x80, 0x90, 0x55, 0x1f, 0x00}, &descriptor));
+  CHECK_EQ(descriptor.size, uint8_t(4));
+  CHECK(!descriptor.longPictureId);
+  CHECK_EQ(descriptor.pictureId, uint16_t(0x55));
+  CHECK(!descriptor.hasTid);
+  CHECK(descriptor.hasKeyIdx);
+  CHECK_EQ(descriptor.keyIdx, uint8_t(0x1f));
+}
+
+TEST(Vp8RejectsTruncation) {
+  chai::Vp8Descriptor descriptor;
+  const std::vector<uint8_t> full = {0x90, 0xf0, 0x92, 0x34, 0x07, 0xa5, 0x00};
+  // Every prefix that cuts the descriptor, or leaves no payload.
+  for (size_t size = 0; size < full.size(); ++size) {
+    std::vector<uint8_t> data(full.begin(), full.begin() + size);
+    CHECK(!parse(data, &descriptor));
+  }
+  CHECK(!parse({0x10}, &descriptor));
+}
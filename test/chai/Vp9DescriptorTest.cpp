@@ -0,0 +1,111 @@
+#include "Vp9Descriptor.h"
+
+#include <vector>
+
+#include "Test.h"
+
+namespace {
+bool parse(const std::vector<uint8_t>& data, chai::Vp9Descriptor* descriptor) {
+  return chai::parseVp9Descriptor(data.data(), data.size(), descriptor);
+}
+}  // namespace
+
+TEST(Vp9NonFlexibleMode) {
+  chai::Vp9Descriptor descriptor;
+  // I P L B E; 15-bit picture id 0x0102; TID 1, U, SID 2, D; TL0PICIDX 9.
+  CHECK(parse({0xec, 0x81, 0x02, 0x35, 0x09, 0x00}, &descriptor));
+  CHECK_EQ(descriptor.size, uint16_t(5));
+  CHECK(descriptor.interPicturePredicted);
+  CHECK(!descriptor.flexibleMode);
+  CHECK(descriptor.startOfFrame);
+  CHECK(descriptor.endOfFrame);
+  CHECK(descriptor.longPictureId);
+  CHECK_EQ(descriptor.pictureId, uint16_t(0x0102));
+  CHECK(descriptor.hasLayerIndices);
+  CHECK_EQ(descriptor.tid, uint8_t(1));
+  CHECK(descriptor.switchingUp);
+  CHECK_EQ(descriptor.sid, uint8_t(2));
+  CHECK(descriptor.interLayerDependency);
+  CHECK(descriptor.hasTl0PicIdx);
+  CHECK_EQ(descriptor.tl0PicIdx, uint8_t(9));
+  CHECK_EQ(descriptor.pDiffCount, uint8_t(0));
+}
+
+TEST(Vp9FlexibleModeReferences) {
+  chai::Vp9Descriptor descriptor;
+  // I P L F B; 7-bit picture id 5; layer byte, no TL0PICIDX; P_DIFF 1 and
+  // 6, N set on the first.
+  CHECK(parse({0xf8, 0x05, 0x00, 0x03, 0x0c, 0x00}, &descriptor));
+  CHECK_EQ(descriptor.size, uint16_t(5));
+  CHECK(descriptor.flexibleMode);
+  CHECK(!descriptor.hasTl0PicIdx);
+  CHECK_EQ(descriptor.pDiffCount, uint8_t(2));
+  CHECK_EQ(descriptor.pDiffs[0], uint8_t(1));
+  CHECK_EQ(descriptor.pDiffs[1], uint8_t(6));
+  // Picture ids wrap at 7 bits: 5 - 6 is 127.
+  auto references = descriptor.toJson()["references"];
+  CHECK(references == nlohmann::json({4, 127}));
+
+  // R 3 times is the most; a fourth P_DIFF is malformed.
+  CHECK(!parse({0xd8, 0x05, 0x03, 0x05, 0x07, 0x08, 0x00}, &descriptor));
+  CHECK(parse({0xd8, 0x05, 0x03, 0x05, 0x06, 0x00}, &descriptor));
+  CHECK_EQ(descriptor.pDiffCount, uint8_t(3));
+}
+
+TEST(Vp9ScalabilityStructure) {
+  chai::Vp9Descriptor descriptor;
+  // B V; SS: N_S 1 (two layers), Y, G; 320x180 and 640x360; N_G 2: TID 0
+  // with one ref (P_DIFF 4), TID 1 U with none.
+  std::vector<uint8_t> data = {0x0a, 0x38, 0x01, 0x40, 0x00, 0xb4,
+                               0x02, 0x80, 0x01, 0x68, 0x02, 0x04,
+                               0x04, 0x30, 0x00};
+  CHECK(parse(data, &descriptor));
+  CHECK(descriptor.ssAttached);
+  const auto& ss = descriptor.ss;
+  CHECK_EQ(ss.spatialLayers, uint8_t(2));
+  CHECK(ss.resolutionsPresent);
+  CHECK_EQ(ss.width[0], uint16_t(320));
+  CHECK_EQ(ss.height[0], uint16_t(180));
+  CHECK_EQ(ss.width[1], uint16_t(640));
+  CHECK_EQ(ss.height[1], uint16_t(360));
+  CHECK(ss.gofPresent);
+  CHECK_EQ(ss.gofSize, uint8_t(2));
+  CHECK_EQ(ss.gof[0].tid, uint8_t(0));
+  CHECK_EQ(ss.gof[0].refCount, uint8_t(1));
+  CHECK_EQ(ss.gof[0].pDiffs[0], uint8_t(4));
+  CHECK_EQ(ss.gof[1].tid, uint8_t(1));
+  CHECK(ss.gof[1].switchingUp);
+  CHECK_EQ(ss.gof[1].refCount, uint8_t(0));
+  CHECK_EQ(descriptor.size, uint16_t(data.size() - 1));
+
+  // Every cut through the SS is rejected.
+  for (size_t size = 1; size < data.size(); ++size) {
+    std::vector<uint8_t> prefix(data.begin(), data.begin() + size);
+    CHECK(!parse(prefix, &descriptor));
+  }
+}
+
+TEST(Vp9LongGofIsCountedNotKept) {
+  // N_G 255 pictures without refs: more than kMaxGofPictures.
+  std::vector<uint8_t> data = {0x02, 0x08, 0xff};
+  for (int i = 0; i < 255; ++i) {
+    data.push_back(uint8_t((i % 4) << 5));
+  }
+  data.push_back(0x00);
+  chai::Vp9Descriptor descriptor;
+  CHECK(parse(data, &descriptor));
+  CHECK_EQ(descriptor.ss.gofSize, uint8_t(255));
+  CHECK_EQ(descriptor.ss.gof[15].tid, uint8_t(3));
+  CHECK_EQ(descriptor.size, uint16_t(data.size() - 1));
+  CHECK_EQ(descriptor.ss.toJson()["gof"].size(),
+           size_t(chai::Vp9ScalabilityStructure::kMaxGofPictures));
+}
+
+TEST(Vp9RejectsTruncation) {
+  chai::Vp9Descriptor descriptor;
+  const std::vector<uint8_t> full = {0xec, 0x81, 0x02, 0x35, 0x09, 0x00};
+  for (size_t size = 0; size < full.size(); ++size) {
+    std::vector<uint8_t> data(full.begin(), full.begin() + size);
+    CHECK(!parse(data, &descriptor));
+  }
+}